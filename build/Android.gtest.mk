@@ -34,6 +34,7 @@ GTEST_DEX_DIRECTORIES := \
   NonStaticLeafMethods \
   ProtoCompare \
   ProtoCompare2 \
+  QuickenedCode \
   StaticLeafMethods \
   Statics \
   StaticsFromCode \
@@ -54,6 +55,7 @@ ART_GTEST_jni_compiler_test_DEX_DEPS := MyClassNatives
 ART_GTEST_jni_internal_test_DEX_DEPS := AllFields StaticLeafMethods
 ART_GTEST_object_test_DEX_DEPS := ProtoCompare ProtoCompare2 StaticsFromCode XandY
 ART_GTEST_proxy_test_DEX_DEPS := Interfaces
+ART_GTEST_quickened_code_table_test_DEX_DEPS := QuickenedCode
 ART_GTEST_reflection_test_DEX_DEPS := Main NonStaticLeafMethods StaticLeafMethods
 ART_GTEST_stub_test_DEX_DEPS := AllFields
 ART_GTEST_transaction_test_DEX_DEPS := Transaction
@@ -84,6 +86,7 @@ RUNTIME_GTEST_COMMON_SRC_FILES := \
   runtime/base/unix_file/random_access_file_utils_test.cc \
   runtime/base/unix_file/string_file_test.cc \
   runtime/class_linker_test.cc \
+  runtime/cpu_sampling_profiler_test.cc \
   runtime/dex_file_test.cc \
   runtime/dex_file_verifier_test.cc \
   runtime/dex_instruction_visitor_test.cc \
@@ -104,19 +107,26 @@ RUNTIME_GTEST_COMMON_SRC_FILES := \
   runtime/gc/space/large_object_space_test.cc \
   runtime/gtest_test.cc \
   runtime/handle_scope_test.cc \
+  runtime/hprof/hprof_test.cc \
   runtime/indenter_test.cc \
   runtime/indirect_reference_table_test.cc \
+  runtime/inline_cache_test.cc \
   runtime/instruction_set_test.cc \
   runtime/intern_table_test.cc \
+  runtime/jit/jit_code_cache_test.cc \
   runtime/leb128_test.cc \
+  runtime/lock_contention_profiler_test.cc \
   runtime/mem_map_test.cc \
   runtime/mirror/dex_cache_test.cc \
   runtime/mirror/object_test.cc \
   runtime/monitor_pool_test.cc \
   runtime/monitor_test.cc \
   runtime/parsed_options_test.cc \
+  runtime/quickened_code_table_test.cc \
   runtime/reference_table_test.cc \
+  runtime/thread_list_test.cc \
   runtime/thread_pool_test.cc \
+  runtime/trace_test.cc \
   runtime/transaction_test.cc \
   runtime/utils_test.cc \
   runtime/verifier/method_verifier_test.cc \
@@ -28,6 +28,10 @@ class Backend {
     virtual void Materialize() = 0;
     virtual CompiledMethod* GetCompiledMethod() = 0;
 
+    // Number of target instructions generated by Materialize(), for compilation statistics.
+    // Returns 0 if the backend doesn't track them.
+    virtual size_t GetNumInstructions() const { return 0; }
+
     // Queries for backend support for vectors
     /*
      * Return the number of bits in a vector register.
@@ -23,6 +23,7 @@
 #include "compiler_internals.h"
 #include "driver/compiler_driver.h"
 #include "driver/compiler_options.h"
+#include "driver/method_compilation_stats.h"
 #include "mirror/object.h"
 #include "pass_driver_me_opts.h"
 #include "runtime.h"
@@ -148,6 +149,11 @@ static CompiledMethod* CompileMethod(CompilerDriver& driver,
     cu.enable_debug |= (1 << kDebugCodegenDump);
   }
 
+  if (driver.GetCompilerOptions().GetIncludeMethodTraceHooks()) {
+    // Inlined callees could not report their entry and exit to method tracing.
+    cu.disable_opt |= (1 << kSuppressMethodInlining);
+  }
+
   /*
    * TODO: rework handling of optimization and debug flags.  Should we split out
    * MIR and backend flags?  Need command-line setting as well.
@@ -235,6 +241,13 @@ static CompiledMethod* CompileMethod(CompilerDriver& driver,
 
   if (result) {
     VLOG(compiler) << cu.instruction_set << ": Compiled " << PrettyMethod(method_idx, dex_file);
+    MethodCompilationStats* method_stats = driver.GetMethodCompilationStats();
+    if (method_stats != nullptr) {
+      method_stats->RecordBackend(MethodReference(&dex_file, method_idx),
+                                  compiler->IsPortable() ? MethodCompilationStats::kBackendPortable
+                                                         : MethodCompilationStats::kBackendQuick,
+                                  cu.mir_graph->GetNumMIRs(), cu.cg->GetNumInstructions());
+    }
   } else {
     VLOG(compiler) << cu.instruction_set << ": Deferred " << PrettyMethod(method_idx, dex_file);
   }
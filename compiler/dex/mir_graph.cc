@@ -878,6 +878,19 @@ void MIRGraph::ShowOpcodeStats() {
   }
 }
 
+size_t MIRGraph::GetNumMIRs() {
+  size_t count = 0;
+  AllNodesIterator iter(this);
+  for (BasicBlock* bb = iter.Next(); bb != nullptr; bb = iter.Next()) {
+    for (MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+      if (!MIR::DecodedInstruction::IsPseudoMirOp(mir->dalvikInsn.opcode)) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
 uint64_t MIRGraph::GetDataFlowAttributes(Instruction::Code opcode) {
   DCHECK_LT((size_t) opcode, (sizeof(oat_data_flow_attributes_) / sizeof(oat_data_flow_attributes_[0])));
   return oat_data_flow_attributes_[opcode];
@@ -668,6 +668,9 @@ class MIRGraph {
 
   void ShowOpcodeStats();
 
+  // Number of MIRs left after optimization, not counting extended MIR ops.
+  size_t GetNumMIRs();
+
   DexCompilationUnit* GetCurrentDexCompilationUnit() const {
     return m_units_[current_method_];
   }
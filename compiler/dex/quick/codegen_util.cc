@@ -314,6 +314,16 @@ void Mir2Lir::UpdateLIROffsets() {
   }
 }
 
+size_t Mir2Lir::GetNumInstructions() const {
+  size_t count = 0;
+  for (LIR* lir = first_lir_insn_; lir != nullptr; lir = lir->next) {
+    if (!lir->flags.is_nop && !IsPseudoLirOp(lir->opcode)) {
+      count++;
+    }
+  }
+  return count;
+}
+
 /* Dump instructions and constant pool contents */
 void Mir2Lir::CodegenDump() {
   LOG(INFO) << "Dumping LIR insns for "
@@ -617,9 +627,13 @@ bool Mir2Lir::VerifyCatchEntries() {
   // Sort dex_pcs, so that we can quickly check it against the ordered mir_graph_->catches_.
   std::sort(dex_pcs.begin(), dex_pcs.end());
 
+  // Loop headers exported for on-stack replacement share the table with the catch entries.
+  std::set<uint32_t> entries(mir_graph_->catches_);
+  entries.insert(osr_entries_.begin(), osr_entries_.end());
+
   bool success = true;
   auto it = dex_pcs.begin(), end = dex_pcs.end();
-  for (uint32_t dex_pc : mir_graph_->catches_) {
+  for (uint32_t dex_pc : entries) {
     while (it != end && *it < dex_pc) {
       LOG(INFO) << "Unexpected catch entry @ dex pc 0x" << std::hex << *it;
       ++it;
@@ -634,7 +648,7 @@ bool Mir2Lir::VerifyCatchEntries() {
   }
   if (!success) {
     LOG(INFO) << "Bad dex2pcMapping table in " << PrettyMethod(cu_->method_idx, *cu_->dex_file);
-    LOG(INFO) << "Entries @ decode: " << mir_graph_->catches_.size() << ", Entries in table: "
+    LOG(INFO) << "Entries @ decode: " << entries.size() << ", Entries in table: "
               << table.DexToPcSize();
   }
   return success;
@@ -1006,6 +1020,7 @@ Mir2Lir::Mir2Lir(CompilationUnit* cu, MIRGraph* mir_graph, ArenaAllocator* arena
       live_sreg_(0),
       core_vmap_table_(mir_graph->GetArena()->Adapter()),
       fp_vmap_table_(mir_graph->GetArena()->Adapter()),
+      osr_entries_(mir_graph->GetArena()->Adapter()),
       num_core_spills_(0),
       num_fp_spills_(0),
       frame_size_(0),
@@ -1028,10 +1043,12 @@ void Mir2Lir::Materialize() {
   /* Allocate Registers using simple local allocation scheme */
   SimpleRegAlloc();
 
-  /* First try the custom light codegen for special cases. */
+  /* First try the custom light codegen for special cases, which has no method trace hooks. */
   DCHECK(cu_->compiler_driver->GetMethodInlinerMap() != nullptr);
-  bool special_worked = cu_->compiler_driver->GetMethodInlinerMap()->GetMethodInliner(cu_->dex_file)
-      ->GenSpecial(this, cu_->method_idx);
+  bool special_worked =
+      !cu_->compiler_driver->GetCompilerOptions().GetIncludeMethodTraceHooks() &&
+      cu_->compiler_driver->GetMethodInlinerMap()->GetMethodInliner(cu_->dex_file)
+          ->GenSpecial(this, cu_->method_idx);
 
   /* Take normal path for converting MIR to LIR only if the special codegen did not succeed. */
   if (special_worked == false) {
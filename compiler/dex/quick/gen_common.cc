@@ -1991,6 +1991,50 @@ void Mir2Lir::GenSuspendTestAndBranch(int opt_flags, LIR* target) {
   }
 }
 
+class MethodTraceHookSlowPath : public Mir2Lir::LIRSlowPath {
+ public:
+  MethodTraceHookSlowPath(Mir2Lir* m2l, LIR* branch, LIR* cont, QuickEntrypointEnum trampoline)
+      : LIRSlowPath(m2l, m2l->GetCurrentDexPc(), branch, cont), trampoline_(trampoline) {
+  }
+
+  void Compile() OVERRIDE {
+    m2l_->ResetRegPool();
+    m2l_->ResetDefTracking();
+    GenerateTargetLabel();
+    RegStorage r_method = m2l_->TargetReg(kArg0, kRef);
+    m2l_->LoadCurrMethodDirect(r_method);
+    m2l_->CallRuntimeHelperReg(trampoline_, r_method, true);
+    m2l_->OpUnconditionalBranch(cont_);
+  }
+
+ private:
+  const QuickEntrypointEnum trampoline_;
+};
+
+/* Report method entry or exit if the thread is tracing methods */
+void Mir2Lir::GenMethodTraceHook(QuickEntrypointEnum trampoline) {
+  if (!cu_->compiler_driver->GetCompilerOptions().GetIncludeMethodTraceHooks()) {
+    return;
+  }
+  DCHECK(trampoline == kQuickMethodEntryHook || trampoline == kQuickMethodExitHook);
+  FlushAllRegs();
+  LIR* branch = OpTestMethodTraceHooks();
+  LIR* cont = NewLIR0(kPseudoTargetLabel);
+  AddSlowPath(new (arena_) MethodTraceHookSlowPath(this, branch, cont, trampoline));
+}
+
+LIR* Mir2Lir::OpTestMethodTraceHooks() {
+  RegStorage r_tmp = AllocTemp();
+  if (cu_->target64) {
+    Load32Disp(TargetPtrReg(kSelf), Thread::MethodTraceHooksOffset<8>().Int32Value(), r_tmp);
+  } else {
+    Load32Disp(TargetPtrReg(kSelf), Thread::MethodTraceHooksOffset<4>().Int32Value(), r_tmp);
+  }
+  LIR* branch = OpCmpImmBranch(kCondNe, r_tmp, 0, nullptr);
+  FreeTemp(r_tmp);
+  return branch;
+}
+
 /* Call out to helper assembly routine that will null check obj and then lock it. */
 void Mir2Lir::GenMonitorEnter(int opt_flags, RegLocation rl_src) {
   FlushAllRegs();
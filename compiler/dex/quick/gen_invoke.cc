@@ -1703,8 +1703,10 @@ void Mir2Lir::GenInvoke(CallInfo* info) {
     return;
   }
   DCHECK(cu_->compiler_driver->GetMethodInlinerMap() != nullptr);
-  if (cu_->compiler_driver->GetMethodInlinerMap()->GetMethodInliner(cu_->dex_file)
-      ->GenIntrinsic(this, info)) {
+  // Intrinsics would hide the call from method tracing.
+  if (!cu_->compiler_driver->GetCompilerOptions().GetIncludeMethodTraceHooks() &&
+      cu_->compiler_driver->GetMethodInlinerMap()->GetMethodInliner(cu_->dex_file)
+          ->GenIntrinsic(this, info)) {
     return;
   }
   GenInvokeNoInline(info);
@@ -441,6 +441,7 @@ void Mir2Lir::CompileDalvikInstruction(MIR* mir, BasicBlock* bb, LIR* label_list
       if (!kLeafOptimization || !mir_graph_->MethodIsLeaf()) {
         GenSuspendTest(opt_flags);
       }
+      GenMethodTraceHook(kQuickMethodExitHook);
       break;
 
     case Instruction::RETURN_OBJECT:
@@ -450,6 +451,7 @@ void Mir2Lir::CompileDalvikInstruction(MIR* mir, BasicBlock* bb, LIR* label_list
       if (!kLeafOptimization || !mir_graph_->MethodIsLeaf()) {
         GenSuspendTest(opt_flags);
       }
+      GenMethodTraceHook(kQuickMethodExitHook);
       DCHECK_EQ(LocToRegClass(rl_src[0]), ShortyToRegClass(cu_->shorty[0]));
       StoreValue(GetReturn(LocToRegClass(rl_src[0])), rl_src[0]);
       break;
@@ -458,6 +460,7 @@ void Mir2Lir::CompileDalvikInstruction(MIR* mir, BasicBlock* bb, LIR* label_list
       if (!kLeafOptimization || !mir_graph_->MethodIsLeaf()) {
         GenSuspendTest(opt_flags);
       }
+      GenMethodTraceHook(kQuickMethodExitHook);
       DCHECK_EQ(LocToRegClass(rl_src[0]), ShortyToRegClass(cu_->shorty[0]));
       StoreValueWide(GetReturnWide(LocToRegClass(rl_src[0])), rl_src[0]);
       break;
@@ -1101,6 +1104,28 @@ void Mir2Lir::GenPrintLabel(MIR* mir) {
   }
 }
 
+bool Mir2Lir::IsOsrEntry(BasicBlock* bb) {
+  if (!cu_->compiler_driver->GetCompilerOptions().GetIncludeOsrEntries() ||
+      bb->block_type != kDalvikByteCode) {
+    return false;
+  }
+  // Non-special compiler temps live in the frame, the runtime has no values to give them.
+  if (mir_graph_->GetNumNonSpecialCompilerTemps() != 0) {
+    return false;
+  }
+  // Quick keeps no values in temps across blocks, so on entry to any block the Dalvik registers
+  // are in their home locations and can be set up from an interpreter frame.
+  GrowableArray<BasicBlockId>::Iterator iter(bb->predecessors);
+  for (BasicBlock* pred_bb = mir_graph_->GetBasicBlock(iter.Next()); pred_bb != nullptr;
+       pred_bb = mir_graph_->GetBasicBlock(iter.Next())) {
+    if (pred_bb->block_type == kDalvikByteCode && pred_bb->start_offset >= bb->start_offset) {
+      // Reached by a backward branch.
+      return true;
+    }
+  }
+  return false;
+}
+
 // Handle the content in each basic block.
 bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb) {
   if (bb->block_type == kDead) return false;
@@ -1117,9 +1142,13 @@ bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb) {
 
   LIR* head_lir = NULL;
 
-  // If this is a catch block, export the start address.
+  // If this is a catch block or a loop header the runtime may enter from the interpreter,
+  // export the start address.
   if (bb->catch_entry) {
     head_lir = NewLIR0(kPseudoExportedPC);
+  } else if (IsOsrEntry(bb)) {
+    head_lir = NewLIR0(kPseudoExportedPC);
+    osr_entries_.push_back(bb->start_offset);
   }
 
   // Free temp registers and reset redundant store tracking.
@@ -1129,6 +1158,7 @@ bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb) {
     ResetRegPool();
     int start_vreg = mir_graph_->GetFirstInVR();
     GenEntrySequence(&mir_graph_->reg_location_[start_vreg], mir_graph_->GetMethodLoc());
+    GenMethodTraceHook(kQuickMethodEntryHook);
   } else if (bb->block_type == kExitBlock) {
     ResetRegPool();
     GenExitSequence();
@@ -643,6 +643,7 @@ class Mir2Lir : public Backend {
     int ComputeFrameSize();
     virtual void Materialize();
     virtual CompiledMethod* GetCompiledMethod();
+    size_t GetNumInstructions() const OVERRIDE;
     void MarkSafepointPC(LIR* inst);
     void MarkSafepointPCAfter(LIR* after);
     void SetupResourceMasks(LIR* lir);
@@ -858,6 +859,7 @@ class Mir2Lir : public Backend {
     void GenConversionCall(QuickEntrypointEnum trampoline, RegLocation rl_dest, RegLocation rl_src);
     virtual void GenSuspendTest(int opt_flags);
     virtual void GenSuspendTestAndBranch(int opt_flags, LIR* target);
+    void GenMethodTraceHook(QuickEntrypointEnum trampoline);
 
     // This will be overridden by x86 implementation.
     virtual void GenConstWide(RegLocation rl_dest, int64_t value);
@@ -1067,6 +1069,8 @@ class Mir2Lir : public Backend {
     // Shared by all targets - implemented in mir_to_lir.cc.
     void CompileDalvikInstruction(MIR* mir, BasicBlock* bb, LIR* label_list);
     virtual void HandleExtendedMethodMIR(BasicBlock* bb, MIR* mir);
+    // Is bb a loop header whose native pc is exported for on-stack replacement?
+    bool IsOsrEntry(BasicBlock* bb);
     bool MethodBlockCodeGen(BasicBlock* bb);
     bool SpecialMIR2LIR(const InlineMethod& special);
     virtual void MethodMIR2LIR();
@@ -1434,6 +1438,8 @@ class Mir2Lir : public Backend {
     virtual LIR* OpRegRegReg(OpKind op, RegStorage r_dest, RegStorage r_src1,
                              RegStorage r_src2) = 0;
     virtual LIR* OpTestSuspend(LIR* target) = 0;
+    // Branch (to a slow path, the target is left unset) if method trace hooks are enabled.
+    virtual LIR* OpTestMethodTraceHooks();
     virtual LIR* OpVldm(RegStorage r_base, int count) = 0;
     virtual LIR* OpVstm(RegStorage r_base, int count) = 0;
     virtual void OpRegCopyWide(RegStorage dest, RegStorage src) = 0;
@@ -1729,6 +1735,8 @@ class Mir2Lir : public Backend {
     std::vector<uint8_t> encoded_mapping_table_;
     ArenaVector<uint32_t> core_vmap_table_;
     ArenaVector<uint32_t> fp_vmap_table_;
+    // Dex pcs of the loop headers exported for on-stack replacement.
+    ArenaVector<uint32_t> osr_entries_;
     std::vector<uint8_t> native_gc_map_;
     int num_core_spills_;
     int num_fp_spills_;
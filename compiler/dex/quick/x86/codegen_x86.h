@@ -302,6 +302,7 @@ class X86Mir2Lir : public Mir2Lir {
   LIR* OpRegRegImm(OpKind op, RegStorage r_dest, RegStorage r_src1, int value) OVERRIDE;
   LIR* OpRegRegReg(OpKind op, RegStorage r_dest, RegStorage r_src1, RegStorage r_src2) OVERRIDE;
   LIR* OpTestSuspend(LIR* target) OVERRIDE;
+  LIR* OpTestMethodTraceHooks() OVERRIDE;
   LIR* OpVldm(RegStorage r_base, int count) OVERRIDE;
   LIR* OpVstm(RegStorage r_base, int count) OVERRIDE;
   void OpRegCopyWide(RegStorage dest, RegStorage src) OVERRIDE;
@@ -1344,6 +1344,15 @@ LIR* X86Mir2Lir::OpTestSuspend(LIR* target) {
   return OpCondBranch((target == NULL) ? kCondNe : kCondEq, target);
 }
 
+LIR* X86Mir2Lir::OpTestMethodTraceHooks() {
+  if (cu_->target64) {
+    OpTlsCmp(Thread::MethodTraceHooksOffset<8>(), 0);
+  } else {
+    OpTlsCmp(Thread::MethodTraceHooksOffset<4>(), 0);
+  }
+  return OpCondBranch(kCondNe, nullptr);
+}
+
 // Decrement register and branch on condition
 LIR* X86Mir2Lir::OpDecAndBranch(ConditionCode c_code, RegStorage reg, LIR* target) {
   OpRegImm(kOpSub, reg, 1);
@@ -35,6 +35,7 @@
 #include "dex/verified_method.h"
 #include "dex/quick/dex_file_method_inliner.h"
 #include "driver/compiler_options.h"
+#include "driver/method_compilation_stats.h"
 #include "jni_internal.h"
 #include "object_lock.h"
 #include "profiler.h"
@@ -351,6 +352,7 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
       dump_stats_(dump_stats),
       dump_passes_(dump_passes),
       timings_logger_(timer),
+      method_stats_(nullptr),
       compiler_library_(nullptr),
       compiler_context_(nullptr),
       compiler_enable_auto_elf_loading_(nullptr),
@@ -372,7 +374,8 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
 
   compiler_->Init();
 
-  CHECK(!Runtime::Current()->IsStarted());
+  // The JIT creates its driver in a running runtime.
+  CHECK(!Runtime::Current()->IsStarted() || Runtime::Current()->UseJit());
   if (image_) {
     CHECK(image_classes_.get() != nullptr);
   } else {
@@ -593,6 +596,57 @@ void CompilerDriver::CompileOne(mirror::ArtMethod* method, TimingLogger* timings
   self->TransitionFromSuspendedToRunnable();
 }
 
+CompiledMethod* CompilerDriver::CompileJitMethod(Thread* self, mirror::ArtMethod* method) {
+  DCHECK(Runtime::Current()->UseJit());
+  jobject jclass_loader;
+  const DexFile* dex_file = method->GetDexFile();
+  uint16_t class_def_idx = method->GetClassDefIndex();
+  uint32_t method_idx = method->GetDexMethodIndex();
+  uint32_t access_flags = method->GetAccessFlags();
+  InvokeType invoke_type = method->GetInvokeType();
+  {
+    ScopedObjectAccessUnchecked soa(self);
+    ScopedLocalRef<jobject>
+      local_class_loader(soa.Env(),
+                    soa.AddLocalReference<jobject>(method->GetDeclaringClass()->GetClassLoader()));
+    jclass_loader = soa.Env()->NewGlobalRef(local_class_loader.get());
+  }
+  const DexFile::CodeItem* code_item = dex_file->GetCodeItem(method->GetCodeItemOffset());
+  self->TransitionFromRunnableToSuspended(kNative);
+
+  // The code is shared with the interpreter, so it must not be quickened.
+  CompileMethod(code_item, access_flags, invoke_type, class_def_idx, method_idx, jclass_loader,
+                *dex_file, kDontDexToDexCompile);
+
+  self->GetJniEnv()->DeleteGlobalRef(jclass_loader);
+
+  self->TransitionFromSuspendedToRunnable();
+  return GetCompiledMethod(MethodReference(dex_file, method_idx));
+}
+
+void CompilerDriver::FreeJitCompiledMethod(Thread* self, MethodReference ref) {
+  DCHECK(Runtime::Current()->UseJit());
+  verification_results_->RemoveVerifiedMethod(ref);
+  {
+    MutexLock mu(self, compiled_methods_lock_);
+    MethodTable::iterator it = compiled_methods_.find(ref);
+    if (it != compiled_methods_.end()) {
+      delete it->second;
+      compiled_methods_.erase(it);
+    }
+    // The tables in the dedupe sets may be shared by other compiled methods.
+    if (!compiled_methods_.empty()) {
+      return;
+    }
+  }
+  dedupe_code_.Clear(self);
+  dedupe_src_mapping_table_.Clear(self);
+  dedupe_mapping_table_.Clear(self);
+  dedupe_vmap_table_.Clear(self);
+  dedupe_gc_map_.Clear(self);
+  dedupe_cfi_info_.Clear(self);
+}
+
 void CompilerDriver::Resolve(jobject class_loader, const std::vector<const DexFile*>& dex_files,
                              ThreadPool* thread_pool, TimingLogger* timings) {
   for (size_t i = 0; i != dex_files.size(); ++i) {
@@ -2047,7 +2101,8 @@ void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t
                                    const DexFile& dex_file,
                                    DexToDexCompilationLevel dex_to_dex_compilation_level) {
   CompiledMethod* compiled_method = nullptr;
-  uint64_t start_ns = kTimeCompileMethod ? NanoTime() : 0;
+  uint64_t start_ns = (kTimeCompileMethod || method_stats_ != nullptr) ? NanoTime() : 0;
+  bool dex_to_dex_compiled = false;
 
   if ((access_flags & kAccNative) != 0) {
     // Are we interpreting only and have support for generic JNI down calls?
@@ -2055,6 +2110,10 @@ void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t
         (instruction_set_ == kX86_64 || instruction_set_ == kArm64)) {
       // Leaving this empty will trigger the generic JNI version
     } else {
+      // The class linker sets the access flags of @FastNative and @CriticalNative methods, the
+      // stub has to agree with them.
+      access_flags |= dex_file.GetNativeMethodAnnotationAccessFlags(
+          dex_file.GetClassDef(class_def_idx), method_idx, access_flags);
       compiled_method = compiler_->JniCompile(access_flags, method_idx, dex_file);
       CHECK(compiled_method != nullptr);
     }
@@ -2078,14 +2137,20 @@ void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t
                               invoke_type, class_def_idx,
                               method_idx, class_loader, dex_file,
                               dex_to_dex_compilation_level);
+      dex_to_dex_compiled = true;
     }
   }
-  if (kTimeCompileMethod) {
+  if (kTimeCompileMethod || method_stats_ != nullptr) {
     uint64_t duration_ns = NanoTime() - start_ns;
-    if (duration_ns > MsToNs(compiler_->GetMaximumCompilationTimeBeforeWarning())) {
+    if (kTimeCompileMethod &&
+        duration_ns > MsToNs(compiler_->GetMaximumCompilationTimeBeforeWarning())) {
       LOG(WARNING) << "Compilation of " << PrettyMethod(method_idx, dex_file)
                    << " took " << PrettyDuration(duration_ns);
     }
+    if (method_stats_ != nullptr) {
+      RecordMethodCompilation(MethodReference(&dex_file, method_idx), access_flags, code_item,
+                              compiled_method, dex_to_dex_compiled, duration_ns);
+    }
   }
 
   Thread* self = Thread::Current();
@@ -2106,6 +2171,27 @@ void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t
   }
 }
 
+void CompilerDriver::RecordMethodCompilation(MethodReference ref, uint32_t access_flags,
+                                             const DexFile::CodeItem* code_item,
+                                             const CompiledMethod* compiled_method,
+                                             bool dex_to_dex_compiled, uint64_t duration_ns) {
+  MethodCompilationStats::Backend backend;
+  if ((access_flags & kAccNative) != 0) {
+    backend = (compiled_method != nullptr) ? MethodCompilationStats::kBackendJni
+                                           : MethodCompilationStats::kBackendNone;
+  } else if (compiled_method != nullptr) {
+    // The backend normally records itself, this is only a fallback.
+    backend = compiler_->IsPortable() ? MethodCompilationStats::kBackendPortable
+                                      : MethodCompilationStats::kBackendQuick;
+  } else if (dex_to_dex_compiled) {
+    backend = MethodCompilationStats::kBackendDexToDex;
+  } else {
+    backend = MethodCompilationStats::kBackendNone;
+  }
+  size_t dex_code_bytes = (code_item != nullptr) ? code_item->insns_size_in_code_units_ * 2 : 0;
+  method_stats_->RecordCompilation(ref, backend, duration_ns, dex_code_bytes, compiled_method);
+}
+
 CompiledClass* CompilerDriver::GetCompiledClass(ClassReference ref) const {
   MutexLock mu(Thread::Current(), compiled_classes_lock_);
   ClassTable::const_iterator it = compiled_classes_.find(ref);
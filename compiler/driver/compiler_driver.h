@@ -51,6 +51,7 @@ class CompilerOptions;
 class DexCompilationUnit;
 class DexFileToMethodInlinerMap;
 struct InlineIGetIPutData;
+class MethodCompilationStats;
 class OatWriter;
 class ParallelCompilationManager;
 class ScopedObjectAccess;
@@ -103,6 +104,18 @@ class CompilerDriver {
   void CompileOne(mirror::ArtMethod* method, TimingLogger* timings)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Compile a single method for the JIT. Unlike CompileOne the method's dex file is not resolved
+  // and verified first, the caller must already have recorded the method's verification results.
+  // Returns nullptr if the compiler declined the method.
+  CompiledMethod* CompileJitMethod(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Free what the JIT compilation of a method left behind once its code has been copied out: the
+  // compiled method, its verification results and, when no compiled method is left, the dedupe
+  // sets. The JIT compiles one method at a time, so nothing else uses the sets meanwhile.
+  void FreeJitCompiledMethod(Thread* self, MethodReference ref)
+      LOCKS_EXCLUDED(compiled_methods_lock_);
+
   VerificationResults* GetVerificationResults() const {
     return verification_results_;
   }
@@ -390,6 +403,16 @@ class CompilerDriver {
     return timings_logger_;
   }
 
+  // Record the cost of compiling each method into method_stats, which isn't owned. Pass nullptr
+  // to stop recording.
+  void SetMethodCompilationStats(MethodCompilationStats* method_stats) {
+    method_stats_ = method_stats;
+  }
+
+  MethodCompilationStats* GetMethodCompilationStats() const {
+    return method_stats_;
+  }
+
   class PatchInformation {
    public:
     const DexFile& GetDexFile() const {
@@ -675,6 +698,10 @@ class CompilerDriver {
                      jobject class_loader, const DexFile& dex_file,
                      DexToDexCompilationLevel dex_to_dex_compilation_level)
       LOCKS_EXCLUDED(compiled_methods_lock_);
+  void RecordMethodCompilation(MethodReference ref, uint32_t access_flags,
+                               const DexFile::CodeItem* code_item,
+                               const CompiledMethod* compiled_method, bool dex_to_dex_compiled,
+                               uint64_t duration_ns);
 
   static void CompileClass(const ParallelCompilationManager* context, size_t class_def_index)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
@@ -724,6 +751,8 @@ class CompilerDriver {
 
   CumulativeLogger* const timings_logger_;
 
+  MethodCompilationStats* method_stats_;
+
   typedef void (*CompilerCallbackFn)(CompilerDriver& driver);
   typedef MutexLock* (*CompilerMutexLockFn)(CompilerDriver& driver);
 
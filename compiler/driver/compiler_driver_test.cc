@@ -19,10 +19,12 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <memory>
+#include <sstream>
 
 #include "class_linker.h"
 #include "common_compiler_test.h"
 #include "dex_file.h"
+#include "driver/method_compilation_stats.h"
 #include "gc/heap.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/class-inl.h"
@@ -182,6 +184,29 @@ TEST_F(CompilerDriverTest, AbstractMethodErrorStub) {
   }
 }
 
+TEST_F(CompilerDriverTest, MethodCompilationStats) {
+  TEST_DISABLED_FOR_PORTABLE();
+  jobject class_loader;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    class_loader = LoadDex("AbstractMethod");
+  }
+  ASSERT_TRUE(class_loader != NULL);
+  MethodCompilationStats method_stats;
+  compiler_driver_->SetMethodCompilationStats(&method_stats);
+  CompileAll(class_loader);
+  compiler_driver_->SetMethodCompilationStats(nullptr);
+
+  // The constructors and foo methods of both classes, including the abstract one.
+  EXPECT_EQ(4U, method_stats.Size());
+  std::ostringstream os;
+  method_stats.Dump(os, MethodCompilationStats::kSortByCodeSize);
+  std::string report(os.str());
+  EXPECT_NE(report.find("\tnone\t"), std::string::npos) << report;
+  EXPECT_NE(report.find("void AbstractClass.foo()"), std::string::npos) << report;
+  EXPECT_NE(report.find("void ConcreteClass.<init>()"), std::string::npos) << report;
+}
+
 // TODO: need check-cast test (when stub complete & we can throw/catch
 
 }  // namespace art
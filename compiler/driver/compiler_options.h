@@ -61,7 +61,9 @@ class CompilerOptions {
     include_debug_symbols_(kDefaultIncludeDebugSymbols),
     implicit_null_checks_(false),
     implicit_so_checks_(false),
-    implicit_suspend_checks_(false)
+    implicit_suspend_checks_(false),
+    include_osr_entries_(false),
+    include_method_trace_hooks_(false)
 #ifdef ART_SEA_IR_MODE
     , sea_ir_mode_(false)
 #endif
@@ -96,7 +98,9 @@ class CompilerOptions {
     include_debug_symbols_(include_debug_symbols),
     implicit_null_checks_(implicit_null_checks),
     implicit_so_checks_(implicit_so_checks),
-    implicit_suspend_checks_(implicit_suspend_checks)
+    implicit_suspend_checks_(implicit_suspend_checks),
+    include_osr_entries_(false),
+    include_method_trace_hooks_(false)
 #ifdef ART_SEA_IR_MODE
     , sea_ir_mode_(sea_ir_mode)
 #endif
@@ -187,6 +191,22 @@ class CompilerOptions {
     implicit_suspend_checks_ = new_val;
   }
 
+  bool GetIncludeOsrEntries() const {
+    return include_osr_entries_;
+  }
+
+  void SetIncludeOsrEntries(bool new_val) {
+    include_osr_entries_ = new_val;
+  }
+
+  bool GetIncludeMethodTraceHooks() const {
+    return include_method_trace_hooks_;
+  }
+
+  void SetIncludeMethodTraceHooks(bool new_val) {
+    include_method_trace_hooks_ = new_val;
+  }
+
 #ifdef ART_SEA_IR_MODE
   bool GetSeaIrMode();
 #endif
@@ -214,6 +234,11 @@ class CompilerOptions {
   bool implicit_null_checks_;
   bool implicit_so_checks_;
   bool implicit_suspend_checks_;
+  // Export the native pc of loop headers so the runtime can enter the code from the interpreter.
+  bool include_osr_entries_;
+  // Report method entry and exit from compiled code while method tracing is enabled, so that
+  // tracing does not force the method into the interpreter.
+  bool include_method_trace_hooks_;
 #ifdef ART_SEA_IR_MODE
   bool sea_ir_mode_;
 #endif
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "method_compilation_stats.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+#include "base/stringprintf.h"
+#include "compiled_method.h"
+#include "dex_file.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+
+static const char* GetBackendName(MethodCompilationStats::Backend backend) {
+  switch (backend) {
+    case MethodCompilationStats::kBackendNone: return "none";
+    case MethodCompilationStats::kBackendDexToDex: return "dex-to-dex";
+    case MethodCompilationStats::kBackendJni: return "jni";
+    case MethodCompilationStats::kBackendQuick: return "quick";
+    case MethodCompilationStats::kBackendOptimizing: return "optimizing";
+    case MethodCompilationStats::kBackendPortable: return "portable";
+    case MethodCompilationStats::kBackendCount: break;
+  }
+  LOG(FATAL) << "Unexpected backend " << static_cast<int>(backend);
+  return nullptr;
+}
+
+MethodCompilationStats::MethodCompilationStats()
+    : lock_("method compilation stats lock") {
+}
+
+void MethodCompilationStats::RecordBackend(MethodReference ref, Backend backend, size_t mir_count,
+                                           size_t instruction_count) {
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = entries_.find(ref);
+  if (it == entries_.end()) {
+    it = entries_.Put(ref, Entry());
+  }
+  it->second.backend = backend;
+  it->second.mir_count = mir_count;
+  it->second.instruction_count = instruction_count;
+}
+
+void MethodCompilationStats::RecordCompilation(MethodReference ref, Backend backend,
+                                               uint64_t compile_time_ns, size_t dex_code_bytes,
+                                               const CompiledMethod* compiled_method) {
+  Entry entry;
+  entry.backend = backend;
+  entry.compile_time_ns = compile_time_ns;
+  entry.dex_code_bytes = dex_code_bytes;
+  if (compiled_method != nullptr) {
+    const std::vector<uint8_t>* code = compiled_method->GetQuickCode();
+    if (code == nullptr) {
+      code = compiled_method->GetPortableCode();
+    }
+    entry.code_bytes = (code != nullptr) ? code->size() : 0;
+    entry.mapping_table_bytes = compiled_method->GetMappingTable().size();
+    entry.vmap_table_bytes = compiled_method->GetVmapTable().size();
+    entry.gc_map_bytes = compiled_method->GetGcMap().size();
+  }
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = entries_.find(ref);
+  if (it != entries_.end()) {
+    // Keep what the backend recorded.
+    entry.backend = it->second.backend;
+    entry.mir_count = it->second.mir_count;
+    entry.instruction_count = it->second.instruction_count;
+    it->second = entry;
+  } else {
+    entries_.Put(ref, entry);
+  }
+}
+
+size_t MethodCompilationStats::Size() const {
+  MutexLock mu(Thread::Current(), lock_);
+  return entries_.size();
+}
+
+static uint64_t GetSortValue(const MethodCompilationStats::Entry& entry,
+                             MethodCompilationStats::SortKey key) {
+  return (key == MethodCompilationStats::kSortByCompileTime) ? entry.compile_time_ns
+                                                             : entry.code_bytes;
+}
+
+// Orders by descending key, then by method so that the order doesn't depend on where the dex
+// files were mapped.
+class EntryComparator {
+ public:
+  explicit EntryComparator(MethodCompilationStats::SortKey key) : key_(key) {}
+
+  bool operator()(const std::pair<MethodReference, MethodCompilationStats::Entry>& lhs,
+                  const std::pair<MethodReference, MethodCompilationStats::Entry>& rhs) const {
+    uint64_t lhs_value = GetSortValue(lhs.second, key_);
+    uint64_t rhs_value = GetSortValue(rhs.second, key_);
+    if (lhs_value != rhs_value) {
+      return lhs_value > rhs_value;
+    }
+    if (lhs.first.dex_file != rhs.first.dex_file) {
+      int cmp = lhs.first.dex_file->GetLocation().compare(rhs.first.dex_file->GetLocation());
+      if (cmp != 0) {
+        return cmp < 0;
+      }
+    }
+    return lhs.first.dex_method_index < rhs.first.dex_method_index;
+  }
+
+ private:
+  const MethodCompilationStats::SortKey key_;
+};
+
+void MethodCompilationStats::SortedEntries(SortKey key, std::vector<EntryPair>* entries) const {
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    entries->assign(entries_.begin(), entries_.end());
+  }
+  std::sort(entries->begin(), entries->end(), EntryComparator(key));
+}
+
+void MethodCompilationStats::Dump(std::ostream& os, SortKey key) const {
+  std::vector<EntryPair> entries;
+  SortedEntries(key, &entries);
+
+  size_t backend_methods[kBackendCount] = {};
+  uint64_t backend_time_ns[kBackendCount] = {};
+  size_t backend_code_bytes[kBackendCount] = {};
+  for (const EntryPair& entry : entries) {
+    backend_methods[entry.second.backend]++;
+    backend_time_ns[entry.second.backend] += entry.second.compile_time_ns;
+    backend_code_bytes[entry.second.backend] += entry.second.code_bytes;
+  }
+  os << "# " << entries.size() << " methods\n"
+     << "# backend\tmethods\tcompile_time_us\tcode_bytes\n";
+  for (size_t i = 0; i < kBackendCount; ++i) {
+    if (backend_methods[i] != 0) {
+      os << StringPrintf("# %s\t%zd\t%" PRIu64 "\t%zd\n",
+                         GetBackendName(static_cast<Backend>(i)), backend_methods[i],
+                         backend_time_ns[i] / 1000, backend_code_bytes[i]);
+    }
+  }
+
+  os << "compile_time_us\tbackend\tdex_code_bytes\tmirs\tlirs\tcode_bytes\t"
+     << "mapping_table_bytes\tvmap_table_bytes\tgc_map_bytes\tmethod\n";
+  for (const EntryPair& entry : entries) {
+    const Entry& e = entry.second;
+    os << StringPrintf("%" PRIu64 "\t%s\t%zd\t%zd\t%zd\t%zd\t%zd\t%zd\t%zd\t",
+                       e.compile_time_ns / 1000, GetBackendName(e.backend), e.dex_code_bytes,
+                       e.mir_count, e.instruction_count, e.code_bytes, e.mapping_table_bytes,
+                       e.vmap_table_bytes, e.gc_map_bytes)
+       << PrettyMethod(entry.first.dex_method_index, *entry.first.dex_file) << "\n";
+  }
+}
+
+void MethodCompilationStats::DumpTop(std::ostream& os, size_t count) const {
+  std::vector<EntryPair> entries;
+  SortedEntries(kSortByCompileTime, &entries);
+  os << "Methods with the largest compile times:\n";
+  for (size_t i = 0; i < std::min(count, entries.size()); ++i) {
+    const EntryPair& entry = entries[i];
+    os << "  " << PrettyDuration(entry.second.compile_time_ns) << " "
+       << PrettyMethod(entry.first.dex_method_index, *entry.first.dex_file) << "\n";
+  }
+  std::sort(entries.begin(), entries.end(), EntryComparator(kSortByCodeSize));
+  os << "Methods with the largest code:\n";
+  for (size_t i = 0; i < std::min(count, entries.size()); ++i) {
+    const EntryPair& entry = entries[i];
+    os << "  " << PrettySize(entry.second.code_bytes) << " "
+       << PrettyMethod(entry.first.dex_method_index, *entry.first.dex_file) << "\n";
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_DRIVER_METHOD_COMPILATION_STATS_H_
+#define ART_COMPILER_DRIVER_METHOD_COMPILATION_STATS_H_
+
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "method_reference.h"
+#include "safe_map.h"
+
+namespace art {
+
+class CompiledMethod;
+
+// Records what compiling each method cost, in compile time and in the size of what was
+// generated, so that the compiler filter thresholds can be tuned on real code. Methods are
+// recorded concurrently by the compiler threads.
+class MethodCompilationStats {
+ public:
+  enum Backend {
+    kBackendNone,       // Left to the interpreter.
+    kBackendDexToDex,   // Only quickened.
+    kBackendJni,
+    kBackendQuick,
+    kBackendOptimizing,
+    kBackendPortable,
+    kBackendCount,
+  };
+
+  enum SortKey {
+    kSortByCompileTime,
+    kSortByCodeSize,
+  };
+
+  struct Entry {
+    Entry()
+        : backend(kBackendNone),
+          compile_time_ns(0),
+          dex_code_bytes(0),
+          mir_count(0),
+          instruction_count(0),
+          code_bytes(0),
+          mapping_table_bytes(0),
+          vmap_table_bytes(0),
+          gc_map_bytes(0) {}
+
+    Backend backend;
+    uint64_t compile_time_ns;
+    size_t dex_code_bytes;
+    // MIRs after optimization, Quick only.
+    size_t mir_count;
+    // Generated target instructions (LIRs), Quick only.
+    size_t instruction_count;
+    size_t code_bytes;
+    size_t mapping_table_bytes;
+    size_t vmap_table_bytes;
+    size_t gc_map_bytes;
+  };
+
+  MethodCompilationStats();
+
+  // Record the backend that generated the code of a method and the size of its IR. Called by the
+  // backend before the compilation of the method is recorded.
+  void RecordBackend(MethodReference ref, Backend backend, size_t mir_count,
+                     size_t instruction_count) LOCKS_EXCLUDED(lock_);
+
+  // Record the compilation of a method. The backend is only used if it wasn't already recorded,
+  // compiled_method may be nullptr if no code was generated.
+  void RecordCompilation(MethodReference ref, Backend backend, uint64_t compile_time_ns,
+                         size_t dex_code_bytes, const CompiledMethod* compiled_method)
+      LOCKS_EXCLUDED(lock_);
+
+  size_t Size() const LOCKS_EXCLUDED(lock_);
+
+  // Dump a tab separated report with a line per method, sorted by descending key, preceded by
+  // a summary per backend.
+  void Dump(std::ostream& os, SortKey key) const LOCKS_EXCLUDED(lock_);
+
+  // Dump the methods with the largest compile times and code sizes.
+  void DumpTop(std::ostream& os, size_t count) const LOCKS_EXCLUDED(lock_);
+
+ private:
+  typedef SafeMap<MethodReference, Entry, MethodReferenceComparator> EntryTable;
+  typedef std::pair<MethodReference, Entry> EntryPair;
+
+  void SortedEntries(SortKey key, std::vector<EntryPair>* entries) const LOCKS_EXCLUDED(lock_);
+
+  mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  EntryTable entries_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(MethodCompilationStats);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_DRIVER_METHOD_COMPILATION_STATS_H_
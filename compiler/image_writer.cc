@@ -193,6 +193,12 @@ void ImageWriter::SetImageOffset(mirror::Object* object, size_t offset) {
       LOG(FATAL) << "Thin locked object " << obj << " found during object copy";
       break;
     }
+    case LockWord::kBiased: {
+      // Objects locked by the compiler remain biased towards it once unlocked.
+      CHECK_EQ(lw.BiasLockCount(), 0U) << "Biased locked object " << obj
+          << " found during object copy";
+      break;
+    }
     case LockWord::kUnlocked:
       // No hash, don't need to save it.
       break;
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_compiler.h"
+
+#include "base/timing_logger.h"
+#include "dex_instruction-inl.h"
+#include "handle_scope-inl.h"
+#include "instrumentation.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache.h"
+#include "runtime.h"
+#include "thread-inl.h"
+#include "verifier/method_verifier-inl.h"
+
+namespace art {
+namespace jit {
+
+extern "C" void* jit_load() {
+  VLOG(jit) << "loading jit compiler";
+  JitCompiler* const jit_compiler = JitCompiler::Create();
+  CHECK(jit_compiler != nullptr);
+  VLOG(jit) << "Done loading jit compiler";
+  return jit_compiler;
+}
+
+extern "C" void jit_unload(void* handle) {
+  DCHECK(handle != nullptr);
+  delete reinterpret_cast<JitCompiler*>(handle);
+}
+
+extern "C" bool jit_compile_method(void* handle, mirror::ArtMethod* method, Thread* self)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  JitCompiler* jit_compiler = reinterpret_cast<JitCompiler*>(handle);
+  DCHECK(jit_compiler != nullptr);
+  return jit_compiler->CompileMethod(self, method);
+}
+
+// Returns true if code_item contains instructions only the interpreter executes, such as those
+// written by the DEX-to-DEX compiler.
+static bool HasRuntimeOnlyInstructions(const DexFile::CodeItem* code_item) {
+  const uint16_t* insns = code_item->insns_;
+  uint32_t dex_pc = 0;
+  while (dex_pc < code_item->insns_size_in_code_units_) {
+    const Instruction* inst = Instruction::At(insns + dex_pc);
+    if (inst->GetVerifyIsRuntimeOnly()) {
+      return true;
+    }
+    dex_pc += inst->SizeInCodeUnits();
+  }
+  return false;
+}
+
+JitCompiler* JitCompiler::Create() {
+  return new JitCompiler();
+}
+
+JitCompiler::JitCompiler() {
+  compiler_options_.reset(new CompilerOptions());
+  // Methods only get here once they are hot, so don't let the filter skip them.
+  compiler_options_->SetCompilerFilter(CompilerOptions::kSpeed);
+  // Loops still running in the interpreter continue in the code at a loop header.
+  compiler_options_->SetIncludeOsrEntries(true);
+  cumulative_logger_.reset(new CumulativeLogger("jit times"));
+  verification_results_.reset(new VerificationResults(compiler_options_.get()));
+  method_inliner_map_.reset(new DexFileToMethodInlinerMap);
+  callbacks_.reset(new QuickCompilerCallbacks(verification_results_.get(),
+                                              method_inliner_map_.get()));
+  // Thumb2 is what dex2oat generates for ARM. The instruction set features are left at their
+  // conservative defaults.
+  InstructionSet instruction_set = kRuntimeISA == kArm ? kThumb2 : kRuntimeISA;
+  InstructionSetFeatures instruction_set_features;
+  compiler_driver_.reset(new CompilerDriver(compiler_options_.get(), verification_results_.get(),
+                                            method_inliner_map_.get(), Compiler::kQuick,
+                                            instruction_set, instruction_set_features, false,
+                                            nullptr, 1, false, false,
+                                            cumulative_logger_.get()));
+  // Code is installed directly in memory, there is no oat file to patch.
+  compiler_driver_->SetSupportBootImageFixup(false);
+}
+
+JitCompiler::~JitCompiler() {
+}
+
+bool JitCompiler::CompileMethod(Thread* self, mirror::ArtMethod* method) {
+  if (!VerifyMethod(self, method)) {
+    return false;
+  }
+  MethodReference method_ref(method->GetDexFile(), method->GetDexMethodIndex());
+  const CompiledMethod* compiled_method = compiler_driver_->CompileJitMethod(self, method);
+  // The code cache keeps its own copy of the code and tables.
+  bool success = compiled_method != nullptr && AddToCodeCache(self, method, compiled_method);
+  compiler_driver_->FreeJitCompiledMethod(self, method_ref);
+  return success;
+}
+
+bool JitCompiler::VerifyMethod(Thread* self, mirror::ArtMethod* method) {
+  const DexFile* dex_file = method->GetDexFile();
+  const DexFile::CodeItem* code_item = dex_file->GetCodeItem(method->GetCodeItemOffset());
+  if (code_item == nullptr || HasRuntimeOnlyInstructions(code_item)) {
+    return false;
+  }
+  StackHandleScope<2> hs(self);
+  mirror::Class* klass = method->GetDeclaringClass();
+  Handle<mirror::DexCache> dex_cache(hs.NewHandle(klass->GetDexCache()));
+  Handle<mirror::ClassLoader> class_loader(hs.NewHandle(klass->GetClassLoader()));
+  // Class loading is not allowed on the JIT thread. The class was verified before it was
+  // initialized, so references that don't resolve now only cause soft failures.
+  verifier::MethodVerifier verifier(dex_file, &dex_cache, &class_loader, klass->GetClassDef(),
+                                    code_item, method->GetDexMethodIndex(), method,
+                                    method->GetAccessFlags(), false, true, false);
+  if (!verifier.Verify()) {
+    return false;
+  }
+  return callbacks_->MethodVerified(&verifier);
+}
+
+bool JitCompiler::AddToCodeCache(Thread* self, mirror::ArtMethod* method,
+                                 const CompiledMethod* compiled_method) {
+  const std::vector<uint8_t>* code = compiled_method->GetQuickCode();
+  if (code == nullptr) {
+    return false;
+  }
+  JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
+  const uint8_t* gc_map = nullptr;
+  const void* entry_point = code_cache->CommitCode(self, method,
+                                                   compiled_method->GetMappingTable(),
+                                                   compiled_method->GetVmapTable(),
+                                                   compiled_method->GetGcMap(),
+                                                   compiled_method->GetFrameSizeInBytes(),
+                                                   compiled_method->GetCoreSpillMask(),
+                                                   compiled_method->GetFpSpillMask(),
+                                                   *code, compiled_method->CodeDelta(),
+                                                   &gc_map);
+  if (entry_point == nullptr) {
+    LOG(WARNING) << "JIT code cache full, not installing code for " << PrettyMethod(method);
+    return false;
+  }
+  // The gc map has to be published before any thread can enter the code. Replacing the entry
+  // point is a single pointer store, threads already running the method stay in the interpreter
+  // until a loop moves them into the code by on-stack replacement.
+  method->SetNativeGcMap(gc_map);
+  QuasiAtomic::ThreadFenceRelease();
+  Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(method, entry_point, nullptr, false);
+  return true;
+}
+
+}  // namespace jit
+}  // namespace art
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_JIT_JIT_COMPILER_H_
+#define ART_COMPILER_JIT_JIT_COMPILER_H_
+
+#include <memory>
+
+#include "base/mutex.h"
+#include "compiled_method.h"
+#include "dex/quick/dex_file_to_method_inliner_map.h"
+#include "dex/quick_compiler_callbacks.h"
+#include "dex/verification_results.h"
+#include "driver/compiler_driver.h"
+#include "driver/compiler_options.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+
+namespace jit {
+
+// The compiler half of the JIT, loaded into the runtime by jit::Jit through the jit_load,
+// jit_compile_method and jit_unload entry points. It drives the Quick backend one method at a
+// time and installs the result in the runtime's JIT code cache.
+class JitCompiler {
+ public:
+  static JitCompiler* Create();
+  ~JitCompiler();
+
+  // Verify, compile and install method. Returns false if the method can't be compiled.
+  bool CompileMethod(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  JitCompiler();
+
+  // Re-run the verifier on method to produce the verification results the Quick backend needs,
+  // class verification at runtime does not keep them.
+  bool VerifyMethod(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Copy the code into the code cache and make it the method's entry point.
+  bool AddToCodeCache(Thread* self, mirror::ArtMethod* method,
+                      const CompiledMethod* compiled_method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  std::unique_ptr<CompilerOptions> compiler_options_;
+  std::unique_ptr<CumulativeLogger> cumulative_logger_;
+  std::unique_ptr<VerificationResults> verification_results_;
+  std::unique_ptr<DexFileToMethodInlinerMap> method_inliner_map_;
+  std::unique_ptr<QuickCompilerCallbacks> callbacks_;
+  std::unique_ptr<CompilerDriver> compiler_driver_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitCompiler);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_COMPILER_JIT_JIT_COMPILER_H_
@@ -35,6 +35,7 @@
 #include "ScopedLocalRef.h"
 #include "scoped_thread_state_change.h"
 #include "thread.h"
+#include "utils.h"
 
 extern "C" JNIEXPORT jint JNICALL Java_MyClassNatives_bar(JNIEnv*, jobject, jint count) {
   return count + 1;
@@ -171,6 +172,9 @@ class JniCompilerTest : public CommonCompilerTest {
   void StackArgsIntsFirstImpl();
   void StackArgsFloatsFirstImpl();
   void StackArgsMixedImpl();
+  void FastNativeStaticIntIntMethodImpl();
+  void CriticalNativeStaticIntIntMethodImpl();
+  void CriticalNativeStaticMixedMethodImpl();
 
   JNIEnv* env_;
   jmethodID jmethod_;
@@ -1742,4 +1746,129 @@ void JniCompilerTest::StackArgsMixedImpl() {
 
 JNI_TEST(StackArgsMixed)
 
+jint Java_MyClassNatives_fastAdd(JNIEnv* env, jclass klass, jint x, jint y) {
+  // A fast native keeps its JNIEnv* and jclass but stays Runnable.
+  EXPECT_EQ(kRunnable, Thread::Current()->GetState());
+  EXPECT_EQ(Thread::Current()->GetJniEnv(), env);
+  EXPECT_TRUE(klass != nullptr);
+  return x + y;
+}
+
+void JniCompilerTest::FastNativeStaticIntIntMethodImpl() {
+  TEST_DISABLED_FOR_PORTABLE();
+  SetUpForTest(true, "fastAdd", "(II)I",
+               reinterpret_cast<void*>(&Java_MyClassNatives_fastAdd));
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::ArtMethod* method = soa.DecodeMethod(jmethod_);
+    EXPECT_TRUE(method->IsFastNative());
+    EXPECT_FALSE(method->IsCriticalNative());
+  }
+
+  jint result = env_->CallStaticIntMethod(jklass_, jmethod_, 20, 22);
+  EXPECT_EQ(42, result);
+  result = env_->CallStaticIntMethod(jklass_, jmethod_, -1, INT32_MIN);
+  EXPECT_EQ(INT32_MAX, result);
+}
+
+JNI_TEST(FastNativeStaticIntIntMethod)
+
+jint Java_MyClassNatives_criticalAdd(jint x, jint y) {
+  // A critical native gets neither JNIEnv* nor jclass and stays Runnable.
+  EXPECT_EQ(kRunnable, Thread::Current()->GetState());
+  return x + y;
+}
+
+void JniCompilerTest::CriticalNativeStaticIntIntMethodImpl() {
+  TEST_DISABLED_FOR_PORTABLE();
+  SetUpForTest(true, "criticalAdd", "(II)I",
+               reinterpret_cast<void*>(&Java_MyClassNatives_criticalAdd));
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::ArtMethod* method = soa.DecodeMethod(jmethod_);
+    EXPECT_TRUE(method->IsCriticalNative());
+    EXPECT_FALSE(method->IsFastNative());
+  }
+
+  jint result = env_->CallStaticIntMethod(jklass_, jmethod_, 20, 22);
+  EXPECT_EQ(42, result);
+  result = env_->CallStaticIntMethod(jklass_, jmethod_, -1, INT32_MIN);
+  EXPECT_EQ(INT32_MAX, result);
+}
+
+JNI_TEST(CriticalNativeStaticIntIntMethod)
+
+jdouble Java_MyClassNatives_criticalMix(jint i, jlong l, jfloat f, jdouble d) {
+  EXPECT_EQ(kRunnable, Thread::Current()->GetState());
+  EXPECT_EQ(7, i);
+  EXPECT_EQ(INT64_C(0x123456789), l);
+  EXPECT_EQ(0.5F, f);
+  EXPECT_EQ(0.25, d);
+  return i + l + f + d;
+}
+
+void JniCompilerTest::CriticalNativeStaticMixedMethodImpl() {
+  TEST_DISABLED_FOR_PORTABLE();
+  SetUpForTest(true, "criticalMix", "(IJFD)D",
+               reinterpret_cast<void*>(&Java_MyClassNatives_criticalMix));
+
+  // The long lands at an aligned register pair or stack slot without the JNIEnv* before it.
+  jdouble result = env_->CallStaticDoubleMethod(jklass_, jmethod_, 7, INT64_C(0x123456789), 0.5F,
+                                                0.25);
+  EXPECT_EQ(7 + INT64_C(0x123456789) + 0.5 + 0.25, result);
+}
+
+JNI_TEST(CriticalNativeStaticMixedMethod)
+
+static jint BenchmarkJniAdd(JNIEnv*, jclass, jint x, jint y) {
+  return x + y;
+}
+
+static jint BenchmarkCriticalAdd(jint x, jint y) {
+  return x + y;
+}
+
+// Compares the cost of a call from compiled code through the stubs of the three JNI tiers.
+TEST_F(JniCompilerTest, BenchmarkNativeTiers) {
+  TEST_DISABLED_FOR_PORTABLE();
+  static const char* const kTiers[] = { "normal", "fast", "critical" };
+  void* const native_fnptrs[] = {
+    reinterpret_cast<void*>(&BenchmarkJniAdd),
+    reinterpret_cast<void*>(&BenchmarkJniAdd),
+    reinterpret_cast<void*>(&BenchmarkCriticalAdd),
+  };
+  const jint kIterations = 1000000;
+
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    class_loader_ = LoadDex("MyClassNatives");
+  }
+  for (const char* tier : kTiers) {
+    std::string add(std::string(tier) + "Add");
+    CompileForTest(class_loader_, true, add.c_str(), "(II)I");
+    CompileForTest(class_loader_, true, (add + "Loop").c_str(), "(I)I");
+  }
+  Thread::Current()->TransitionFromSuspendedToRunnable();
+  bool started = runtime_->Start();
+  CHECK(started);
+  env_ = Thread::Current()->GetJniEnv();
+  jklass_ = env_->FindClass("MyClassNatives");
+  ASSERT_TRUE(jklass_ != nullptr);
+
+  for (size_t i = 0; i < arraysize(kTiers); ++i) {
+    std::string add(std::string(kTiers[i]) + "Add");
+    JNINativeMethod methods[] = { { add.c_str(), "(II)I", native_fnptrs[i] } };
+    ASSERT_EQ(JNI_OK, env_->RegisterNatives(jklass_, methods, 1)) << add;
+    jmethodID loop = env_->GetStaticMethodID(jklass_, (add + "Loop").c_str(), "(I)I");
+    ASSERT_TRUE(loop != nullptr) << add;
+
+    uint64_t start_ns = NanoTime();
+    jint result = env_->CallStaticIntMethod(jklass_, loop, kIterations);
+    uint64_t elapsed_ns = NanoTime() - start_ns;
+    EXPECT_EQ(kIterations, result) << add;
+    LOG(INFO) << kTiers[i] << " native: "
+              << static_cast<double>(elapsed_ns) / kIterations << "ns per call";
+  }
+}
+
 }  // namespace art
@@ -101,20 +101,25 @@ bool ManagedRuntimeCallingConvention::IsCurrentParamALong() {
 // JNI calling convention
 
 JniCallingConvention* JniCallingConvention::Create(bool is_static, bool is_synchronized,
-                                                   const char* shorty,
+                                                   bool is_critical_native, const char* shorty,
                                                    InstructionSet instruction_set) {
   switch (instruction_set) {
     case kArm:
     case kThumb2:
-      return new arm::ArmJniCallingConvention(is_static, is_synchronized, shorty);
+      return new arm::ArmJniCallingConvention(is_static, is_synchronized, is_critical_native,
+                                              shorty);
     case kArm64:
-      return new arm64::Arm64JniCallingConvention(is_static, is_synchronized, shorty);
+      return new arm64::Arm64JniCallingConvention(is_static, is_synchronized, is_critical_native,
+                                                  shorty);
     case kMips:
-      return new mips::MipsJniCallingConvention(is_static, is_synchronized, shorty);
+      return new mips::MipsJniCallingConvention(is_static, is_synchronized, is_critical_native,
+                                                shorty);
     case kX86:
-      return new x86::X86JniCallingConvention(is_static, is_synchronized, shorty);
+      return new x86::X86JniCallingConvention(is_static, is_synchronized, is_critical_native,
+                                              shorty);
     case kX86_64:
-      return new x86_64::X86_64JniCallingConvention(is_static, is_synchronized, shorty);
+      return new x86_64::X86_64JniCallingConvention(is_static, is_synchronized, is_critical_native,
+                                                    shorty);
     default:
       LOG(FATAL) << "Unknown InstructionSet: " << instruction_set;
       return NULL;
@@ -122,7 +127,8 @@ JniCallingConvention* JniCallingConvention::Create(bool is_static, bool is_synch
 }
 
 size_t JniCallingConvention::ReferenceCount() const {
-  return NumReferenceArgs() + (IsStatic() ? 1 : 0);
+  // Critical natives get no jclass.
+  return NumReferenceArgs() + ((IsStatic() && !IsCriticalNative()) ? 1 : 0);
 }
 
 FrameOffset JniCallingConvention::SavedLocalReferenceCookieOffset() const {
@@ -136,7 +142,7 @@ FrameOffset JniCallingConvention::ReturnValueSaveLocation() const {
 }
 
 bool JniCallingConvention::HasNext() {
-  if (itr_args_ <= kObjectOrClass) {
+  if (!IsCriticalNative() && itr_args_ <= kObjectOrClass) {
     return true;
   } else {
     unsigned int arg_pos = itr_args_ - NumberOfExtraArgumentsForJni();
@@ -146,7 +152,7 @@ bool JniCallingConvention::HasNext() {
 
 void JniCallingConvention::Next() {
   CHECK(HasNext());
-  if (itr_args_ > kObjectOrClass) {
+  if (IsCriticalNative() || itr_args_ > kObjectOrClass) {
     int arg_pos = itr_args_ - NumberOfExtraArgumentsForJni();
     if (IsParamALongOrDouble(arg_pos)) {
       itr_longs_and_doubles_++;
@@ -164,6 +170,9 @@ void JniCallingConvention::Next() {
 }
 
 bool JniCallingConvention::IsCurrentParamAReference() {
+  if (IsCriticalNative()) {
+    return IsParamAReference(itr_args_);
+  }
   switch (itr_args_) {
     case kJniEnv:
       return false;  // JNIEnv*
@@ -177,10 +186,13 @@ bool JniCallingConvention::IsCurrentParamAReference() {
 }
 
 bool JniCallingConvention::IsCurrentParamJniEnv() {
-  return (itr_args_ == kJniEnv);
+  return !IsCriticalNative() && (itr_args_ == kJniEnv);
 }
 
 bool JniCallingConvention::IsCurrentParamAFloatOrDouble() {
+  if (IsCriticalNative()) {
+    return IsParamAFloatOrDouble(itr_args_);
+  }
   switch (itr_args_) {
     case kJniEnv:
       return false;  // JNIEnv*
@@ -194,6 +206,9 @@ bool JniCallingConvention::IsCurrentParamAFloatOrDouble() {
 }
 
 bool JniCallingConvention::IsCurrentParamADouble() {
+  if (IsCriticalNative()) {
+    return IsParamADouble(itr_args_);
+  }
   switch (itr_args_) {
     case kJniEnv:
       return false;  // JNIEnv*
@@ -207,6 +222,9 @@ bool JniCallingConvention::IsCurrentParamADouble() {
 }
 
 bool JniCallingConvention::IsCurrentParamALong() {
+  if (IsCriticalNative()) {
+    return IsParamALong(itr_args_);
+  }
   switch (itr_args_) {
     case kJniEnv:
       return false;  // JNIEnv*
@@ -230,7 +248,7 @@ FrameOffset JniCallingConvention::CurrentParamHandleScopeEntryOffset() {
 }
 
 size_t JniCallingConvention::CurrentParamSize() {
-  if (itr_args_ <= kObjectOrClass) {
+  if (!IsCriticalNative() && itr_args_ <= kObjectOrClass) {
     return frame_pointer_size_;  // JNIEnv or jobject/jclass
   } else {
     int arg_pos = itr_args_ - NumberOfExtraArgumentsForJni();
@@ -238,9 +256,13 @@ size_t JniCallingConvention::CurrentParamSize() {
   }
 }
 
-size_t JniCallingConvention::NumberOfExtraArgumentsForJni() {
+size_t JniCallingConvention::NumberOfExtraArgumentsForJni() const {
   // The first argument is the JNIEnv*.
   // Static methods have an extra argument which is the jclass.
+  // Critical natives have neither.
+  if (IsCriticalNative()) {
+    return 0;
+  }
   return IsStatic() ? 2 : 1;
 }
 
@@ -28,6 +28,7 @@
 #include "ir_builder.h"
 #include "jni/portable/jni_compiler.h"
 #include "llvm_compilation_unit.h"
+#include "modifiers.h"
 #include "thread-inl.h"
 #include "utils_llvm.h"
 #include "verifier/method_verifier.h"
@@ -216,6 +217,8 @@ CompiledMethod* ArtLLVMJniCompileMethod(CompilerDriver* driver, uint32_t access_
                                         uint32_t method_idx, const DexFile& dex_file) {
   ClassLinker *class_linker = Runtime::Current()->GetClassLinker();
 
+  // Critical natives get the normal stub, the class linker does not mark them with portable code.
+  access_flags &= ~kAccCriticalNative;
   DexCompilationUnit dex_compilation_unit(nullptr, nullptr, class_linker, dex_file, nullptr,
                                           0, method_idx, access_flags, nullptr);
 
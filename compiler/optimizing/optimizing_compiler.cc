@@ -24,6 +24,7 @@
 #include "compiler.h"
 #include "driver/compiler_driver.h"
 #include "driver/dex_compilation_unit.h"
+#include "driver/method_compilation_stats.h"
 #include "graph_visualizer.h"
 #include "nodes.h"
 #include "register_allocator.h"
@@ -288,6 +289,11 @@ CompiledMethod* OptimizingCompiler::Compile(const DexFile::CodeItem* code_item,
   CompiledMethod* method = TryCompile(code_item, access_flags, invoke_type, class_def_idx,
                                       method_idx, class_loader, dex_file);
   if (method != nullptr) {
+    MethodCompilationStats* method_stats = GetCompilerDriver()->GetMethodCompilationStats();
+    if (method_stats != nullptr) {
+      method_stats->RecordBackend(MethodReference(&dex_file, method_idx),
+                                  MethodCompilationStats::kBackendOptimizing, 0, 0);
+    }
     return method;
   }
 
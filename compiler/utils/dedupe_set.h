@@ -60,6 +60,14 @@ class DedupeSet {
     return hashed_key.second;
   }
 
+  // Delete all keys. Pointers returned by Add must no longer be in use.
+  void Clear(Thread* self) {
+    for (HashType i = 0; i < kShard; ++i) {
+      MutexLock lock(self, *lock_[i]);
+      STLDeleteValues(&keys_[i]);
+    }
+  }
+
   explicit DedupeSet(const char* set_name) {
     for (HashType i = 0; i < kShard; ++i) {
       std::ostringstream oss;
@@ -30,6 +30,7 @@
 #include <sys/utsname.h>
 #endif
 
+#include "base/perf_counters.h"
 #include "base/stl_util.h"
 #include "base/stringpiece.h"
 #include "base/timing_logger.h"
@@ -45,6 +46,7 @@
 #include "dex/quick/dex_file_to_method_inliner_map.h"
 #include "driver/compiler_driver.h"
 #include "driver/compiler_options.h"
+#include "driver/method_compilation_stats.h"
 #include "elf_fixup.h"
 #include "elf_patcher.h"
 #include "elf_stripper.h"
@@ -207,11 +209,26 @@ static void Usage(const char* fmt, ...) {
   UsageError("");
   UsageError("  --dump-timing: display a breakdown of where time was spent");
   UsageError("");
+  UsageError("  --perf-counters: record the cycles, instructions, cache, dTLB and branch misses");
+  UsageError("      of the main thread in each timing, to be shown with --dump-timing. Skipped");
+  UsageError("      if the hardware performance counters are unavailable.");
+  UsageError("");
+  UsageError("  --dump-method-stats=<file.tsv>: write the compile time, backend, IR sizes and");
+  UsageError("      generated sizes of each method to a tab separated report. With --dump-stats,");
+  UsageError("      also log the methods with the largest compile times and code.");
+  UsageError("      Example: --dump-method-stats=/tmp/method-stats.tsv");
+  UsageError("");
+  UsageError("  --method-stats-sort=(compile-time|code-size): order of the method report.");
+  UsageError("      Default: compile-time");
+  UsageError("");
   UsageError("  --include-patch-information: Include patching information so the generated code");
   UsageError("      can have its base address moved without full recompilation.");
   UsageError("");
   UsageError("  --no-include-patch-information: Do not include patching information.");
   UsageError("");
+  UsageError("  --include-method-trace-hooks: Make the compiled code report method entry and exit");
+  UsageError("      itself, so that method tracing does not force it into the interpreter.");
+  UsageError("");
   UsageError("  --include-debug-symbols: Include ELF symbols in this oat file");
   UsageError("");
   UsageError("  --no-include-debug-symbols: Do not include ELF symbols in this oat file");
@@ -367,6 +384,7 @@ class Dex2Oat {
                                       std::unique_ptr<std::set<std::string>>& image_classes,
                                       bool dump_stats,
                                       bool dump_passes,
+                                      MethodCompilationStats* method_stats,
                                       TimingLogger& timings,
                                       CumulativeLogger& compiler_phases_timings,
                                       std::string profile_file,
@@ -406,8 +424,10 @@ class Dex2Oat {
                                                               profile_file));
 
     driver->GetCompiler()->SetBitcodeFileName(*driver.get(), bitcode_filename);
+    driver->SetMethodCompilationStats(method_stats);
 
     driver->CompileAll(class_loader, dex_files, &timings);
+    driver->SetMethodCompilationStats(nullptr);
 
     TimingLogger::ScopedTiming t2("dex2oat OatWriter", &timings);
     std::string image_file_location;
@@ -892,10 +912,15 @@ static int dex2oat(int argc, char** argv) {
   bool is_host = false;
   bool dump_stats = false;
   bool dump_timing = false;
+  bool perf_counters = false;
   bool dump_passes = false;
+  std::string method_stats_filename;
+  MethodCompilationStats::SortKey method_stats_sort_key =
+      MethodCompilationStats::kSortByCompileTime;
   bool print_pass_options = false;
   bool include_patch_information = CompilerOptions::kDefaultIncludePatchInformation;
   bool include_debug_symbols = kIsDebugBuild;
+  bool include_method_trace_hooks = false;
   bool dump_slow_timing = kIsDebugBuild;
   bool watch_dog_enabled = true;
   bool generate_gdb_information = kIsDebugBuild;
@@ -1067,10 +1092,23 @@ static int dex2oat(int argc, char** argv) {
       runtime_args.push_back(argv[i]);
     } else if (option == "--dump-timing") {
       dump_timing = true;
+    } else if (option == "--perf-counters") {
+      perf_counters = true;
     } else if (option == "--dump-passes") {
       dump_passes = true;
     } else if (option == "--dump-stats") {
       dump_stats = true;
+    } else if (option.starts_with("--dump-method-stats=")) {
+      method_stats_filename = option.substr(strlen("--dump-method-stats=")).data();
+    } else if (option.starts_with("--method-stats-sort=")) {
+      StringPiece sort_key = option.substr(strlen("--method-stats-sort=")).data();
+      if (sort_key == "compile-time") {
+        method_stats_sort_key = MethodCompilationStats::kSortByCompileTime;
+      } else if (sort_key == "code-size") {
+        method_stats_sort_key = MethodCompilationStats::kSortByCodeSize;
+      } else {
+        Usage("Unknown --method-stats-sort key %s", sort_key.data());
+      }
     } else if (option == "--include-debug-symbols" || option == "--no-strip-symbols") {
       include_debug_symbols = true;
     } else if (option == "--no-include-debug-symbols" || option == "--strip-symbols") {
@@ -1110,6 +1148,8 @@ static int dex2oat(int argc, char** argv) {
       include_patch_information = true;
     } else if (option == "--no-include-patch-information") {
       include_patch_information = false;
+    } else if (option == "--include-method-trace-hooks") {
+      include_method_trace_hooks = true;
     } else {
       Usage("Unknown argument %s", option.data());
     }
@@ -1127,6 +1167,10 @@ static int dex2oat(int argc, char** argv) {
     Usage("--oat-symbols should not be used with --oat-fd");
   }
 
+  if (include_method_trace_hooks && compiler_kind != Compiler::kQuick) {
+    Usage("--include-method-trace-hooks is only supported by the Quick compiler backend");
+  }
+
   if (!oat_symbols.empty() && is_host) {
     Usage("--oat-symbols should not be used with --host");
   }
@@ -1265,10 +1309,16 @@ static int dex2oat(int argc, char** argv) {
     case kArm:
     case kThumb2:
     case kArm64:
+      implicit_null_checks = true;
+      implicit_so_checks = true;
+      break;
+
     case kX86:
     case kX86_64:
+      // Must agree with the runtime, which only installs the suspension fault handler on x86.
       implicit_null_checks = true;
       implicit_so_checks = true;
+      implicit_suspend_checks = true;
       break;
 
     default:
@@ -1298,6 +1348,7 @@ static int dex2oat(int argc, char** argv) {
                                                                               true;
 #endif
   ));  // NOLINT(whitespace/parens)
+  compiler_options->SetIncludeMethodTraceHooks(include_method_trace_hooks);
 
   // Done with usage checks, enable watchdog if requested
   WatchDog watch_dog(watch_dog_enabled);
@@ -1324,6 +1375,9 @@ static int dex2oat(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  if (perf_counters) {
+    PerfCounters::SetEnabled(true);
+  }
   timings.StartTiming("dex2oat Setup");
   LOG(INFO) << CommandLine();
 
@@ -1483,6 +1537,14 @@ static int dex2oat(int argc, char** argv) {
   oss.str("");  // Reset.
   oss << kRuntimeISA;
   key_value_store->Put(OatHeader::kDex2OatHostKey, oss.str());
+  if (include_method_trace_hooks) {
+    key_value_store->Put(OatHeader::kMethodTraceHooksKey, "true");
+  }
+
+  std::unique_ptr<MethodCompilationStats> method_stats;
+  if (!method_stats_filename.empty()) {
+    method_stats.reset(new MethodCompilationStats());
+  }
 
   std::unique_ptr<const CompilerDriver> compiler(dex2oat->CreateOatFile(boot_image_option,
                                                                         android_root,
@@ -1495,6 +1557,7 @@ static int dex2oat(int argc, char** argv) {
                                                                         image_classes,
                                                                         dump_stats,
                                                                         dump_passes,
+                                                                        method_stats.get(),
                                                                         timings,
                                                                         compiler_phases_timings,
                                                                         profile_file,
@@ -1506,6 +1569,21 @@ static int dex2oat(int argc, char** argv) {
 
   VLOG(compiler) << "Oat file written successfully (unstripped): " << oat_location;
 
+  if (method_stats.get() != nullptr) {
+    TimingLogger::ScopedTiming t("dex2oat MethodStats", &timings);
+    std::ofstream method_stats_file(method_stats_filename.c_str());
+    method_stats->Dump(method_stats_file, method_stats_sort_key);
+    method_stats_file.close();
+    if (method_stats_file.fail()) {
+      PLOG(ERROR) << "Failed to write method stats to " << method_stats_filename;
+    }
+    if (dump_stats) {
+      std::ostringstream os;
+      method_stats->DumpTop(os, 20);
+      LOG(INFO) << os.str();
+    }
+  }
+
   // Notes on the interleaving of creating the image and oat file to
   // ensure the references between the two are correct.
   //
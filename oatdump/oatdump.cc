@@ -14,14 +14,19 @@
  * limitations under the License.
  */
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "atomic.h"
+#include "base/mutex.h"
 #include "base/stringpiece.h"
 #include "base/unix_file/fd_file.h"
 #include "class_linker.h"
@@ -102,6 +107,18 @@ static void usage() {
           "  --no-disassemble may be used to disable disassembly.\n"
           "      Example: --no-disassemble\n"
           "\n");
+  fprintf(stderr,
+          "  --threads=<n>: dump the classes of each dex file on n threads. The output is\n"
+          "      identical to a dump on a single thread.\n"
+          "      Example: --threads=8\n"
+          "      Default: 1\n"
+          "\n");
+  fprintf(stderr,
+          "  --stats-only=(json|csv): only dump the code sizes of each dex file, class and\n"
+          "      method and, with --image, the object sizes of each class, in a format\n"
+          "      suitable for comparing builds.\n"
+          "      Example: --stats-only=csv\n"
+          "\n");
   exit(EXIT_FAILURE);
 }
 
@@ -116,24 +133,135 @@ const char* image_roots_descriptions_[] = {
   "kClassRoots",
 };
 
+enum StatsFormat {
+  kStatsFormatNone,
+  kStatsFormatJson,
+  kStatsFormatCsv,
+};
+
 class OatDumperOptions {
  public:
   OatDumperOptions(bool dump_raw_mapping_table,
                    bool dump_raw_gc_map,
                    bool dump_vmap,
                    bool disassemble_code,
-                   bool absolute_addresses)
+                   bool absolute_addresses,
+                   size_t thread_count,
+                   StatsFormat stats_format)
     : dump_raw_mapping_table_(dump_raw_mapping_table),
       dump_raw_gc_map_(dump_raw_gc_map),
       dump_vmap_(dump_vmap),
       disassemble_code_(disassemble_code),
-      absolute_addresses_(absolute_addresses) {}
+      absolute_addresses_(absolute_addresses),
+      thread_count_(thread_count),
+      stats_format_(stats_format) {}
 
   const bool dump_raw_mapping_table_;
   const bool dump_raw_gc_map_;
   const bool dump_vmap_;
   const bool disassemble_code_;
   const bool absolute_addresses_;
+  const size_t thread_count_;
+  const StatsFormat stats_format_;
+};
+
+// Quote a string for a JSON document.
+static std::string JsonQuote(const std::string& s) {
+  std::string result("\"");
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      result += StringPrintf("\\u%04x", c);
+    } else {
+      result += c;
+    }
+  }
+  result += '"';
+  return result;
+}
+
+// Quote a string for a CSV field, method signatures contain commas.
+static std::string CsvQuote(const std::string& s) {
+  std::string result("\"");
+  for (char c : s) {
+    if (c == '"') {
+      result += '"';
+    }
+    result += c;
+  }
+  result += '"';
+  return result;
+}
+
+static const char kStatsCsvHeader[] =
+    "kind,dex_file,name,count,bytes,dex_code_bytes,quick_code_bytes,"
+    "gc_map_bytes,mapping_table_bytes,vmap_table_bytes\n";
+
+// Sizes of the compiled code of a method, or totals of a class or dex file. Code shared by
+// several methods through deduplication is counted for each of them.
+struct CodeSizes {
+  CodeSizes()
+      : methods(0),
+        dex_code_bytes(0),
+        quick_code_bytes(0),
+        gc_map_bytes(0),
+        mapping_table_bytes(0),
+        vmap_table_bytes(0) {}
+
+  void Add(const CodeSizes& other) {
+    methods += other.methods;
+    dex_code_bytes += other.dex_code_bytes;
+    quick_code_bytes += other.quick_code_bytes;
+    gc_map_bytes += other.gc_map_bytes;
+    mapping_table_bytes += other.mapping_table_bytes;
+    vmap_table_bytes += other.vmap_table_bytes;
+  }
+
+  void DumpJson(std::ostream& os) const {
+    os << StringPrintf("\"methods\": %zd, \"dex_code_bytes\": %zd, \"quick_code_bytes\": %zd, "
+                       "\"gc_map_bytes\": %zd, \"mapping_table_bytes\": %zd, "
+                       "\"vmap_table_bytes\": %zd",
+                       methods, dex_code_bytes, quick_code_bytes, gc_map_bytes,
+                       mapping_table_bytes, vmap_table_bytes);
+  }
+
+  // The bytes column is only filled in for dex files, with the size of the dex file.
+  void DumpCsv(std::ostream& os, const char* kind, const std::string& dex_file,
+               const std::string& name, const std::string& bytes) const {
+    os << kind << "," << CsvQuote(dex_file) << "," << CsvQuote(name) << ","
+       << StringPrintf("%zd,%s,%zd,%zd,%zd,%zd,%zd\n", methods, bytes.c_str(), dex_code_bytes,
+                       quick_code_bytes, gc_map_bytes, mapping_table_bytes, vmap_table_bytes);
+  }
+
+  size_t Bytes() const {
+    return dex_code_bytes + quick_code_bytes + gc_map_bytes + mapping_table_bytes +
+        vmap_table_bytes;
+  }
+
+  size_t methods;
+  size_t dex_code_bytes;
+  size_t quick_code_bytes;
+  size_t gc_map_bytes;
+  size_t mapping_table_bytes;
+  size_t vmap_table_bytes;
+};
+
+// A class or method row of the size statistics. Rows are sorted by name and then by size, so that
+// the output of two builds can be diffed even if classes or methods moved in the dex file.
+struct CodeSizesRow {
+  bool operator<(const CodeSizesRow& other) const {
+    if (name != other.name) {
+      return name < other.name;
+    }
+    return sizes.Bytes() < other.sizes.Bytes();
+  }
+
+  std::string name;
+  CodeSizes sizes;
+  // The formatted rows of the methods of a class.
+  std::string method_rows;
 };
 
 class OatDumper {
@@ -142,9 +270,7 @@ class OatDumper {
     : oat_file_(oat_file),
       oat_dex_files_(oat_file.GetOatDexFiles()),
       options_(options),
-      disassembler_(Disassembler::Create(oat_file_.GetOatHeader().GetInstructionSet(),
-                                         new DisassemblerOptions(options_->absolute_addresses_,
-                                                                 oat_file.Begin()))) {
+      disassembler_(CreateDisassembler()) {
     AddAllOffsets();
   }
 
@@ -251,6 +377,48 @@ class OatDumper {
     return success;
   }
 
+  // Dump the code sizes of each dex file, class and method in the format of the options, as the
+  // value of a JSON member or as CSV rows.
+  bool DumpSizeStats(std::ostream& os) {
+    bool success = true;
+    bool json = options_->stats_format_ == kStatsFormatJson;
+    if (json) {
+      os << "{\n  \"size\": " << oat_file_.Size() << ",\n  \"dex_files\": [";
+    } else {
+      os << StringPrintf("oat_file,,,1,%zd,,,,,\n", oat_file_.Size());
+    }
+    for (size_t i = 0; i < oat_dex_files_.size(); i++) {
+      const OatFile::OatDexFile* oat_dex_file = oat_dex_files_[i];
+      CHECK(oat_dex_file != nullptr);
+      if (json) {
+        os << (i == 0 ? "\n" : ",\n");
+      }
+      if (!DumpOatDexFileSizeStats(os, *oat_dex_file)) {
+        success = false;
+      }
+    }
+    if (json) {
+      os << "\n  ]\n}";
+    }
+    os << std::flush;
+    return success;
+  }
+
+  // Dump only the size statistics, as a complete JSON document or CSV table.
+  bool DumpStatsOnly(std::ostream& os) {
+    bool success;
+    if (options_->stats_format_ == kStatsFormatJson) {
+      os << "{\n\"oat_file\": ";
+      success = DumpSizeStats(os);
+      os << "\n}\n";
+    } else {
+      os << kStatsCsvHeader;
+      success = DumpSizeStats(os);
+    }
+    os << std::flush;
+    return success;
+  }
+
   size_t ComputeSize(const void* oat_data) {
     if (reinterpret_cast<const byte*>(oat_data) < oat_file_.Begin() ||
         reinterpret_cast<const byte*>(oat_data) > oat_file_.End()) {
@@ -336,6 +504,109 @@ class OatDumper {
     offsets_.insert(oat_file_.Size());
   }
 
+  bool DumpOatDexFileSizeStats(std::ostream& os, const OatFile::OatDexFile& oat_dex_file) {
+    bool json = options_->stats_format_ == kStatsFormatJson;
+    const std::string& location = oat_dex_file.GetDexFileLocation();
+    std::string error_msg;
+    std::unique_ptr<const DexFile> dex_file(oat_dex_file.OpenDexFile(&error_msg));
+    if (dex_file.get() == nullptr) {
+      LOG(WARNING) << "Failed to open dex file '" << location << "': " << error_msg;
+      if (json) {
+        os << "    {\"location\": " << JsonQuote(location) << ", \"error\": "
+           << JsonQuote(error_msg) << "}";
+      }
+      return false;
+    }
+    if (json) {
+      os << "    {\"location\": " << JsonQuote(location)
+         << StringPrintf(", \"checksum\": %u, \"size\": %zd, \"classes\": [",
+                         oat_dex_file.GetDexFileLocationChecksum(), oat_dex_file.FileSize());
+    }
+    CodeSizes dex_file_sizes;
+    std::vector<CodeSizesRow> class_rows;
+    class_rows.reserve(dex_file->NumClassDefs());
+    for (size_t class_def_index = 0;
+         class_def_index < dex_file->NumClassDefs();
+         class_def_index++) {
+      const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
+      const OatFile::OatClass oat_class = oat_dex_file.GetOatClass(class_def_index);
+      class_rows.push_back(CodeSizesRow());
+      CodeSizesRow& class_row = class_rows.back();
+      class_row.name = dex_file->GetClassDescriptor(class_def);
+      std::vector<CodeSizesRow> method_rows;
+      const byte* class_data = dex_file->GetClassData(class_def);
+      if (class_data != nullptr) {
+        ClassDataItemIterator it(*dex_file, class_data);
+        SkipAllFields(it);
+        uint32_t class_method_index = 0;
+        while (it.HasNext()) {
+          method_rows.push_back(CodeSizesRow());
+          CodeSizesRow& method_row = method_rows.back();
+          method_row.name = PrettyMethod(it.GetMemberIndex(), *dex_file, true);
+          method_row.sizes = ComputeMethodSizes(oat_class.GetOatMethod(class_method_index),
+                                                it.GetMethodCodeItem());
+          class_row.sizes.Add(method_row.sizes);
+          class_method_index++;
+          it.Next();
+        }
+      }
+      std::stable_sort(method_rows.begin(), method_rows.end());
+      std::ostringstream method_os;
+      for (size_t i = 0; i < method_rows.size(); i++) {
+        if (json) {
+          method_os << (i == 0 ? "\n" : ",\n")
+                    << "        {\"name\": " << JsonQuote(method_rows[i].name) << ", ";
+          method_rows[i].sizes.DumpJson(method_os);
+          method_os << "}";
+        } else {
+          method_rows[i].sizes.DumpCsv(method_os, "method", location, method_rows[i].name, "");
+        }
+      }
+      class_row.method_rows = method_os.str();
+      dex_file_sizes.Add(class_row.sizes);
+    }
+    std::stable_sort(class_rows.begin(), class_rows.end());
+    if (!json) {
+      dex_file_sizes.DumpCsv(os, "dex_file", location, "",
+                             StringPrintf("%zd", oat_dex_file.FileSize()));
+    }
+    for (size_t i = 0; i < class_rows.size(); i++) {
+      if (json) {
+        os << (i == 0 ? "\n" : ",\n")
+           << "      {\"descriptor\": " << JsonQuote(class_rows[i].name) << ", ";
+        class_rows[i].sizes.DumpJson(os);
+        os << ", \"methods\": [" << class_rows[i].method_rows << "]}";
+      } else {
+        class_rows[i].sizes.DumpCsv(os, "class", location, class_rows[i].name, "");
+        os << class_rows[i].method_rows;
+      }
+    }
+    if (json) {
+      os << "\n    ], ";
+      dex_file_sizes.DumpJson(os);
+      os << "}";
+    }
+    return true;
+  }
+
+  CodeSizes ComputeMethodSizes(const OatFile::OatMethod& oat_method,
+                               const DexFile::CodeItem* code_item) {
+    CodeSizes sizes;
+    sizes.methods = 1;
+    if (code_item != nullptr) {
+      sizes.dex_code_bytes = code_item->insns_size_in_code_units_ * 2;
+    }
+    // Don't read sizes from offsets past the end of a corrupt file, the dump reports those.
+    if (oat_method.GetQuickCode() != nullptr &&
+        oat_method.GetQuickCodeSizeOffset() <= oat_file_.Size()) {
+      sizes.quick_code_bytes = oat_method.GetQuickCodeSize();
+    }
+    sizes.gc_map_bytes = ComputeSize(oat_method.GetNativeGcMap());
+    sizes.mapping_table_bytes = ComputeSize(oat_method.GetMappingTable());
+    sizes.vmap_table_bytes = ComputeSize(oat_method.GetVmapTable());
+    return sizes;
+  }
+
   static uint32_t AlignCodeOffset(uint32_t maybe_thumb_offset) {
     return maybe_thumb_offset & ~0x1;  // TODO: Make this Thumb2 specific.
   }
@@ -351,6 +622,12 @@ class OatDumper {
     offsets_.insert(oat_method.GetNativeGcMapOffset());
   }
 
+  Disassembler* CreateDisassembler() {
+    return Disassembler::Create(oat_file_.GetOatHeader().GetInstructionSet(),
+                                new DisassemblerOptions(options_->absolute_addresses_,
+                                                        oat_file_.Begin()));
+  }
+
   bool DumpOatDexFile(std::ostream& os, const OatFile::OatDexFile& oat_dex_file) {
     bool success = true;
     os << "OatDexFile:\n";
@@ -366,21 +643,13 @@ class OatDumper {
       os << std::flush;
       return false;
     }
+    if (options_->thread_count_ > 1 && dex_file->NumClassDefs() > 1) {
+      return DumpOatClassDefsInParallel(os, oat_dex_file, *dex_file.get());
+    }
     for (size_t class_def_index = 0;
          class_def_index < dex_file->NumClassDefs();
          class_def_index++) {
-      const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
-      const char* descriptor = dex_file->GetClassDescriptor(class_def);
-      uint32_t oat_class_offset = oat_dex_file.GetOatClassOffset(class_def_index);
-      const OatFile::OatClass oat_class = oat_dex_file.GetOatClass(class_def_index);
-      os << StringPrintf("%zd: %s (offset=0x%08x) (type_idx=%d)",
-                         class_def_index, descriptor, oat_class_offset, class_def.class_idx_)
-         << " (" << oat_class.GetStatus() << ")"
-         << " (" << oat_class.GetType() << ")\n";
-      // TODO: include bitmap here if type is kOatClassSomeCompiled?
-      Indenter indent_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
-      std::ostream indented_os(&indent_filter);
-      if (!DumpOatClass(indented_os, oat_class, *(dex_file.get()), class_def)) {
+      if (!DumpOatClassDef(os, disassembler_, oat_dex_file, *dex_file.get(), class_def_index)) {
         success = false;
       }
     }
@@ -389,6 +658,138 @@ class OatDumper {
     return success;
   }
 
+  bool DumpOatClassDef(std::ostream& os, Disassembler* disassembler,
+                       const OatFile::OatDexFile& oat_dex_file, const DexFile& dex_file,
+                       size_t class_def_index) {
+    const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
+    const char* descriptor = dex_file.GetClassDescriptor(class_def);
+    uint32_t oat_class_offset = oat_dex_file.GetOatClassOffset(class_def_index);
+    const OatFile::OatClass oat_class = oat_dex_file.GetOatClass(class_def_index);
+    os << StringPrintf("%zd: %s (offset=0x%08x) (type_idx=%d)",
+                       class_def_index, descriptor, oat_class_offset, class_def.class_idx_)
+       << " (" << oat_class.GetStatus() << ")"
+       << " (" << oat_class.GetType() << ")\n";
+    // TODO: include bitmap here if type is kOatClassSomeCompiled?
+    Indenter indent_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
+    std::ostream indented_os(&indent_filter);
+    return DumpOatClass(indented_os, disassembler, oat_class, dex_file, class_def);
+  }
+
+  // The classes of a dex file being dumped on several threads. Workers claim classes in class
+  // def order and dump each to its own buffer. The calling thread writes the buffers out in the
+  // same order, so the output is identical to a sequential dump. Workers don't dump classes
+  // too far ahead of the writer, which bounds the memory held by buffers.
+  class ParallelDump {
+   public:
+    ParallelDump(OatDumper* dumper, const OatFile::OatDexFile& oat_dex_file,
+                 const DexFile& dex_file)
+        : dumper_(dumper),
+          oat_dex_file_(oat_dex_file),
+          dex_file_(dex_file),
+          next_class_def_index_(0),
+          lock_("oatdump parallel dump lock"),
+          cond_("oatdump parallel dump condition", lock_),
+          buffers_(dex_file.NumClassDefs(), nullptr),
+          written_(0),
+          success_(true) {}
+
+    bool Run(std::ostream& os) {
+      Thread* self = Thread::Current();
+      // Give away the mutator lock, if held, so that the writer can wait for the workers.
+      ScopedThreadStateChange tsc(self, kNative);
+      size_t class_def_count = dex_file_.NumClassDefs();
+      size_t thread_count = std::min(dumper_->options_->thread_count_, class_def_count);
+      std::vector<pthread_t> threads(thread_count);
+      for (pthread_t& thread : threads) {
+        CHECK_PTHREAD_CALL(pthread_create, (&thread, nullptr, &WorkerMain, this),
+                           "oatdump worker");
+      }
+      for (size_t i = 0; i < class_def_count; ++i) {
+        std::unique_ptr<std::string> buffer;
+        {
+          MutexLock mu(self, lock_);
+          while (buffers_[i] == nullptr) {
+            cond_.Wait(self);
+          }
+          buffer.reset(buffers_[i]);
+          buffers_[i] = nullptr;
+          written_ = i + 1;
+          cond_.Broadcast(self);
+        }
+        os << *buffer;
+      }
+      for (pthread_t& thread : threads) {
+        CHECK_PTHREAD_CALL(pthread_join, (thread, nullptr), "oatdump worker shutdown");
+      }
+      os << std::flush;
+      MutexLock mu(self, lock_);
+      return success_;
+    }
+
+   private:
+    // Bound on the number of classes dumped but not yet written out.
+    static constexpr size_t kMaxBufferedClasses = 256;
+
+    static void* WorkerMain(void* arg) {
+      ParallelDump* dump = reinterpret_cast<ParallelDump*>(arg);
+      Runtime* runtime = Runtime::Current();
+      // Attach to the runtime, if any, as the verifier dump runs managed code lookups.
+      if (runtime != nullptr) {
+        CHECK(runtime->AttachCurrentThread("oatdump worker", true, nullptr, false));
+      }
+      dump->Work(Thread::Current());
+      if (runtime != nullptr) {
+        runtime->DetachCurrentThread();
+      }
+      return nullptr;
+    }
+
+    void Work(Thread* self) {
+      // Disassemblers keep decoder state, so each worker has its own.
+      std::unique_ptr<Disassembler> disassembler(dumper_->CreateDisassembler());
+      while (true) {
+        size_t class_def_index = next_class_def_index_.FetchAndAddSequentiallyConsistent(1);
+        if (class_def_index >= dex_file_.NumClassDefs()) {
+          break;
+        }
+        {
+          MutexLock mu(self, lock_);
+          while (class_def_index >= written_ + kMaxBufferedClasses) {
+            cond_.Wait(self);
+          }
+        }
+        std::ostringstream os;
+        bool success = dumper_->DumpOatClassDef(os, disassembler.get(), oat_dex_file_,
+                                                dex_file_, class_def_index);
+        std::string* buffer = new std::string(os.str());
+        MutexLock mu(self, lock_);
+        buffers_[class_def_index] = buffer;
+        success_ = success_ && success;
+        cond_.Broadcast(self);
+      }
+    }
+
+    OatDumper* const dumper_;
+    const OatFile::OatDexFile& oat_dex_file_;
+    const DexFile& dex_file_;
+    Atomic<size_t> next_class_def_index_;
+    Mutex lock_;
+    ConditionVariable cond_ GUARDED_BY(lock_);
+    // The dumped classes not yet written out, indexed by class def index.
+    std::vector<std::string*> buffers_ GUARDED_BY(lock_);
+    // Number of classes written out.
+    size_t written_ GUARDED_BY(lock_);
+    bool success_ GUARDED_BY(lock_);
+
+    DISALLOW_COPY_AND_ASSIGN(ParallelDump);
+  };
+
+  bool DumpOatClassDefsInParallel(std::ostream& os, const OatFile::OatDexFile& oat_dex_file,
+                                  const DexFile& dex_file) {
+    ParallelDump parallel_dump(this, oat_dex_file, dex_file);
+    return parallel_dump.Run(os);
+  }
+
   static void SkipAllFields(ClassDataItemIterator& it) {
     while (it.HasNextStaticField()) {
       it.Next();
@@ -398,7 +799,8 @@ class OatDumper {
     }
   }
 
-  bool DumpOatClass(std::ostream& os, const OatFile::OatClass& oat_class, const DexFile& dex_file,
+  bool DumpOatClass(std::ostream& os, Disassembler* disassembler,
+                    const OatFile::OatClass& oat_class, const DexFile& dex_file,
                     const DexFile::ClassDef& class_def) {
     bool success = true;
     const byte* class_data = dex_file.GetClassData(class_def);
@@ -410,7 +812,7 @@ class OatDumper {
     SkipAllFields(it);
     uint32_t class_method_index = 0;
     while (it.HasNextDirectMethod()) {
-      if (!DumpOatMethod(os, class_def, class_method_index, oat_class, dex_file,
+      if (!DumpOatMethod(os, disassembler, class_def, class_method_index, oat_class, dex_file,
                          it.GetMemberIndex(), it.GetMethodCodeItem(),
                          it.GetRawMemberAccessFlags())) {
         success = false;
@@ -419,7 +821,7 @@ class OatDumper {
       it.Next();
     }
     while (it.HasNextVirtualMethod()) {
-      if (!DumpOatMethod(os, class_def, class_method_index, oat_class, dex_file,
+      if (!DumpOatMethod(os, disassembler, class_def, class_method_index, oat_class, dex_file,
                          it.GetMemberIndex(), it.GetMethodCodeItem(),
                          it.GetRawMemberAccessFlags())) {
         success = false;
@@ -437,8 +839,8 @@ class OatDumper {
   // When this was picked, the largest arm method was 55,256 bytes and arm64 was 50,412 bytes.
   static constexpr uint32_t kMaxCodeSize = 100 * 1000;
 
-  bool DumpOatMethod(std::ostream& os, const DexFile::ClassDef& class_def,
-                     uint32_t class_method_index,
+  bool DumpOatMethod(std::ostream& os, Disassembler* disassembler,
+                     const DexFile::ClassDef& class_def, uint32_t class_method_index,
                      const OatFile::OatClass& oat_class, const DexFile& dex_file,
                      uint32_t dex_method_idx, const DexFile::CodeItem* code_item,
                      uint32_t method_access_flags) {
@@ -616,7 +1018,8 @@ class OatDumper {
           success = false;
           if (options_->disassemble_code_) {
             if (code_size_offset + kPrologueBytes <= oat_file_.Size()) {
-              DumpCode(*indent2_os, verifier.get(), oat_method, code_item, true, kPrologueBytes);
+              DumpCode(*indent2_os, disassembler, verifier.get(), oat_method, code_item, true,
+                       kPrologueBytes);
             }
           }
         } else if (code_size > kMaxCodeSize) {
@@ -628,11 +1031,12 @@ class OatDumper {
           success = false;
           if (options_->disassemble_code_) {
             if (code_size_offset + kPrologueBytes <= oat_file_.Size()) {
-              DumpCode(*indent2_os, verifier.get(), oat_method, code_item, true, kPrologueBytes);
+              DumpCode(*indent2_os, disassembler, verifier.get(), oat_method, code_item, true,
+                       kPrologueBytes);
             }
           }
         } else if (options_->disassemble_code_) {
-          DumpCode(*indent2_os, verifier.get(), oat_method, code_item, !success, 0);
+          DumpCode(*indent2_os, disassembler, verifier.get(), oat_method, code_item, !success, 0);
         }
       }
     }
@@ -910,7 +1314,7 @@ class OatDumper {
     return nullptr;
   }
 
-  void DumpCode(std::ostream& os, verifier::MethodVerifier* verifier,
+  void DumpCode(std::ostream& os, Disassembler* disassembler, verifier::MethodVerifier* verifier,
                 const OatFile::OatMethod& oat_method, const DexFile::CodeItem* code_item,
                 bool bad_input, size_t code_size) {
     const void* portable_code = oat_method.GetPortableCode();
@@ -929,7 +1333,7 @@ class OatDumper {
         if (!bad_input) {
           DumpMappingAtOffset(os, oat_method, offset, false);
         }
-        offset += disassembler_->Dump(os, quick_native_pc + offset);
+        offset += disassembler->Dump(os, quick_native_pc + offset);
         if (!bad_input) {
           uint32_t dex_pc = DumpMappingAtOffset(os, oat_method, offset, true);
           if (dex_pc != DexFile::kDexNoIndex) {
@@ -960,9 +1364,13 @@ class ImageDumper {
       : os_(os),
         image_space_(image_space),
         image_header_(image_header),
+        stats_format_(oat_dumper_options->stats_format_),
         oat_dumper_options_(oat_dumper_options) {}
 
   bool Dump() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (stats_format_ != kStatsFormatNone) {
+      return DumpStatsOnly();
+    }
     std::ostream& os = *os_;
     os << "MAGIC: " << image_header_.GetMagic() << "\n\n";
 
@@ -1057,23 +1465,7 @@ class ImageDumper {
     gc::Heap* heap = Runtime::Current()->GetHeap();
     const std::vector<gc::space::ContinuousSpace*>& spaces = heap->GetContinuousSpaces();
     Thread* self = Thread::Current();
-    {
-      {
-        WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
-        heap->FlushAllocStack();
-      }
-      // Since FlushAllocStack() above resets the (active) allocation
-      // stack. Need to revoke the thread-local allocation stacks that
-      // point into it.
-      {
-        self->TransitionFromRunnableToSuspended(kNative);
-        ThreadList* thread_list = Runtime::Current()->GetThreadList();
-        thread_list->SuspendAll();
-        heap->RevokeAllThreadLocalAllocationStacks(self);
-        thread_list->ResumeAll();
-        self->TransitionFromSuspendedToRunnable();
-      }
-    }
+    FlushAllocationStacks(self);
     {
       std::ostream* saved_os = os_;
       Indenter indent_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
@@ -1115,6 +1507,108 @@ class ImageDumper {
   }
 
  private:
+  void FlushAllocationStacks(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    gc::Heap* heap = Runtime::Current()->GetHeap();
+    {
+      WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+      heap->FlushAllocStack();
+    }
+    // Since FlushAllocStack() above resets the (active) allocation
+    // stack. Need to revoke the thread-local allocation stacks that
+    // point into it.
+    {
+      self->TransitionFromRunnableToSuspended(kNative);
+      ThreadList* thread_list = Runtime::Current()->GetThreadList();
+      thread_list->SuspendAll();
+      heap->RevokeAllThreadLocalAllocationStacks(self);
+      thread_list->ResumeAll();
+      self->TransitionFromSuspendedToRunnable();
+    }
+  }
+
+  // Dump the object sizes of each class in the image and the code sizes of its oat file, without
+  // the objects and code themselves.
+  bool DumpStatsOnly() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    std::ostream& os = *os_;
+    std::string image_filename = image_space_.GetImageFilename();
+    std::string oat_location = ImageHeader::GetOatLocationFromImageLocation(image_filename);
+    ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+    const OatFile* oat_file = class_linker->FindOpenedOatFileFromOatLocation(oat_location);
+    if (oat_file == nullptr) {
+      std::string error_msg;
+      oat_file = OatFile::Open(oat_location, oat_location, nullptr, false, &error_msg);
+      if (oat_file == nullptr) {
+        LOG(ERROR) << "Failed to open oat file '" << oat_location << "': " << error_msg;
+        return false;
+      }
+    }
+    oat_dumper_.reset(new OatDumper(*oat_file, oat_dumper_options_.release()));
+
+    Thread* self = Thread::Current();
+    FlushAllocationStacks(self);
+    {
+      ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+      for (const auto& space : Runtime::Current()->GetHeap()->GetContinuousSpaces()) {
+        if (space->IsImageSpace()) {
+          space->AsImageSpace()->GetLiveBitmap()->Walk(ImageDumper::StatsCallback, this);
+        }
+      }
+    }
+
+    size_t object_count = 0;
+    for (const auto& sizes_and_count : stats_.sizes_and_counts) {
+      object_count += sizes_and_count.second.count;
+    }
+    bool json = stats_format_ == kStatsFormatJson;
+    if (json) {
+      os << "{\n\"image\": {\n  \"location\": " << JsonQuote(image_filename)
+         << StringPrintf(",\n  \"objects\": %zd, \"object_bytes\": %zd,\n  \"classes\": [",
+                         object_count, stats_.object_bytes);
+    } else {
+      os << kStatsCsvHeader
+         << StringPrintf("image,,%s,%zd,%zd,,,,,\n", CsvQuote(image_filename).c_str(),
+                         object_count, stats_.object_bytes);
+    }
+    bool first = true;
+    for (const auto& sizes_and_count : stats_.sizes_and_counts) {
+      const std::string& descriptor(sizes_and_count.first);
+      if (json) {
+        os << (first ? "\n" : ",\n") << "    {\"descriptor\": " << JsonQuote(descriptor)
+           << StringPrintf(", \"instances\": %zd, \"bytes\": %zd}",
+                           sizes_and_count.second.count, sizes_and_count.second.bytes);
+      } else {
+        os << "object,," << CsvQuote(descriptor)
+           << StringPrintf(",%zd,%zd,,,,,\n",
+                           sizes_and_count.second.count, sizes_and_count.second.bytes);
+      }
+      first = false;
+    }
+    bool success;
+    if (json) {
+      os << "\n  ]\n},\n\"oat_file\": ";
+      success = oat_dumper_->DumpSizeStats(os);
+      os << "\n}\n";
+    } else {
+      success = oat_dumper_->DumpSizeStats(os);
+    }
+    os << std::flush;
+    return success;
+  }
+
+  static void StatsCallback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    DCHECK(obj != nullptr);
+    DCHECK(arg != nullptr);
+    ImageDumper* state = reinterpret_cast<ImageDumper*>(arg);
+    if (!state->InDumpSpace(obj)) {
+      return;
+    }
+    size_t object_bytes = obj->SizeOf();
+    state->stats_.object_bytes += object_bytes;
+    std::string temp;
+    state->stats_.Update(obj->GetClass()->GetDescriptor(&temp), object_bytes);
+  }
+
   static void PrettyObjectValue(std::ostream& os, mirror::Class* type, mirror::Object* value)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     CHECK(type != nullptr);
@@ -1667,6 +2161,7 @@ class ImageDumper {
   std::ostream* os_;
   gc::space::ImageSpace& image_space_;
   const ImageHeader& image_header_;
+  const StatsFormat stats_format_;
   std::unique_ptr<OatDumper> oat_dumper_;
   std::unique_ptr<OatDumperOptions> oat_dumper_options_;
 
@@ -1696,6 +2191,8 @@ static int oatdump(int argc, char** argv) {
   bool dump_raw_gc_map = false;
   bool dump_vmap = true;
   bool disassemble_code = true;
+  size_t thread_count = 1;
+  StatsFormat stats_format = kStatsFormatNone;
 
   for (int i = 0; i < argc; i++) {
     const StringPiece option(argv[i]);
@@ -1726,6 +2223,23 @@ static int oatdump(int argc, char** argv) {
       dump_vmap = false;
     } else if (option == "--no-disassemble") {
       disassemble_code = false;
+    } else if (option.starts_with("--threads=")) {
+      const char* threads_str = option.substr(strlen("--threads=")).data();
+      if (!ParseUint(threads_str, &thread_count) || thread_count == 0) {
+        fprintf(stderr, "Failed to parse --threads argument '%s' as a positive integer\n",
+                threads_str);
+        usage();
+      }
+    } else if (option.starts_with("--stats-only=")) {
+      StringPiece stats_format_str = option.substr(strlen("--stats-only=")).data();
+      if (stats_format_str == "json") {
+        stats_format = kStatsFormatJson;
+      } else if (stats_format_str == "csv") {
+        stats_format = kStatsFormatCsv;
+      } else {
+        fprintf(stderr, "Unknown --stats-only format %s\n", stats_format_str.data());
+        usage();
+      }
     } else if (option.starts_with("--output=")) {
       const char* filename = option.substr(strlen("--output=")).data();
       out.reset(new std::ofstream(filename));
@@ -1756,7 +2270,9 @@ static int oatdump(int argc, char** argv) {
                                                                             dump_raw_gc_map,
                                                                             dump_vmap,
                                                                             disassemble_code,
-                                                                            absolute_addresses));
+                                                                            absolute_addresses,
+                                                                            thread_count,
+                                                                            stats_format));
   MemMap::Init();
   if (oat_filename != nullptr) {
     std::string error_msg;
@@ -1767,7 +2283,8 @@ static int oatdump(int argc, char** argv) {
       return EXIT_FAILURE;
     }
     OatDumper oat_dumper(*oat_file, oat_dumper_options.release());
-    bool success = oat_dumper.Dump(*os);
+    bool success = (stats_format != kStatsFormatNone) ? oat_dumper.DumpStatsOnly(*os)
+                                                       : oat_dumper.Dump(*os);
     return (success) ? EXIT_SUCCESS : EXIT_FAILURE;
   }
 
@@ -26,6 +26,7 @@ LIBART_COMMON_SRC_FILES := \
   base/hex_dump.cc \
   base/logging.cc \
   base/mutex.cc \
+  base/perf_counters.cc \
   base/scoped_flock.cc \
   base/stringpiece.cc \
   base/stringprintf.cc \
@@ -38,6 +39,7 @@ LIBART_COMMON_SRC_FILES := \
   check_jni.cc \
   class_linker.cc \
   common_throws.cc \
+  cpu_sampling_profiler.cc \
   debugger.cc \
   dex_file.cc \
   dex_file_verifier.cc \
@@ -60,6 +62,7 @@ LIBART_COMMON_SRC_FILES := \
   gc/collector/semi_space.cc \
   gc/collector/sticky_mark_sweep.cc \
   gc/gc_cause.cc \
+  gc/gc_telemetry.cc \
   gc/heap.cc \
   gc/reference_processor.cc \
   gc/reference_queue.cc \
@@ -74,12 +77,14 @@ LIBART_COMMON_SRC_FILES := \
   hprof/hprof.cc \
   image.cc \
   indirect_reference_table.cc \
+  inline_cache.cc \
   instruction_set.cc \
   instrumentation.cc \
   intern_table.cc \
   interpreter/interpreter.cc \
   interpreter/interpreter_common.cc \
   interpreter/interpreter_switch_impl.cc \
+  interpreter/mterp/mterp.cc \
   jdwp/jdwp_event.cc \
   jdwp/jdwp_expand_buf.cc \
   jdwp/jdwp_handler.cc \
@@ -87,8 +92,11 @@ LIBART_COMMON_SRC_FILES := \
   jdwp/jdwp_request.cc \
   jdwp/jdwp_socket.cc \
   jdwp/object_registry.cc \
+  jit/jit.cc \
+  jit/jit_code_cache.cc \
   jni_internal.cc \
   jobject_comparator.cc \
+  lock_contention_profiler.cc \
   mem_map.cc \
   memory_region.cc \
   method_helper.cc \
@@ -137,6 +145,7 @@ LIBART_COMMON_SRC_FILES := \
   parsed_options.cc \
   primitive.cc \
   quick_exception_handler.cc \
+  quickened_code_table.cc \
   quick/inline_method_analyser.cc \
   reference_table.cc \
   reflection.cc \
@@ -243,7 +252,8 @@ LIBART_SRC_FILES_x86 := \
   arch/x86/portable_entrypoints_x86.S \
   arch/x86/quick_entrypoints_x86.S \
   arch/x86/thread_x86.cc \
-  arch/x86/fault_handler_x86.cc
+  arch/x86/fault_handler_x86.cc \
+  interpreter/mterp/out/mterp_x86.S
 
 LIBART_TARGET_SRC_FILES_x86 := \
   $(LIBART_SRC_FILES_x86)
@@ -259,7 +269,8 @@ LIBART_SRC_FILES_x86_64 := \
   arch/x86_64/quick_entrypoints_x86_64.S \
   arch/x86_64/thread_x86_64.cc \
   monitor_pool.cc \
-  arch/x86/fault_handler_x86.cc
+  arch/x86/fault_handler_x86.cc \
+  interpreter/mterp/out/mterp_x86_64.S
 
 LIBART_TARGET_SRC_FILES_x86_64 := \
   $(LIBART_SRC_FILES_x86_64) \
@@ -303,6 +314,7 @@ LIBART_ENUM_OPERATOR_OUT_HEADER_FILES := \
   gc/heap.h \
   indirect_reference_table.h \
   instruction_set.h \
+  interpreter/interpreter.h \
   invoke_type.h \
   jdwp/jdwp.h \
   jdwp/jdwp_constants.h \
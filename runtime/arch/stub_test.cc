@@ -619,8 +619,8 @@ TEST_F(StubTest, LockObject) {
 
   LockWord lock_after = obj->GetLockWord(false);
   LockWord::LockState new_state = lock_after.GetState();
-  EXPECT_EQ(LockWord::LockState::kThinLocked, new_state);
-  EXPECT_EQ(lock_after.ThinLockCount(), 0U);  // Thin lock starts count at zero
+  EXPECT_EQ(LockWord::LockState::kBiased, new_state);
+  EXPECT_EQ(lock_after.BiasLockCount(), 1U);  // Biased lock counts the holds
 
   for (size_t i = 1; i < kThinLockLoops; ++i) {
     Invoke3(reinterpret_cast<size_t>(obj.Get()), 0U, 0U, art_quick_lock_object, self);
@@ -629,8 +629,8 @@ TEST_F(StubTest, LockObject) {
 
     LockWord l_inc = obj->GetLockWord(false);
     LockWord::LockState l_inc_state = l_inc.GetState();
-    EXPECT_EQ(LockWord::LockState::kThinLocked, l_inc_state);
-    EXPECT_EQ(l_inc.ThinLockCount(), i);
+    EXPECT_EQ(LockWord::LockState::kBiased, l_inc_state);
+    EXPECT_EQ(l_inc.BiasLockCount(), i + 1);
   }
 
   // Force a fat lock by running identity hashcode to fill up lock word.
@@ -701,13 +701,21 @@ static void TestUnlockObject(StubTest* test) NO_THREAD_SAFETY_ANALYSIS {
 
   LockWord lock_after2 = obj->GetLockWord(false);
   LockWord::LockState new_state2 = lock_after2.GetState();
-  EXPECT_EQ(LockWord::LockState::kThinLocked, new_state2);
+  EXPECT_EQ(LockWord::LockState::kBiased, new_state2);
 
   test->Invoke3(reinterpret_cast<size_t>(obj.Get()), 0U, 0U, art_quick_unlock_object, self);
 
+  // The lock stays biased towards us once released.
   LockWord lock_after3 = obj->GetLockWord(false);
   LockWord::LockState new_state3 = lock_after3.GetState();
-  EXPECT_EQ(LockWord::LockState::kUnlocked, new_state3);
+  EXPECT_EQ(LockWord::LockState::kBiased, new_state3);
+  EXPECT_EQ(lock_after3.BiasLockCount(), 0U);
+
+  // Unlocking a biased lock we don't hold is an illegal monitor state too.
+  test->Invoke3(reinterpret_cast<size_t>(obj.Get()), 0U, 0U, art_quick_unlock_object, self);
+  EXPECT_TRUE(self->IsExceptionPending());
+  self->ClearException();
+  EXPECT_EQ(lock_after3.GetValue(), obj->GetLockWord(false).GetValue());
 
   // Stress test:
   // Keep a number of objects and their locks in flight. Randomly lock or unlock one of them in
@@ -741,7 +749,9 @@ static void TestUnlockObject(StubTest* test) NO_THREAD_SAFETY_ANALYSIS {
       LockWord lock_iter = objects[index]->GetLockWord(false);
       LockWord::LockState iter_state = lock_iter.GetState();
       if (counts[index] == 0) {
-        EXPECT_EQ(LockWord::LockState::kHashCode, iter_state);
+        // Never locked objects store the hash in the lock word, revoking a bias inflates.
+        EXPECT_TRUE(iter_state == LockWord::LockState::kHashCode ||
+                    iter_state == LockWord::LockState::kFatLocked);
       } else {
         EXPECT_EQ(LockWord::LockState::kFatLocked, iter_state);
       }
@@ -778,10 +788,11 @@ static void TestUnlockObject(StubTest* test) NO_THREAD_SAFETY_ANALYSIS {
         EXPECT_EQ(counts[index], info.entry_count_) << index;
       } else {
         if (counts[index] > 0) {
-          EXPECT_EQ(LockWord::LockState::kThinLocked, iter_state);
-          EXPECT_EQ(counts[index] - 1, lock_iter.ThinLockCount());
+          EXPECT_EQ(LockWord::LockState::kBiased, iter_state);
+          EXPECT_EQ(counts[index], lock_iter.BiasLockCount());
         } else {
-          EXPECT_EQ(LockWord::LockState::kUnlocked, iter_state);
+          EXPECT_EQ(LockWord::LockState::kBiased, iter_state);
+          EXPECT_EQ(0U, lock_iter.BiasLockCount());
         }
       }
     }
@@ -19,6 +19,8 @@
 
 #include "asm_support.h"
 
+// Offset of field Thread::tls32_.state_and_flags verified in InitCpu
+#define THREAD_FLAGS_OFFSET 0
 // Offset of field Thread::self_ verified in InitCpu
 #define THREAD_SELF_OFFSET 156
 // Offset of field Thread::card_table_ verified in InitCpu
@@ -116,6 +116,8 @@ extern "C" void art_quick_invoke_virtual_trampoline_with_access_check(uint32_t,
 
 // Thread entrypoints.
 extern "C" void art_quick_test_suspend();
+extern "C" void art_quick_method_entry_hook(mirror::ArtMethod*);
+extern "C" void art_quick_method_exit_hook(mirror::ArtMethod*);
 
 // Throw entrypoints.
 extern "C" void art_quick_deliver_exception(void*);
@@ -247,6 +249,8 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
 
   // Thread
   qpoints->pTestSuspend = art_quick_test_suspend;
+  qpoints->pMethodEntryHook = art_quick_method_entry_hook;
+  qpoints->pMethodExitHook = art_quick_method_exit_hook;
 
   // Throws
   qpoints->pDeliverException = art_quick_deliver_exception;
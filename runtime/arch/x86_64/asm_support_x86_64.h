@@ -27,6 +27,8 @@
 // Offset of field Runtime::callee_save_methods_[kRefsAndArgs]
 #define RUNTIME_REF_AND_ARGS_CALLEE_SAVE_FRAME_OFFSET 16
 
+// Offset of field Thread::tls32_.state_and_flags verified in InitCpu
+#define THREAD_FLAGS_OFFSET 0
 // Offset of field Thread::self_ verified in InitCpu
 #define THREAD_SELF_OFFSET 192
 // Offset of field Thread::card_table_ verified in InitCpu
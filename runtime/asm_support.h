@@ -23,18 +23,52 @@
 // check.
 #define SUSPEND_CHECK_INTERVAL (1000)
 
+// Offsets within jit::OsrEntryState, the argument of art_quick_osr_stub on 32-bit targets.
+#define OSR_ENTRY_NATIVE_PC_OFFSET 0
+#define OSR_ENTRY_FRAME_SIZE_OFFSET 4
+#define OSR_ENTRY_SELF_OFFSET 8
+#define OSR_ENTRY_SP_SPILL_OFFSET 12
+#define OSR_ENTRY_SHORTY_OFFSET 16
+#define OSR_ENTRY_CORE_REGISTERS_OFFSET 20
+#define OSR_ENTRY_FP_REGISTERS_OFFSET 84
+
+// Offsets within ShadowFrame.
+#define SHADOWFRAME_NUMBER_OF_VREGS_OFFSET 0
+#if defined(__LP64__)
+#define SHADOWFRAME_METHOD_OFFSET 16
+#define SHADOWFRAME_DEX_PC_OFFSET 24
+#define SHADOWFRAME_VREGS_OFFSET 28
+#else
+#define SHADOWFRAME_METHOD_OFFSET 8
+#define SHADOWFRAME_DEX_PC_OFFSET 12
+#define SHADOWFRAME_VREGS_OFFSET 16
+#endif
+
+// Values returned to the assembly interpreter by its helpers, see interpreter/mterp/mterp.h.
+#define MTERP_STATUS_EXCEPTION 0
+#define MTERP_STATUS_CONTINUE 1
+#define MTERP_STATUS_SWITCH_INTERPRETERS 2
+#define MTERP_STATUS_RETURNED 3
+
 // Offsets within java.lang.Object.
 #define CLASS_OFFSET 0
 #define LOCK_WORD_OFFSET 4
 
+// Runtime access flags of java.lang.Class, see modifiers.h.
+#define ACCESS_FLAGS_CLASS_IS_BIAS_DISABLED 0x40000000
+
 #if !defined(USE_BAKER_OR_BROOKS_READ_BARRIER)
 
 // Offsets within java.lang.Class.
 #define CLASS_COMPONENT_TYPE_OFFSET 12
+#define CLASS_ACCESS_FLAGS_OFFSET 60
 
 // Array offsets.
 #define ARRAY_LENGTH_OFFSET 8
 #define OBJECT_ARRAY_DATA_OFFSET 12
+// Arrays of components smaller than an int start at the same offset.
+#define INT_ARRAY_DATA_OFFSET 12
+#define LONG_ARRAY_DATA_OFFSET 16
 
 // Offsets within java.lang.String.
 #define STRING_VALUE_OFFSET 8
@@ -56,10 +90,14 @@
 
 // Offsets within java.lang.Class.
 #define CLASS_COMPONENT_TYPE_OFFSET 20
+#define CLASS_ACCESS_FLAGS_OFFSET 68
 
 // Array offsets.
 #define ARRAY_LENGTH_OFFSET 16
 #define OBJECT_ARRAY_DATA_OFFSET 20
+// Arrays of components smaller than an int start at the same offset.
+#define INT_ARRAY_DATA_OFFSET 20
+#define LONG_ARRAY_DATA_OFFSET 24
 
 // Offsets within java.lang.String.
 #define STRING_VALUE_OFFSET 16
@@ -21,6 +21,7 @@
 
 #include "atomic.h"
 #include "base/logging.h"
+#include "lock_contention_profiler.h"
 #include "mutex-inl.h"
 #include "runtime.h"
 #include "scoped_thread_state_change.h"
@@ -310,6 +311,8 @@ void Mutex::ExclusiveLock(Thread* self) {
   if (!recursive_ || !IsExclusiveHeld(self)) {
 #if ART_USE_FUTEXES
     bool done = false;
+    uint64_t contention_start_ns = 0;
+    uint64_t contention_owner_tid = 0;
     do {
       int32_t cur_state = state_.LoadRelaxed();
       if (LIKELY(cur_state == 0)) {
@@ -318,6 +321,11 @@ void Mutex::ExclusiveLock(Thread* self) {
       } else {
         // Failed to acquire, hang up.
         ScopedContentionRecorder scr(this, SafeGetTid(self), GetExclusiveOwnerTid());
+        if (UNLIKELY(LockContentionProfiler::IsEnabled()) && contention_start_ns == 0) {
+          LockContentionProfiler::BeginMutexContention(self);
+          contention_start_ns = NanoTime();
+          contention_owner_tid = GetExclusiveOwnerTid();
+        }
         num_contenders_++;
         if (futex(state_.Address(), FUTEX_WAIT, 1, NULL, NULL, 0) != 0) {
           // EAGAIN and EINTR both indicate a spurious failure, try again from the beginning.
@@ -330,6 +338,10 @@ void Mutex::ExclusiveLock(Thread* self) {
       }
     } while (!done);
     DCHECK_EQ(state_.LoadRelaxed(), 1);
+    if (UNLIKELY(contention_start_ns != 0)) {
+      LockContentionProfiler::RecordMutexContention(self, this, contention_owner_tid,
+                                                    NanoTime() - contention_start_ns);
+    }
 #else
     CHECK_MUTEX_CALL(pthread_mutex_lock, (&mutex_));
 #endif
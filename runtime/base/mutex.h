@@ -76,6 +76,7 @@ enum LockLevel {
   kTransactionLogLock,
   kInternTableLock,
   kOatFileSecondaryLookupLock,
+  kJitCodeCacheLock,
   kDefaultMutexLevel,
   kMarkSweepLargeObjectLock,
   kPinTableLock,
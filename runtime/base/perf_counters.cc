@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "perf_counters.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "utils.h"
+
+namespace art {
+
+bool PerfCounters::enabled_ = false;
+
+void PerfCounterValues::DumpRates(std::ostream& os) const {
+  const char* separator = "";
+  if (IsAvailable(kCycles) && IsAvailable(kInstructions) && values[kCycles] != 0) {
+    os << StringPrintf("IPC %.2f", static_cast<double>(values[kInstructions]) / values[kCycles]);
+    separator = ", ";
+  }
+  if (!IsAvailable(kInstructions) || values[kInstructions] == 0) {
+    return;
+  }
+  // Misses per thousand instructions.
+  const double kilo_instructions = values[kInstructions] / 1000.0;
+  for (size_t i = kCacheMisses; i < kCounterCount; ++i) {
+    Counter counter = static_cast<Counter>(i);
+    if (IsAvailable(counter)) {
+      os << separator << PerfCounters::GetName(counter)
+         << StringPrintf(" %.2f/ki", values[i] / kilo_instructions);
+      separator = ", ";
+    }
+  }
+}
+
+const char* PerfCounters::GetName(PerfCounterValues::Counter counter) {
+  switch (counter) {
+    case PerfCounterValues::kCycles: return "cycles";
+    case PerfCounterValues::kInstructions: return "instructions";
+    case PerfCounterValues::kCacheMisses: return "cache-misses";
+    case PerfCounterValues::kDTlbMisses: return "dtlb-misses";
+    case PerfCounterValues::kBranchMisses: return "branch-misses";
+    case PerfCounterValues::kCounterCount: break;
+  }
+  LOG(FATAL) << "Unexpected counter " << static_cast<int>(counter);
+  return nullptr;
+}
+
+void PerfCounters::SetEnabled(bool enabled) {
+  if (enabled && !enabled_) {
+    // Say once what is missing rather than on every thread that opens the counters.
+    PerfCounters probe;
+    if (!probe.IsOpen()) {
+      LOG(WARNING) << "Hardware performance counters are unavailable, timings won't have them"
+                   << " (see /proc/sys/kernel/perf_event_paranoid)";
+    } else {
+      for (size_t i = 0; i < PerfCounterValues::kCounterCount; ++i) {
+        if (probe.fds_[i] == -1) {
+          LOG(WARNING) << "Hardware performance counter "
+                       << GetName(static_cast<PerfCounterValues::Counter>(i)) << " is unavailable";
+        }
+      }
+    }
+  }
+  enabled_ = enabled;
+}
+
+#if defined(__linux__)
+static int OpenCounter(uint32_t type, uint64_t config, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+      PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // pid 0 and cpu -1 count the calling thread on any CPU.
+  return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+PerfCounters::PerfCounters() : tid_(::art::GetTid()), group_fd_(-1), open_count_(0) {
+  for (size_t i = 0; i < PerfCounterValues::kCounterCount; ++i) {
+    fds_[i] = -1;
+    read_index_[i] = 0;
+  }
+#if defined(__linux__)
+  static const struct {
+    uint32_t type;
+    uint64_t config;
+  } kEvents[PerfCounterValues::kCounterCount] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  };
+  for (size_t i = 0; i < PerfCounterValues::kCounterCount; ++i) {
+    int fd = OpenCounter(kEvents[i].type, kEvents[i].config, group_fd_);
+    if (fd == -1) {
+      continue;
+    }
+    if (group_fd_ == -1) {
+      group_fd_ = fd;
+    }
+    fds_[i] = fd;
+    read_index_[i] = open_count_++;
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+  for (size_t i = 0; i < PerfCounterValues::kCounterCount; ++i) {
+    if (fds_[i] != -1) {
+      close(fds_[i]);
+    }
+  }
+}
+
+bool PerfCounters::Read(PerfCounterValues* values) const {
+  *values = PerfCounterValues();
+  if (!IsOpen()) {
+    return false;
+  }
+  // The number of counters, the times enabled and running, then the values in opening order.
+  uint64_t data[3 + PerfCounterValues::kCounterCount];
+  ssize_t bytes = TEMP_FAILURE_RETRY(read(group_fd_, data, sizeof(data)));
+  if (bytes < static_cast<ssize_t>((3 + open_count_) * sizeof(uint64_t)) ||
+      data[0] != open_count_ || data[2] == 0) {
+    return false;
+  }
+  const uint64_t time_enabled = data[1];
+  const uint64_t time_running = data[2];
+  for (size_t i = 0; i < PerfCounterValues::kCounterCount; ++i) {
+    if (fds_[i] != -1) {
+      uint64_t value = data[3 + read_index_[i]];
+      if (time_running < time_enabled) {
+        // The counters were only on the PMU part of the time.
+        value = static_cast<uint64_t>(static_cast<double>(value) * time_enabled / time_running);
+      }
+      values->values[i] = value;
+      values->available |= 1U << i;
+    }
+  }
+  return true;
+}
+
+}  // namespace art
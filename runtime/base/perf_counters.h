@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_BASE_PERF_COUNTERS_H_
+#define ART_RUNTIME_BASE_PERF_COUNTERS_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <ostream>
+
+#include "base/macros.h"
+
+namespace art {
+
+// Values of the hardware counters of a thread. Counters that couldn't be opened are zero and
+// not in the available mask.
+struct PerfCounterValues {
+  enum Counter {
+    kCycles,
+    kInstructions,
+    kCacheMisses,
+    kDTlbMisses,
+    kBranchMisses,
+    kCounterCount,
+  };
+
+  PerfCounterValues() : available(0) {
+    for (size_t i = 0; i < kCounterCount; ++i) {
+      values[i] = 0;
+    }
+  }
+
+  bool IsAvailable(Counter counter) const {
+    return (available & (1U << counter)) != 0;
+  }
+
+  // Counters add up only where both sides have them.
+  void Add(const PerfCounterValues& other) {
+    available &= other.available;
+    for (size_t i = 0; i < kCounterCount; ++i) {
+      values[i] += other.values[i];
+    }
+  }
+
+  PerfCounterValues Minus(const PerfCounterValues& other) const {
+    PerfCounterValues result;
+    result.available = available & other.available;
+    for (size_t i = 0; i < kCounterCount; ++i) {
+      result.values[i] = values[i] - other.values[i];
+    }
+    return result;
+  }
+
+  // Dump the instructions per cycle and the misses per thousand instructions.
+  void DumpRates(std::ostream& os) const;
+
+  uint32_t available;
+  uint64_t values[kCounterCount];
+};
+
+// The hardware performance counters of the calling thread, read through perf_event_open. Only
+// user space is counted. Counters the kernel or the CPU don't support, or that the
+// perf_event_paranoid setting forbids, are left out and every read reports them unavailable.
+class PerfCounters {
+ public:
+  // Whether timing loggers should record counters for their splits, off by default.
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled() {
+    return enabled_;
+  }
+
+  // Opens the counters of the calling thread.
+  PerfCounters();
+  ~PerfCounters();
+
+  // The thread the counters count.
+  pid_t GetTid() const {
+    return tid_;
+  }
+
+  bool IsOpen() const {
+    return group_fd_ != -1;
+  }
+
+  // Read the current values, scaled up if the kernel had to multiplex the counters. Returns
+  // false and no available counters if the read failed.
+  bool Read(PerfCounterValues* values) const;
+
+  static const char* GetName(PerfCounterValues::Counter counter);
+
+ private:
+  static bool enabled_;
+
+  const pid_t tid_;
+  // The group leader is the first counter that could be opened.
+  int group_fd_;
+  int fds_[PerfCounterValues::kCounterCount];
+  // Position of each open counter in a group read.
+  size_t read_index_[PerfCounterValues::kCounterCount];
+  size_t open_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfCounters);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_BASE_PERF_COUNTERS_H_
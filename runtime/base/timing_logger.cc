@@ -64,6 +64,7 @@ void CumulativeLogger::Reset() {
   iterations_ = 0;
   total_time_ = 0;
   STLDeleteElements(&histograms_);
+  counters_.clear();
 }
 
 void CumulativeLogger::AddLogger(const TimingLogger &logger) {
@@ -73,6 +74,9 @@ void CumulativeLogger::AddLogger(const TimingLogger &logger) {
   for (size_t i = 0; i < timings.size(); ++i) {
     if (timings[i].IsStartTiming()) {
       AddPair(timings[i].GetName(), timing_data.GetExclusiveTime(i));
+      if (timing_data.HasPerfCounters()) {
+        AddCounters(timings[i].GetName(), timing_data.GetExclusiveCounters(i));
+      }
     }
   }
   ++iterations_;
@@ -106,6 +110,15 @@ void CumulativeLogger::AddPair(const std::string& label, uint64_t delta_time) {
   histogram->AddValue(delta_time);
 }
 
+void CumulativeLogger::AddCounters(const std::string& label, const PerfCounterValues& counters) {
+  auto it = counters_.find(label);
+  if (it == counters_.end()) {
+    counters_.Put(label, counters);
+  } else {
+    it->second.Add(counters);
+  }
+}
+
 class CompareHistorgramByTimeSpentDeclining {
  public:
   bool operator()(const Histogram<uint64_t>* a, const Histogram<uint64_t>* b) const {
@@ -124,24 +137,61 @@ void CumulativeLogger::DumpHistogram(std::ostream &os) const {
     histogram->CreateHistogram(&cumulative_data);
     histogram->PrintConfidenceIntervals(os, 0.99, cumulative_data);
   }
+  if (!counters_.empty()) {
+    // Tells whether a slow phase waits on memory or is bound by computation.
+    os << "Hardware counters (exclusive):\n";
+    for (Histogram<uint64_t>* histogram : sorted_histograms) {
+      auto it = counters_.find(histogram->Name());
+      if (it != counters_.end() && it->second.available != 0) {
+        os << histogram->Name() << ": ";
+        it->second.DumpRates(os);
+        os << "\n";
+      }
+    }
+  }
   os << "Done Dumping histograms \n";
 }
 
 TimingLogger::TimingLogger(const char* name, bool precise, bool verbose)
-    : name_(name), precise_(precise), verbose_(verbose) {
+    : name_(name), precise_(precise), verbose_(verbose), counting_(false) {
 }
 
 void TimingLogger::Reset() {
   timings_.clear();
+  counting_ = false;
+  counter_values_.clear();
+}
+
+void TimingLogger::StartCounting() {
+  if (perf_counters_.get() == nullptr || perf_counters_->GetTid() != GetTid()) {
+    perf_counters_.reset(new PerfCounters());
+  }
+  counting_ = perf_counters_->IsOpen();
+}
+
+void TimingLogger::ReadPerfCounters() {
+  PerfCounterValues values;
+  // A failed read leaves the counters of the adjacent splits unavailable.
+  perf_counters_->Read(&values);
+  counter_values_.push_back(values);
 }
 
 void TimingLogger::StartTiming(const char* label) {
   DCHECK(label != nullptr);
+  if (UNLIKELY(timings_.empty() && PerfCounters::IsEnabled())) {
+    StartCounting();
+  }
   timings_.push_back(Timing(NanoTime(), label));
+  if (UNLIKELY(counting_)) {
+    ReadPerfCounters();
+  }
   ATRACE_BEGIN(label);
 }
 
 void TimingLogger::EndTiming() {
+  if (UNLIKELY(counting_)) {
+    ReadPerfCounters();
+  }
   timings_.push_back(Timing(NanoTime(), nullptr));
   ATRACE_END();
 }
@@ -166,6 +216,10 @@ size_t TimingLogger::FindTimingIndex(const char* name, size_t start_idx) const {
 TimingLogger::TimingData TimingLogger::CalculateTimingData() const {
   TimingLogger::TimingData ret;
   ret.data_.resize(timings_.size());
+  if (counting_) {
+    DCHECK_EQ(counter_values_.size(), timings_.size());
+    ret.exclusive_counters_.resize(timings_.size());
+  }
   std::vector<size_t> open_stack;
   for (size_t i = 0; i < timings_.size(); ++i) {
     if (timings_[i].IsEndTiming()) {
@@ -183,6 +237,20 @@ TimingLogger::TimingData TimingLogger::CalculateTimingData() const {
         // total time value later.
         ret.data_[open_stack.back()].exclusive_time -= time;
       }
+      if (counting_) {
+        // The exclusive counters are computed like the exclusive time.
+        const PerfCounterValues total = counter_values_[i].Minus(counter_values_[open_idx]);
+        PerfCounterValues* exclusive = &ret.exclusive_counters_[open_idx];
+        PerfCounterValues* parent =
+            open_stack.empty() ? nullptr : &ret.exclusive_counters_[open_stack.back()];
+        for (size_t j = 0; j < PerfCounterValues::kCounterCount; ++j) {
+          exclusive->values[j] += total.values[j];
+          if (parent != nullptr) {
+            parent->values[j] -= total.values[j];
+          }
+        }
+        exclusive->available = total.available;
+      }
     } else {
       open_stack.push_back(i);
     }
@@ -223,7 +291,13 @@ void TimingLogger::Dump(std::ostream &os, const char* indent_string) const {
       if (exclusive_time != total_time) {
         os << "/" << FormatDuration(total_time, tu, kFractionalDigits);
       }
-      os << " " << timings_[i].GetName() << "\n";
+      os << " " << timings_[i].GetName();
+      if (timing_data.HasPerfCounters() && timing_data.GetExclusiveCounters(i).available != 0) {
+        os << " [";
+        timing_data.GetExclusiveCounters(i).DumpRates(os);
+        os << "]";
+      }
+      os << "\n";
       ++tab_count;
     } else {
       --tab_count;
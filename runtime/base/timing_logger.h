@@ -20,7 +20,10 @@
 #include "base/histogram.h"
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "base/perf_counters.h"
+#include "safe_map.h"
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -59,12 +62,16 @@ class CumulativeLogger {
 
   void AddPair(const std::string &label, uint64_t delta_time)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void AddCounters(const std::string& label, const PerfCounterValues& counters)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void DumpHistogram(std::ostream &os) const EXCLUSIVE_LOCKS_REQUIRED(lock_);
   uint64_t GetTotalTime() const {
     return total_time_;
   }
   static const uint64_t kAdjust = 1000;
   std::set<Histogram<uint64_t>*, HistogramComparator> histograms_ GUARDED_BY(lock_);
+  // Exclusive hardware counters per label, for the loggers that recorded them.
+  SafeMap<std::string, PerfCounterValues> counters_ GUARDED_BY(lock_);
   std::string name_;
   const std::string lock_name_;
   mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
@@ -107,9 +114,11 @@ class TimingLogger {
     TimingData() = default;
     TimingData(TimingData&& other) {
       std::swap(data_, other.data_);
+      std::swap(exclusive_counters_, other.exclusive_counters_);
     }
     TimingData& operator=(TimingData&& other) {
       std::swap(data_, other.data_);
+      std::swap(exclusive_counters_, other.exclusive_counters_);
       return *this;
     }
     uint64_t GetTotalTime(size_t idx) {
@@ -118,6 +127,12 @@ class TimingLogger {
     uint64_t GetExclusiveTime(size_t idx) {
       return data_[idx].exclusive_time;
     }
+    bool HasPerfCounters() const {
+      return !exclusive_counters_.empty();
+    }
+    const PerfCounterValues& GetExclusiveCounters(size_t idx) const {
+      return exclusive_counters_[idx];
+    }
 
    private:
     // Each begin split has a total time and exclusive time. Exclusive time is total time - total
@@ -128,6 +143,8 @@ class TimingLogger {
       uint64_t exclusive_time;
     };
     std::vector<CalculatedDataPoint> data_;
+    // Indexed like data_, empty if the logger didn't record hardware counters.
+    std::vector<PerfCounterValues> exclusive_counters_;
     friend class TimingLogger;
   };
 
@@ -177,6 +194,18 @@ class TimingLogger {
     return timings_;
   }
 
+  // Whether hardware counters were recorded along with the timings. They are when
+  // PerfCounters::IsEnabled() as the first timing starts and the counters of the thread could be
+  // opened. Only the thread that records the timings is counted.
+  bool HasPerfCounters() const {
+    return counting_;
+  }
+
+  // The counters at each time point, if HasPerfCounters().
+  const std::vector<PerfCounterValues>& GetPerfCounterValues() const {
+    return counter_values_;
+  }
+
   TimingData CalculateTimingData() const;
 
  protected:
@@ -192,6 +221,16 @@ class TimingLogger {
   std::vector<Timing> timings_;
 
  private:
+  void StartCounting();
+  void ReadPerfCounters();
+
+  // The counters of the thread that recorded the timings, kept across resets while the same
+  // thread records them.
+  std::unique_ptr<PerfCounters> perf_counters_;
+  bool counting_;
+  // The counters at each timing point, when counting.
+  std::vector<PerfCounterValues> counter_values_;
+
   DISALLOW_COPY_AND_ASSIGN(TimingLogger);
 };
 
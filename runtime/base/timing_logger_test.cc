@@ -16,6 +16,8 @@
 
 #include "timing_logger.h"
 
+#include <sstream>
+
 #include "common_runtime_test.h"
 
 namespace art {
@@ -158,4 +160,43 @@ TEST_F(TimingLoggerTest, ScopedAndExplicit) {
   EXPECT_LE(timings[idx_innerinnersplit1].GetTime(), timings[idx_innerinnersplit2].GetTime());
 }
 
+TEST_F(TimingLoggerTest, PerfCounters) {
+  PerfCounters::SetEnabled(true);
+  TimingLogger logger("PerfCounters", true, false);
+  logger.StartTiming("Outer Split");
+  logger.StartTiming("Inner Split");
+  logger.EndTiming();
+  logger.EndTiming();
+  PerfCounters::SetEnabled(false);
+  // The timings are the same whether or not the counters could be opened.
+  EXPECT_EQ(4U, logger.GetTimings().size());
+  TimingLogger::TimingData data(logger.CalculateTimingData());
+  EXPECT_EQ(logger.HasPerfCounters(), data.HasPerfCounters());
+  if (logger.HasPerfCounters()) {
+    EXPECT_EQ(4U, logger.GetPerfCounterValues().size());
+  }
+  std::ostringstream os;
+  logger.Dump(os);
+  EXPECT_NE(os.str().find("Inner Split"), std::string::npos) << os.str();
+
+  // Counters aren't opened once disabled.
+  logger.Reset();
+  logger.StartTiming("Split");
+  logger.EndTiming();
+  EXPECT_FALSE(logger.HasPerfCounters());
+}
+
+TEST_F(TimingLoggerTest, PerfCounterRates) {
+  PerfCounterValues values;
+  values.available = (1U << PerfCounterValues::kCycles) |
+      (1U << PerfCounterValues::kInstructions) | (1U << PerfCounterValues::kCacheMisses);
+  values.values[PerfCounterValues::kCycles] = 2000;
+  values.values[PerfCounterValues::kInstructions] = 1000;
+  values.values[PerfCounterValues::kCacheMisses] = 5;
+  values.values[PerfCounterValues::kBranchMisses] = 7;
+  std::ostringstream os;
+  values.DumpRates(os);
+  EXPECT_EQ("IPC 0.50, cache-misses 5.00/ki", os.str());
+}
+
 }  // namespace art
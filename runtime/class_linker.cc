@@ -42,6 +42,7 @@
 #include "handle_scope.h"
 #include "intern_table.h"
 #include "interpreter/interpreter.h"
+#include "jit/jit.h"
 #include "leb128.h"
 #include "method_helper-inl.h"
 #include "oat.h"
@@ -666,6 +667,9 @@ const OatFile* ClassLinker::RegisterOatFile(const OatFile* oat_file) {
   }
   VLOG(class_linker) << "Registering " << oat_file->GetLocation();
   oat_files_.push_back(oat_file);
+  if (oat_file->HasMethodTraceHooks()) {
+    method_trace_hook_oat_files_.push_back(oat_file);
+  }
   return oat_file;
 }
 
@@ -2409,6 +2413,14 @@ const void* ClassLinker::GetQuickOatCodeFor(mirror::ArtMethod* method) {
   if (method->IsProxyMethod()) {
     return GetQuickProxyInvokeHandler();
   }
+  jit::Jit* const jit = Runtime::Current()->GetJit();
+  if (jit != nullptr) {
+    // Code compiled at runtime takes precedence, the oat file has none for the method.
+    const void* code = jit->GetCodeCache()->GetCodeFor(Thread::Current(), method);
+    if (code != nullptr) {
+      return code;
+    }
+  }
   OatFile::OatMethod oat_method;
   const void* result = nullptr;
   if (FindOatMethodFor(method, &oat_method)) {
@@ -2432,6 +2444,35 @@ const void* ClassLinker::GetQuickOatCodeFor(mirror::ArtMethod* method) {
   return result;
 }
 
+bool ClassLinker::HasMethodTraceHooks(mirror::ArtMethod* method) {
+  if (method->IsNative() || method->IsProxyMethod() || method->IsAbstract()) {
+    return false;
+  }
+  jit::Jit* const jit = Runtime::Current()->GetJit();
+  if (jit != nullptr && jit->GetCodeCache()->GetCodeFor(Thread::Current(), method) != nullptr) {
+    return false;
+  }
+  mirror::Class* declaring_class = method->GetDeclaringClass();
+  const OatFile::OatDexFile* oat_dex_file =
+      FindOpenedOatDexFileForDexFile(*declaring_class->GetDexCache()->GetDexFile());
+  if (oat_dex_file == nullptr || !oat_dex_file->GetOatFile()->HasMethodTraceHooks()) {
+    return false;
+  }
+  OatFile::OatMethod oat_method;
+  return FindOatMethodFor(method, &oat_method) && oat_method.GetQuickCode() != nullptr;
+}
+
+bool ClassLinker::IsMethodTraceHookCode(uintptr_t pc) {
+  ReaderMutexLock mu(Thread::Current(), dex_lock_);
+  for (const OatFile* oat_file : method_trace_hook_oat_files_) {
+    if (pc >= reinterpret_cast<uintptr_t>(oat_file->Begin()) &&
+        pc < reinterpret_cast<uintptr_t>(oat_file->End())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 #if defined(ART_USE_PORTABLE_COMPILER)
 const void* ClassLinker::GetPortableOatCodeFor(mirror::ArtMethod* method,
                                                bool* have_portable_code) {
@@ -2503,9 +2544,11 @@ static bool NeedsInterpreter(
   }
 #endif
   // If interpreter mode is enabled, every method (except native and proxy) must
-  // be run with interpreter.
-  return Runtime::Current()->GetInstrumentation()->InterpretOnly() &&
-         !method->IsNative() && !method->IsProxyMethod();
+  // be run with interpreter, unless method tracing only needs its entry and exit.
+  instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
+  return instrumentation->InterpretOnly() &&
+         !method->IsNative() && !method->IsProxyMethod() &&
+         !instrumentation->UsesMethodTraceHooks(method);
 }
 
 void ClassLinker::FixupStaticTrampolines(mirror::Class* klass) {
@@ -2899,6 +2942,15 @@ mirror::ArtMethod* ClassLinker::LoadMethod(Thread* self, const DexFile& dex_file
       }
     }
   }
+  if (UNLIKELY((access_flags & kAccNative) != 0)) {
+    // The JNI compiler looks at the same annotations, see CompilerDriver::CompileMethod.
+    access_flags |= dex_file.GetNativeMethodAnnotationAccessFlags(*klass->GetClassDef(),
+                                                                  dex_method_idx, access_flags);
+    if (kUsePortableCompiler) {
+      // The portable JNI compiler emits normal stubs for critical natives.
+      access_flags &= ~kAccCriticalNative;
+    }
+  }
   dst->SetAccessFlags(access_flags);
 
   self->EndAssertNoThreadSuspension(old_cause);
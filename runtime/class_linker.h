@@ -347,6 +347,15 @@ class ClassLinker {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 #endif
 
+  // Does the oat code of the method report method entry and exit itself while method tracing?
+  // Code compiled by the JIT does not.
+  bool HasMethodTraceHooks(mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Does the quick code at pc report method entry and exit itself? Cheap enough for every frame
+  // of a stack walk, only the oat files compiled with hooks are searched.
+  bool IsMethodTraceHookCode(uintptr_t pc) LOCKS_EXCLUDED(dex_lock_);
+
   // Get the oat code for a method from a method index.
   const void* GetQuickOatCodeFor(const DexFile& dex_file, uint16_t class_def_idx, uint32_t method_idx)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -675,6 +684,8 @@ class ClassLinker {
   std::vector<size_t> new_dex_cache_roots_ GUARDED_BY(dex_lock_);;
   std::vector<GcRoot<mirror::DexCache>> dex_caches_ GUARDED_BY(dex_lock_);
   std::vector<const OatFile*> oat_files_ GUARDED_BY(dex_lock_);
+  // The oat files compiled with method trace hooks, usually none.
+  std::vector<const OatFile*> method_trace_hook_oat_files_ GUARDED_BY(dex_lock_);
 
 
   // multimap from a string hash code of a class descriptor to
@@ -0,0 +1,518 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpu_sampling_profiler.h"
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "base/unix_file/fd_file.h"
+#include "dex_file-inl.h"
+#include "mirror/art_method-inl.h"
+#include "os.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "stack.h"
+#include "thread.h"
+#include "thread_list.h"
+#include "utils.h"
+
+namespace art {
+
+// Number of methods shown in a report.
+static constexpr size_t kMaxReportedMethods = 20;
+
+// A single producer, single consumer ring of samples. The producer is the thread currently owning
+// the buffer, the consumer is whoever holds CpuSamplingProfiler::lock_. Also holds the timer that
+// makes the owner take samples.
+class CpuSampleBuffer {
+ public:
+  static constexpr size_t kCapacity = 64;
+
+  CpuSampleBuffer() : owner_(nullptr), head_(0), tail_(0), dropped_(0), has_timer_(false) {
+  }
+
+  bool TryAcquire(Thread* self) {
+    return owner_.CompareExchangeStrongSequentiallyConsistent(nullptr, self);
+  }
+
+  void Release() {
+    owner_.StoreSequentiallyConsistent(nullptr);
+  }
+
+  // Start a timer on the CPU time clock of thread which sends it SIGPROF every interval_us.
+  void StartTimer(Thread* thread, uint32_t interval_us) {
+    if (has_timer_.LoadSequentiallyConsistent()) {
+      return;
+    }
+#if defined(__linux__)
+    clockid_t clock;
+    int rc = pthread_getcpuclockid(thread->GetPthreadSelf(), &clock);
+    if (rc != 0) {
+      errno = rc;
+      PLOG(WARNING) << "Failed to get the CPU time clock of " << *thread;
+      return;
+    }
+    sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event._sigev_un._tid = thread->GetTid();
+    if (timer_create(clock, &event, &timer_) == -1) {
+      PLOG(WARNING) << "Failed to create a CPU sampling timer for " << *thread;
+      return;
+    }
+    itimerspec spec;
+    spec.it_interval.tv_sec = interval_us / 1000000;
+    spec.it_interval.tv_nsec = (interval_us % 1000000) * 1000;
+    spec.it_value = spec.it_interval;
+    if (timer_settime(timer_, 0, &spec, nullptr) == -1) {
+      PLOG(WARNING) << "Failed to arm the CPU sampling timer of " << *thread;
+      timer_delete(timer_);
+      return;
+    }
+    has_timer_.StoreSequentiallyConsistent(true);
+#else
+    // Start refuses to run without kIsSupported.
+    UNUSED(thread);
+    UNUSED(interval_us);
+#endif
+  }
+
+  // Delete the timer, if any. May race with itself as a thread exits while sampling is stopped.
+  void StopTimer() {
+#if defined(__linux__)
+    if (has_timer_.CompareExchangeStrongSequentiallyConsistent(true, false)) {
+      timer_delete(timer_);
+    }
+#endif
+  }
+
+  void Push(const CpuSample& sample) {
+    size_t head = head_.LoadRelaxed();
+    if (head - tail_.LoadSequentiallyConsistent() == kCapacity) {
+      // Full, the consumer hasn't caught up.
+      dropped_.FetchAndAddSequentiallyConsistent(1);
+      return;
+    }
+    samples_[head % kCapacity] = sample;
+    head_.StoreRelease(head + 1);
+  }
+
+  template <typename Visitor>
+  void Drain(Visitor* visitor) {
+    size_t tail = tail_.LoadRelaxed();
+    const size_t head = head_.LoadSequentiallyConsistent();
+    for (; tail != head; ++tail) {
+      (*visitor)(samples_[tail % kCapacity]);
+    }
+    tail_.StoreSequentiallyConsistent(tail);
+  }
+
+  // Drop the samples not drained yet and the count of dropped samples.
+  void Discard() {
+    tail_.StoreSequentiallyConsistent(head_.LoadSequentiallyConsistent());
+    dropped_.StoreRelaxed(0);
+  }
+
+  uint32_t GetDropped() const {
+    return dropped_.LoadRelaxed();
+  }
+
+ private:
+  Atomic<Thread*> owner_;
+  Atomic<size_t> head_;
+  Atomic<size_t> tail_;
+  Atomic<uint32_t> dropped_;
+  Atomic<bool> has_timer_;
+  timer_t timer_;
+  CpuSample samples_[kCapacity];
+
+  DISALLOW_COPY_AND_ASSIGN(CpuSampleBuffer);
+};
+
+namespace {
+
+typedef std::pair<const DexFile*, uint32_t> MethodKey;
+// Innermost frame first, empty for samples without managed frames.
+typedef std::vector<MethodKey> StackKey;
+
+// Aggregated samples, guarded by CpuSamplingProfiler::lock_.
+static std::map<StackKey, uint64_t>* gStackCounts = nullptr;
+
+class SampleAggregator {
+ public:
+  explicit SampleAggregator(std::map<StackKey, uint64_t>* counts) : counts_(counts) {}
+
+  void operator()(const CpuSample& sample) {
+    StackKey stack_key;
+    for (size_t i = 0; i < sample.depth; ++i) {
+      stack_key.push_back(std::make_pair(sample.frames[i].dex_file, sample.frames[i].method_idx));
+    }
+    ++(*counts_)[stack_key];
+  }
+
+ private:
+  std::map<StackKey, uint64_t>* const counts_;
+};
+
+static bool CompareSelfSamples(const std::pair<MethodKey, std::pair<uint64_t, uint64_t>>& lhs,
+                               const std::pair<MethodKey, std::pair<uint64_t, uint64_t>>& rhs) {
+  return lhs.second.first > rhs.second.first;
+}
+
+// A thread using a whole CPU fills its ring in kCapacity intervals, drain it when it may be a
+// quarter full.
+static uint64_t GetDrainIntervalUs(uint32_t interval_us) {
+  uint64_t drain_interval_us = static_cast<uint64_t>(interval_us) * CpuSampleBuffer::kCapacity / 4;
+  return std::min(std::max(drain_interval_us, UINT64_C(1000)), UINT64_C(1000000));
+}
+
+static std::string PrettyFrame(const MethodKey& method) {
+  return PrettyMethod(method.second, *method.first, false);
+}
+
+class CpuSampleStackVisitor : public StackVisitor {
+ public:
+  CpuSampleStackVisitor(Thread* thread, CpuSample* sample)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      : StackVisitor(thread, nullptr), sample_(sample) {}
+
+  bool VisitFrame() OVERRIDE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::ArtMethod* m = GetMethod();
+    if (m->IsRuntimeMethod() || m->IsProxyMethod()) {
+      return true;
+    }
+    CpuSample::Frame& frame = sample_->frames[sample_->depth++];
+    frame.dex_file = m->GetDexFile();
+    frame.method_idx = m->GetDexMethodIndex();
+    return sample_->depth < CpuSample::kMaxStackDepth;
+  }
+
+ private:
+  CpuSample* const sample_;
+};
+
+}  // namespace
+
+Atomic<bool> CpuSamplingProfiler::enabled_(false);
+uint32_t CpuSamplingProfiler::interval_us_ = 0;
+Mutex* CpuSamplingProfiler::lock_ = nullptr;
+std::vector<CpuSampleBuffer*>* CpuSamplingProfiler::buffers_ = nullptr;
+std::string* CpuSamplingProfiler::output_filename_ = nullptr;
+pthread_t CpuSamplingProfiler::drain_pthread_ = 0U;
+bool CpuSamplingProfiler::handler_installed_ = false;
+struct sigaction CpuSamplingProfiler::old_action_;
+
+void CpuSamplingProfiler::HandleSignal(int /*signal_number*/, siginfo_t* /*info*/,
+                                       void* /*context*/) {
+  // Only async signal safe work here. The stack is walked at the next suspend check, so that
+  // check is forced to be taken for implicit suspend checks too.
+  Thread* self = Thread::Current();
+  if (self != nullptr && enabled_.LoadRelaxed()) {
+    self->AtomicSetFlag(kCpuSampleRequest);
+    self->TriggerSuspend();
+  }
+}
+
+void CpuSamplingProfiler::Start(uint32_t interval_us, const std::string& output_filename) {
+  CHECK(kIsSupported) << "CPU sampling needs per-thread CPU time timers";
+  CHECK_GT(interval_us, 0U);
+  if (lock_ == nullptr) {
+    lock_ = new Mutex("cpu sampling profiler lock");
+  }
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    MutexLock mu2(self, *lock_);
+    if (!handler_installed_) {
+      // The handler stays installed once sampling stopped so that late signals are ignored rather
+      // than terminating the process, until Shutdown restores the previous one.
+      struct sigaction action;
+      memset(&action, 0, sizeof(action));
+      sigemptyset(&action.sa_mask);
+      action.sa_sigaction = HandleSignal;
+      action.sa_flags = SA_SIGINFO | SA_RESTART;
+      if (sigaction(SIGPROF, &action, &old_action_) == -1) {
+        PLOG(ERROR) << "Failed to install the CPU sampling signal handler";
+        return;
+      }
+      handler_installed_ = true;
+    }
+    if (buffers_ == nullptr) {
+      buffers_ = new std::vector<CpuSampleBuffer*>;
+      gStackCounts = new std::map<StackKey, uint64_t>;
+    }
+    if (!IsEnabled()) {
+      // A new profile, forget the samples of the previous one.
+      gStackCounts->clear();
+      for (CpuSampleBuffer* buffer : *buffers_) {
+        buffer->Discard();
+      }
+    }
+    delete output_filename_;
+    output_filename_ = output_filename.empty() ? nullptr : new std::string(output_filename);
+    interval_us_ = interval_us;
+    enabled_.StoreSequentiallyConsistent(true);
+    for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+      StartThreadLocked(thread);
+    }
+  }
+  VLOG(profiler) << "CPU sampling started, interval " << interval_us << "us";
+  // Threads can't be attached before the runtime is started, Runtime::Start starts it then.
+  if (Runtime::Current()->IsStarted()) {
+    StartDrainThread();
+  }
+}
+
+void CpuSamplingProfiler::StartDrainThread() {
+  if (lock_ == nullptr) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), *lock_);
+  if (IsEnabled() && drain_pthread_ == 0U) {
+    CHECK_PTHREAD_CALL(pthread_create, (&drain_pthread_, nullptr, &RunDrainThread, nullptr),
+                       "CPU sampling profiler drain thread");
+  }
+}
+
+void* CpuSamplingProfiler::RunDrainThread(void* /*arg*/) {
+  Runtime* runtime = Runtime::Current();
+  if (!runtime->AttachCurrentThread("CPU sampling profiler", true,
+                                    runtime->GetSystemThreadGroup(), !runtime->IsCompiler())) {
+    // The runtime is shutting down, it dumps what is left.
+    return nullptr;
+  }
+  Thread* self = Thread::Current();
+  while (IsEnabled()) {
+    uint64_t drain_interval_us;
+    {
+      MutexLock mu(self, *lock_);
+      drain_interval_us = GetDrainIntervalUs(interval_us_);
+    }
+    usleep(drain_interval_us);
+    MutexLock mu(self, *lock_);
+    DrainLocked();
+  }
+  runtime->DetachCurrentThread();
+  return nullptr;
+}
+
+void CpuSamplingProfiler::StartThreadLocked(Thread* thread) {
+  CpuSampleBuffer* buffer = thread->GetCpuSampleBuffer();
+  if (buffer == nullptr) {
+    // Reuse the buffer of an exited thread if possible.
+    for (CpuSampleBuffer* candidate : *buffers_) {
+      if (candidate->TryAcquire(thread)) {
+        buffer = candidate;
+        break;
+      }
+    }
+    if (buffer == nullptr) {
+      buffer = new CpuSampleBuffer;
+      CHECK(buffer->TryAcquire(thread));
+      buffers_->push_back(buffer);
+    }
+    thread->SetCpuSampleBuffer(buffer);
+  }
+  buffer->StartTimer(thread, interval_us_);
+}
+
+void CpuSamplingProfiler::ThreadAttached(Thread* self) {
+  if (!IsEnabled()) {
+    return;
+  }
+  MutexLock mu(self, *lock_);
+  // Start may have seen self in the thread list already.
+  if (IsEnabled()) {
+    StartThreadLocked(self);
+  }
+}
+
+void CpuSamplingProfiler::Stop() {
+  enabled_.StoreSequentiallyConsistent(false);
+  if (lock_ == nullptr) {
+    return;
+  }
+  pthread_t drain_pthread;
+  {
+    MutexLock mu(Thread::Current(), *lock_);
+    if (buffers_ != nullptr) {
+      for (CpuSampleBuffer* buffer : *buffers_) {
+        buffer->StopTimer();
+      }
+    }
+    drain_pthread = drain_pthread_;
+    drain_pthread_ = 0U;
+  }
+  if (drain_pthread != 0U) {
+    CHECK_PTHREAD_CALL(pthread_join, (drain_pthread, nullptr),
+                       "CPU sampling profiler drain thread shutdown");
+  }
+}
+
+void CpuSamplingProfiler::Shutdown() {
+  if (lock_ == nullptr) {
+    return;
+  }
+  Stop();
+  Thread* self = Thread::Current();
+  if (self != nullptr) {
+    ScopedObjectAccess soa(self);
+    DumpToFile();
+  }
+  MutexLock mu(self, *lock_);
+  // The timers are gone, give SIGPROF back to whoever had it before.
+  if (handler_installed_) {
+    if (sigaction(SIGPROF, &old_action_, nullptr) == -1) {
+      PLOG(WARNING) << "Failed to restore the SIGPROF handler";
+    }
+    handler_installed_ = false;
+  }
+  // The per-thread buffers are left alone as exiting daemon threads may still release them.
+}
+
+void CpuSamplingProfiler::ReleaseThreadBuffer(CpuSampleBuffer* buffer) {
+  if (buffer != nullptr) {
+    buffer->StopTimer();
+    buffer->Release();
+  }
+}
+
+void CpuSamplingProfiler::RecordSample(Thread* self) {
+  CpuSampleBuffer* buffer = self->GetCpuSampleBuffer();
+  if (buffer == nullptr || !IsEnabled()) {
+    // A request left over from before sampling stopped.
+    return;
+  }
+  CpuSample sample;
+  sample.depth = 0;
+  CpuSampleStackVisitor visitor(self, &sample);
+  visitor.WalkStack(false);
+  buffer->Push(sample);
+}
+
+void CpuSamplingProfiler::DrainLocked() {
+  if (buffers_ == nullptr) {
+    return;
+  }
+  SampleAggregator aggregator(gStackCounts);
+  for (CpuSampleBuffer* buffer : *buffers_) {
+    buffer->Drain(&aggregator);
+  }
+}
+
+void CpuSamplingProfiler::Dump(std::ostream& os) {
+  if (lock_ == nullptr) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), *lock_);
+  DrainLocked();
+  if (gStackCounts == nullptr) {
+    return;
+  }
+  uint64_t dropped = 0;
+  for (CpuSampleBuffer* buffer : *buffers_) {
+    dropped += buffer->GetDropped();
+  }
+  // Samples with the method innermost (self) and anywhere on the stack (total).
+  std::map<MethodKey, std::pair<uint64_t, uint64_t>> method_counts;
+  uint64_t total = 0;
+  for (const auto& entry : *gStackCounts) {
+    const StackKey& stack = entry.first;
+    total += entry.second;
+    if (stack.empty()) {
+      continue;
+    }
+    method_counts[stack[0]].first += entry.second;
+    std::set<MethodKey> seen;
+    for (const MethodKey& method : stack) {
+      if (seen.insert(method).second) {
+        method_counts[method].second += entry.second;
+      }
+    }
+  }
+  os << "CPU sampling profile: " << total << " samples, " << dropped << " samples dropped\n";
+  std::vector<std::pair<MethodKey, std::pair<uint64_t, uint64_t>>> methods(method_counts.begin(),
+                                                                            method_counts.end());
+  std::sort(methods.begin(), methods.end(), CompareSelfSamples);
+  if (methods.size() > kMaxReportedMethods) {
+    methods.resize(kMaxReportedMethods);
+  }
+  for (const auto& entry : methods) {
+    os << "  self=" << entry.second.first << " (" << entry.second.first * 100 / total << "%)"
+       << " total=" << entry.second.second << " (" << entry.second.second * 100 / total << "%) "
+       << PrettyFrame(entry.first) << "\n";
+  }
+  os << "\n";
+}
+
+void CpuSamplingProfiler::DumpCollapsedStacks(std::ostream& os) {
+  if (lock_ == nullptr) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), *lock_);
+  DrainLocked();
+  if (gStackCounts == nullptr) {
+    return;
+  }
+  for (const auto& entry : *gStackCounts) {
+    const StackKey& stack = entry.first;
+    if (stack.empty()) {
+      os << "[no managed frames]";
+    }
+    for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+      if (it != stack.rbegin()) {
+        os << ";";
+      }
+      os << PrettyFrame(*it);
+    }
+    os << " " << entry.second << "\n";
+  }
+}
+
+void CpuSamplingProfiler::DumpToFile() {
+  if (lock_ == nullptr) {
+    return;
+  }
+  std::string filename;
+  {
+    MutexLock mu(Thread::Current(), *lock_);
+    if (output_filename_ == nullptr) {
+      return;
+    }
+    filename = *output_filename_;
+  }
+  std::ostringstream os;
+  DumpCollapsedStacks(os);
+  std::unique_ptr<File> file(OS::CreateEmptyFile(filename.c_str()));
+  if (file.get() == nullptr) {
+    PLOG(ERROR) << "Failed to open CPU sampling profile " << filename;
+    return;
+  }
+  const std::string report(os.str());
+  if (!file->WriteFully(report.c_str(), report.size())) {
+    PLOG(ERROR) << "Failed to write CPU sampling profile " << filename;
+  }
+}
+
+}  // namespace art
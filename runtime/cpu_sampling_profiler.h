@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CPU_SAMPLING_PROFILER_H_
+#define ART_RUNTIME_CPU_SAMPLING_PROFILER_H_
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class DexFile;
+class Thread;
+
+// A sampled managed stack, innermost frame first. Methods are recorded by dex file and index
+// rather than by ArtMethod so that samples remain valid when a moving collector relocates them.
+struct CpuSample {
+  static constexpr size_t kMaxStackDepth = 32;
+
+  struct Frame {
+    const DexFile* dex_file;
+    uint32_t method_idx;
+  };
+
+  size_t depth;
+  Frame frames[kMaxStackDepth];
+};
+
+class CpuSampleBuffer;
+
+// Samples the managed stacks of threads while they use CPU, without suspending any other thread.
+// Each thread has a timer on its own CPU time clock, which sends it SIGPROF every interval. The
+// signal handler only sets kCpuSampleRequest, the stack is walked by the thread itself at its
+// next suspend check, where doing so is safe. Samples go into per-thread single producer, single
+// consumer rings. Once the runtime is started, a daemon thread drains the rings into counts per
+// distinct stack well before they fill up. A report is dumped on SIGQUIT, through VMDebug or as
+// collapsed stacks to the file given by -Xcpusampleprofile-file.
+class CpuSamplingProfiler {
+ public:
+  // Whether threads have CPU time clocks that sampling timers can be armed on. -Xcpusampleprofile
+  // is rejected and VMDebug throws otherwise.
+#if defined(__linux__)
+  static constexpr bool kIsSupported = true;
+#else
+  static constexpr bool kIsSupported = false;
+#endif
+
+  // Start sampling every interval_us microseconds of CPU time of each attached thread. Starting
+  // after a stop discards the samples of the previous profile.
+  static void Start(uint32_t interval_us, const std::string& output_filename)
+      LOCKS_EXCLUDED(lock_, Locks::thread_list_lock_);
+  // Stop sampling, the samples so far are kept for the next report.
+  static void Stop() LOCKS_EXCLUDED(lock_, Locks::thread_list_lock_);
+  // Stop sampling, write the output file and restore the SIGPROF handler found by Start.
+  static void Shutdown() LOCKS_EXCLUDED(lock_, Locks::thread_list_lock_);
+
+  // Start the drain thread if sampling was started before the runtime. Called by Runtime::Start.
+  static void StartDrainThread() LOCKS_EXCLUDED(lock_);
+
+  static bool IsEnabled() {
+    return enabled_.LoadRelaxed();
+  }
+
+  // Called as a thread is attached, starts its timer if sampling.
+  static void ThreadAttached(Thread* self) LOCKS_EXCLUDED(lock_);
+
+  // Called as a thread is destroyed, stops its timer. Its samples are kept until the next report.
+  static void ReleaseThreadBuffer(CpuSampleBuffer* buffer);
+
+  // Record a sample of the stack of self, called at the suspend check following a SIGPROF.
+  static void RecordSample(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Aggregate the outstanding samples and dump the methods with the most samples.
+  static void Dump(std::ostream& os) LOCKS_EXCLUDED(lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Aggregate the outstanding samples and dump all stacks in the collapsed format of flame graph
+  // tools, one "outermost;...;innermost count" line per distinct stack.
+  static void DumpCollapsedStacks(std::ostream& os) LOCKS_EXCLUDED(lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Dump the collapsed stacks to the output file, if one was given.
+  static void DumpToFile() LOCKS_EXCLUDED(lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  static void HandleSignal(int signal_number, siginfo_t* info, void* context);
+  static void StartThreadLocked(Thread* thread) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  static void DrainLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  static void* RunDrainThread(void* arg) LOCKS_EXCLUDED(lock_);
+
+  static Atomic<bool> enabled_;
+  static uint32_t interval_us_ GUARDED_BY(lock_);
+  // Guards the buffers, the aggregated samples and the output filename.
+  static Mutex* lock_;
+  static std::vector<CpuSampleBuffer*>* buffers_ GUARDED_BY(lock_);
+  static std::string* output_filename_ GUARDED_BY(lock_);
+  static pthread_t drain_pthread_ GUARDED_BY(lock_);
+  // The SIGPROF action replaced by HandleSignal, valid while handler_installed_.
+  static bool handler_installed_ GUARDED_BY(lock_);
+  static struct sigaction old_action_ GUARDED_BY(lock_);
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(CpuSamplingProfiler);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CPU_SAMPLING_PROFILER_H_
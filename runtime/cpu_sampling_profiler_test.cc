@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cpu_sampling_profiler.h"
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <sstream>
+
+#include "common_runtime_test.h"
+#include "entrypoints/entrypoint_utils-inl.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+
+class CpuSamplingProfilerTest : public CommonRuntimeTest {
+ protected:
+  void SetUp() OVERRIDE {
+    ASSERT_EQ(0, sigaction(SIGPROF, nullptr, &old_action_));
+    CommonRuntimeTest::SetUp();
+  }
+
+  void TearDown() OVERRIDE {
+    // The runtime restores the handler it replaced as it shuts down, make sure of it regardless.
+    CommonRuntimeTest::TearDown();
+    ASSERT_EQ(0, sigaction(SIGPROF, &old_action_, nullptr));
+  }
+
+  struct sigaction old_action_;
+};
+
+TEST_F(CpuSamplingProfilerTest, SignalRequestsSampleAtSuspendCheck) {
+  Thread* self = Thread::Current();
+  // An interval long enough for the timer not to fire during the test.
+  CpuSamplingProfiler::Start(10 * 1000 * 1000, "");
+  ASSERT_TRUE(CpuSamplingProfiler::IsEnabled());
+  ASSERT_TRUE(self->GetCpuSampleBuffer() != nullptr);
+
+  // The handler only flags the thread.
+  ASSERT_EQ(0, pthread_kill(pthread_self(), SIGPROF));
+  EXPECT_TRUE(self->ReadFlag(kCpuSampleRequest));
+  self->RemoveSuspendTrigger();
+
+  std::ostringstream os;
+  {
+    ScopedObjectAccess soa(self);
+    CheckSuspend(self);
+    EXPECT_FALSE(self->ReadFlag(kCpuSampleRequest));
+    CpuSamplingProfiler::RecordSample(self);
+    CpuSamplingProfiler::DumpCollapsedStacks(os);
+  }
+  CpuSamplingProfiler::Stop();
+  EXPECT_FALSE(CpuSamplingProfiler::IsEnabled());
+
+  // The test thread has no managed frames.
+  EXPECT_NE(os.str().find("[no managed frames] 2\n"), std::string::npos) << os.str();
+}
+
+}  // namespace art
@@ -336,6 +336,11 @@ uint32_t Dbg::instrumentation_events_ = 0;
 
 // Breakpoints.
 static std::vector<Breakpoint> gBreakpoints GUARDED_BY(Locks::breakpoint_lock_);
+// Number of breakpoints in gBreakpoints at each method and dex pc. A dex pc is checked with a
+// lookup instead of a scan of every breakpoint, which matters when everything is deoptimized and
+// each dex pc of each method is checked.
+static SafeMap<std::pair<const mirror::ArtMethod*, uint32_t>, size_t> gBreakpointLocations
+    GUARDED_BY(Locks::breakpoint_lock_);
 
 void DebugInvokeReq::VisitRoots(RootCallback* callback, void* arg, uint32_t tid,
                                 RootType root_type) {
@@ -382,13 +387,11 @@ static bool IsBreakpoint(const mirror::ArtMethod* m, uint32_t dex_pc)
     LOCKS_EXCLUDED(Locks::breakpoint_lock_)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   ReaderMutexLock mu(Thread::Current(), *Locks::breakpoint_lock_);
-  for (size_t i = 0, e = gBreakpoints.size(); i < e; ++i) {
-    if (gBreakpoints[i].DexPc() == dex_pc && gBreakpoints[i].Method() == m) {
-      VLOG(jdwp) << "Hit breakpoint #" << i << ": " << gBreakpoints[i];
-      return true;
-    }
+  if (gBreakpointLocations.find(std::make_pair(m, dex_pc)) == gBreakpointLocations.end()) {
+    return false;
   }
-  return false;
+  VLOG(jdwp) << StringPrintf("Hit breakpoint at %s @%#x", PrettyMethod(m).c_str(), dex_pc);
+  return true;
 }
 
 static bool IsSuspendedForDebugger(ScopedObjectAccessUnchecked& soa, Thread* thread)
@@ -743,6 +746,7 @@ void Dbg::GoActive() {
     // TODO: dalvik only warned if there were breakpoints left over. clear in Dbg::Disconnected?
     ReaderMutexLock mu(Thread::Current(), *Locks::breakpoint_lock_);
     CHECK_EQ(gBreakpoints.size(), 0U);
+    CHECK_EQ(gBreakpointLocations.size(), 0U);
   }
 
   {
@@ -1455,6 +1459,10 @@ bool Dbg::MatchLocation(const JDWP::JdwpLocation& expected_location,
   return m == event_location.method;
 }
 
+JDWP::MethodId Dbg::GetMethodId(mirror::ArtMethod* m) {
+  return ToMethodId(m);
+}
+
 bool Dbg::MatchType(mirror::Class* event_class, JDWP::RefTypeId class_id) {
   if (event_class == nullptr) {
     return false;
@@ -3123,6 +3131,11 @@ static bool IsMethodPossiblyInlined(Thread* self, mirror::ArtMethod* m)
 
 static const Breakpoint* FindFirstBreakpointForMethod(mirror::ArtMethod* m)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::breakpoint_lock_) {
+  // The first location at or after (m, 0) is in m if m has breakpoints.
+  auto it = gBreakpointLocations.lower_bound(std::make_pair(m, 0U));
+  if (it == gBreakpointLocations.end() || it->first.first != m) {
+    return nullptr;
+  }
   for (Breakpoint& breakpoint : gBreakpoints) {
     if (breakpoint.Method() == m) {
       return &breakpoint;
@@ -3190,6 +3203,13 @@ void Dbg::WatchLocation(const JDWP::JdwpLocation* location, DeoptimizationReques
   {
     WriterMutexLock mu(self, *Locks::breakpoint_lock_);
     gBreakpoints.push_back(Breakpoint(m, location->dex_pc, need_full_deoptimization));
+    std::pair<const mirror::ArtMethod*, uint32_t> key(m, location->dex_pc);
+    auto it = gBreakpointLocations.find(key);
+    if (it == gBreakpointLocations.end()) {
+      gBreakpointLocations.Put(key, 1U);
+    } else {
+      ++it->second;
+    }
     VLOG(jdwp) << "Set breakpoint #" << (gBreakpoints.size() - 1) << ": "
                << gBreakpoints[gBreakpoints.size() - 1];
   }
@@ -3208,6 +3228,12 @@ void Dbg::UnwatchLocation(const JDWP::JdwpLocation* location, DeoptimizationRequ
       need_full_deoptimization = gBreakpoints[i].NeedFullDeoptimization();
       DCHECK_NE(need_full_deoptimization, Runtime::Current()->GetInstrumentation()->IsDeoptimized(m));
       gBreakpoints.erase(gBreakpoints.begin() + i);
+      std::pair<const mirror::ArtMethod*, uint32_t> key(m, location->dex_pc);
+      auto it = gBreakpointLocations.find(key);
+      DCHECK(it != gBreakpointLocations.end());
+      if (--it->second == 0U) {
+        gBreakpointLocations.erase(it);
+      }
       break;
     }
   }
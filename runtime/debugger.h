@@ -308,6 +308,10 @@ class Dbg {
                             const JDWP::EventLocation& event_location)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // The method id of the JDWP locations in m.
+  static JDWP::MethodId GetMethodId(mirror::ArtMethod* m)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   static bool MatchType(mirror::Class* event_class, JDWP::RefTypeId class_id)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -23,10 +23,14 @@
 #include <string.h>
 #include <sys/file.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <memory>
 
 #include "base/logging.h"
+#include "base/stl_util.h"
 #include "base/stringprintf.h"
+#include "barrier.h"
 #include "class_linker.h"
 #include "dex_file-inl.h"
 #include "dex_file_verifier.h"
@@ -36,10 +40,12 @@
 #include "mirror/art_method-inl.h"
 #include "mirror/string.h"
 #include "os.h"
+#include "runtime.h"
 #include "safe_map.h"
 #include "ScopedFd.h"
 #include "handle_scope-inl.h"
 #include "thread.h"
+#include "thread_pool.h"
 #include "utf-inl.h"
 #include "utils.h"
 #include "well_known_classes.h"
@@ -245,7 +251,7 @@ const DexFile* DexFile::OpenMemory(const std::string& location,
 }
 
 const DexFile* DexFile::Open(const ZipArchive& zip_archive, const char* entry_name,
-                             const std::string& location, std::string* error_msg,
+                             const std::string& location, bool verify, std::string* error_msg,
                              ZipOpenErrorCode* error_code) {
   CHECK(!location.empty());
   std::unique_ptr<ZipEntry> zip_entry(zip_archive.Find(entry_name, error_msg));
@@ -253,7 +259,9 @@ const DexFile* DexFile::Open(const ZipArchive& zip_archive, const char* entry_na
     *error_code = ZipOpenErrorCode::kEntryNotFound;
     return nullptr;
   }
-  std::unique_ptr<MemMap> map(zip_entry->ExtractToMemMap(location.c_str(), entry_name, error_msg));
+  // Uncompressed entries aligned for the dex file's word sized structures are used in place.
+  std::unique_ptr<MemMap> map(zip_entry->MapDirectlyOrExtract(location.c_str(), entry_name,
+                                                              sizeof(uint32_t), error_msg));
   if (map.get() == NULL) {
     *error_msg = StringPrintf("Failed to extract '%s' from '%s': %s", entry_name, location.c_str(),
                               error_msg->c_str());
@@ -268,14 +276,14 @@ const DexFile* DexFile::Open(const ZipArchive& zip_archive, const char* entry_na
     *error_code = ZipOpenErrorCode::kDexFileError;
     return nullptr;
   }
-  if (!dex_file->DisableWrite()) {
+  if (!dex_file->IsReadOnly() && !dex_file->DisableWrite()) {
     *error_msg = StringPrintf("Failed to make dex file '%s' read only", location.c_str());
     *error_code = ZipOpenErrorCode::kMakeReadOnlyError;
     return nullptr;
   }
   CHECK(dex_file->IsReadOnly()) << location;
-  if (!DexFileVerifier::Verify(dex_file.get(), dex_file->Begin(), dex_file->Size(),
-                               location.c_str(), error_msg)) {
+  if (verify && !DexFileVerifier::Verify(dex_file.get(), dex_file->Begin(), dex_file->Size(),
+                                         location.c_str(), error_msg)) {
     *error_code = ZipOpenErrorCode::kVerifyError;
     return nullptr;
   }
@@ -283,45 +291,113 @@ const DexFile* DexFile::Open(const ZipArchive& zip_archive, const char* entry_na
   return dex_file.release();
 }
 
+// Runs the checksum and verifier passes over an opened dex file. Passes the barrier once a
+// thread pool worker is done with it.
+class DexFileVerifyTask : public Task {
+ public:
+  DexFileVerifyTask(const DexFile* dex_file, Barrier* barrier)
+      : dex_file_(dex_file), barrier_(barrier), verified_(false) {
+  }
+
+  void Run(Thread* self) OVERRIDE {
+    verified_ = DexFileVerifier::Verify(dex_file_, dex_file_->Begin(), dex_file_->Size(),
+                                        dex_file_->GetLocation().c_str(), &error_msg_);
+  }
+
+  // Called by the worker after Run, the task may be deleted as soon as the barrier is passed.
+  void Finalize() OVERRIDE {
+    barrier_->Pass(Thread::Current());
+  }
+
+  bool IsVerified() const {
+    return verified_;
+  }
+
+  const std::string& GetErrorMsg() const {
+    return error_msg_;
+  }
+
+ private:
+  const DexFile* const dex_file_;
+  Barrier* const barrier_;
+  bool verified_;
+  std::string error_msg_;
+};
+
 bool DexFile::OpenFromZip(const ZipArchive& zip_archive, const std::string& location,
                           std::string* error_msg, std::vector<const DexFile*>* dex_files) {
-  ZipOpenErrorCode error_code;
-  std::unique_ptr<const DexFile> dex_file(Open(zip_archive, kClassesDex, location, error_msg,
-                                               &error_code));
-  if (dex_file.get() == nullptr) {
-    return false;
-  } else {
-    // Had at least classes.dex.
-    dex_files->push_back(dex_file.release());
-
-    // Now try some more.
-    size_t i = 2;
-
-    // We could try to avoid std::string allocations by working on a char array directly. As we
-    // do not expect a lot of iterations, this seems too involved and brittle.
-
-    while (i < 100) {
-      std::string name = StringPrintf("classes%zu.dex", i);
-      std::string fake_location = location + kMultiDexSeparator + name;
-      std::unique_ptr<const DexFile> next_dex_file(Open(zip_archive, name.c_str(), fake_location,
-                                                        error_msg, &error_code));
-      if (next_dex_file.get() == nullptr) {
-        if (error_code != ZipOpenErrorCode::kEntryNotFound) {
-          LOG(WARNING) << error_msg;
+  // Extraction shares the archive's file offset, so the dex files are extracted one after the
+  // other on this thread. Their checksum and verifier passes, which dominate for large apps, are
+  // handed to the runtime's verifier thread pool as soon as there is a second dex file. Workers can
+  // only be waited for by an attached thread that doesn't hold the mutator lock.
+  Thread* self = Thread::Current();
+  const bool can_use_thread_pool = self != nullptr && !Locks::mutator_lock_->IsSharedHeld(self);
+  ThreadPool* thread_pool = nullptr;
+  // The pool is shared with other archives being opened, only the tasks of this one are waited
+  // for.
+  Barrier barrier(0);
+  std::vector<const DexFile*> opened_dex_files;
+  std::vector<DexFileVerifyTask*> verify_tasks;
+
+  // We could try to avoid std::string allocations by working on a char array directly. As we
+  // do not expect a lot of iterations, this seems too involved and brittle.
+  for (size_t i = 1; i < 100; ++i) {
+    const std::string name =
+        (i == 1) ? std::string(kClassesDex) : StringPrintf("classes%zu.dex", i);
+    const std::string entry_location = (i == 1) ? location : location + kMultiDexSeparator + name;
+    ZipOpenErrorCode error_code;
+    const DexFile* dex_file = Open(zip_archive, name.c_str(), entry_location, false, error_msg,
+                                   &error_code);
+    if (dex_file == nullptr) {
+      if (i > 1 && error_code != ZipOpenErrorCode::kEntryNotFound) {
+        LOG(WARNING) << *error_msg;
+      }
+      break;
+    }
+    opened_dex_files.push_back(dex_file);
+    verify_tasks.push_back(new DexFileVerifyTask(dex_file, &barrier));
+    if (thread_pool != nullptr) {
+      thread_pool->AddTask(self, verify_tasks.back());
+    } else if (i == 2 && can_use_thread_pool) {
+      thread_pool = Runtime::Current()->GetDexFileVerifyThreadPool(self);
+      if (thread_pool != nullptr) {
+        for (DexFileVerifyTask* task : verify_tasks) {
+          thread_pool->AddTask(self, task);
         }
-        break;
-      } else {
-        dex_files->push_back(next_dex_file.release());
       }
-
-      i++;
     }
+  }
+  if (thread_pool != nullptr) {
+    barrier.Increment(self, static_cast<int>(verify_tasks.size()));
+  } else {
+    for (DexFileVerifyTask* task : verify_tasks) {
+      task->Run(self);
+    }
+  }
 
-    return true;
+  // Accept dex files in order up to the first one failing verification, as if they had been opened
+  // and verified one at a time.
+  bool accepting = true;
+  for (size_t i = 0; i < opened_dex_files.size(); ++i) {
+    if (accepting && !verify_tasks[i]->IsVerified()) {
+      accepting = false;
+      *error_msg = verify_tasks[i]->GetErrorMsg();
+      if (i != 0) {
+        LOG(WARNING) << *error_msg;
+      }
+    }
+    if (accepting) {
+      dex_files->push_back(opened_dex_files[i]);
+    } else {
+      delete opened_dex_files[i];
+    }
   }
+  // Succeed if we had at least classes.dex.
+  const bool success = !verify_tasks.empty() && verify_tasks[0]->IsVerified();
+  STLDeleteElements(&verify_tasks);
+  return success;
 }
 
-
 const DexFile* DexFile::OpenMemory(const byte* base,
                                    size_t size,
                                    const std::string& location,
@@ -472,6 +548,65 @@ const DexFile::ClassDef* DexFile::FindClassDef(uint16_t type_idx) const {
   return NULL;
 }
 
+uint32_t DexFile::GetNativeMethodAnnotationAccessFlags(const ClassDef& class_def,
+                                                      uint32_t method_idx,
+                                                      uint32_t access_flags) const {
+  DCHECK_NE(access_flags & kAccNative, 0U);
+  if (class_def.annotations_off_ == 0) {
+    return 0;
+  }
+  const AnnotationsDirectoryItem* directory =
+      reinterpret_cast<const AnnotationsDirectoryItem*>(begin_ + class_def.annotations_off_);
+  const FieldAnnotationsItem* field_annotations =
+      reinterpret_cast<const FieldAnnotationsItem*>(directory + 1);
+  const MethodAnnotationsItem* method_annotations =
+      reinterpret_cast<const MethodAnnotationsItem*>(field_annotations + directory->fields_size_);
+  const AnnotationSetItem* annotation_set = nullptr;
+  // Method annotations are sorted by method index.
+  for (uint32_t i = 0; i < directory->methods_size_; ++i) {
+    if (method_annotations[i].method_idx_ >= method_idx) {
+      if (method_annotations[i].method_idx_ == method_idx) {
+        annotation_set = reinterpret_cast<const AnnotationSetItem*>(
+            begin_ + method_annotations[i].annotations_off_);
+      }
+      break;
+    }
+  }
+  if (annotation_set == nullptr) {
+    return 0;
+  }
+  uint32_t flags = 0;
+  for (uint32_t i = 0; i < annotation_set->size_; ++i) {
+    const AnnotationItem* annotation =
+        reinterpret_cast<const AnnotationItem*>(begin_ + annotation_set->entries_[i]);
+    if (annotation->visibility_ != kDexVisibilityBuild) {
+      continue;
+    }
+    const byte* annotation_data = annotation->annotation_;
+    const char* descriptor = StringByTypeIdx(DecodeUnsignedLeb128(&annotation_data));
+    if (strcmp(descriptor, "Ldalvik/annotation/optimization/FastNative;") == 0) {
+      flags |= kAccFastNative;
+    } else if (strcmp(descriptor, "Ldalvik/annotation/optimization/CriticalNative;") == 0) {
+      flags |= kAccCriticalNative;
+    }
+  }
+  if (flags == (kAccFastNative | kAccCriticalNative)) {
+    LOG(WARNING) << "Ignoring @FastNative and @CriticalNative on "
+                 << PrettyMethod(method_idx, *this) << ", they are exclusive";
+    return 0;
+  }
+  if (flags == kAccCriticalNative) {
+    const char* shorty = GetMethodShorty(GetMethodId(method_idx));
+    if ((access_flags & kAccStatic) == 0 || (access_flags & kAccSynchronized) != 0 ||
+        strchr(shorty, 'L') != nullptr) {
+      LOG(WARNING) << "Ignoring @CriticalNative on " << PrettyMethod(method_idx, *this)
+                   << ", it is not a static non-synchronized method of primitives";
+      return 0;
+    }
+  }
+  return flags;
+}
+
 const DexFile::FieldId* DexFile::FindFieldId(const DexFile::TypeId& declaring_klass,
                                               const DexFile::StringId& name,
                                               const DexFile::TypeId& type) const {
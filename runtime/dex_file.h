@@ -654,6 +654,14 @@ class DexFile {
   // Looks up a class definition by its type index.
   const ClassDef* FindClassDef(uint16_t type_idx) const;
 
+  // Returns kAccFastNative or kAccCriticalNative for a native method of class_def annotated with
+  // the build visible @dalvik.annotation.optimization.FastNative or CriticalNative, 0 otherwise.
+  // Fast natives run without leaving the Runnable state. Critical natives must also be static,
+  // not synchronized and only take and return primitives, they are called without JNIEnv* and
+  // jclass. Annotations on methods breaking those rules are ignored with a warning.
+  uint32_t GetNativeMethodAnnotationAccessFlags(const ClassDef& class_def, uint32_t method_idx,
+                                                uint32_t access_flags) const;
+
   const TypeList* GetInterfacesList(const ClassDef& class_def) const {
     if (class_def.interfaces_off_ == 0) {
         return NULL;
@@ -905,9 +913,9 @@ class DexFile {
   };
 
   // Opens .dex file from the entry_name in a zip archive. error_code is undefined when non-nullptr
-  // return.
+  // return. When verify is false the caller is responsible for running the DexFileVerifier.
   static const DexFile* Open(const ZipArchive& zip_archive, const char* entry_name,
-                             const std::string& location, std::string* error_msg,
+                             const std::string& location, bool verify, std::string* error_msg,
                              ZipOpenErrorCode* error_code);
 
   // Opens a .dex file at the given address backed by a MemMap
@@ -16,14 +16,18 @@
 
 #include "dex_file.h"
 
+#include <unistd.h>
+
 #include <memory>
 
 #include "base/stl_util.h"
 #include "base/unix_file/fd_file.h"
 #include "common_runtime_test.h"
+#include "dex_file_verifier.h"
 #include "os.h"
 #include "scoped_thread_state_change.h"
 #include "thread-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -207,6 +211,101 @@ TEST_F(DexFileTest, GetChecksum) {
   EXPECT_EQ(java_lang_dex_file_->GetLocationChecksum(), checksum);
 }
 
+TEST_F(DexFileTest, VerifyThroughput) {
+  // Not a pass/fail benchmark, reports the rate of the checksum and verifier passes, including
+  // the string data checks, over core-libart.
+  ScopedObjectAccess soa(Thread::Current());
+  const DexFile* dex_file = java_lang_dex_file_;
+  const size_t kIterations = 5;
+  std::string error_msg;
+  uint64_t start_ns = NanoTime();
+  for (size_t i = 0; i < kIterations; ++i) {
+    ASSERT_TRUE(DexFileVerifier::Verify(dex_file, dex_file->Begin(), dex_file->Size(),
+                                        dex_file->GetLocation().c_str(), &error_msg)) << error_msg;
+  }
+  uint64_t verify_ns = NanoTime() - start_ns;
+  LOG(INFO) << "Verified " << PrettySize(kIterations * dex_file->Size()) << " in "
+            << PrettyDuration(verify_ns) << ", "
+            << PrettySize(kIterations * dex_file->Size() * 1000000000 / (verify_ns + 1)) << "/s";
+}
+
+// A zip of classes.dex, classes2.dex and classes3.dex, each the dex file of kRawDex, and of
+// classes4.dex, a copy with a bad checksum.
+static const char kMultiDexZip[] =
+  "UEsDBBQAAAAIAAAAIUT4CtPz7gEAAIgDAAALAAAAY2xhc3Nlcy5kZXhtkz9oFEEUxt/M7u0lubgu"
+  "13gQiaekzgXU6mIIiKKwURC5xkLm7sZz42YuOOuRYBO7E0QsLMQ2TUBJGdLESsHGLqiljZBSbG38"
+  "ZmdWFrmB3877N29mZ7/ty62ZpYuXKdr+Tk8PZ4/PfZ3/9Pzkw88GrzcWf7+4MvaINoloq3OpTm58"
+  "5ESnycar4D1AiD4DBn4ALKMTFzfBGzBWMe+DA3AEvoBv4A+YQ34F3AH3QRc8ABpsg2fc9jJ9fVAB"
+  "gdt/2hG48804e4/ZzU+RO8S/p11fHoU/BcYoesdpYr3Jv0Hw0OXN9BqPt9zW7ubn5Lk95vYc9+Bs"
+  "RqYyRJzluZfcvkcRXy02ciP+z2c5wXKikmyFKjeVko8pjG9Jncn+Qu62acr5bboQ90U6Sh61hFLD"
+  "TGTJULWuqV461IkaXE2F1m2an1CTN3L58xPya3Kj6wokSurxuhiJVirUoHW7uy57WZtq9gyLJkOs"
+  "Q7wTU030elLr66kYaPKV2JAUZA8TvbBElZFIn0jijKrmdqrhMnHOwgbjHq/5NHuGcZ+FZ1kD749L"
+  "eNWknR3/OL9tBusXrKh0R8Vc6JOXNOqVdOqXtFop6TUoadaLrG2+DWta+y7swNlGJyyyfYzWeNPu"
+  "azTuFTXmOzdtf6MTcvFcX26t+Z/+AlBLAwQUAAAACAAAACFE+ArT8+4BAACIAwAADAAAAGNsYXNz"
+  "ZXMyLmRleG2TP2gUQRTG38zu7SW5uC7XeBCJp6TOBdTqYgiIorBRELnGQubuxnPjZi4465FgE7sT"
+  "RCwsxDZNQEkZ0sRKwcYuqKWNkFJsbfxmZ1YWuYHfzvs3b2Znv+3LrZmli5cp2v5OTw9nj899nf/0"
+  "/OTDzwavNxZ/v7gy9og2iWirc6lObnzkRKfJxqvgPUCIPgMGfgAsoxMXN8EbMFYx74MDcAS+gG/g"
+  "D5hDfgXcAfdBFzwAGmyDZ9z2Mn19UAGB23/aEbjzzTh7j9nNT5E7xL+nXV8ehT8Fxih6x2livcm/"
+  "QfDQ5c30Go+33Nbu5ufkuT3m9hz34GxGpjJEnOW5l9y+RxFfLTZyI/7PZznBcqKSbIUqN5WSjymM"
+  "b0mdyf5C7rZpyvltuhD3RTpKHrWEUsNMZMlQta6pXjrUiRpcTYXWbZqfUJM3cvnzE/JrcqPrCiRK"
+  "6vG6GIlWKtSgdbu7LntZm2r2DIsmQ6xDvBNTTfR6UuvrqRho8pXYkBRkDxO9sESVkUifSOKMquZ2"
+  "quEycc7CBuMer/k0e4Zxn4VnWQPvj0t41aSdHf84v20G6xesqHRHxVzok5c06pV06pe0WinpNShp"
+  "1ousbb4Na1r7LuzA2UYnLLJ9jNZ40+5rNO4VNeY7N21/oxNy8Vxfbq35n/4CUEsDBBQAAAAIAAAA"
+  "IUT4CtPz7gEAAIgDAAAMAAAAY2xhc3NlczMuZGV4bZM/aBRBFMbfzO7tJbm4Ltd4EImnpM4F1Opi"
+  "CIiisFEQucZC5u7Gc+NmLjjrkWATuxNELCzENk1ASRnSxErBxi6opY2QUmxt/GZnVha5gd/O+zdv"
+  "Zme/7cutmaWLlyna/k5PD2ePz32d//T85MPPBq83Fn+/uDL2iDaJaKtzqU5ufOREp8nGq+A9QIg+"
+  "AwZ+ACyjExc3wRswVjHvgwNwBL6Ab+APmEN+BdwB90EXPAAabINn3PYyfX1QAYHbf9oRuPPNOHuP"
+  "2c1PkTvEv6ddXx6FPwXGKHrHaWK9yb9B8NDlzfQaj7fc1u7m5+S5Peb2HPfgbEamMkSc5bmX3L5H"
+  "EV8tNnIj/s9nOcFyopJshSo3lZKPKYxvSZ3J/kLutmnK+W26EPdFOkoetYRSw0xkyVC1rqleOtSJ"
+  "GlxNhdZtmp9Qkzdy+fMT8mtyo+sKJErq8boYiVYq1KB1u7sue1mbavYMiyZDrEO8E1NN9HpS6+up"
+  "GGjyldiQFGQPE72wRJWRSJ9I4oyq5naq4TJxzsIG4x6v+TR7hnGfhWdZA++PS3jVpJ0d/zi/bQbr"
+  "F6yodEfFXOiTlzTqlXTql7RaKek1KGnWi6xtvg1rWvsu7MDZRicssn2M1njT7ms07hU15js3bX+j"
+  "E3LxXF9urfmf/gJQSwMEFAAAAAgAAAAhROCDg+PxAQAAiAMAAAwAAABjbGFzc2VzNC5kZXhtkz9o"
+  "FEEUxt/M7u3FXFyXazyIxFNS5wJqdTEERElgVRC5xkLm7sZz42YuOOuRYBO7C4hYWIitTUCxlDSm"
+  "imBjF9TSRkgpadP4zc6srJKB3877N29mZ7/ty43J+UtXKNr8QU93pw7Of5v5vH2496vB6425o+dX"
+  "xx7ROhFtdC7XyY19TnSGbLwK3gOE6Atg4CfAMjp0cRNchrGE+QP4CD6Br+A7OAbTyC+CO+A+6IIH"
+  "QINN8IzbXqavDyogcPufcgTufJPO3mF289PkDvH3adeXR+FPgDGK3nE6sd7kXyO46/JmeoXHG25r"
+  "3+bn5Lk95vYc9+CsR6YyRJzluRfcvkcRXyo2ciP+z2c5wUKikmyRKitKyccUxrekzmR/NnfbNOH8"
+  "Nl2M+yIdJY9aQqlhJrJkqFrXVS8d6kQNrqVC6zbNmJrtf2vyRi5/4YQeN+Va1xVIlNTjVTESrVSo"
+  "Qet2d1X2sjbV7BnmTIZYh3gnppro9aTWN1Ix0OQrsSYpyB4menaeKiORPpHEGVXN7VTDBeKchQ3G"
+  "PV7zaeos4z4Lz7EG3h+X8LJJW1v+QX7bDNZvWFHpjoq50CcvadQr6dQvabVS0mtQ0qwXWdt8G9a0"
+  "9l3YgbONTlhk+xit8abd12jcK2rMd27a/kYn5OK5vtxa8z/9AVBLAQIUAxQAAAAIAAAAIUT4CtPz"
+  "7gEAAIgDAAALAAAAAAAAAAAAAACAAQAAAABjbGFzc2VzLmRleFBLAQIUAxQAAAAIAAAAIUT4CtPz"
+  "7gEAAIgDAAAMAAAAAAAAAAAAAACAARcCAABjbGFzc2VzMi5kZXhQSwECFAMUAAAACAAAACFE+ArT"
+  "8+4BAACIAwAADAAAAAAAAAAAAAAAgAEvBAAAY2xhc3NlczMuZGV4UEsBAhQDFAAAAAgAAAAhROCD"
+  "g+PxAQAAiAMAAAwAAAAAAAAAAAAAAIABRwYAAGNsYXNzZXM0LmRleFBLBQYAAAAABAAEAOcAAABi"
+  "CAAAAAA=";
+
+TEST_F(DexFileTest, OpenMultiDexZip) {
+  // Not holding the mutator lock, the dex files after classes.dex are verified on the runtime's
+  // verifier thread pool as well as on this thread.
+  ScratchFile tmp;
+  size_t length;
+  std::unique_ptr<byte[]> zip_bytes(DecodeBase64(kMultiDexZip, &length));
+  ASSERT_TRUE(zip_bytes.get() != nullptr);
+  ASSERT_TRUE(tmp.GetFile()->WriteFully(zip_bytes.get(), length));
+  const char* location = tmp.GetFilename().c_str();
+  // The second archive reuses the thread pool created for the first.
+  for (size_t i = 0; i < 2; ++i) {
+    std::string error_msg;
+    std::vector<const DexFile*> dex_files;
+    ASSERT_TRUE(DexFile::Open(location, location, &error_msg, &dex_files)) << error_msg;
+    // The dex files are accepted in order up to the first failing verification.
+    ASSERT_EQ(3U, dex_files.size());
+    for (size_t j = 0; j < dex_files.size(); ++j) {
+      EXPECT_EQ(DexFile::GetMultiDexClassesDexName(j, location), dex_files[j]->GetLocation());
+      EXPECT_EQ(904U, dex_files[j]->GetHeader().file_size_);
+    }
+    EXPECT_NE(std::string::npos, error_msg.find("classes4.dex")) << error_msg;
+    STLDeleteElements(&dex_files);
+  }
+  if (sysconf(_SC_NPROCESSORS_CONF) > 1) {
+    ThreadPool* thread_pool = Runtime::Current()->GetDexFileVerifyThreadPool(Thread::Current());
+    ASSERT_TRUE(thread_pool != nullptr);
+    EXPECT_GT(thread_pool->GetThreadCount(), 0U);
+  }
+}
+
 TEST_F(DexFileTest, ClassDefs) {
   ScopedObjectAccess soa(Thread::Current());
   const DexFile* raw(OpenTestDexFile("Nested"));
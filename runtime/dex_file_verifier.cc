@@ -17,6 +17,7 @@
 #include "dex_file_verifier.h"
 
 #include <zlib.h>
+#include <algorithm>
 #include <memory>
 
 #include "base/stringprintf.h"
@@ -821,6 +822,14 @@ bool DexFileVerifier::CheckIntraStringDataItem() {
       return false;
     }
 
+    // Skip runs of non-zero ASCII, which need no further checks.
+    size_t ascii_count = CountLeadingAsciiChars(ptr_, std::min<size_t>(size - i, file_end - ptr_));
+    if (ascii_count != 0) {
+      ptr_ += ascii_count;
+      i += ascii_count - 1;
+      continue;
+    }
+
     uint8_t byte = *(ptr_++);
 
     // Switch on the high 4 bits.
@@ -21,6 +21,7 @@
 
 #include "class_linker-inl.h"
 #include "common_throws.h"
+#include "cpu_sampling_profiler.h"
 #include "dex_file.h"
 #include "indirect_reference_table.h"
 #include "invoke_type.h"
@@ -638,6 +639,9 @@ static inline void CheckSuspend(Thread* thread) {
       thread->RunCheckpointFunction();
     } else if (thread->ReadFlag(kSuspendRequest)) {
       thread->FullSuspendCheck();
+    } else if (thread->ReadFlag(kCpuSampleRequest)) {
+      thread->AtomicClearFlag(kCpuSampleRequest);
+      CpuSamplingProfiler::RecordSample(thread);
     } else {
       break;
     }
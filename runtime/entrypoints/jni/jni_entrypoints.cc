@@ -24,15 +24,15 @@
 namespace art {
 
 // Used by the JNI dlsym stub to find the native method to invoke if none is registered.
+// Fast and critical natives get here Runnable, the others Native, hence no thread safety analysis.
 #if defined(__arm__) || defined(__aarch64__)
-extern "C" void* artFindNativeMethod() {
+extern "C" void* artFindNativeMethod() NO_THREAD_SAFETY_ANALYSIS {
   Thread* self = Thread::Current();
 #else
-extern "C" void* artFindNativeMethod(Thread* self) {
+extern "C" void* artFindNativeMethod(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
   DCHECK_EQ(self, Thread::Current());
 #endif
-  Locks::mutator_lock_->AssertNotHeld(self);  // We come here as Native.
-  ScopedObjectAccess soa(self);
+  ScopedObjectAccessUnchecked soa(self);
 
   mirror::ArtMethod* method = self->GetCurrentMethod(NULL);
   DCHECK(method != NULL);
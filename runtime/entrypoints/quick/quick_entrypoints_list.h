@@ -121,6 +121,8 @@
   V(InvokeVirtualTrampolineWithAccessCheck, void, uint32_t, void*) \
 \
   V(TestSuspend, void, void) \
+  V(MethodEntryHook, void, mirror::ArtMethod*) \
+  V(MethodExitHook, void, mirror::ArtMethod*) \
 \
   V(DeliverException, void, void*) \
   V(ThrowArrayBounds, void, int32_t, int32_t) \
@@ -15,11 +15,13 @@
  */
 
 #include "callee_save_frame.h"
+#include "entrypoints/entrypoint_utils.h"
 #include "instruction_set.h"
 #include "instrumentation.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/object-inl.h"
 #include "runtime.h"
+#include "stack.h"
 #include "thread-inl.h"
 
 namespace art {
@@ -72,4 +74,50 @@ extern "C" TwoWordReturn artInstrumentationMethodExitFromCode(Thread* self,
   return return_or_deoptimize_pc;
 }
 
+// Finds the return pc of the method that called into the runtime.
+class HookedFrameReturnPcVisitor : public StackVisitor {
+ public:
+  explicit HookedFrameReturnPcVisitor(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      : StackVisitor(self, nullptr), return_pc_(0) {}
+
+  bool VisitFrame() OVERRIDE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (GetMethod()->IsRuntimeMethod()) {
+      return true;  // Skip the callee save frame of the hook.
+    }
+    return_pc_ = GetReturnPc();
+    return false;
+  }
+
+  uintptr_t return_pc_;
+};
+
+extern "C" void artMethodEntryHookFromCode(mirror::ArtMethod* method, Thread* self,
+                                           StackReference<mirror::ArtMethod>* sp)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  FinishCalleeSaveFrameSetup(self, sp, Runtime::kRefsOnly);
+  // The receiver is not available to the hook, listeners see a null this object.
+  Runtime::Current()->GetInstrumentation()->MethodEnterEvent(self, nullptr, method, 0);
+}
+
+extern "C" void artMethodExitHookFromCode(mirror::ArtMethod* method, Thread* self,
+                                          StackReference<mirror::ArtMethod>* sp)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  FinishCalleeSaveFrameSetup(self, sp, Runtime::kRefsOnly);
+  instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
+  if (!instrumentation->HasMethodExitListeners()) {
+    return;
+  }
+  // A frame that was already active when tracing started had an instrumentation exit stub
+  // installed, which reports the exit instead.
+  if (!self->GetInstrumentationStack()->empty()) {
+    HookedFrameReturnPcVisitor visitor(self);
+    visitor.WalkStack(true);
+    if (visitor.return_pc_ == GetQuickInstrumentationExitPc()) {
+      return;
+    }
+  }
+  // The return value is not available to the hook, listeners see a zero value.
+  instrumentation->MethodExitEvent(self, nullptr, method, 0, JValue());
+}
+
 }  // namespace art
@@ -34,8 +34,9 @@ extern uint32_t JniMethodStart(Thread* self) {
   uint32_t saved_local_ref_cookie = env->local_ref_cookie;
   env->local_ref_cookie = env->locals.GetSegmentState();
   mirror::ArtMethod* native_method = self->GetManagedStack()->GetTopQuickFrame()->AsMirrorPtr();
-  if (!native_method->IsFastNative()) {
-    // When not fast JNI we transition out of runnable.
+  if (!native_method->IsFastNative() && !native_method->IsCriticalNative()) {
+    // When not fast JNI we transition out of runnable. Critical natives only get here through the
+    // generic JNI trampoline and stay Runnable like they do with their compiled stub.
     self->TransitionFromRunnableToSuspended(kNative);
   }
   return saved_local_ref_cookie;
@@ -49,7 +50,7 @@ extern uint32_t JniMethodStartSynchronized(jobject to_lock, Thread* self) {
 // TODO: NO_THREAD_SAFETY_ANALYSIS due to different control paths depending on fast JNI.
 static void GoToRunnable(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
   mirror::ArtMethod* native_method = self->GetManagedStack()->GetTopQuickFrame()->AsMirrorPtr();
-  bool is_fast = native_method->IsFastNative();
+  bool is_fast = native_method->IsFastNative() || native_method->IsCriticalNative();
   if (!is_fast) {
     self->TransitionFromSuspendedToRunnable();
   } else if (UNLIKELY(self->TestAllFlags())) {
@@ -130,8 +130,16 @@ class EntrypointsOrderTest : public CommonRuntimeTest {
     EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, thread_local_alloc_stack_top, thread_local_alloc_stack_end,
                         kPointerSize);
     EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, thread_local_alloc_stack_end, held_mutexes, kPointerSize);
-    EXPECT_OFFSET_DIFF(Thread, tlsPtr_.held_mutexes, Thread, wait_mutex_,
-                       kPointerSize * kLockLevelCount + kPointerSize, thread_tlsptr_end);
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, held_mutexes, nested_signal_state,
+                        kPointerSize * kLockLevelCount);
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, nested_signal_state, contention_sample_buffer,
+                        kPointerSize);
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, contention_sample_buffer, cpu_sample_buffer,
+                        kPointerSize);
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, cpu_sample_buffer, trace_buffer, kPointerSize);
+    EXPECT_OFFSET_DIFFP(Thread, tlsPtr_, trace_buffer, method_trace_hooks, kPointerSize);
+    EXPECT_OFFSET_DIFF(Thread, tlsPtr_.method_trace_hooks, Thread, wait_mutex_,
+                       kPointerSize, thread_tlsptr_end);
   }
 
   void CheckInterpreterEntryPoints() {
@@ -277,7 +285,9 @@ class EntrypointsOrderTest : public CommonRuntimeTest {
                          pInvokeVirtualTrampolineWithAccessCheck, kPointerSize);
     EXPECT_OFFSET_DIFFNP(QuickEntryPoints, pInvokeVirtualTrampolineWithAccessCheck,
                          pTestSuspend, kPointerSize);
-    EXPECT_OFFSET_DIFFNP(QuickEntryPoints, pTestSuspend, pDeliverException, kPointerSize);
+    EXPECT_OFFSET_DIFFNP(QuickEntryPoints, pTestSuspend, pMethodEntryHook, kPointerSize);
+    EXPECT_OFFSET_DIFFNP(QuickEntryPoints, pMethodEntryHook, pMethodExitHook, kPointerSize);
+    EXPECT_OFFSET_DIFFNP(QuickEntryPoints, pMethodExitHook, pDeliverException, kPointerSize);
 
     EXPECT_OFFSET_DIFFNP(QuickEntryPoints, pDeliverException, pThrowArrayBounds, kPointerSize);
     EXPECT_OFFSET_DIFFNP(QuickEntryPoints, pThrowArrayBounds, pThrowDivZero, kPointerSize);
@@ -64,6 +64,7 @@ static constexpr bool kParallelRecursiveMark = true;
 // ProcessMarkStack with very small mark stacks.
 static constexpr size_t kMinimumParallelMarkStackSize = 128;
 static constexpr bool kParallelProcessMarkStack = true;
+static constexpr bool kParallelThreadRootMarking = true;
 
 // Profiling and information flags.
 static constexpr bool kProfileLargeObjects = false;
@@ -498,7 +499,19 @@ void MarkSweep::MarkRoots(Thread* self) {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   if (Locks::mutator_lock_->IsExclusiveHeld(self)) {
     // If we exclusively hold the mutator lock, all threads must be suspended.
-    Runtime::Current()->VisitRoots(MarkRootCallback, this);
+    Runtime* runtime = Runtime::Current();
+    size_t thread_count = GetThreadCount(true);
+    if (kParallelThreadRootMarking && thread_count > 1) {
+      {
+        TimingLogger::ScopedTiming t2("MarkThreadRootsParallel", GetTimings());
+        runtime->GetThreadList()->VisitRootsParallel(MarkRootParallelCallback, this,
+                                                     heap_->GetThreadPool(), thread_count);
+      }
+      runtime->VisitNonThreadRoots(MarkRootCallback, this);
+      runtime->VisitConcurrentRoots(MarkRootCallback, this);
+    } else {
+      runtime->VisitRoots(MarkRootCallback, this);
+    }
     RevokeAllThreadLocalAllocationStacks(self);
   } else {
     MarkRootsCheckpoint(self, kRevokeRosAllocThreadLocalBuffersAtCheckpoint);
@@ -988,9 +1001,16 @@ void MarkSweep::MarkRootsCheckpoint(Thread* self,
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   CheckpointMarkThreadRoots check_point(this, revoke_ros_alloc_thread_local_buffers_at_checkpoint);
   ThreadList* thread_list = Runtime::Current()->GetThreadList();
+  // Suspended threads have their checkpoints run by the GC thread pool, if there is one.
+  ThreadPool* thread_pool = nullptr;
+  size_t thread_count = GetThreadCount(false);
+  if (kParallelThreadRootMarking && thread_count > 1) {
+    thread_pool = heap_->GetThreadPool();
+    thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  }
   // Request the check point is run on all threads returning a count of the threads that must
   // run through the barrier including self.
-  size_t barrier_count = thread_list->RunCheckpoint(&check_point);
+  size_t barrier_count = thread_list->RunCheckpoint(&check_point, thread_pool);
   // Release locks then wait for all mutator threads to pass the barrier.
   // TODO: optimize to not release locks when there are no threads to wait for.
   Locks::heap_bitmap_lock_->ExclusiveUnlock(self);
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc_telemetry.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "base/logging.h"
+#include "base/timing_logger.h"
+#include "base/unix_file/fd_file.h"
+#include "thread.h"
+
+namespace art {
+namespace gc {
+
+GcTelemetry::GcTelemetry()
+    : last_id_(0),
+      slots_(new Slot[kCapacity]),
+      streaming_(false),
+      dropped_records_(0),
+      stream_lock_("gc telemetry stream lock") {
+  for (size_t i = 0; i < kCapacity; ++i) {
+    slots_[i].sequence.StoreRelaxed(0);
+  }
+}
+
+void GcTelemetry::SetPauses(const std::vector<uint64_t>& pause_times,
+                            GcTelemetryRecord* record) {
+  record->pause_count = pause_times.size();
+  record->total_pause_ns = 0;
+  record->max_pause_ns = 0;
+  for (size_t i = 0; i < pause_times.size(); ++i) {
+    if (i < GcTelemetryRecord::kMaxPauses) {
+      record->pauses_ns[i] = pause_times[i];
+    }
+    record->total_pause_ns += pause_times[i];
+    record->max_pause_ns = std::max(record->max_pause_ns, pause_times[i]);
+  }
+}
+
+void GcTelemetry::SetPhases(const TimingLogger& timings, GcTelemetryRecord* record) {
+  // Only the outermost timings are phases, the nested ones are accounted in them.
+  record->phase_count = 0;
+  size_t depth = 0;
+  uint64_t phase_start = 0;
+  const char* phase_name = nullptr;
+  for (const TimingLogger::Timing& timing : timings.GetTimings()) {
+    if (timing.IsStartTiming()) {
+      if (depth++ == 0) {
+        phase_start = timing.GetTime();
+        phase_name = timing.GetName();
+      }
+    } else if (--depth == 0 && record->phase_count < GcTelemetryRecord::kMaxPhases) {
+      GcTelemetryRecord::Phase* phase = &record->phases[record->phase_count++];
+      strncpy(phase->name, phase_name, GcTelemetryRecord::kMaxPhaseNameLength - 1);
+      phase->name[GcTelemetryRecord::kMaxPhaseNameLength - 1] = '\0';
+      // The names go into space separated output.
+      std::replace(phase->name, phase->name + strlen(phase->name), ' ', '_');
+      phase->duration_ns = timing.GetTime() - phase_start;
+    }
+  }
+}
+
+void GcTelemetry::Record(GcTelemetryRecord* record) {
+  const uint64_t id = last_id_.LoadRelaxed() + 1;
+  record->id = id;
+  Slot* slot = &slots_[(id - 1) % kCapacity];
+  // Readers of the previous record of this slot see the odd sequence, or a changed one after
+  // copying, and skip it.
+  slot->sequence.StoreRelaxed(2 * id - 1);
+  QuasiAtomic::ThreadFenceRelease();
+  slot->record = *record;
+  slot->sequence.StoreRelease(2 * id);
+  last_id_.StoreSequentiallyConsistent(id);
+}
+
+bool GcTelemetry::ReadRecord(uint64_t id, GcTelemetryRecord* record) const {
+  const Slot* slot = &slots_[(id - 1) % kCapacity];
+  if (slot->sequence.LoadSequentiallyConsistent() != 2 * id) {
+    return false;
+  }
+  *record = slot->record;
+  QuasiAtomic::ThreadFenceAcquire();
+  return slot->sequence.LoadRelaxed() == 2 * id;
+}
+
+void GcTelemetry::GetRecords(uint64_t after_id, std::vector<GcTelemetryRecord>* records) const {
+  const uint64_t last_id = GetLastId();
+  uint64_t first_id = after_id + 1;
+  if (last_id > kCapacity) {
+    first_id = std::max(first_id, last_id - kCapacity + 1);
+  }
+  GcTelemetryRecord record;
+  for (uint64_t id = first_id; id <= last_id; ++id) {
+    if (ReadRecord(id, &record)) {
+      records->push_back(record);
+    }
+  }
+}
+
+void GcTelemetry::StartStreaming(int fd) {
+  MutexLock mu(Thread::Current(), stream_lock_);
+  stream_file_.reset(new File(fd, "gc-telemetry"));
+  streaming_.StoreRelaxed(true);
+}
+
+void GcTelemetry::StopStreaming() {
+  MutexLock mu(Thread::Current(), stream_lock_);
+  streaming_.StoreRelaxed(false);
+  stream_file_.reset();
+}
+
+void GcTelemetry::Stream(const GcTelemetryRecord& record) {
+  if (!streaming_.LoadRelaxed()) {
+    return;
+  }
+  std::ostringstream os;
+  DumpRecord(os, record);
+  const std::string line(os.str());
+  MutexLock mu(Thread::Current(), stream_lock_);
+  if (stream_file_.get() == nullptr) {
+    return;
+  }
+  // The thread that finished the collection writes the record, it must not wait for the reader.
+  // The fd is shared with the caller, so rather than making it non-blocking, poll it: a pipe that
+  // polls writable has room for PIPE_BUF bytes, more than a line.
+  struct pollfd poll_fd;
+  poll_fd.fd = stream_file_->Fd();
+  poll_fd.events = POLLOUT;
+  poll_fd.revents = 0;
+  int ready = TEMP_FAILURE_RETRY(poll(&poll_fd, 1, kStreamTimeoutMs));
+  if (ready == 0) {
+    // The reader is behind, drop the record rather than stall the collecting thread.
+    dropped_records_.FetchAndAddSequentiallyConsistent(1);
+    return;
+  }
+  if (ready > 0 && (poll_fd.revents & POLLOUT) == 0) {
+    LOG(WARNING) << "Gc telemetry stream closed by the reader, stopping";
+    streaming_.StoreRelaxed(false);
+    stream_file_.reset();
+    return;
+  }
+  ssize_t bytes = -1;
+  if (ready > 0) {
+    bytes = TEMP_FAILURE_RETRY(write(stream_file_->Fd(), line.c_str(), line.size()));
+  }
+  if (bytes == -1) {
+    PLOG(WARNING) << "Failed to stream gc telemetry, stopping";
+    streaming_.StoreRelaxed(false);
+    stream_file_.reset();
+  } else if (static_cast<size_t>(bytes) != line.size()) {
+    // Only a socket may take part of the line, the rest of the record is lost.
+    dropped_records_.FetchAndAddSequentiallyConsistent(1);
+  }
+}
+
+void GcTelemetry::DumpRecord(std::ostream& os, const GcTelemetryRecord& record) {
+  os << "id=" << record.id
+     << " cause=" << record.cause
+     << " collector=" << record.collector_type
+     << " type=" << record.gc_type
+     << " start_ns=" << record.start_time_ns
+     << " duration_ns=" << record.duration_ns
+     << " pauses=" << record.pause_count
+     << " total_pause_ns=" << record.total_pause_ns
+     << " max_pause_ns=" << record.max_pause_ns
+     << " pauses_ns=";
+  const size_t pauses = std::min(record.pause_count, GcTelemetryRecord::kMaxPauses);
+  for (size_t i = 0; i < pauses; ++i) {
+    os << (i != 0 ? "," : "") << record.pauses_ns[i];
+  }
+  os << " freed_objects=" << record.freed_objects
+     << " freed_bytes=" << record.freed_bytes
+     << " freed_los_objects=" << record.freed_large_objects
+     << " freed_los_bytes=" << record.freed_large_object_bytes
+     << " allocated_before=" << record.bytes_allocated_before
+     << " allocated_after=" << record.bytes_allocated_after
+     << " total_memory=" << record.total_memory
+     << " allocation_rate=" << record.allocation_rate
+     << " phases_ns=";
+  for (size_t i = 0; i < record.phase_count; ++i) {
+    os << (i != 0 ? "," : "") << record.phases[i].name << ":" << record.phases[i].duration_ns;
+  }
+  os << "\n";
+}
+
+}  // namespace gc
+}  // namespace art
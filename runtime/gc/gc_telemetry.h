@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_GC_TELEMETRY_H_
+#define ART_RUNTIME_GC_GC_TELEMETRY_H_
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "gc/collector/gc_type.h"
+#include "gc/collector_type.h"
+#include "gc/gc_cause.h"
+#include "os.h"
+
+namespace art {
+
+class TimingLogger;
+
+namespace gc {
+
+// What a single collection cost and what it freed.
+struct GcTelemetryRecord {
+  static constexpr size_t kMaxPauses = 8;
+  static constexpr size_t kMaxPhases = 12;
+  static constexpr size_t kMaxPhaseNameLength = 32;
+
+  struct Phase {
+    char name[kMaxPhaseNameLength];
+    uint64_t duration_ns;
+  };
+
+  // Number of the collection since the heap was created, starting at 1.
+  uint64_t id;
+  GcCause cause;
+  CollectorType collector_type;
+  collector::GcType gc_type;
+  // NanoTime() when the collection was requested, and how long it took.
+  uint64_t start_time_ns;
+  uint64_t duration_ns;
+  // All pauses are counted in the total and the maximum, only the first kMaxPauses are kept.
+  size_t pause_count;
+  uint64_t pauses_ns[kMaxPauses];
+  uint64_t total_pause_ns;
+  uint64_t max_pause_ns;
+  // Bytes may be negative when a moving collection copies more than it frees.
+  uint64_t freed_objects;
+  int64_t freed_bytes;
+  uint64_t freed_large_objects;
+  int64_t freed_large_object_bytes;
+  uint64_t bytes_allocated_before;
+  uint64_t bytes_allocated_after;
+  uint64_t total_memory;
+  // Bytes per second allocated since the previous collection.
+  uint64_t allocation_rate;
+  // The outermost timings of the collection.
+  size_t phase_count;
+  Phase phases[kMaxPhases];
+};
+
+// Keeps the records of the most recent collections in a ring that is written without locks, so
+// that monitoring can follow the collections without parsing logs. Records are read through
+// VMDebug.getGcTelemetry or streamed as text to a file descriptor as collections finish.
+class GcTelemetry {
+ public:
+  static constexpr size_t kCapacity = 64;
+  // How long the thread that finished a collection waits for the stream reader.
+  static constexpr int kStreamTimeoutMs = 1;
+
+  GcTelemetry();
+
+  // Fill in the pauses and phases of a record from the timings of a collection.
+  static void SetPauses(const std::vector<uint64_t>& pause_times, GcTelemetryRecord* record);
+  static void SetPhases(const TimingLogger& timings, GcTelemetryRecord* record);
+
+  // Add the record of a finished collection, assigning its id. Collections are serialized by the
+  // heap so there is a single writer, readers never block it.
+  void Record(GcTelemetryRecord* record);
+
+  // Copy the records with an id greater than after_id that are still in the ring, oldest first.
+  // Records overwritten while they are copied are skipped.
+  void GetRecords(uint64_t after_id, std::vector<GcTelemetryRecord>* records) const;
+
+  uint64_t GetLastId() const {
+    return last_id_.LoadSequentiallyConsistent();
+  }
+
+  // Write each record added from now on to fd, which is closed when streaming stops. Stops a
+  // previous stream. Records the reader has no room for within kStreamTimeoutMs are dropped, the
+  // flags of fd are left alone.
+  void StartStreaming(int fd) LOCKS_EXCLUDED(stream_lock_);
+  void StopStreaming() LOCKS_EXCLUDED(stream_lock_);
+
+  // Write a record to the stream, if any. Called once the collection has finished.
+  void Stream(const GcTelemetryRecord& record) LOCKS_EXCLUDED(stream_lock_);
+
+  // Number of records not streamed because the reader fell behind.
+  uint64_t GetDroppedRecords() const {
+    return dropped_records_.LoadSequentiallyConsistent();
+  }
+
+  // Dump a record as a single line of space separated key=value pairs.
+  static void DumpRecord(std::ostream& os, const GcTelemetryRecord& record);
+
+ private:
+  struct Slot {
+    // 2 * id once the record of collection id is written, odd while it is being written.
+    Atomic<uint64_t> sequence;
+    GcTelemetryRecord record;
+  };
+
+  bool ReadRecord(uint64_t id, GcTelemetryRecord* record) const;
+
+  Atomic<uint64_t> last_id_;
+  std::unique_ptr<Slot[]> slots_;
+
+  Atomic<bool> streaming_;
+  Atomic<uint64_t> dropped_records_;
+  Mutex stream_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::unique_ptr<File> stream_file_ GUARDED_BY(stream_lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(GcTelemetry);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_GC_TELEMETRY_H_
@@ -18,9 +18,12 @@
 
 #define ATRACE_TAG ATRACE_TAG_DALVIK
 #include <cutils/trace.h>
+#include <inttypes.h>
 
+#include <algorithm>
 #include <limits>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "base/allocator.h"
@@ -685,6 +688,12 @@ void Heap::VisitObjects(ObjectCallback callback, void* arg) {
   Thread* self = Thread::Current();
   // GCs can move objects, so don't allow this.
   const char* old_cause = self->StartAssertNoThreadSuspension("Visiting objects");
+  VisitObjectsNotInLiveBitmaps(callback, arg);
+  GetLiveBitmap()->Walk(callback, arg);
+  self->EndAssertNoThreadSuspension(old_cause);
+}
+
+void Heap::VisitObjectsNotInLiveBitmaps(ObjectCallback callback, void* arg) {
   if (bump_pointer_space_ != nullptr) {
     // Visit objects in bump pointer space.
     bump_pointer_space_->Walk(callback, arg);
@@ -700,8 +709,101 @@ void Heap::VisitObjects(ObjectCallback callback, void* arg) {
       callback(obj, arg);
     }
   }
-  GetLiveBitmap()->Walk(callback, arg);
-  self->EndAssertNoThreadSuspension(old_cause);
+}
+
+// Is an object marked in [begin, end) of the bitmap?
+template <size_t kAlignment>
+static bool HasMarkedObjects(accounting::SpaceBitmap<kAlignment>* bitmap, uintptr_t begin,
+                             uintptr_t end) {
+  const uword* words = bitmap->Begin();
+  const size_t bit_end = (end - bitmap->HeapBegin() + kAlignment - 1) / kAlignment;
+  size_t bit = (begin - bitmap->HeapBegin()) / kAlignment;
+  while (bit < bit_end) {
+    const size_t shift = bit % kBitsPerWord;
+    const size_t bits = std::min(static_cast<size_t>(kBitsPerWord) - shift, bit_end - bit);
+    uword word = words[bit / kBitsPerWord] >> shift;
+    if (bits < static_cast<size_t>(kBitsPerWord)) {
+      word &= (static_cast<uword>(1) << bits) - 1;
+    }
+    if (word != 0) {
+      return true;
+    }
+    bit += bits;
+  }
+  return false;
+}
+
+template <size_t kAlignment>
+static void AddLiveBitmapRanges(space::Space* space, accounting::SpaceBitmap<kAlignment>* bitmap,
+                                uintptr_t begin, uintptr_t end, size_t range_size,
+                                std::vector<Heap::LiveBitmapRange>* ranges) {
+  for (uintptr_t range_begin = begin; range_begin < end; range_begin += range_size) {
+    Heap::LiveBitmapRange range = { space, range_begin, std::min(range_begin + range_size, end) };
+    if (HasMarkedObjects(bitmap, range.begin, range.end)) {
+      ranges->push_back(range);
+    }
+  }
+}
+
+// Records the lowest and the highest address of the objects visited.
+class ObjectBoundsVisitor {
+ public:
+  ObjectBoundsVisitor() : begin_(std::numeric_limits<uintptr_t>::max()), end_(0) {}
+
+  void operator()(mirror::Object* obj) const {
+    begin_ = std::min(begin_, reinterpret_cast<uintptr_t>(obj));
+    end_ = std::max(end_, reinterpret_cast<uintptr_t>(obj) + 1);
+  }
+
+  mutable uintptr_t begin_;
+  mutable uintptr_t end_;
+};
+
+void Heap::GetLiveBitmapRanges(size_t range_size, std::vector<LiveBitmapRange>* ranges) {
+  CHECK_ALIGNED(range_size, kPageSize);
+  for (const auto& space : continuous_spaces_) {
+    accounting::ContinuousSpaceBitmap* bitmap = space->GetLiveBitmap();
+    if (bitmap != nullptr) {
+      AddLiveBitmapRanges(space, bitmap, bitmap->HeapBegin(),
+                          reinterpret_cast<uintptr_t>(space->End()), range_size, ranges);
+    }
+  }
+  for (const auto& space : discontinuous_spaces_) {
+    // The objects of a large object space may be anywhere in the bitmap, which spans the address
+    // space. Only the part between the first and the last live object is split.
+    accounting::LargeObjectBitmap* bitmap = space->GetLiveBitmap();
+    ObjectBoundsVisitor bounds;
+    bitmap->VisitMarkedRange(bitmap->HeapBegin(), static_cast<uintptr_t>(bitmap->HeapLimit()),
+                             bounds);
+    if (bounds.begin_ < bounds.end_) {
+      AddLiveBitmapRanges(space, bitmap, bounds.begin_, bounds.end_, range_size, ranges);
+    }
+  }
+}
+
+class ObjectCallbackVisitor {
+ public:
+  ObjectCallbackVisitor(ObjectCallback* callback, void* arg) : callback_(callback), arg_(arg) {}
+
+  void operator()(mirror::Object* obj) const {
+    callback_(obj, arg_);
+  }
+
+ private:
+  ObjectCallback* const callback_;
+  void* const arg_;
+};
+
+void Heap::VisitLiveBitmapRange(const LiveBitmapRange& range, ObjectCallback callback,
+                                void* arg) {
+  ObjectCallbackVisitor visitor(callback, arg);
+  if (range.space->IsContinuousSpace()) {
+    range.space->AsContinuousSpace()->GetLiveBitmap()->VisitMarkedRange(range.begin, range.end,
+                                                                        visitor);
+  } else {
+    range.space->AsDiscontinuousSpace()->GetLiveBitmap()->VisitMarkedRange(range.begin, range.end,
+                                                                           visitor);
+  }
 }
 
 void Heap::MarkAllocStackAsLive(accounting::ObjectStack* stack) {
@@ -1446,6 +1548,82 @@ void Heap::CountInstances(const std::vector<mirror::Class*>& classes, bool use_i
   self->EndAssertNoThreadSuspension(old_cause);
 }
 
+class ClassHistogramBuilder {
+ public:
+  ClassHistogramBuilder() : last_class_(nullptr), last_entry_(nullptr) {}
+
+  static void Callback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
+    ClassHistogramBuilder* builder = reinterpret_cast<ClassHistogramBuilder*>(arg);
+    mirror::Class* klass = obj->GetClass();
+    CHECK(klass != nullptr);
+    // Objects of a class are often allocated together, so skip the lookup for runs of them.
+    if (klass != builder->last_class_) {
+      builder->last_class_ = klass;
+      builder->last_entry_ = &builder->entries_[klass];
+      builder->last_entry_->klass = klass;
+    }
+    ++builder->last_entry_->instances;
+    builder->last_entry_->bytes += obj->SizeOf();
+  }
+
+  void GetHistogram(std::vector<Heap::ClassHistogramEntry>* histogram) const {
+    histogram->clear();
+    histogram->reserve(entries_.size());
+    for (const auto& entry : entries_) {
+      histogram->push_back(entry.second);
+    }
+    std::sort(histogram->begin(), histogram->end(), CompareBytes);
+  }
+
+ private:
+  static bool CompareBytes(const Heap::ClassHistogramEntry& lhs,
+                           const Heap::ClassHistogramEntry& rhs) {
+    return lhs.bytes > rhs.bytes || (lhs.bytes == rhs.bytes && lhs.instances > rhs.instances);
+  }
+
+  std::unordered_map<mirror::Class*, Heap::ClassHistogramEntry> entries_;
+  mirror::Class* last_class_;
+  Heap::ClassHistogramEntry* last_entry_;
+  DISALLOW_COPY_AND_ASSIGN(ClassHistogramBuilder);
+};
+
+void Heap::GetClassHistogram(std::vector<ClassHistogramEntry>* histogram) {
+  // Can't do any GC in this function since this may move classes.
+  Thread* self = Thread::Current();
+  auto* old_cause = self->StartAssertNoThreadSuspension("GetClassHistogram");
+  ClassHistogramBuilder builder;
+  {
+    WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    VisitObjects(ClassHistogramBuilder::Callback, &builder);
+  }
+  builder.GetHistogram(histogram);
+  self->EndAssertNoThreadSuspension(old_cause);
+}
+
+void Heap::DumpClassHistogram(std::ostream& os, size_t max_classes) {
+  Thread* self = Thread::Current();
+  // The classes are only valid until the next GC.
+  auto* old_cause = self->StartAssertNoThreadSuspension("DumpClassHistogram");
+  std::vector<ClassHistogramEntry> histogram;
+  GetClassHistogram(&histogram);
+  uint64_t total_instances = 0;
+  uint64_t total_bytes = 0;
+  for (const ClassHistogramEntry& entry : histogram) {
+    total_instances += entry.instances;
+    total_bytes += entry.bytes;
+  }
+  os << "Class histogram: " << histogram.size() << " classes, " << total_instances
+     << " instances, " << PrettySize(total_bytes) << "\n";
+  os << StringPrintf("%12s %12s  %s\n", "bytes", "instances", "class");
+  for (size_t i = 0; i < std::min(max_classes, histogram.size()); ++i) {
+    const ClassHistogramEntry& entry = histogram[i];
+    os << StringPrintf("%12" PRIu64 " %12" PRIu64 "  ", entry.bytes, entry.instances)
+       << PrettyDescriptor(entry.klass) << "\n";
+  }
+  self->EndAssertNoThreadSuspension(old_cause);
+}
+
 class InstanceCollector {
  public:
   InstanceCollector(mirror::Class* c, int32_t max_count, std::vector<mirror::Object*>& instances)
@@ -1568,13 +1746,15 @@ HomogeneousSpaceCompactResult Heap::PerformHomogeneousSpaceCompact() {
   // Suspend all threads.
   tl->SuspendAll();
   uint64_t start_time = NanoTime();
+  const uint64_t gc_start_size = GetBytesAllocated();
   // Launch compaction.
   space::MallocSpace* to_space = main_space_backup_.release();
   space::MallocSpace* from_space = main_space_;
   to_space->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
   const uint64_t space_size_before_compaction = from_space->Size();
   AddSpace(to_space);
-  Compact(to_space, from_space, kGcCauseHomogeneousSpaceCompact);
+  collector::GarbageCollector* collector =
+      Compact(to_space, from_space, kGcCauseHomogeneousSpaceCompact);
   // Leave as prot read so that we can still run ROSAlloc verification on this space.
   from_space->GetMemMap()->Protect(PROT_READ);
   const uint64_t space_size_after_compaction = to_space->Size();
@@ -1595,7 +1775,10 @@ HomogeneousSpaceCompactResult Heap::PerformHomogeneousSpaceCompact() {
   // Finish GC.
   reference_processor_.EnqueueClearedReferences(self);
   GrowForUtilization(semi_space_collector_);
+  GcTelemetryRecord telemetry_record;
+  RecordGcTelemetry(collector, start_time, gc_start_size, &telemetry_record);
   FinishGC(self, collector::kGcTypeFull);
+  gc_telemetry_.Stream(telemetry_record);
   return HomogeneousSpaceCompactResult::kSuccess;
 }
 
@@ -1647,6 +1830,9 @@ void Heap::TransitionCollector(CollectorType collector_type) {
     return;
   }
   tl->SuspendAll();
+  const uint64_t gc_start_size = GetBytesAllocated();
+  // The collector that copied the objects, if the transition had to.
+  collector::GarbageCollector* collector = nullptr;
   switch (collector_type) {
     case kCollectorTypeSS: {
       if (!IsMovingGc(collector_type_)) {
@@ -1660,7 +1846,7 @@ void Heap::TransitionCollector(CollectorType collector_type) {
         bump_pointer_space_ = space::BumpPointerSpace::CreateFromMemMap("Bump pointer space",
                                                                         mem_map.release());
         AddSpace(bump_pointer_space_);
-        Compact(bump_pointer_space_, main_space_, kGcCauseCollectorTransition);
+        collector = Compact(bump_pointer_space_, main_space_, kGcCauseCollectorTransition);
         // Use the now empty main space mem map for the bump pointer temp space.
         mem_map.reset(main_space_->ReleaseMemMap());
         // Unset the pointers just in case.
@@ -1697,7 +1883,7 @@ void Heap::TransitionCollector(CollectorType collector_type) {
         mem_map.release();
         // Compact to the main space from the bump pointer space, don't need to swap semispaces.
         AddSpace(main_space_);
-        Compact(main_space_, bump_pointer_space_, kGcCauseCollectorTransition);
+        collector = Compact(main_space_, bump_pointer_space_, kGcCauseCollectorTransition);
         mem_map.reset(bump_pointer_space_->ReleaseMemMap());
         RemoveSpace(bump_pointer_space_);
         bump_pointer_space_ = nullptr;
@@ -1728,7 +1914,14 @@ void Heap::TransitionCollector(CollectorType collector_type) {
   reference_processor_.EnqueueClearedReferences(self);
   uint64_t duration = NanoTime() - start_time;
   GrowForUtilization(semi_space_collector_);
+  GcTelemetryRecord telemetry_record;
+  if (collector != nullptr) {
+    RecordGcTelemetry(collector, start_time, gc_start_size, &telemetry_record);
+  }
   FinishGC(self, collector::kGcTypeFull);
+  if (collector != nullptr) {
+    gc_telemetry_.Stream(telemetry_record);
+  }
   int32_t after_allocated = num_bytes_allocated_.LoadSequentiallyConsistent();
   int32_t delta_allocated = before_allocated - after_allocated;
   std::string saved_str;
@@ -2044,9 +2237,9 @@ void Heap::SwapSemiSpaces() {
   std::swap(bump_pointer_space_, temp_space_);
 }
 
-void Heap::Compact(space::ContinuousMemMapAllocSpace* target_space,
-                   space::ContinuousMemMapAllocSpace* source_space,
-                   GcCause gc_cause) {
+collector::GarbageCollector* Heap::Compact(space::ContinuousMemMapAllocSpace* target_space,
+                                           space::ContinuousMemMapAllocSpace* source_space,
+                                           GcCause gc_cause) {
   CHECK(kMovingCollector);
   if (target_space != source_space) {
     // Don't swap spaces since this isn't a typical semi space collection.
@@ -2054,11 +2247,13 @@ void Heap::Compact(space::ContinuousMemMapAllocSpace* target_space,
     semi_space_collector_->SetFromSpace(source_space);
     semi_space_collector_->SetToSpace(target_space);
     semi_space_collector_->Run(gc_cause, false);
+    return semi_space_collector_;
   } else {
     CHECK(target_space->IsBumpPointerSpace())
         << "In-place compaction is only supported for bump pointer spaces";
     mark_compact_collector_->SetSpace(target_space->AsBumpPointerSpace());
     mark_compact_collector_->Run(kGcCauseCollectorTransition, false);
+    return mark_compact_collector_;
   }
 }
 
@@ -2196,12 +2391,36 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
               << " total " << PrettyDuration((duration / 1000) * 1000);
     VLOG(heap) << ConstDumpable<TimingLogger>(*current_gc_iteration_.GetTimings());
   }
+  GcTelemetryRecord telemetry_record;
+  RecordGcTelemetry(collector, gc_start_time_ns, gc_start_size, &telemetry_record);
   FinishGC(self, gc_type);
+  gc_telemetry_.Stream(telemetry_record);
   // Inform DDMS that a GC completed.
   Dbg::GcDidFinish();
   return gc_type;
 }
 
+void Heap::RecordGcTelemetry(collector::GarbageCollector* collector, uint64_t gc_start_time_ns,
+                             uint64_t gc_start_size, GcTelemetryRecord* record) {
+  const collector::Iteration* iteration = GetCurrentGcIteration();
+  record->cause = iteration->GetGcCause();
+  record->collector_type = collector->GetCollectorType();
+  record->gc_type = collector->GetGcType();
+  record->start_time_ns = gc_start_time_ns;
+  record->duration_ns = iteration->GetDurationNs();
+  GcTelemetry::SetPauses(iteration->GetPauseTimes(), record);
+  record->freed_objects = iteration->GetFreedObjects();
+  record->freed_bytes = iteration->GetFreedBytes();
+  record->freed_large_objects = iteration->GetFreedLargeObjects();
+  record->freed_large_object_bytes = iteration->GetFreedLargeObjectBytes();
+  record->bytes_allocated_before = gc_start_size;
+  record->bytes_allocated_after = GetBytesAllocated();
+  record->total_memory = GetTotalMemory();
+  record->allocation_rate = allocation_rate_;
+  GcTelemetry::SetPhases(*collector->GetTimings(), record);
+  gc_telemetry_.Record(record);
+}
+
 void Heap::FinishGC(Thread* self, collector::GcType gc_type) {
   MutexLock mu(self, *gc_complete_lock_);
   collector_type_running_ = kCollectorTypeNone;
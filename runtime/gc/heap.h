@@ -30,6 +30,7 @@
 #include "gc/collector/garbage_collector.h"
 #include "gc/collector/gc_type.h"
 #include "gc/collector_type.h"
+#include "gc/gc_telemetry.h"
 #include "globals.h"
 #include "gtest/gtest.h"
 #include "instruction_set.h"
@@ -207,6 +208,27 @@ class Heap {
   void VisitObjects(ObjectCallback callback, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
 
+  // Visit the live objects which are not marked in a live bitmap, those in the bump pointer space
+  // and on the allocation stack.
+  void VisitObjectsNotInLiveBitmaps(ObjectCallback callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  // The objects starting in [begin, end) of the live bitmap of a space.
+  struct LiveBitmapRange {
+    space::Space* space;
+    uintptr_t begin;
+    uintptr_t end;
+  };
+
+  // Split the live bitmaps of the spaces into ranges of at most range_size bytes, leaving out the
+  // ranges without live objects. The ranges are ordered by space and address. They may be visited
+  // concurrently with VisitLiveBitmapRange, which together with VisitObjectsNotInLiveBitmaps
+  // visits the same objects as VisitObjects.
+  void GetLiveBitmapRanges(size_t range_size, std::vector<LiveBitmapRange>* ranges)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+  void VisitLiveBitmapRange(const LiveBitmapRange& range, ObjectCallback callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
   void CheckPreconditionsForAllocObject(mirror::Class* c, size_t byte_count)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -278,6 +300,23 @@ class Heap {
                       uint64_t* counts)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // The instances of a class in a class histogram.
+  struct ClassHistogramEntry {
+    mirror::Class* klass;
+    uint64_t instances;
+    // The shallow size of the instances.
+    uint64_t bytes;
+  };
+
+  // Count the instances of every class and their bytes in a single walk of the heap, in order of
+  // decreasing bytes. Objects which are unreachable but not yet freed are included.
+  void GetClassHistogram(std::vector<ClassHistogramEntry>* histogram)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Dump the max_classes classes of the histogram with the most bytes.
+  void DumpClassHistogram(std::ostream& os, size_t max_classes)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   // Implements JDWP RT_Instances.
   void GetInstances(mirror::Class* c, int32_t max_count, std::vector<mirror::Object*>& instances)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
@@ -599,15 +638,24 @@ class Heap {
     return &reference_processor_;
   }
 
+  GcTelemetry* GetGcTelemetry() {
+    return &gc_telemetry_;
+  }
+
  private:
-  // Compact source space to target space.
-  void Compact(space::ContinuousMemMapAllocSpace* target_space,
-               space::ContinuousMemMapAllocSpace* source_space,
-               GcCause gc_cause)
+  // Compact source space to target space. Returns the collector that did it.
+  collector::GarbageCollector* Compact(space::ContinuousMemMapAllocSpace* target_space,
+                                       space::ContinuousMemMapAllocSpace* source_space,
+                                       GcCause gc_cause)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void FinishGC(Thread* self, collector::GcType gc_type) LOCKS_EXCLUDED(gc_complete_lock_);
 
+  // Add the telemetry record of the collection that just ran, must be called before the GC
+  // completes since the next collection reuses the current iteration.
+  void RecordGcTelemetry(collector::GarbageCollector* collector, uint64_t gc_start_time_ns,
+                         uint64_t gc_start_size, GcTelemetryRecord* record);
+
   // Create a mem map with a preferred base address.
   static MemMap* MapAnonymousPreferredAddress(const char* name, byte* request_begin,
                                               size_t capacity, int prot_flags,
@@ -911,6 +959,9 @@ class Heap {
   // Info related to the current or previous GC iteration.
   collector::Iteration current_gc_iteration_;
 
+  // Records of the most recent collections.
+  GcTelemetry gc_telemetry_;
+
   // Heap verification flags.
   const bool verify_missing_card_marks_;
   const bool verify_system_weaks_;
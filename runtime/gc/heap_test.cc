@@ -14,6 +14,12 @@
  * limitations under the License.
  */
 
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sstream>
+
 #include "common_runtime_test.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/space_bitmap-inl.h"
@@ -61,6 +67,113 @@ TEST_F(HeapTest, GarbageCollectClassLinkerInit) {
   Runtime::Current()->GetHeap()->CollectGarbage(false);
 }
 
+TEST_F(HeapTest, ClassHistogram) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::Class> c(
+      hs.NewHandle(class_linker_->FindSystemClass(soa.Self(), "[Ljava/lang/Object;")));
+  Handle<mirror::ObjectArray<mirror::Object>> array(hs.NewHandle(
+      mirror::ObjectArray<mirror::Object>::Alloc(soa.Self(), c.Get(), 16)));
+  ASSERT_TRUE(array.Get() != nullptr);
+
+  Heap* heap = Runtime::Current()->GetHeap();
+  std::vector<Heap::ClassHistogramEntry> histogram;
+  heap->GetClassHistogram(&histogram);
+  ASSERT_FALSE(histogram.empty());
+  bool found = false;
+  for (size_t i = 0; i < histogram.size(); ++i) {
+    const Heap::ClassHistogramEntry& entry = histogram[i];
+    if (i != 0) {
+      EXPECT_LE(entry.bytes, histogram[i - 1].bytes);
+    }
+    EXPECT_GT(entry.instances, 0U);
+    if (entry.klass == c.Get()) {
+      found = true;
+      EXPECT_GE(entry.bytes, array->SizeOf());
+    }
+  }
+  EXPECT_TRUE(found);
+
+  std::ostringstream os;
+  heap->DumpClassHistogram(os, 1);
+  EXPECT_NE(os.str().find("Class histogram: "), std::string::npos) << os.str();
+}
+
+TEST_F(HeapTest, GcTelemetry) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  GcTelemetry* telemetry = heap->GetGcTelemetry();
+  const uint64_t last_id = telemetry->GetLastId();
+  heap->CollectGarbage(false);
+  ASSERT_EQ(last_id + 1, telemetry->GetLastId());
+
+  std::vector<GcTelemetryRecord> records;
+  telemetry->GetRecords(last_id, &records);
+  ASSERT_EQ(1U, records.size());
+  const GcTelemetryRecord& record = records[0];
+  EXPECT_EQ(last_id + 1, record.id);
+  EXPECT_EQ(kGcCauseExplicit, record.cause);
+  EXPECT_GT(record.duration_ns, 0U);
+  EXPECT_GT(record.pause_count, 0U);
+  EXPECT_LE(record.max_pause_ns, record.total_pause_ns);
+  EXPECT_GT(record.phase_count, 0U);
+
+  std::ostringstream os;
+  GcTelemetry::DumpRecord(os, record);
+  EXPECT_EQ(0U, os.str().find("id="));
+  EXPECT_NE(os.str().find(" cause=Explicit "), std::string::npos) << os.str();
+}
+
+TEST_F(HeapTest, GcTelemetryKeepsMostRecentRecords) {
+  GcTelemetry telemetry;
+  for (size_t i = 0; i < GcTelemetry::kCapacity + 3; ++i) {
+    GcTelemetryRecord record = GcTelemetryRecord();
+    record.freed_objects = i;
+    telemetry.Record(&record);
+    EXPECT_EQ(i + 1, record.id);
+  }
+  std::vector<GcTelemetryRecord> records;
+  telemetry.GetRecords(0, &records);
+  ASSERT_EQ(GcTelemetry::kCapacity, records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    EXPECT_EQ(i + 4, records[i].id);
+    EXPECT_EQ(i + 3, records[i].freed_objects);
+  }
+  records.clear();
+  telemetry.GetRecords(telemetry.GetLastId() - 1, &records);
+  ASSERT_EQ(1U, records.size());
+  EXPECT_EQ(telemetry.GetLastId(), records[0].id);
+}
+
+TEST_F(HeapTest, GcTelemetryStreamDropsWhenReaderIsBehind) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  GcTelemetry telemetry;
+  // Like VMDebug, stream to a dup of the caller's descriptor.
+  telemetry.StartStreaming(dup(fds[1]));
+  // Nobody reads the pipe, once it is full the records are dropped instead of blocking.
+  const size_t kRecords = 512;
+  for (size_t i = 0; i < kRecords; ++i) {
+    GcTelemetryRecord record = GcTelemetryRecord();
+    telemetry.Record(&record);
+    telemetry.Stream(record);
+  }
+  const uint64_t dropped = telemetry.GetDroppedRecords();
+  EXPECT_GT(dropped, 0U);
+  EXPECT_LT(dropped, kRecords);
+  telemetry.StopStreaming();
+  // The caller's descriptor still blocks.
+  EXPECT_EQ(0, fcntl(fds[1], F_GETFL) & O_NONBLOCK);
+  close(fds[1]);
+
+  // The records that made it are whole lines, starting with the first one.
+  char buffer[64];
+  ssize_t bytes = read(fds[0], buffer, sizeof(buffer) - 1);
+  ASSERT_GT(bytes, 0);
+  buffer[bytes] = '\0';
+  EXPECT_EQ(0, strncmp(buffer, "id=1 ", 5)) << buffer;
+  close(fds[0]);
+}
+
 TEST_F(HeapTest, HeapBitmapCapacityTest) {
   byte* heap_begin = reinterpret_cast<byte*>(0x1000);
   const size_t heap_capacity = kObjectAlignment * (sizeof(intptr_t) * 8 + 1);
@@ -15,28 +15,39 @@
  */
 
 /*
- * Preparation and completion of hprof data generation.  The output is
- * written into two files and then combined.  This is necessary because
- * we generate some of the data (strings and classes) while we dump the
- * heap, and some analysis tools require that the class and string data
- * appear first.
+ * Preparation and completion of hprof data generation.  Some analysis tools
+ * require that the class and string data appear before the heap data that
+ * refers to them, so the heap is walked twice: first without output, to
+ * collect the strings and classes, then to stream the heap records to the
+ * output in bounded chunks after the string and class tables.
+ *
+ * Each walk is split into partitions, one for the roots and the objects
+ * outside the live bitmaps and one for each range of a live bitmap, which are
+ * walked in parallel on the heap's thread pool. Every partition writes its own
+ * sequence of HEAP_DUMP_SEGMENT records. The first walk gives the size of
+ * each, so when the dump goes to a regular file the second walk writes the
+ * partitions in parallel straight to their offsets in the file.
  */
 
 #include "hprof.h"
 
-#include <cutils/open_memstream.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/time.h>
-#include <sys/uio.h>
 #include <time.h>
 #include <time.h>
 #include <unistd.h>
+#include <zlib.h>
 
+#include <algorithm>
+#include <memory>
 #include <set>
+#include <vector>
 
+#include "atomic.h"
 #include "base/logging.h"
 #include "base/stringprintf.h"
 #include "base/unix_file/fd_file.h"
@@ -56,6 +67,7 @@
 #include "safe_map.h"
 #include "scoped_thread_state_change.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 
 namespace art {
 
@@ -170,14 +182,293 @@ enum HprofBasicType {
 typedef uint32_t HprofStringId;
 typedef uint32_t HprofClassObjectId;
 
+// Where the bytes of a dump go. Write returns false on error.
+class HprofOutput {
+ public:
+  HprofOutput() : bytes_written_(0), failed_(false) {}
+  virtual ~HprofOutput() {}
+
+  bool Write(const void* data, size_t length) {
+    bytes_written_ += length;
+    if (!HandleWrite(reinterpret_cast<const uint8_t*>(data), length)) {
+      failed_ = true;
+    }
+    return !failed_;
+  }
+
+  // Write out any bytes the output buffers.
+  bool Flush() {
+    if (!failed_ && !HandleFlush()) {
+      failed_ = true;
+    }
+    return !failed_;
+  }
+
+  // Called once all records are written.
+  virtual bool Finish() {
+    return Flush();
+  }
+
+  // Uncompressed size of the dump so far.
+  size_t BytesWritten() const {
+    return bytes_written_;
+  }
+
+  // Has any write failed?
+  bool Failed() const {
+    return failed_;
+  }
+
+ protected:
+  virtual bool HandleWrite(const uint8_t* data, size_t length) = 0;
+
+  virtual bool HandleFlush() {
+    return true;
+  }
+
+ private:
+  size_t bytes_written_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(HprofOutput);
+};
+
+// Discards the dump, for the pass that only collects the strings and classes.
+class NullHprofOutput FINAL : public HprofOutput {
+ public:
+  NullHprofOutput() {}
+
+ protected:
+  bool HandleWrite(const uint8_t*, size_t) OVERRIDE {
+    return true;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NullHprofOutput);
+};
+
+// Collects the small writes of the records into large ones. The buffer is only allocated while
+// the output is written to, from the first write to the next Flush.
+class BufferedHprofOutput : public HprofOutput {
+ public:
+  static constexpr size_t kBufferSize = 64 * KB;
+
+  BufferedHprofOutput() : buffered_(0) {}
+
+  virtual ~BufferedHprofOutput() {
+    FreeBuffer();
+  }
+
+  // The most buffers allocated at the same time so far.
+  static size_t GetPeakBuffers() {
+    return peak_buffers_.LoadSequentiallyConsistent();
+  }
+
+ protected:
+  bool HandleWrite(const uint8_t* data, size_t length) OVERRIDE {
+    if (buffered_ + length > kBufferSize && !WriteBuffer()) {
+      return false;
+    }
+    if (length >= kBufferSize) {
+      return WriteOut(data, length);
+    }
+    if (buffer_.get() == nullptr) {
+      AllocateBuffer();
+    }
+    memcpy(buffer_.get() + buffered_, data, length);
+    buffered_ += length;
+    return true;
+  }
+
+  bool HandleFlush() OVERRIDE {
+    bool success = WriteBuffer();
+    FreeBuffer();
+    return success;
+  }
+
+  virtual bool WriteOut(const uint8_t* data, size_t length) = 0;
+
+ private:
+  bool WriteBuffer() {
+    size_t length = buffered_;
+    buffered_ = 0;
+    return length == 0 || WriteOut(buffer_.get(), length);
+  }
+
+  void AllocateBuffer() {
+    buffer_.reset(new uint8_t[kBufferSize]);
+    size_t live = live_buffers_.FetchAndAddSequentiallyConsistent(1) + 1;
+    size_t peak = peak_buffers_.LoadSequentiallyConsistent();
+    while (live > peak && !peak_buffers_.CompareExchangeWeakSequentiallyConsistent(peak, live)) {
+      peak = peak_buffers_.LoadSequentiallyConsistent();
+    }
+  }
+
+  void FreeBuffer() {
+    if (buffer_.get() != nullptr) {
+      buffer_.reset();
+      live_buffers_.FetchAndSubSequentiallyConsistent(1);
+    }
+  }
+
+  static Atomic<size_t> live_buffers_;
+  static Atomic<size_t> peak_buffers_;
+
+  size_t buffered_;
+  std::unique_ptr<uint8_t[]> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferedHprofOutput);
+};
+
+Atomic<size_t> BufferedHprofOutput::live_buffers_(0);
+Atomic<size_t> BufferedHprofOutput::peak_buffers_(0);
+
+class FileHprofOutput FINAL : public BufferedHprofOutput {
+ public:
+  explicit FileHprofOutput(File* file) : file_(file) {}
+
+ protected:
+  bool WriteOut(const uint8_t* data, size_t length) OVERRIDE {
+    return file_->WriteFully(data, length);
+  }
+
+ private:
+  File* const file_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileHprofOutput);
+};
+
+// Writes to a file from the given offset on, so that partitions of the dump may be written to
+// their parts of the file concurrently.
+class PositionedFileHprofOutput FINAL : public BufferedHprofOutput {
+ public:
+  PositionedFileHprofOutput(File* file, int64_t offset) : file_(file), offset_(offset) {}
+
+ protected:
+  bool WriteOut(const uint8_t* data, size_t length) OVERRIDE {
+    while (length > 0) {
+      int64_t rc = file_->Write(reinterpret_cast<const char*>(data), length, offset_);
+      if (rc <= 0) {
+        return false;
+      }
+      data += rc;
+      length -= rc;
+      offset_ += rc;
+    }
+    return true;
+  }
+
+ private:
+  File* const file_;
+  int64_t offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(PositionedFileHprofOutput);
+};
+
+// Can the partitions of a dump be written to fd at their own offsets?
+static bool AllowsPositionedWrites(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  // Positioned writes to a file opened for appending go to its end.
+  int flags = fcntl(fd, F_GETFL);
+  return flags != -1 && (flags & O_APPEND) == 0 && lseek(fd, 0, SEEK_CUR) >= 0;
+}
+
+// Writes the dump to a file in gzip format.
+class GzipHprofOutput FINAL : public HprofOutput {
+ public:
+  explicit GzipHprofOutput(File* file) : file_(file), initialized_(false) {
+    memset(&stream_, 0, sizeof(stream_));
+    // Add 16 to the window bits for a gzip rather than a zlib header.
+    initialized_ = deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                                Z_DEFAULT_STRATEGY) == Z_OK;
+  }
+
+  ~GzipHprofOutput() {
+    if (initialized_) {
+      deflateEnd(&stream_);
+    }
+  }
+
+  bool Finish() OVERRIDE {
+    return Deflate(nullptr, 0, Z_FINISH);
+  }
+
+ protected:
+  bool HandleWrite(const uint8_t* data, size_t length) OVERRIDE {
+    return Deflate(data, length, Z_NO_FLUSH);
+  }
+
+ private:
+  bool Deflate(const uint8_t* data, size_t length, int flush) {
+    if (!initialized_) {
+      return false;
+    }
+    stream_.next_in = const_cast<uint8_t*>(data);
+    stream_.avail_in = length;
+    int rc;
+    do {
+      stream_.next_out = out_;
+      stream_.avail_out = sizeof(out_);
+      rc = deflate(&stream_, flush);
+      if (rc == Z_STREAM_ERROR) {
+        return false;
+      }
+      if (!file_->WriteFully(out_, sizeof(out_) - stream_.avail_out)) {
+        return false;
+      }
+    } while (stream_.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+    return true;
+  }
+
+  File* const file_;
+  z_stream stream_;
+  bool initialized_;
+  uint8_t out_[64 * KB];
+
+  DISALLOW_COPY_AND_ASSIGN(GzipHprofOutput);
+};
+
+// DDMS takes the dump as a single chunk, so it is collected in memory.
+class DdmsHprofOutput FINAL : public HprofOutput {
+ public:
+  DdmsHprofOutput() {}
+
+  bool Finish() OVERRIDE {
+    Dbg::DdmSendChunk(CHUNK_TYPE("HPDS"), data_);
+    return true;
+  }
+
+ protected:
+  bool HandleWrite(const uint8_t* data, size_t length) OVERRIDE {
+    data_.insert(data_.end(), data, data + length);
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> data_;
+
+  DISALLOW_COPY_AND_ASSIGN(DdmsHprofOutput);
+};
+
 // Represents a top-level hprof record, whose serialized format is:
 // U1  TAG: denoting the type of the record
 // U4  TIME: number of microseconds since the time stamp in the header
 // U4  LENGTH: number of bytes that follow this uint32_t field and belong to this record
 // U1* BODY: as many bytes as specified in the above uint32_t field
+//
+// The body is buffered until the record ends, as its length is only known then. Records whose
+// length is known up front, such as those holding a large array, are instead streamed out in
+// chunks of kStreamChunkSize, which bounds the buffer by the largest buffered record.
 class HprofRecord {
  public:
-  HprofRecord() : alloc_length_(128), fp_(nullptr), tag_(0), time_(0), length_(0), dirty_(false) {
+  static constexpr size_t kStreamChunkSize = 64 * KB;
+
+  HprofRecord()
+      : alloc_length_(128), output_(nullptr), tag_(0), time_(0), length_(0), streamed_length_(0),
+        expected_length_(0), streaming_(false), dirty_(false) {
     body_ = reinterpret_cast<unsigned char*>(malloc(alloc_length_));
   }
 
@@ -185,40 +476,55 @@ class HprofRecord {
     free(body_);
   }
 
-  int StartNewRecord(FILE* fp, uint8_t tag, uint32_t time) {
+  int StartNewRecord(HprofOutput* output, uint8_t tag, uint32_t time) {
     int rc = Flush();
     if (rc != 0) {
       return rc;
     }
 
-    fp_ = fp;
+    output_ = output;
     tag_ = tag;
     time_ = time;
     length_ = 0;
+    streamed_length_ = 0;
+    streaming_ = false;
     dirty_ = true;
     return 0;
   }
 
+  // Start a record with a body of the given length, which is written out as it is added.
+  int StartNewStreamedRecord(HprofOutput* output, uint8_t tag, uint32_t time, uint32_t length) {
+    int rc = StartNewRecord(output, tag, time);
+    if (rc != 0) {
+      return rc;
+    }
+    rc = WriteHeader(length);
+    if (rc != 0) {
+      return rc;
+    }
+    expected_length_ = length;
+    streaming_ = true;
+    return 0;
+  }
+
   int Flush() {
     if (dirty_) {
-      unsigned char headBuf[sizeof(uint8_t) + 2 * sizeof(uint32_t)];
-
-      headBuf[0] = tag_;
-      U4_TO_BUF_BE(headBuf, 1, time_);
-      U4_TO_BUF_BE(headBuf, 5, length_);
-
-      int nb = fwrite(headBuf, 1, sizeof(headBuf), fp_);
-      if (nb != sizeof(headBuf)) {
-        return UNIQUE_ERROR;
+      if (streaming_) {
+        CHECK_EQ(streamed_length_ + length_, expected_length_);
+      } else {
+        int rc = WriteHeader(length_);
+        if (rc != 0) {
+          return rc;
+        }
       }
-      nb = fwrite(body_, 1, length_, fp_);
-      if (nb != static_cast<int>(length_)) {
-        return UNIQUE_ERROR;
+      int rc = WriteBody();
+      if (rc != 0) {
+        return rc;
       }
 
       dirty_ = false;
+      streaming_ = false;
     }
-    // TODO if we used less than half (or whatever) of allocLen, shrink the buffer.
     return 0;
   }
 
@@ -343,11 +649,39 @@ class HprofRecord {
   }
 
   size_t Size() const {
-    return length_;
+    return streamed_length_ + length_;
   }
 
  private:
+  int WriteHeader(uint32_t length) {
+    unsigned char headBuf[sizeof(uint8_t) + 2 * sizeof(uint32_t)];
+
+    headBuf[0] = tag_;
+    U4_TO_BUF_BE(headBuf, 1, time_);
+    U4_TO_BUF_BE(headBuf, 5, length);
+
+    if (!output_->Write(headBuf, sizeof(headBuf))) {
+      return UNIQUE_ERROR;
+    }
+    return 0;
+  }
+
+  int WriteBody() {
+    if (!output_->Write(body_, length_)) {
+      return UNIQUE_ERROR;
+    }
+    streamed_length_ += length_;
+    length_ = 0;
+    return 0;
+  }
+
   int GuaranteeRecordAppend(size_t nmore) {
+    if (streaming_ && length_ + nmore > kStreamChunkSize) {
+      int err = WriteBody();
+      if (UNLIKELY(err != 0)) {
+        return err;
+      }
+    }
     size_t minSize = length_ + nmore;
     if (minSize > alloc_length_) {
       size_t newAllocLen = alloc_length_ * 2;
@@ -371,15 +705,65 @@ class HprofRecord {
   size_t alloc_length_;
   unsigned char* body_;
 
-  FILE* fp_;
+  HprofOutput* output_;
   uint8_t tag_;
   uint32_t time_;
+  // Bytes of the body in the buffer.
   size_t length_;
+  // Bytes of the body already written out, for a streamed record.
+  size_t streamed_length_;
+  // Length of a streamed record given as it started.
+  size_t expected_length_;
+  bool streaming_;
   bool dirty_;
 
   DISALLOW_COPY_AND_ASSIGN(HprofRecord);
 };
 
+#define OBJECTS_PER_SEGMENT     ((size_t)128)
+#define BYTES_PER_SEGMENT       ((size_t)4096)
+
+class Hprof;
+
+// A part of the heap dump walked by one thread: the roots and the objects outside the live
+// bitmaps, or a range of a live bitmap. It writes its own sequence of HEAP_DUMP_SEGMENT records.
+struct HeapDumpPartition {
+  explicit HeapDumpPartition(Hprof* hprof_in)
+      : hprof(hprof_in), range(), output(nullptr), file(nullptr), offset(0),
+        current_heap(HPROF_HEAP_DEFAULT), objects_in_segment(0), in_segment(false), size(0),
+        error(0) {}
+
+  void SetOutput(HprofOutput* new_output, bool owned) {
+    owned_output.reset(owned ? new_output : nullptr);
+    output = new_output;
+  }
+
+  Hprof* const hprof;
+  // The live bitmap range, or no space for the roots and the objects outside the live bitmaps.
+  gc::Heap::LiveBitmapRange range;
+
+  HprofRecord record;
+  std::unique_ptr<HprofOutput> owned_output;
+  HprofOutput* output;
+  // The file and offset to write the partition to by itself, or no file to write it to output.
+  File* file;
+  int64_t offset;
+  HprofHeapId current_heap;  // Which heap we're currently dumping.
+  size_t objects_in_segment;
+  bool in_segment;
+
+  // Bytes of records written by the walk collecting the strings and classes.
+  size_t size;
+  int error;
+
+  // The strings and classes the records refer to, collected by the first walk.
+  std::set<std::string> strings;
+  std::set<mirror::Class*> classes;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HeapDumpPartition);
+};
+
 class Hprof {
  public:
   Hprof(const char* output_filename, int fd, bool direct_to_ddms)
@@ -390,73 +774,32 @@ class Hprof {
         current_record_(),
         gc_thread_serial_number_(0),
         gc_scan_state_(0),
-        current_heap_(HPROF_HEAP_DEFAULT),
-        objects_in_segment_(0),
-        header_fp_(NULL),
-        header_data_ptr_(NULL),
-        header_data_size_(0),
-        body_fp_(NULL),
-        body_data_ptr_(NULL),
-        body_data_size_(0),
+        output_(nullptr),
+        tables_frozen_(false),
         next_string_id_(0x400000) {
     LOG(INFO) << "hprof: heap dump \"" << filename_ << "\" starting...";
-
-    header_fp_ = open_memstream(&header_data_ptr_, &header_data_size_);
-    if (header_fp_ == NULL) {
-      PLOG(FATAL) << "header open_memstream failed";
-    }
-
-    body_fp_ = open_memstream(&body_data_ptr_, &body_data_size_);
-    if (body_fp_ == NULL) {
-      PLOG(FATAL) << "body open_memstream failed";
-    }
-  }
-
-  ~Hprof() {
-    if (header_fp_ != NULL) {
-      fclose(header_fp_);
-    }
-    if (body_fp_ != NULL) {
-      fclose(body_fp_);
-    }
-    free(header_data_ptr_);
-    free(body_data_ptr_);
   }
 
   void Dump()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_) {
-    // Walk the roots and the heap.
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
-    Runtime::Current()->VisitRoots(RootVisitor, this);
     Thread* self = Thread::Current();
     {
       ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
-      Runtime::Current()->GetHeap()->VisitObjects(VisitObjectCallback, this);
+      CreatePartitions();
+      // Collect the strings and classes the heap records refer to, and the size of each partition.
+      for (const auto& partition : partitions_) {
+        partition->SetOutput(new NullHprofOutput(), true);
+      }
+      WalkPartitions(self, true);
+      MergeTables();
     }
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_END, HPROF_TIME);
-    current_record_.Flush();
-    fflush(body_fp_);
-
-    // Write the header.
-    WriteFixedHeader();
-    // Write the string and class tables, and any stack traces, to the header.
-    // (jhat requires that these appear before any of the data in the body that refers to them.)
-    WriteStringTable();
-    WriteClassTable();
-    WriteStackTraces();
-    current_record_.Flush();
-    fflush(header_fp_);
 
-    bool okay = true;
+    std::unique_ptr<File> file;
+    std::unique_ptr<HprofOutput> output;
+    bool positioned = false;
     if (direct_to_ddms_) {
-      // Send the data off to DDMS.
-      iovec iov[2];
-      iov[0].iov_base = header_data_ptr_;
-      iov[0].iov_len = header_data_size_;
-      iov[1].iov_base = body_data_ptr_;
-      iov[1].iov_len = body_data_size_;
-      Dbg::DdmSendChunkV(CHUNK_TYPE("HPDS"), iov, 2);
+      output.reset(new DdmsHprofOutput());
     } else {
       // Where exactly are we writing to?
       int out_fd;
@@ -474,28 +817,60 @@ class Hprof {
           return;
         }
       }
-
-      std::unique_ptr<File> file(new File(out_fd, filename_));
-      okay = file->WriteFully(header_data_ptr_, header_data_size_) &&
-          file->WriteFully(body_data_ptr_, body_data_size_);
-      if (!okay) {
-        std::string msg(StringPrintf("Couldn't dump heap; writing \"%s\" failed: %s",
-                                     filename_.c_str(), strerror(errno)));
-        ThrowRuntimeException("%s", msg.c_str());
-        LOG(ERROR) << msg;
+      file.reset(new File(out_fd, filename_));
+      if (EndsWith(filename_, ".gz")) {
+        output.reset(new GzipHprofOutput(file.get()));
+      } else {
+        output.reset(new FileHprofOutput(file.get()));
+        positioned = AllowsPositionedWrites(out_fd);
       }
     }
 
+    // Write the header.
+    output_ = output.get();
+    WriteFixedHeader();
+    // Write the string and class tables, and any stack traces, before the heap.
+    // (jhat requires that these appear before any of the data in the body that refers to them.)
+    bool okay = WriteStringTable() == 0 && WriteClassTable() == 0 && WriteStackTraces() == 0;
+    size_t dump_size = 0;
+    okay = okay && WriteHeapDump(self, positioned ? file.get() : nullptr, &dump_size) == 0 &&
+        output->Finish();
+    output_ = nullptr;
+    if (!okay) {
+      std::string msg(StringPrintf("Couldn't dump heap; writing \"%s\" failed: %s",
+                                   filename_.c_str(), strerror(errno)));
+      ThrowRuntimeException("%s", msg.c_str());
+      LOG(ERROR) << msg;
+    }
+
     // Throw out a log message for the benefit of "runhat".
     if (okay) {
       uint64_t duration = NanoTime() - start_ns_;
       LOG(INFO) << "hprof: heap dump completed ("
-          << PrettySize(header_data_size_ + body_data_size_ + 1023)
+          << PrettySize(dump_size + 1023)
           << ") in " << PrettyDuration(duration);
     }
   }
 
  private:
+  // Walks a partition on a thread of the heap's thread pool.
+  class PartitionTask : public Task {
+   public:
+    explicit PartitionTask(HeapDumpPartition* partition) : partition_(partition) {}
+
+    // No thread safety analysis since the thread running the dump holds the locks.
+    virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+      partition_->hprof->WalkPartition(partition_);
+    }
+
+    virtual void Finalize() {
+      delete this;
+    }
+
+   private:
+    HeapDumpPartition* const partition_;
+  };
+
   static void RootVisitor(mirror::Object** obj, void* arg, uint32_t thread_id, RootType root_type)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     DCHECK(arg != nullptr);
@@ -508,15 +883,160 @@ class Hprof {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     DCHECK(obj != NULL);
     DCHECK(arg != NULL);
-    reinterpret_cast<Hprof*>(arg)->DumpHeapObject(obj);
+    HeapDumpPartition* partition = reinterpret_cast<HeapDumpPartition*>(arg);
+    partition->hprof->DumpHeapObject(partition, obj);
   }
 
   void VisitRoot(const mirror::Object* obj, uint32_t thread_id, RootType type)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  int DumpHeapObject(mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  int DumpHeapObject(HeapDumpPartition* partition, mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Split the heap into the roots and the objects outside the live bitmaps, followed by ranges of
+  // the live bitmaps, small enough for the walk to be balanced across the threads.
+  void CreatePartitions()
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
+    static constexpr size_t kLiveBitmapRangeSize = 4 * MB;
+    // Enough partitions to balance the threads, few enough to keep their overhead small.
+    static constexpr size_t kPartitionsPerThread = 4;
+    gc::Heap* heap = Runtime::Current()->GetHeap();
+    std::vector<gc::Heap::LiveBitmapRange> ranges;
+    heap->GetLiveBitmapRanges(kLiveBitmapRangeSize, &ranges);
+    ThreadPool* thread_pool = heap->GetThreadPool();
+    const size_t num_threads = (thread_pool != nullptr ? thread_pool->GetThreadCount() : 0) + 1;
+    const size_t max_partitions = kPartitionsPerThread * num_threads;
+    const size_t ranges_per_partition = (ranges.size() + max_partitions - 1) / max_partitions;
+    partitions_.clear();
+    partitions_.emplace_back(new HeapDumpPartition(this));
+    size_t ranges_in_partition = 0;
+    for (const gc::Heap::LiveBitmapRange& range : ranges) {
+      // Merge the following ranges of a space, including the empty ones between them.
+      gc::Heap::LiveBitmapRange* last = &partitions_.back()->range;
+      if (last->space == range.space && ranges_in_partition < ranges_per_partition) {
+        last->end = range.end;
+        ++ranges_in_partition;
+        continue;
+      }
+      partitions_.emplace_back(new HeapDumpPartition(this));
+      partitions_.back()->range = range;
+      ranges_in_partition = 1;
+    }
+  }
+
+  // Write the records of a partition to its output.
+  void WalkPartition(HeapDumpPartition* partition)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
+    partition->in_segment = false;
+    // The output of a partition written by itself only exists while the partition is walked, so
+    // that only the partitions being walked hold output buffers.
+    std::unique_ptr<HprofOutput> positioned_output;
+    if (partition->file != nullptr) {
+      positioned_output.reset(new PositionedFileHprofOutput(partition->file, partition->offset));
+      partition->output = positioned_output.get();
+    }
+    gc::Heap* heap = Runtime::Current()->GetHeap();
+    if (partition->range.space == nullptr) {
+      Runtime::Current()->VisitRoots(RootVisitor, this);
+      heap->VisitObjectsNotInLiveBitmaps(VisitObjectCallback, partition);
+    } else {
+      heap->VisitLiveBitmapRange(partition->range, VisitObjectCallback, partition);
+    }
+    partition->error = partition->record.Flush();
+    // Write out what the output buffers on this thread, so the partitions are written in parallel.
+    if (partition->error == 0 && !partition->output->Flush()) {
+      partition->error = UNIQUE_ERROR;
+    }
+    if (positioned_output.get() != nullptr) {
+      // The offsets of the following partitions depend on the size not changing.
+      CHECK_EQ(positioned_output->BytesWritten(), partition->size);
+      partition->output = nullptr;
+    }
+  }
+
+  // Walk the partitions. The first holds the roots and is walked by this thread, the others are
+  // walked in parallel on the heap's thread pool if there is one and the outputs allow it.
+  void WalkPartitions(Thread* self, bool parallel)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_) {
+    // GCs can move objects, so don't allow this.
+    const char* old_cause = self->StartAssertNoThreadSuspension("Dumping heap");
+    ThreadPool* thread_pool = Runtime::Current()->GetHeap()->GetThreadPool();
+    if (!parallel || thread_pool == nullptr) {
+      for (const auto& partition : partitions_) {
+        WalkPartition(partition.get());
+      }
+    } else {
+      for (size_t i = 1; i < partitions_.size(); ++i) {
+        thread_pool->AddTask(self, new PartitionTask(partitions_[i].get()));
+      }
+      thread_pool->SetMaxActiveWorkers(thread_pool->GetThreadCount());
+      thread_pool->StartWorkers(self);
+      WalkPartition(partitions_[0].get());
+      thread_pool->Wait(self, true, true);
+      thread_pool->StopWorkers(self);
+    }
+    self->EndAssertNoThreadSuspension(old_cause);
+  }
+
+  // Assign IDs to the strings collected by the partitions. The tables may not grow after this,
+  // which allows the partitions to look them up concurrently.
+  void MergeTables() {
+    for (const auto& partition : partitions_) {
+      partition->size = partition->output->BytesWritten();
+      for (const std::string& string : partition->strings) {
+        if (strings_.find(string) == strings_.end()) {
+          strings_.Put(string, next_string_id_++);
+        }
+      }
+      classes_.insert(partition->classes.begin(), partition->classes.end());
+      partition->strings.clear();
+      partition->classes.clear();
+    }
+    tables_frozen_ = true;
+  }
 
-  void Finish() {
+  // Write the heap dump segments of the partitions and the end of the heap dump to output_. With
+  // a file, the partitions are written in parallel to their offsets in it instead.
+  int WriteHeapDump(Thread* self, File* file, size_t* dump_size)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_) {
+    ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    size_t partitions_size = 0;
+    if (file != nullptr) {
+      // The partitions are written after what the output has buffered.
+      if (!output_->Flush()) {
+        return UNIQUE_ERROR;
+      }
+      int64_t offset = lseek(file->Fd(), 0, SEEK_CUR);
+      if (offset < 0) {
+        return UNIQUE_ERROR;
+      }
+      for (const auto& partition : partitions_) {
+        partition->SetOutput(nullptr, false);
+        partition->file = file;
+        partition->offset = offset + partitions_size;
+        partitions_size += partition->size;
+      }
+      WalkPartitions(self, true);
+      if (lseek(file->Fd(), offset + partitions_size, SEEK_SET) < 0) {
+        return UNIQUE_ERROR;
+      }
+    } else {
+      for (const auto& partition : partitions_) {
+        partition->SetOutput(output_, false);
+      }
+      WalkPartitions(self, false);
+    }
+    for (const auto& partition : partitions_) {
+      if (partition->error != 0) {
+        return partition->error;
+      }
+    }
+    current_record_.StartNewRecord(output_, HPROF_TAG_HEAP_DUMP_END, HPROF_TIME);
+    int rc = current_record_.Flush();
+    *dump_size = output_->BytesWritten() + partitions_size;
+    return rc;
   }
 
   int WriteClassTable() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -526,7 +1046,7 @@ class Hprof {
     for (mirror::Class* c : classes_) {
       CHECK(c != nullptr);
 
-      int err = current_record_.StartNewRecord(header_fp_, HPROF_TAG_LOAD_CLASS, HPROF_TIME);
+      int err = current_record_.StartNewRecord(output_, HPROF_TAG_LOAD_CLASS, HPROF_TIME);
       if (UNLIKELY(err != 0)) {
         return err;
       }
@@ -539,7 +1059,7 @@ class Hprof {
       rec->AddU4(nextSerialNumber++);
       rec->AddObjectId(c);
       rec->AddU4(HPROF_NULL_STACK_TRACE);
-      rec->AddStringId(LookupClassNameId(c));
+      rec->AddStringId(FindStringId(PrettyDescriptor(c)));
     }
 
     return 0;
@@ -552,7 +1072,7 @@ class Hprof {
       const std::string& string = p.first;
       size_t id = p.second;
 
-      int err = current_record_.StartNewRecord(header_fp_, HPROF_TAG_STRING, HPROF_TIME);
+      int err = current_record_.StartNewRecord(output_, HPROF_TAG_STRING, HPROF_TIME);
       if (err != 0) {
         return err;
       }
@@ -574,56 +1094,83 @@ class Hprof {
     return 0;
   }
 
-  void StartNewHeapDumpSegment() {
+  // Start a new segment if the partition has none yet or its current one is full.
+  void GuaranteeHeapDumpSegment(HeapDumpPartition* partition) {
+    if (!partition->in_segment || partition->objects_in_segment >= OBJECTS_PER_SEGMENT ||
+        partition->record.Size() >= BYTES_PER_SEGMENT) {
+      StartNewHeapDumpSegment(partition);
+    }
+  }
+
+  void StartNewHeapDumpSegment(HeapDumpPartition* partition) {
     // This flushes the old segment and starts a new one.
-    current_record_.StartNewRecord(body_fp_, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
-    objects_in_segment_ = 0;
+    partition->record.StartNewRecord(partition->output, HPROF_TAG_HEAP_DUMP_SEGMENT, HPROF_TIME);
+    partition->objects_in_segment = 0;
+    partition->in_segment = true;
 
     // Starting a new HEAP_DUMP resets the heap to default.
-    current_heap_ = HPROF_HEAP_DEFAULT;
+    partition->current_heap = HPROF_HEAP_DEFAULT;
+  }
+
+  // Start a segment of the given length for a single large object, which is streamed.
+  void StartStreamedHeapDumpSegment(HeapDumpPartition* partition, uint32_t length) {
+    partition->record.StartNewStreamedRecord(partition->output, HPROF_TAG_HEAP_DUMP_SEGMENT,
+                                             HPROF_TIME, length);
+    partition->objects_in_segment = 0;
+    partition->in_segment = true;
+    partition->current_heap = HPROF_HEAP_DEFAULT;
   }
 
-  int MarkRootObject(const mirror::Object* obj, jobject jniObj);
+  int MarkRootObject(HeapDumpPartition* partition, const mirror::Object* obj, jobject jniObj);
 
-  HprofClassObjectId LookupClassId(mirror::Class* c) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  HprofClassObjectId LookupClassId(HeapDumpPartition* partition, mirror::Class* c)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     if (c == nullptr) {
       // c is the superclass of java.lang.Object or a primitive.
       return 0;
     }
 
-    {
-      auto result = classes_.insert(c);
-      const mirror::Class* present = *result.first;
-      CHECK_EQ(present, c);
+    if (!tables_frozen_) {
+      partition->classes.insert(c);
+      // Make sure that we've assigned a string ID for this class' name
+      LookupClassNameId(partition, c);
+    } else {
+      DCHECK(classes_.find(c) != classes_.end()) << PrettyClass(c);
     }
 
-    // Make sure that we've assigned a string ID for this class' name
-    LookupClassNameId(c);
-
     HprofClassObjectId result = PointerToLowMemUInt32(c);
     return result;
   }
 
-  HprofStringId LookupStringId(mirror::String* string) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    return LookupStringId(string->ToModifiedUtf8());
+  HprofStringId LookupStringId(HeapDumpPartition* partition, mirror::String* string)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return LookupStringId(partition, string->ToModifiedUtf8());
   }
 
-  HprofStringId LookupStringId(const char* string) {
-    return LookupStringId(std::string(string));
+  HprofStringId LookupStringId(HeapDumpPartition* partition, const char* string) {
+    return LookupStringId(partition, std::string(string));
   }
 
-  HprofStringId LookupStringId(const std::string& string) {
-    auto it = strings_.find(string);
-    if (it != strings_.end()) {
-      return it->second;
+  // While the strings are collected, their IDs are not yet assigned. Only the size of the records
+  // matters then, which does not depend on them.
+  HprofStringId LookupStringId(HeapDumpPartition* partition, const std::string& string) {
+    if (!tables_frozen_) {
+      partition->strings.insert(string);
+      return 0;
     }
-    HprofStringId id = next_string_id_++;
-    strings_.Put(string, id);
-    return id;
+    return FindStringId(string);
+  }
+
+  HprofStringId FindStringId(const std::string& string) const {
+    auto it = strings_.find(string);
+    // The tables precede the heap records, which may not refer to new strings.
+    CHECK(it != strings_.end()) << string;
+    return it->second;
   }
 
-  HprofStringId LookupClassNameId(mirror::Class* c) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    return LookupStringId(PrettyDescriptor(c));
+  HprofStringId LookupClassNameId(HeapDumpPartition* partition, mirror::Class* c)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return LookupStringId(partition, PrettyDescriptor(c));
   }
 
   void WriteFixedHeader() {
@@ -632,7 +1179,7 @@ class Hprof {
 
     // Write the file header.
     // U1: NUL-terminated magic string.
-    fwrite(magic, 1, sizeof(magic), header_fp_);
+    output_->Write(magic, sizeof(magic));
 
     // U4: size of identifiers.  We're using addresses as IDs and our heap references are stored
     // as uint32_t.
@@ -640,7 +1187,7 @@ class Hprof {
     COMPILE_ASSERT(sizeof(mirror::HeapReference<mirror::Object>) == sizeof(uint32_t),
       UnexpectedHeapReferenceSize);
     U4_TO_BUF_BE(buf, 0, sizeof(uint32_t));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);
+    output_->Write(buf, sizeof(uint32_t));
 
     // The current time, in milliseconds since 0:00 GMT, 1/1/70.
     timeval now;
@@ -653,19 +1200,23 @@ class Hprof {
 
     // U4: high word of the 64-bit time.
     U4_TO_BUF_BE(buf, 0, (uint32_t)(nowMs >> 32));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);
+    output_->Write(buf, sizeof(uint32_t));
 
     // U4: low word of the 64-bit time.
     U4_TO_BUF_BE(buf, 0, (uint32_t)(nowMs & 0xffffffffULL));
-    fwrite(buf, 1, sizeof(uint32_t), header_fp_);  // xxx fix the time
+    output_->Write(buf, sizeof(uint32_t));  // xxx fix the time
   }
 
-  void WriteStackTraces() {
+  int WriteStackTraces() {
     // Write a dummy stack trace record so the analysis tools don't freak out.
-    current_record_.StartNewRecord(header_fp_, HPROF_TAG_STACK_TRACE, HPROF_TIME);
+    int err = current_record_.StartNewRecord(output_, HPROF_TAG_STACK_TRACE, HPROF_TIME);
+    if (err != 0) {
+      return err;
+    }
     current_record_.AddU4(HPROF_NULL_STACK_TRACE);
     current_record_.AddU4(HPROF_NULL_THREAD);
     current_record_.AddU4(0);    // no frames
+    return current_record_.Flush();
   }
 
   // If direct_to_ddms_ is set, "filename_" and "fd" will be ignored.
@@ -677,20 +1228,20 @@ class Hprof {
 
   uint64_t start_ns_;
 
+  // The record for the tables and the end of the heap dump, which are written by this thread.
   HprofRecord current_record_;
 
   uint32_t gc_thread_serial_number_;
   uint8_t gc_scan_state_;
-  HprofHeapId current_heap_;  // Which heap we're currently dumping.
-  size_t objects_in_segment_;
 
-  FILE* header_fp_;
-  char* header_data_ptr_;
-  size_t header_data_size_;
+  // The output of the header, the tables and the end of the heap dump.
+  HprofOutput* output_;
+  // Have the strings and classes of all partitions been merged into the tables, which must then
+  // not grow?
+  bool tables_frozen_;
 
-  FILE* body_fp_;
-  char* body_data_ptr_;
-  size_t body_data_size_;
+  // The first partition holds the roots and the objects outside the live bitmaps.
+  std::vector<std::unique_ptr<HeapDumpPartition>> partitions_;
 
   std::set<mirror::Class*> classes_;
   HprofStringId next_string_id_;
@@ -699,8 +1250,8 @@ class Hprof {
   DISALLOW_COPY_AND_ASSIGN(Hprof);
 };
 
-#define OBJECTS_PER_SEGMENT     ((size_t)128)
-#define BYTES_PER_SEGMENT       ((size_t)4096)
+// Size of a HEAP_DUMP_INFO record: tag, heap type and heap name string ID.
+#define HEAP_DUMP_INFO_SIZE     ((size_t)9)
 
 // The static field-name for the synthetic object generated to account for class static overhead.
 #define STATIC_OVERHEAD_NAME    "$staticOverhead"
@@ -758,17 +1309,16 @@ static HprofBasicType PrimitiveToBasicTypeAndSize(Primitive::Type prim, size_t*
 // something when ctx->gc_scan_state_ is non-zero, which is usually
 // only true when marking the root set or unreachable
 // objects.  Used to add rootset references to obj.
-int Hprof::MarkRootObject(const mirror::Object* obj, jobject jniObj) {
-  HprofRecord* rec = &current_record_;
+int Hprof::MarkRootObject(HeapDumpPartition* partition, const mirror::Object* obj,
+                          jobject jniObj) {
+  HprofRecord* rec = &partition->record;
   HprofHeapTag heapTag = (HprofHeapTag)gc_scan_state_;
 
   if (heapTag == 0) {
     return 0;
   }
 
-  if (objects_in_segment_ >= OBJECTS_PER_SEGMENT || rec->Size() >= BYTES_PER_SEGMENT) {
-    StartNewHeapDumpSegment();
-  }
+  GuaranteeHeapDumpSegment(partition);
 
   switch (heapTag) {
   // ID: object ID
@@ -837,7 +1387,7 @@ int Hprof::MarkRootObject(const mirror::Object* obj, jobject jniObj) {
     break;
   }
 
-  ++objects_in_segment_;
+  ++partition->objects_in_segment;
   return 0;
 }
 
@@ -845,8 +1395,25 @@ static int StackTraceSerialNumber(const mirror::Object* /*obj*/) {
   return HPROF_NULL_STACK_TRACE;
 }
 
-int Hprof::DumpHeapObject(mirror::Object* obj) {
-  HprofRecord* rec = &current_record_;
+// Returns the size of the dump record of an array, or 0 for other objects.
+static size_t ArrayDumpSize(mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  mirror::Class* c = obj->GetClass();
+  if (c == nullptr || !c->IsArrayClass()) {
+    return 0;
+  }
+  size_t length = obj->AsArray()->GetLength();
+  if (obj->IsObjectArray()) {
+    // Tag, object ID, stack trace, length, class ID and the element IDs.
+    return 1 + 4 + 4 + 4 + 4 + length * sizeof(uint32_t);
+  }
+  size_t size;
+  PrimitiveToBasicTypeAndSize(c->GetComponentType()->GetPrimitiveType(), &size);
+  // Tag, object ID, stack trace, length, element type and the elements.
+  return 1 + 4 + 4 + 4 + 1 + length * size;
+}
+
+int Hprof::DumpHeapObject(HeapDumpPartition* partition, mirror::Object* obj) {
+  HprofRecord* rec = &partition->record;
   gc::space::ContinuousSpace* space =
       Runtime::Current()->GetHeap()->FindContinuousSpaceFromObject(obj, true);
   HprofHeapId heap_type = HPROF_HEAP_APP;
@@ -857,11 +1424,15 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
       heap_type = HPROF_HEAP_IMAGE;
     }
   }
-  if (objects_in_segment_ >= OBJECTS_PER_SEGMENT || rec->Size() >= BYTES_PER_SEGMENT) {
-    StartNewHeapDumpSegment();
+  size_t array_size = ArrayDumpSize(obj);
+  if (array_size > HprofRecord::kStreamChunkSize) {
+    // Stream large arrays in a segment of their own rather than buffering them.
+    StartStreamedHeapDumpSegment(partition, HEAP_DUMP_INFO_SIZE + array_size);
+  } else {
+    GuaranteeHeapDumpSegment(partition);
   }
 
-  if (heap_type != current_heap_) {
+  if (heap_type != partition->current_heap) {
     HprofStringId nameId;
 
     // This object is in a different heap than the current one.
@@ -870,22 +1441,22 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
     rec->AddU4(static_cast<uint32_t>(heap_type));   // uint32_t: heap type
     switch (heap_type) {
     case HPROF_HEAP_APP:
-      nameId = LookupStringId("app");
+      nameId = LookupStringId(partition, "app");
       break;
     case HPROF_HEAP_ZYGOTE:
-      nameId = LookupStringId("zygote");
+      nameId = LookupStringId(partition, "zygote");
       break;
     case HPROF_HEAP_IMAGE:
-      nameId = LookupStringId("image");
+      nameId = LookupStringId(partition, "image");
       break;
     default:
       // Internal error
       LOG(ERROR) << "Unexpected desiredHeap";
-      nameId = LookupStringId("<ILLEGAL>");
+      nameId = LookupStringId(partition, "<ILLEGAL>");
       break;
     }
     rec->AddStringId(nameId);
-    current_heap_ = heap_type;
+    partition->current_heap = heap_type;
   }
 
   mirror::Class* c = obj->GetClass();
@@ -914,9 +1485,9 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
       }
 
       rec->AddU1(HPROF_CLASS_DUMP);
-      rec->AddClassId(LookupClassId(thisClass));
+      rec->AddClassId(LookupClassId(partition, thisClass));
       rec->AddU4(StackTraceSerialNumber(thisClass));
-      rec->AddClassId(LookupClassId(thisClass->GetSuperClass()));
+      rec->AddClassId(LookupClassId(partition, thisClass->GetSuperClass()));
       rec->AddObjectId(thisClass->GetClassLoader());
       rec->AddObjectId(nullptr);    // no signer
       rec->AddObjectId(nullptr);    // no prot domain
@@ -939,7 +1510,7 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
         rec->AddU2((uint16_t)0);
       } else {
         rec->AddU2((uint16_t)(sFieldCount+1));
-        rec->AddStringId(LookupStringId(STATIC_OVERHEAD_NAME));
+        rec->AddStringId(LookupStringId(partition, STATIC_OVERHEAD_NAME));
         rec->AddU1(hprof_basic_object);
         rec->AddClassStaticsId(thisClass);
 
@@ -948,7 +1519,7 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
 
           size_t size;
           HprofBasicType t = SignatureToBasicTypeAndSize(f->GetTypeDescriptor(), &size);
-          rec->AddStringId(LookupStringId(f->GetName()));
+          rec->AddStringId(LookupStringId(partition, f->GetName()));
           rec->AddU1(t);
           if (size == 1) {
             rec->AddU1(static_cast<uint8_t>(f->Get32(thisClass)));
@@ -970,7 +1541,7 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
       for (int i = 0; i < iFieldCount; ++i) {
         mirror::ArtField* f = thisClass->GetInstanceField(i);
         HprofBasicType t = SignatureToBasicTypeAndSize(f->GetTypeDescriptor(), NULL);
-        rec->AddStringId(LookupStringId(f->GetName()));
+        rec->AddStringId(LookupStringId(partition, f->GetName()));
         rec->AddU1(t);
       }
     } else if (c->IsArrayClass()) {
@@ -984,7 +1555,7 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
         rec->AddObjectId(obj);
         rec->AddU4(StackTraceSerialNumber(obj));
         rec->AddU4(length);
-        rec->AddClassId(LookupClassId(c));
+        rec->AddClassId(LookupClassId(partition, c));
 
         // Dump the elements, which are always objects or NULL.
         rec->AddIdList(aobj->AsObjectArray<mirror::Object>());
@@ -1000,15 +1571,19 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
         rec->AddU4(length);
         rec->AddU1(t);
 
-        // Dump the raw, packed element values.
-        if (size == 1) {
-          rec->AddU1List((const uint8_t*)aobj->GetRawData(sizeof(uint8_t), 0), length);
-        } else if (size == 2) {
-          rec->AddU2List((const uint16_t*)aobj->GetRawData(sizeof(uint16_t), 0), length);
-        } else if (size == 4) {
-          rec->AddU4List((const uint32_t*)aobj->GetRawData(sizeof(uint32_t), 0), length);
-        } else if (size == 8) {
-          rec->AddU8List((const uint64_t*)aobj->GetRawData(sizeof(uint64_t), 0), length);
+        // Dump the raw, packed element values, a chunk at a time.
+        const uint32_t chunk_length = HprofRecord::kStreamChunkSize / size;
+        for (uint32_t start = 0; start < length; start += chunk_length) {
+          uint32_t count = std::min(chunk_length, length - start);
+          if (size == 1) {
+            rec->AddU1List((const uint8_t*)aobj->GetRawData(sizeof(uint8_t), start), count);
+          } else if (size == 2) {
+            rec->AddU2List((const uint16_t*)aobj->GetRawData(sizeof(uint16_t), start), count);
+          } else if (size == 4) {
+            rec->AddU4List((const uint32_t*)aobj->GetRawData(sizeof(uint32_t), start), count);
+          } else if (size == 8) {
+            rec->AddU8List((const uint64_t*)aobj->GetRawData(sizeof(uint64_t), start), count);
+          }
         }
       }
     } else {
@@ -1016,7 +1591,7 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
       rec->AddU1(HPROF_INSTANCE_DUMP);
       rec->AddObjectId(obj);
       rec->AddU4(StackTraceSerialNumber(obj));
-      rec->AddClassId(LookupClassId(c));
+      rec->AddClassId(LookupClassId(partition, c));
 
       // Reserve some space for the length of the instance data, which we won't
       // know until we're done writing it.
@@ -1052,7 +1627,7 @@ int Hprof::DumpHeapObject(mirror::Object* obj) {
     }
   }
 
-  ++objects_in_segment_;
+  ++partition->objects_in_segment;
   return 0;
 }
 
@@ -1080,7 +1655,7 @@ void Hprof::VisitRoot(const mirror::Object* obj, uint32_t thread_id, RootType ty
   }
   gc_scan_state_ = xlate[type];
   gc_thread_serial_number_ = thread_id;
-  MarkRootObject(obj, 0);
+  MarkRootObject(partitions_[0].get(), obj, 0);
   gc_scan_state_ = 0;
   gc_thread_serial_number_ = 0;
 }
@@ -1089,6 +1664,10 @@ void Hprof::VisitRoot(const mirror::Object* obj, uint32_t thread_id, RootType ty
 // sent directly to DDMS.
 // If "fd" is >= 0, the output will be written to that file descriptor.
 // Otherwise, "filename" is used to create an output file.
+size_t GetPeakOutputBuffers() {
+  return BufferedHprofOutput::GetPeakBuffers();
+}
+
 void DumpHeap(const char* filename, int fd, bool direct_to_ddms) {
   CHECK(filename != NULL);
 
@@ -17,12 +17,18 @@
 #ifndef ART_RUNTIME_HPROF_HPROF_H_
 #define ART_RUNTIME_HPROF_HPROF_H_
 
+#include <stddef.h>
+
 namespace art {
 
 namespace hprof {
 
 void DumpHeap(const char* filename, int fd, bool direct_to_ddms);
 
+// The most 64KB output buffers of heap dumps allocated at the same time so far. A dump allocates
+// one for each thread writing to the output.
+size_t GetPeakOutputBuffers();
+
 }  // namespace hprof
 
 }  // namespace art
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hprof.h"
+
+#include <string>
+
+#include "common_runtime_test.h"
+#include "gc/heap.h"
+#include "mirror/array-inl.h"
+#include "scoped_thread_state_change.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+namespace art {
+namespace hprof {
+
+class HprofTest : public CommonRuntimeTest {};
+
+TEST_F(HprofTest, DumpBoundsOutputBuffers) {
+  static const size_t kLargeArrays = 64;
+  {
+    // Large objects spread over the address space, and many small ones.
+    ScopedObjectAccess soa(Thread::Current());
+    for (size_t i = 0; i < kLargeArrays; ++i) {
+      ASSERT_TRUE(mirror::ByteArray::Alloc(soa.Self(), 64 * KB) != nullptr);
+      for (size_t j = 0; j < 256; ++j) {
+        ASSERT_TRUE(mirror::IntArray::Alloc(soa.Self(), 16) != nullptr);
+      }
+    }
+  }
+  ScratchFile hprof_file;
+  DumpHeap(hprof_file.GetFilename().c_str(), -1, false);
+
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(hprof_file.GetFilename(), &data));
+  EXPECT_EQ(0U, data.find("JAVA PROFILE 1.0.3"));
+  // The partitions are written by the threads walking them, which hold a buffer each while the
+  // output of the header and the tables has none.
+  ThreadPool* thread_pool = Runtime::Current()->GetHeap()->GetThreadPool();
+  const size_t num_threads = (thread_pool != nullptr ? thread_pool->GetThreadCount() : 0) + 1;
+  EXPECT_GE(GetPeakOutputBuffers(), 1U);
+  EXPECT_LE(GetPeakOutputBuffers(), num_threads);
+}
+
+}  // namespace hprof
+}  // namespace art
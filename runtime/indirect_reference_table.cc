@@ -68,32 +68,69 @@ IndirectReferenceTable::IndirectReferenceTable(size_t initialCount,
   CHECK_LE(initialCount, maxCount);
   CHECK_NE(desiredKind, kHandleScopeOrInvalid);
 
-  std::string error_str;
-  const size_t initial_bytes = initialCount * sizeof(const mirror::Object*);
-  const size_t table_bytes = maxCount * sizeof(const mirror::Object*);
-  table_mem_map_.reset(MemMap::MapAnonymous("indirect ref table", nullptr, table_bytes,
-                                            PROT_READ | PROT_WRITE, false, &error_str));
-  CHECK(table_mem_map_.get() != nullptr) << error_str;
-  CHECK_EQ(table_mem_map_->Size(), table_bytes);
-
-  table_ = reinterpret_cast<GcRoot<mirror::Object>*>(table_mem_map_->Begin());
-  CHECK(table_ != nullptr);
-  memset(table_, 0xd1, initial_bytes);
-
-  const size_t slot_bytes = maxCount * sizeof(IndirectRefSlot);
-  slot_mem_map_.reset(MemMap::MapAnonymous("indirect ref table slots", nullptr, slot_bytes,
-                                           PROT_READ | PROT_WRITE, false, &error_str));
-  CHECK(slot_mem_map_.get() != nullptr) << error_str;
-  slot_data_ = reinterpret_cast<IndirectRefSlot*>(slot_mem_map_->Begin());
-  CHECK(slot_data_ != nullptr);
-
+  // Indices have to fit in the 16 bits of the segment state and the indirect reference.
+  CHECK_LE(maxCount, 65535U);
+
+  // Chunks as small as the initial entries, so that the locals of a thread only take what they
+  // start with, unless that would take too many chunks.
+  const size_t entries_per_chunk = std::min<size_t>(
+      RoundUpToPowerOfTwo(std::max(initialCount, RoundUp(maxCount, kIRTMaxChunks) / kIRTMaxChunks)),
+      kIRTEntriesPerChunk);
+  chunk_shift_ = CTZ(entries_per_chunk);
+  const size_t max_chunks = ChunksFor(maxCount);
+  chunks_.reset(new GcRoot<mirror::Object>*[max_chunks]());
+  slot_chunks_.reset(new IndirectRefSlot*[max_chunks]());
+  num_chunks_ = 0;
+  chunk_serial_ = 0;
   segment_state_.all = IRT_FIRST_SEGMENT;
-  alloc_entries_ = initialCount;
   max_entries_ = maxCount;
   kind_ = desiredKind;
+
+  while (AllocatedEntries() < initialCount) {
+    CHECK(AllocateChunk());
+  }
+  initial_chunks_ = num_chunks_;
 }
 
 IndirectReferenceTable::~IndirectReferenceTable() {
+  for (size_t i = 0; i < num_chunks_; ++i) {
+    delete[] chunks_[i];
+    delete[] slot_chunks_[i];
+  }
+}
+
+bool IndirectReferenceTable::AllocateChunk() {
+  const size_t begin = num_chunks_ << chunk_shift_;
+  if (begin >= max_entries_) {
+    return false;
+  }
+  // The last chunk only has room up to the maximum, which keeps small tables small.
+  const size_t count = std::min(EntriesPerChunk(), max_entries_ - begin);
+  chunks_[num_chunks_] = new GcRoot<mirror::Object>[count];
+  // Serials continue above those of the released chunks, so that references into a chunk freed
+  // by a pop stay stale when the table grows into the same indices again.
+  IndirectRefSlot* slots = new IndirectRefSlot[count]();
+  for (size_t i = 0; i < count; ++i) {
+    slots[i].serial = chunk_serial_;
+  }
+  slot_chunks_[num_chunks_] = slots;
+  ++num_chunks_;
+  return true;
+}
+
+void IndirectReferenceTable::ReleaseUnusedChunks() {
+  const size_t keep = std::max(ChunksFor(segment_state_.parts.topIndex) + 1, initial_chunks_);
+  while (num_chunks_ > keep) {
+    --num_chunks_;
+    delete[] chunks_[num_chunks_];
+    chunks_[num_chunks_] = nullptr;
+    const size_t count = std::min(EntriesPerChunk(), max_entries_ - (num_chunks_ << chunk_shift_));
+    for (size_t i = 0; i < count; ++i) {
+      chunk_serial_ = std::max(chunk_serial_, slot_chunks_[num_chunks_][i].serial);
+    }
+    delete[] slot_chunks_[num_chunks_];
+    slot_chunks_[num_chunks_] = nullptr;
+  }
 }
 
 IndirectRef IndirectReferenceTable::Add(uint32_t cookie, mirror::Object* obj) {
@@ -103,25 +140,15 @@ IndirectRef IndirectReferenceTable::Add(uint32_t cookie, mirror::Object* obj) {
 
   CHECK(obj != NULL);
   VerifyObject(obj);
-  DCHECK(table_ != NULL);
-  DCHECK_LE(alloc_entries_, max_entries_);
   DCHECK_GE(segment_state_.parts.numHoles, prevState.parts.numHoles);
 
-  if (topIndex == alloc_entries_) {
-    // reached end of allocated space; did we hit buffer max?
-    if (topIndex == max_entries_) {
+  if (UNLIKELY(topIndex == AllocatedEntries())) {
+    // reached end of allocated space; grow by a chunk unless we hit buffer max.
+    if (!AllocateChunk()) {
       LOG(FATAL) << "JNI ERROR (app bug): " << kind_ << " table overflow "
                  << "(max=" << max_entries_ << ")\n"
                  << MutatorLockedDumpable<IndirectReferenceTable>(*this);
     }
-
-    size_t newSize = alloc_entries_ * 2;
-    if (newSize > max_entries_) {
-      newSize = max_entries_;
-    }
-    DCHECK_GT(newSize, alloc_entries_);
-
-    alloc_entries_ = newSize;
   }
 
   // We know there's enough room in the table.  Now we just need to find
@@ -132,22 +159,22 @@ IndirectRef IndirectReferenceTable::Add(uint32_t cookie, mirror::Object* obj) {
   if (numHoles > 0) {
     DCHECK_GT(topIndex, 1U);
     // Find the first hole; likely to be near the end of the list.
-    GcRoot<mirror::Object>* pScan = &table_[topIndex - 1];
-    DCHECK(!pScan->IsNull());
-    --pScan;
-    while (!pScan->IsNull()) {
-      DCHECK_GE(pScan, table_ + prevState.parts.topIndex);
-      --pScan;
+    size_t scan = topIndex - 1;
+    DCHECK(!EntryAt(scan)->IsNull());
+    --scan;
+    while (!EntryAt(scan)->IsNull()) {
+      DCHECK_GE(scan, prevState.parts.topIndex);
+      --scan;
     }
-    UpdateSlotAdd(obj, pScan - table_);
-    result = ToIndirectRef(pScan - table_);
-    *pScan = GcRoot<mirror::Object>(obj);
+    UpdateSlotAdd(obj, scan);
+    result = ToIndirectRef(scan);
+    *EntryAt(scan) = GcRoot<mirror::Object>(obj);
     segment_state_.parts.numHoles--;
   } else {
     // Add to the end.
     UpdateSlotAdd(obj, topIndex);
     result = ToIndirectRef(topIndex);
-    table_[topIndex++] = GcRoot<mirror::Object>(obj);
+    *EntryAt(topIndex++) = GcRoot<mirror::Object>(obj);
     segment_state_.parts.topIndex = topIndex;
   }
   if (false) {
@@ -181,8 +208,6 @@ bool IndirectReferenceTable::Remove(uint32_t cookie, IndirectRef iref) {
   int topIndex = segment_state_.parts.topIndex;
   int bottomIndex = prevState.parts.topIndex;
 
-  DCHECK(table_ != NULL);
-  DCHECK_LE(alloc_entries_, max_entries_);
   DCHECK_GE(segment_state_.parts.numHoles, prevState.parts.numHoles);
 
   int idx = ExtractIndex(iref);
@@ -213,16 +238,16 @@ bool IndirectReferenceTable::Remove(uint32_t cookie, IndirectRef iref) {
       return false;
     }
 
-    table_[idx] = GcRoot<mirror::Object>(nullptr);
+    *EntryAt(idx) = GcRoot<mirror::Object>(nullptr);
     int numHoles = segment_state_.parts.numHoles - prevState.parts.numHoles;
     if (numHoles != 0) {
       while (--topIndex > bottomIndex && numHoles != 0) {
         if (false) {
           LOG(INFO) << "+++ checking for hole at " << topIndex-1
                     << " (cookie=" << cookie << ") val="
-                    << table_[topIndex - 1].Read<kWithoutReadBarrier>();
+                    << EntryAt(topIndex - 1)->Read<kWithoutReadBarrier>();
         }
-        if (!table_[topIndex-1].IsNull()) {
+        if (!EntryAt(topIndex - 1)->IsNull()) {
           break;
         }
         if (false) {
@@ -242,7 +267,7 @@ bool IndirectReferenceTable::Remove(uint32_t cookie, IndirectRef iref) {
     // Not the top-most entry.  This creates a hole.  We NULL out the
     // entry to prevent somebody from deleting it twice and screwing up
     // the hole count.
-    if (table_[idx].IsNull()) {
+    if (EntryAt(idx)->IsNull()) {
       LOG(INFO) << "--- WEIRD: removing null entry " << idx;
       return false;
     }
@@ -250,7 +275,7 @@ bool IndirectReferenceTable::Remove(uint32_t cookie, IndirectRef iref) {
       return false;
     }
 
-    table_[idx] = GcRoot<mirror::Object>(nullptr);
+    *EntryAt(idx) = GcRoot<mirror::Object>(nullptr);
     segment_state_.parts.numHoles++;
     if (false) {
       LOG(INFO) << "+++ left hole at " << idx << ", holes=" << segment_state_.parts.numHoles;
@@ -272,7 +297,7 @@ void IndirectReferenceTable::Dump(std::ostream& os) const {
   os << kind_ << " table dump:\n";
   ReferenceTable::Table entries;
   for (size_t i = 0; i < Capacity(); ++i) {
-    mirror::Object* obj = table_[i].Read<kWithoutReadBarrier>();
+    mirror::Object* obj = EntryAt(i)->Read<kWithoutReadBarrier>();
     if (UNLIKELY(obj == nullptr)) {
       // Remove NULLs.
     } else if (UNLIKELY(obj == kClearedJniWeakGlobal)) {
@@ -280,7 +305,7 @@ void IndirectReferenceTable::Dump(std::ostream& os) const {
       // while the read barrier won't.
       entries.push_back(GcRoot<mirror::Object>(obj));
     } else {
-      obj = table_[i].Read();
+      obj = EntryAt(i)->Read();
       entries.push_back(GcRoot<mirror::Object>(obj));
     }
   }
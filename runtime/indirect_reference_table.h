@@ -19,16 +19,20 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <iosfwd>
+#include <memory>
 #include <string>
 
 #include "base/logging.h"
 #include "base/mutex.h"
 #include "gc_root.h"
+#include "globals.h"
 #include "mem_map.h"
 #include "object_callbacks.h"
 #include "offsets.h"
 #include "read_barrier_option.h"
+#include "utils.h"
 
 namespace art {
 namespace mirror {
@@ -148,10 +152,14 @@ static const uint32_t IRT_FIRST_SEGMENT = 0;
  * most-recently-added entry).  For JNI local references, the common
  * operations are adding a new entry and removing an entire table segment.
  *
- * If "alloc_entries_" is not equal to "max_entries_", the table may expand
- * when entries are added, which means the memory may move.  If you want
- * to keep pointers into "table" rather than offsets, you must use a
- * fixed-size table.
+ * The table is stored in chunks, which are allocated as the top index
+ * grows into them and freed again when a segment pop leaves them unused.
+ * A chunk has room for the initial entries, so that a thread's locals
+ * start small, but at most a page worth and enough that kIRTMaxChunks
+ * cover "max_entries_".  Only the array of chunk pointers is sized for
+ * "max_entries_" up front.  An entry stays at the
+ * same address while it is in use, but entries of different chunks are
+ * not contiguous: go through the table to find them.
  *
  * If we delete entries from the middle of the list, we will be left with
  * "holes".  We track the number of holes so that, when adding new elements,
@@ -203,11 +211,17 @@ union IRTSegmentState {
   } parts;
 };
 
+// Maximum number of entries of a chunk of the table, see IndirectReferenceTable.
+static constexpr size_t kIRTEntriesPerChunk = kPageSize / sizeof(GcRoot<mirror::Object>);
+// Number of chunks a table is at most split into, unless its chunks are a page already.
+static constexpr size_t kIRTMaxChunks = 64;
+
 class IrtIterator {
  public:
-  explicit IrtIterator(GcRoot<mirror::Object>* table, size_t i, size_t capacity)
+  explicit IrtIterator(GcRoot<mirror::Object>* const* chunks, size_t chunk_shift, size_t i,
+                       size_t capacity)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      : table_(table), i_(i), capacity_(capacity) {
+      : chunks_(chunks), chunk_shift_(chunk_shift), i_(i), capacity_(capacity) {
     SkipNullsAndTombstones();
   }
 
@@ -219,24 +233,28 @@ class IrtIterator {
 
   mirror::Object** operator*() {
     // This does not have a read barrier as this is used to visit roots.
-    return table_[i_].AddressWithoutBarrier();
+    return Entry().AddressWithoutBarrier();
   }
 
   bool equals(const IrtIterator& rhs) const {
-    return (i_ == rhs.i_ && table_ == rhs.table_);
+    return (i_ == rhs.i_ && chunks_ == rhs.chunks_);
   }
 
  private:
+  GcRoot<mirror::Object>& Entry() const {
+    return chunks_[i_ >> chunk_shift_][i_ & ((1U << chunk_shift_) - 1)];
+  }
+
   void SkipNullsAndTombstones() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     // We skip NULLs and tombstones. Clients don't want to see implementation details.
     while (i_ < capacity_ &&
-           (table_[i_].IsNull() ||
-            table_[i_].Read<kWithoutReadBarrier>() == kClearedJniWeakGlobal)) {
+           (Entry().IsNull() || Entry().Read<kWithoutReadBarrier>() == kClearedJniWeakGlobal)) {
       ++i_;
     }
   }
 
-  GcRoot<mirror::Object>* const table_;
+  GcRoot<mirror::Object>* const* const chunks_;
+  const size_t chunk_shift_;
   size_t i_;
   size_t capacity_;
 };
@@ -304,13 +322,22 @@ class IndirectReferenceTable {
     return segment_state_.parts.topIndex;
   }
 
+  // Return the number of entries the allocated chunks have room for.
+  size_t AllocatedEntries() const {
+    return std::min(num_chunks_ << chunk_shift_, max_entries_);
+  }
+
+  size_t EntriesPerChunk() const {
+    return static_cast<size_t>(1) << chunk_shift_;
+  }
+
   // Note IrtIterator does not have a read barrier as it's used to visit roots.
   IrtIterator begin() {
-    return IrtIterator(table_, 0, Capacity());
+    return IrtIterator(chunks_.get(), chunk_shift_, 0, Capacity());
   }
 
   IrtIterator end() {
-    return IrtIterator(table_, Capacity(), Capacity());
+    return IrtIterator(chunks_.get(), chunk_shift_, Capacity(), Capacity());
   }
 
   void VisitRoots(RootCallback* callback, void* arg, uint32_t tid, RootType root_type)
@@ -320,8 +347,15 @@ class IndirectReferenceTable {
     return segment_state_.all;
   }
 
+  // Restore the state of a segment pushed earlier, popping the segments above it. Frees the
+  // chunks the popped segments grew into.
   void SetSegmentState(uint32_t new_state) {
     segment_state_.all = new_state;
+    // Keep a spare chunk so that a table going up and down across a chunk boundary does not
+    // allocate on every push.
+    if (UNLIKELY(num_chunks_ > ChunksFor(segment_state_.parts.topIndex) + 1)) {
+      ReleaseUnusedChunks();
+    }
   }
 
   static Offset SegmentStateOffset() {
@@ -343,7 +377,7 @@ class IndirectReferenceTable {
    */
   IndirectRef ToIndirectRef(uint32_t tableIndex) const {
     DCHECK_LT(tableIndex, 65536U);
-    uint32_t serialChunk = slot_data_[tableIndex].serial;
+    uint32_t serialChunk = SlotAt(tableIndex)->serial;
     uintptr_t uref = serialChunk << 20 | (tableIndex << 2) | kind_;
     return reinterpret_cast<IndirectRef>(uref);
   }
@@ -355,13 +389,30 @@ class IndirectReferenceTable {
    * this slot.
    */
   void UpdateSlotAdd(const mirror::Object* obj, int slot) {
-    if (slot_data_ != NULL) {
-      IndirectRefSlot* pSlot = &slot_data_[slot];
-      pSlot->serial++;
-      pSlot->previous[pSlot->serial % kIRTPrevCount] = obj;
-    }
+    IndirectRefSlot* pSlot = SlotAt(slot);
+    pSlot->serial++;
+    pSlot->previous[pSlot->serial % kIRTPrevCount] = obj;
+  }
+
+  // The entry and the extended debug info at "index", whose chunk must be allocated.
+  GcRoot<mirror::Object>* EntryAt(size_t index) const {
+    DCHECK_LT(index, AllocatedEntries());
+    return &chunks_[index >> chunk_shift_][index & (EntriesPerChunk() - 1)];
+  }
+  IndirectRefSlot* SlotAt(size_t index) const {
+    DCHECK_LT(index, AllocatedEntries());
+    return &slot_chunks_[index >> chunk_shift_][index & (EntriesPerChunk() - 1)];
   }
 
+  size_t ChunksFor(size_t entries) const {
+    return RoundUp(entries, EntriesPerChunk()) >> chunk_shift_;
+  }
+
+  // Allocate the next chunk. Returns false if the table is at its maximum size.
+  bool AllocateChunk();
+  // Free the chunks above the top index but a spare one, keeping the initial ones.
+  void ReleaseUnusedChunks();
+
   // Abort if check_jni is not enabled.
   static void AbortIfNoCheckJNI();
 
@@ -372,19 +423,22 @@ class IndirectReferenceTable {
   /* semi-public - read/write by jni down calls */
   IRTSegmentState segment_state_;
 
-  // Mem map where we store the indirect refs.
-  std::unique_ptr<MemMap> table_mem_map_;
-  // Mem map where we store the extended debugging info.
-  std::unique_ptr<MemMap> slot_mem_map_;
-  // bottom of the stack. Do not directly access the object references
-  // in this as they are roots. Use Get() that has a read barrier.
-  GcRoot<mirror::Object>* table_;
+  // The entries, in chunks of EntriesPerChunk(). The first num_chunks_ are allocated and the
+  // rest null; the array itself never moves. Do not directly access the object references in
+  // this as they are roots. Use Get() that has a read barrier.
+  std::unique_ptr<GcRoot<mirror::Object>*[]> chunks_;
+  /* extended debugging info, chunked like the entries */
+  std::unique_ptr<IndirectRefSlot*[]> slot_chunks_;
+  /* log2 of the #of entries of a chunk */
+  size_t chunk_shift_;
+  /* #of allocated chunks */
+  size_t num_chunks_;
+  /* #of chunks allocated by the constructor, never freed */
+  size_t initial_chunks_;
+  /* first serial of the slots of a new chunk, the highest serial of any released chunk */
+  uint32_t chunk_serial_;
   /* bit mask, ORed into all irefs */
   IndirectRefKind kind_;
-  /* extended debugging info */
-  IndirectRefSlot* slot_data_;
-  /* #of entries we have space for */
-  size_t alloc_entries_;
   /* max #of entries allowed */
   size_t max_entries_;
 };
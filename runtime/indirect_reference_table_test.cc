@@ -16,6 +16,8 @@
 
 #include "indirect_reference_table-inl.h"
 
+#include <vector>
+
 #include "common_runtime_test.h"
 #include "mirror/object-inl.h"
 #include "scoped_thread_state_change.h"
@@ -250,4 +252,117 @@ TEST_F(IndirectReferenceTableTest, BasicTest) {
   CheckDump(&irt, 0, 0);
 }
 
+TEST_F(IndirectReferenceTableTest, GrowAndShrinkSegments) {
+  ScopedObjectAccess soa(Thread::Current());
+  static const size_t kTableInitial = 16;
+  static const size_t kTableMax = 4 * kIRTEntriesPerChunk + 10;
+  IndirectReferenceTable irt(kTableInitial, kTableMax, kLocal);
+  // Chunks are small, but no more than kIRTMaxChunks are needed.
+  const size_t chunk = irt.EntriesPerChunk();
+  EXPECT_GE(chunk * kIRTMaxChunks, kTableMax);
+  EXPECT_LT(chunk, kIRTEntriesPerChunk);
+  EXPECT_EQ(chunk, irt.AllocatedEntries());
+
+  mirror::Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(c != NULL);
+  mirror::Object* obj0 = c->AllocObject(soa.Self());
+  ASSERT_TRUE(obj0 != NULL);
+
+  const uint32_t first_cookie = IRT_FIRST_SEGMENT;
+  IndirectRef iref0 = irt.Add(first_cookie, obj0);
+  ASSERT_TRUE(iref0 != NULL);
+
+  // Push a segment and fill the table up to its maximum, growing it chunk by chunk.
+  const uint32_t cookie = irt.GetSegmentState();
+  IndirectRef last = NULL;
+  for (size_t i = 1; i < kTableMax; i++) {
+    last = irt.Add(cookie, obj0);
+    ASSERT_TRUE(last != NULL) << "Failed adding " << i;
+  }
+  EXPECT_EQ(kTableMax, irt.Capacity());
+  EXPECT_EQ(kTableMax, irt.AllocatedEntries());
+  EXPECT_EQ(obj0, irt.Get(last));
+  EXPECT_EQ(obj0, irt.Get(iref0));
+
+  // Popping the segment frees all chunks but the one in use and a spare one.
+  irt.SetSegmentState(cookie);
+  EXPECT_EQ(1U, irt.Capacity());
+  EXPECT_EQ(2 * chunk, irt.AllocatedEntries());
+  EXPECT_EQ(obj0, irt.Get(iref0));
+
+  // The table grows again after a pop.
+  for (size_t i = 1; i < 3 * chunk; i++) {
+    last = irt.Add(cookie, obj0);
+    ASSERT_TRUE(last != NULL) << "Failed adding " << i;
+  }
+  EXPECT_EQ(obj0, irt.Get(last));
+  irt.SetSegmentState(first_cookie);
+  EXPECT_EQ(0U, irt.Capacity());
+  EXPECT_EQ(chunk, irt.AllocatedEntries());
+}
+
+TEST_F(IndirectReferenceTableTest, StaleAfterRegrow) {
+  ScopedObjectAccess soa(Thread::Current());
+  static const size_t kTableInitial = 16;
+  static const size_t kTableMax = 4 * kIRTEntriesPerChunk;
+  IndirectReferenceTable irt(kTableInitial, kTableMax, kLocal);
+  const size_t chunk = irt.EntriesPerChunk();
+
+  mirror::Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(c != NULL);
+  mirror::Object* obj0 = c->AllocObject(soa.Self());
+  ASSERT_TRUE(obj0 != NULL);
+  mirror::Object* obj1 = c->AllocObject(soa.Self());
+  ASSERT_TRUE(obj1 != NULL);
+
+  // Fill a pushed segment into the fourth chunk, which the pop frees.
+  const uint32_t cookie = irt.GetSegmentState();
+  IndirectRef stale = NULL;
+  for (size_t i = 0; i <= 3 * chunk; i++) {
+    stale = irt.Add(cookie, obj0);
+    ASSERT_TRUE(stale != NULL) << "Failed adding " << i;
+  }
+  irt.SetSegmentState(cookie);
+  EXPECT_EQ(chunk, irt.AllocatedEntries());
+
+  // Growing back into the same index gives a reference the stale one does not match.
+  IndirectRef last = NULL;
+  for (size_t i = 0; i <= 3 * chunk; i++) {
+    last = irt.Add(cookie, obj1);
+    ASSERT_TRUE(last != NULL) << "Failed adding " << i;
+  }
+  EXPECT_NE(stale, last);
+  EXPECT_EQ(obj1, irt.Get(last));
+  EXPECT_EQ(kInvalidIndirectRefObject, irt.Get(stale)) << "stale lookup succeeded";
+}
+
+TEST_F(IndirectReferenceTableTest, LocalsStartSmall) {
+  ScopedObjectAccess soa(Thread::Current());
+  // The sizes of the locals of a thread.
+  static const size_t kTableInitial = 64;
+  static const size_t kTableMax = 512;
+  IndirectReferenceTable irt(kTableInitial, kTableMax, kLocal);
+  EXPECT_EQ(kTableInitial, irt.EntriesPerChunk());
+  EXPECT_EQ(kTableInitial, irt.AllocatedEntries());
+
+  mirror::Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(c != NULL);
+  mirror::Object* obj0 = c->AllocObject(soa.Self());
+  ASSERT_TRUE(obj0 != NULL);
+
+  // Each chunk is allocated as the top index reaches it.
+  const uint32_t cookie = IRT_FIRST_SEGMENT;
+  std::vector<IndirectRef> irefs;
+  for (size_t i = 0; i < kTableMax; i++) {
+    irefs.push_back(irt.Add(cookie, obj0));
+    ASSERT_TRUE(irefs.back() != NULL) << "Failed adding " << i;
+    EXPECT_EQ(RoundUp(i + 1, kTableInitial), irt.AllocatedEntries());
+  }
+  for (IndirectRef iref : irefs) {
+    EXPECT_EQ(obj0, irt.Get(iref));
+  }
+  irt.SetSegmentState(cookie);
+  EXPECT_EQ(kTableInitial, irt.AllocatedEntries());
+}
+
 }  // namespace art
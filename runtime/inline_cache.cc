@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "inline_cache.h"
+
+#include <algorithm>
+
+#include "dex_file.h"
+#include "dex_instruction-inl.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class.h"
+#include "utils.h"
+
+namespace art {
+
+void InlineCache::Update(mirror::Class* klass, mirror::ArtMethod* target) {
+  DCHECK(target != nullptr);
+  uint32_t index;
+  do {
+    index = claimed_.LoadRelaxed();
+    for (size_t i = 0; i < index; ++i) {
+      if (classes_[i].Read() == klass) {
+        // Another thread got here first.
+        return;
+      }
+    }
+    if (index == kIndividualCacheSize) {
+      megamorphic_.StoreRelaxed(true);
+      return;
+    }
+  } while (!claimed_.CompareExchangeWeakRelaxed(index, index + 1));
+  // Threads that miss on the same class at once may still claim an entry each. Lookups find the
+  // first one, the other is only a wasted entry.
+  targets_[index] = target;
+  QuasiAtomic::ThreadFenceRelease();
+  classes_[index].Assign(klass);
+}
+
+MethodInlineCaches::MethodInlineCaches(mirror::ArtMethod* method,
+                                       const std::vector<uint32_t>& dex_pcs)
+    : method_(method), num_caches_(dex_pcs.size()), caches_(new InlineCache[dex_pcs.size()]) {
+  for (size_t i = 0; i < num_caches_; ++i) {
+    caches_[i].dex_pc_ = dex_pcs[i];
+  }
+}
+
+InlineCache* MethodInlineCaches::GetInlineCache(uint32_t dex_pc) {
+  InlineCache* const end = caches_.get() + num_caches_;
+  InlineCache* it = std::lower_bound(caches_.get(), end, dex_pc,
+                                     [](const InlineCache& cache, uint32_t pc) {
+                                       return cache.GetDexPc() < pc;
+                                     });
+  if (it == end || it->GetDexPc() != dex_pc) {
+    return nullptr;
+  }
+  return it;
+}
+
+InlineCacheTable::InlineCacheTable() : table_(new Atomic<MethodInlineCaches*>[kTableSize]()) {
+  COMPILE_ASSERT(IsPowerOfTwo(kTableSize), table_size_must_be_a_power_of_two);
+  COMPILE_ASSERT(!kMovingMethods, inline_caches_expect_methods_not_to_move);
+}
+
+InlineCacheTable::~InlineCacheTable() {
+  for (size_t i = 0; i < kTableSize; ++i) {
+    delete table_[i].LoadRelaxed();
+  }
+}
+
+MethodInlineCaches* InlineCacheTable::GetMethodInlineCaches(mirror::ArtMethod* method,
+                                                            bool create) {
+  const size_t start = TableIndex(method);
+  bool found_free_slot = false;
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    MethodInlineCaches* caches =
+        table_[(start + i) & (kTableSize - 1)].LoadSequentiallyConsistent();
+    if (caches == nullptr) {
+      found_free_slot = true;
+      break;
+    } else if (caches->GetMethod() == method) {
+      return caches;
+    }
+  }
+  if (!create || !found_free_slot) {
+    return nullptr;
+  }
+  const DexFile::CodeItem* code_item = method->GetCodeItem();
+  if (code_item == nullptr) {
+    return nullptr;
+  }
+  std::vector<uint32_t> dex_pcs;
+  const uint16_t* insns = code_item->insns_;
+  for (uint32_t dex_pc = 0; dex_pc < code_item->insns_size_in_code_units_; ) {
+    const Instruction* inst = Instruction::At(insns + dex_pc);
+    switch (inst->Opcode()) {
+      case Instruction::INVOKE_INTERFACE:
+      case Instruction::INVOKE_INTERFACE_RANGE:
+        dex_pcs.push_back(dex_pc);
+        break;
+      default:
+        break;
+    }
+    dex_pc += inst->SizeInCodeUnits();
+  }
+  if (dex_pcs.empty()) {
+    // Nothing to cache, don't spend a slot on the method.
+    return nullptr;
+  }
+  std::unique_ptr<MethodInlineCaches> new_caches(new MethodInlineCaches(method, dex_pcs));
+  // Another thread may create the caches of the method, or take the free slot, meanwhile.
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    Atomic<MethodInlineCaches*>& slot = table_[(start + i) & (kTableSize - 1)];
+    MethodInlineCaches* caches = slot.LoadSequentiallyConsistent();
+    if (caches == nullptr) {
+      if (slot.CompareExchangeStrongSequentiallyConsistent(nullptr, new_caches.get())) {
+        return new_caches.release();
+      }
+      caches = slot.LoadSequentiallyConsistent();
+    }
+    if (caches->GetMethod() == method) {
+      return caches;
+    }
+  }
+  return nullptr;
+}
+
+void InlineCacheTable::VisitRoots(RootCallback* callback, void* arg) {
+  for (size_t i = 0; i < kTableSize; ++i) {
+    MethodInlineCaches* caches = table_[i].LoadRelaxed();
+    if (caches == nullptr) {
+      continue;
+    }
+    for (size_t j = 0; j < caches->num_caches_; ++j) {
+      InlineCache& cache = caches->caches_[j];
+      for (size_t k = 0; k < InlineCache::kIndividualCacheSize; ++k) {
+        if (!cache.classes_[k].IsNull()) {
+          cache.classes_[k].VisitRoot(callback, arg, 0, kRootVMInternal);
+        }
+      }
+    }
+  }
+}
+
+size_t InlineCacheTable::NumberOfMethods() {
+  size_t count = 0;
+  for (size_t i = 0; i < kTableSize; ++i) {
+    if (table_[i].LoadRelaxed() != nullptr) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+}  // namespace art
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_INLINE_CACHE_H_
+#define ART_RUNTIME_INLINE_CACHE_H_
+
+#include <memory>
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "gc_root-inl.h"
+#include "globals.h"
+#include "object_callbacks.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+  class Class;
+}  // namespace mirror
+
+// The receiver classes seen at one invoke-interface, each with the method the invoke dispatched
+// to for it. Entries are claimed in order and never change once set, so neither readers nor
+// writers take a lock: a class is only published after its target, and an entry whose class
+// isn't visible yet reads as a miss. Once all entries are claimed further classes only mark the
+// call site megamorphic.
+class InlineCache {
+ public:
+  static constexpr size_t kIndividualCacheSize = 4;
+
+  InlineCache() : dex_pc_(0), claimed_(0), megamorphic_(false), targets_() {
+  }
+
+  uint32_t GetDexPc() const {
+    return dex_pc_;
+  }
+
+  // Returns the method the call site dispatches to for receivers of klass, or nullptr if klass
+  // has not been seen here.
+  mirror::ArtMethod* Lookup(mirror::Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    for (size_t i = 0; i < kIndividualCacheSize; ++i) {
+      mirror::Class* cached_class = classes_[i].Read();
+      if (cached_class == klass) {
+        return targets_[i];
+      } else if (cached_class == nullptr) {
+        break;
+      }
+    }
+    return nullptr;
+  }
+
+  // Record that the call site dispatched to target for a receiver of klass.
+  void Update(mirror::Class* klass, mirror::ArtMethod* target)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Type feedback for the compilers. The receiver classes are in the order they were first seen.
+  size_t GetNumberOfClasses() const {
+    size_t count = 0;
+    while (count < kIndividualCacheSize && !classes_[count].IsNull()) {
+      ++count;
+    }
+    return count;
+  }
+
+  mirror::Class* GetClass(size_t i) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    DCHECK_LT(i, kIndividualCacheSize);
+    return classes_[i].Read();
+  }
+
+  bool IsUninitialized() const {
+    return GetNumberOfClasses() == 0;
+  }
+
+  bool IsMonomorphic() const {
+    return !IsMegamorphic() && GetNumberOfClasses() == 1;
+  }
+
+  bool IsPolymorphic() const {
+    return !IsMegamorphic() && GetNumberOfClasses() > 1;
+  }
+
+  bool IsMegamorphic() const {
+    return megamorphic_.LoadRelaxed();
+  }
+
+ private:
+  uint32_t dex_pc_;
+  // Number of entries claimed by updates. An entry is only written by the thread that claimed it.
+  Atomic<uint32_t> claimed_;
+  Atomic<bool> megamorphic_;
+  GcRoot<mirror::Class> classes_[kIndividualCacheSize];
+  // Methods are never moved, their pointers don't need to be visited by the GC.
+  mirror::ArtMethod* targets_[kIndividualCacheSize];
+
+  friend class InlineCacheTable;
+  friend class MethodInlineCaches;
+
+  DISALLOW_COPY_AND_ASSIGN(InlineCache);
+};
+
+// The inline caches of all invoke-interface instructions of one method, sorted by dex pc.
+class MethodInlineCaches {
+ public:
+  MethodInlineCaches(mirror::ArtMethod* method, const std::vector<uint32_t>& dex_pcs);
+
+  mirror::ArtMethod* GetMethod() const {
+    return method_;
+  }
+
+  // Returns the cache of the invoke at dex_pc, or nullptr if there is no interface invoke at
+  // dex_pc.
+  InlineCache* GetInlineCache(uint32_t dex_pc);
+
+  size_t NumberOfInlineCaches() const {
+    return num_caches_;
+  }
+
+ private:
+  mirror::ArtMethod* const method_;
+  const size_t num_caches_;
+  std::unique_ptr<InlineCache[]> caches_;
+
+  friend class InlineCacheTable;
+
+  DISALLOW_COPY_AND_ASSIGN(MethodInlineCaches);
+};
+
+// Runtime-wide side table from methods to their inline caches. Caches are created the first time
+// the interpreter executes an interface invoke of a method and are never freed. The table is
+// indexed by method address with a bounded linear probe and methods that find no free slot
+// simply go without caches. Slots are filled with a compare-and-swap, so neither lookups nor
+// misses take a lock. The receiver classes held by the caches are roots, updated when a moving
+// collection relocates them.
+//
+// Virtual invokes aren't cached: their vtable dispatch costs about as much as a cache lookup and
+// the interpreter quickens them once resolved, see QuickenedCodeTable.
+class InlineCacheTable {
+ public:
+  InlineCacheTable();
+  ~InlineCacheTable();
+
+  // Returns the caches of method, creating them if create is true. Returns nullptr if method has
+  // no interface invokes, has no caches and create is false, or the table is full.
+  MethodInlineCaches* GetMethodInlineCaches(mirror::ArtMethod* method, bool create)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Shorthand for the cache of the invoke at dex_pc of method, created on first use.
+  InlineCache* GetInlineCache(mirror::ArtMethod* method, uint32_t dex_pc)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    MethodInlineCaches* caches = GetMethodInlineCaches(method, true);
+    return caches != nullptr ? caches->GetInlineCache(dex_pc) : nullptr;
+  }
+
+  // Called with the mutators suspended, like the other non-concurrent roots.
+  void VisitRoots(RootCallback* callback, void* arg);
+
+  size_t NumberOfMethods();
+
+ private:
+  static constexpr size_t kTableSize = 8 * KB;
+  static constexpr size_t kMaxProbes = 16;
+
+  static size_t TableIndex(mirror::ArtMethod* method) {
+    return (reinterpret_cast<uintptr_t>(method) / kObjectAlignment) & (kTableSize - 1);
+  }
+
+  // Slots are only ever filled, and own the caches they are filled with.
+  std::unique_ptr<Atomic<MethodInlineCaches*>[]> table_;
+
+  DISALLOW_COPY_AND_ASSIGN(InlineCacheTable);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_INLINE_CACHE_H_
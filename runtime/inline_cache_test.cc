@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "inline_cache.h"
+
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "dex_instruction-inl.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+
+class InlineCacheTest : public CommonRuntimeTest {};
+
+TEST_F(InlineCacheTest, ReceiverClasses) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* collection_class =
+      class_linker_->FindSystemClass(soa.Self(), "Ljava/util/AbstractCollection;");
+  ASSERT_TRUE(collection_class != nullptr);
+  // AbstractCollection.containsAll() calls iterator(), hasNext() and next() with
+  // invoke-interface.
+  mirror::ArtMethod* contains_all =
+      collection_class->FindVirtualMethod("containsAll", "(Ljava/util/Collection;)Z");
+  ASSERT_TRUE(contains_all != nullptr);
+  const DexFile::CodeItem* code_item = contains_all->GetCodeItem();
+  ASSERT_TRUE(code_item != nullptr);
+  uint32_t invoke_dex_pc = DexFile::kDexNoIndex;
+  for (uint32_t dex_pc = 0; dex_pc < code_item->insns_size_in_code_units_; ) {
+    const Instruction* inst = Instruction::At(code_item->insns_ + dex_pc);
+    if (inst->Opcode() == Instruction::INVOKE_INTERFACE) {
+      invoke_dex_pc = dex_pc;
+      break;
+    }
+    dex_pc += inst->SizeInCodeUnits();
+  }
+  ASSERT_NE(DexFile::kDexNoIndex, invoke_dex_pc);
+
+  InlineCacheTable table;
+  EXPECT_TRUE(table.GetMethodInlineCaches(contains_all, false) == nullptr);
+  MethodInlineCaches* caches = table.GetMethodInlineCaches(contains_all, true);
+  ASSERT_TRUE(caches != nullptr);
+  EXPECT_EQ(caches, table.GetMethodInlineCaches(contains_all, false));
+  EXPECT_EQ(1U, table.NumberOfMethods());
+  EXPECT_GE(caches->NumberOfInlineCaches(), 2U);
+  // There is no invoke in the middle of an instruction.
+  EXPECT_TRUE(caches->GetInlineCache(invoke_dex_pc + 1) == nullptr);
+
+  InlineCache* cache = table.GetInlineCache(contains_all, invoke_dex_pc);
+  ASSERT_TRUE(cache != nullptr);
+  EXPECT_EQ(invoke_dex_pc, cache->GetDexPc());
+  EXPECT_TRUE(cache->IsUninitialized());
+
+  // Methods without interface invokes get no caches.
+  mirror::Class* object_class = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(object_class != nullptr);
+  mirror::ArtMethod* to_string = object_class->FindVirtualMethod("toString",
+                                                                 "()Ljava/lang/String;");
+  ASSERT_TRUE(to_string != nullptr);
+  EXPECT_TRUE(table.GetMethodInlineCaches(to_string, true) == nullptr);
+  EXPECT_EQ(1U, table.NumberOfMethods());
+
+  const char* descriptors[] = {
+      "Ljava/lang/Object;", "Ljava/lang/String;", "Ljava/lang/Class;", "Ljava/lang/Integer;",
+      "Ljava/lang/Long;"
+  };
+  COMPILE_ASSERT(arraysize(descriptors) == InlineCache::kIndividualCacheSize + 1,
+                 one_more_class_than_the_cache_holds);
+  mirror::Class* classes[arraysize(descriptors)];
+  for (size_t i = 0; i < arraysize(descriptors); ++i) {
+    classes[i] = class_linker_->FindSystemClass(soa.Self(), descriptors[i]);
+    ASSERT_TRUE(classes[i] != nullptr) << descriptors[i];
+  }
+
+  cache->Update(classes[0], contains_all);
+  EXPECT_TRUE(cache->IsMonomorphic());
+  EXPECT_EQ(contains_all, cache->Lookup(classes[0]));
+  EXPECT_TRUE(cache->Lookup(classes[1]) == nullptr);
+  // Updating with a class already cached changes nothing.
+  cache->Update(classes[0], contains_all);
+  EXPECT_EQ(1U, cache->GetNumberOfClasses());
+
+  for (size_t i = 1; i < InlineCache::kIndividualCacheSize; ++i) {
+    cache->Update(classes[i], contains_all);
+  }
+  EXPECT_TRUE(cache->IsPolymorphic());
+  EXPECT_EQ(InlineCache::kIndividualCacheSize, cache->GetNumberOfClasses());
+  for (size_t i = 0; i < InlineCache::kIndividualCacheSize; ++i) {
+    EXPECT_EQ(classes[i], cache->GetClass(i));
+  }
+
+  cache->Update(classes[InlineCache::kIndividualCacheSize], contains_all);
+  EXPECT_TRUE(cache->IsMegamorphic());
+  EXPECT_FALSE(cache->IsPolymorphic());
+  EXPECT_TRUE(cache->Lookup(classes[InlineCache::kIndividualCacheSize]) == nullptr);
+  EXPECT_EQ(contains_all, cache->Lookup(classes[0]));
+}
+
+}  // namespace art
@@ -61,7 +61,7 @@ static bool InstallStubsClassVisitor(mirror::Class* klass, void* arg)
 Instrumentation::Instrumentation()
     : instrumentation_stubs_installed_(false), entry_exit_stubs_installed_(false),
       interpreter_stubs_installed_(false),
-      interpret_only_(false), forced_interpret_only_(false),
+      interpret_only_(false), forced_interpret_only_(false), method_trace_hooks_enabled_(false),
       have_method_entry_listeners_(false), have_method_exit_listeners_(false),
       have_method_unwind_listeners_(false), have_dex_pc_listeners_(false),
       have_field_read_listeners_(false), have_field_write_listeners_(false),
@@ -160,7 +160,7 @@ void Instrumentation::InstallStubsForMethod(mirror::ArtMethod* method) {
     }
   } else {  // !uninstall
     if ((interpreter_stubs_installed_ || forced_interpret_only_ || IsDeoptimized(method)) &&
-        !method->IsNative()) {
+        !method->IsNative() && !UsesMethodTraceHooks(method)) {
 #if defined(ART_USE_PORTABLE_COMPILER)
       new_portable_code = GetPortableToInterpreterBridge();
 #endif
@@ -686,7 +686,8 @@ void Instrumentation::UpdateMethodsCode(mirror::ArtMethod* method, const void* q
     new_quick_code = quick_code;
     new_have_portable_code = have_portable_code;
   } else {
-    if ((interpreter_stubs_installed_ || IsDeoptimized(method)) && !method->IsNative()) {
+    if ((interpreter_stubs_installed_ || IsDeoptimized(method)) && !method->IsNative() &&
+        !UsesMethodTraceHooks(method)) {
 #if defined(ART_USE_PORTABLE_COMPILER)
       new_portable_code = GetPortableToInterpreterBridge();
 #else
@@ -909,15 +910,40 @@ void Instrumentation::UndeoptimizeEverything() {
   ConfigureStubs(false, false);
 }
 
+static void SetMethodTraceHooksForThread(Thread* thread, void* arg) {
+  thread->SetMethodTraceHooksEnabled(*reinterpret_cast<bool*>(arg));
+}
+
+void Instrumentation::SetMethodTraceHooksEnabled(bool enabled) {
+  // Registering threads read the flag under the thread list lock.
+  MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+  method_trace_hooks_enabled_ = enabled;
+  Runtime::Current()->GetThreadList()->ForEach(SetMethodTraceHooksForThread, &enabled);
+}
+
 void Instrumentation::EnableMethodTracing() {
   bool require_interpreter = kDeoptimizeForAccurateMethodEntryExitListeners;
+  // Compiled code with method trace hooks keeps running when the interpreter is only required
+  // for tracing. If everything is already interpreted for another reason, e.g. the debugger,
+  // that code must stay interpreted.
+  if (require_interpreter && !interpreter_stubs_installed_) {
+    SetMethodTraceHooksEnabled(true);
+  }
   ConfigureStubs(!require_interpreter, require_interpreter);
 }
 
 void Instrumentation::DisableMethodTracing() {
+  if (method_trace_hooks_enabled_) {
+    SetMethodTraceHooksEnabled(false);
+  }
   ConfigureStubs(false, false);
 }
 
+bool Instrumentation::UsesMethodTraceHooks(mirror::ArtMethod* method) {
+  return method_trace_hooks_enabled_ && !forced_interpret_only_ && !method->IsNative() &&
+      !IsDeoptimized(method) && Runtime::Current()->GetClassLinker()->HasMethodTraceHooks(method);
+}
+
 const void* Instrumentation::GetQuickCodeFor(mirror::ArtMethod* method) const {
   Runtime* runtime = Runtime::Current();
   if (LIKELY(!instrumentation_stubs_installed_)) {
@@ -177,6 +177,17 @@ class Instrumentation {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
       LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::classlinker_classes_lock_);
 
+  // Is compiled code with method trace hooks reporting method entry and exit?
+  bool AreMethodTraceHooksEnabled() const {
+    return method_trace_hooks_enabled_;
+  }
+
+  // Can the method keep running its compiled code while method tracing forces the interpreter,
+  // because that code reports its own entry and exit?
+  bool UsesMethodTraceHooks(mirror::ArtMethod* method)
+      LOCKS_EXCLUDED(deoptimized_methods_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   InterpreterHandlerTable GetInterpreterHandlerTable() const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     return interpreter_handler_table_;
@@ -348,6 +359,11 @@ class Instrumentation {
       LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::classlinker_classes_lock_,
                      deoptimized_methods_lock_);
 
+  // Sets whether threads run the method trace hooks of compiled code.
+  void SetMethodTraceHooksEnabled(bool enabled)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
   void UpdateInterpreterHandlerTable() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_) {
     interpreter_handler_table_ = IsActive() ? kAlternativeHandlerTable : kMainHandlerTable;
   }
@@ -407,6 +423,11 @@ class Instrumentation {
   // Did the runtime request we only run in the interpreter? ie -Xint mode.
   bool forced_interpret_only_;
 
+  // Does method tracing keep compiled code with method trace hooks running instead of
+  // interpreting it? Written with the thread list lock held, which threads registering read it
+  // under.
+  bool method_trace_hooks_enabled_;
+
   // Do we have any listeners for method entry events? Short-cut to avoid taking the
   // instrumentation_lock_.
   bool have_method_entry_listeners_ GUARDED_BY(Locks::mutator_lock_);
@@ -18,7 +18,9 @@
 
 #include <limits>
 
+#include "interpreter/mterp/mterp.h"
 #include "mirror/string-inl.h"
+#include "quickened_code_table.h"
 
 namespace art {
 namespace interpreter {
@@ -311,16 +313,19 @@ static void InterpreterJni(Thread* self, ArtMethod* method, const StringPiece& s
   }
 }
 
-enum InterpreterImplKind {
-  kSwitchImpl,            // Switch-based interpreter implementation.
-  kComputedGotoImplKind   // Computed-goto-based interpreter implementation.
-};
+bool IsInterpreterImplAvailable(InterpreterImplKind kind) {
+  switch (kind) {
+    case kSwitchImpl:
+      return true;
+    case kComputedGotoImplKind:
+      return kDefaultInterpreterImplKind == kComputedGotoImplKind;
+    case kMterpImplKind:
+      return kMterpAvailable;
+  }
+  return false;
+}
 
-#if !defined(__clang__)
-static constexpr InterpreterImplKind kInterpreterImplKind = kComputedGotoImplKind;
-#else
-// Clang 3.4 fails to build the goto interpreter implementation.
-static constexpr InterpreterImplKind kInterpreterImplKind = kSwitchImpl;
+#if defined(__clang__)
 template<bool do_access_check, bool transaction_active>
 JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem* code_item,
                        ShadowFrame& shadow_frame, JValue result_register) {
@@ -358,17 +363,40 @@ static inline JValue Execute(Thread* self, MethodHelper& mh, const DexFile::Code
   DCHECK(!shadow_frame.GetMethod()->IsNative());
   shadow_frame.GetMethod()->GetDeclaringClass()->AssertInitializedOrInitializingInThread(self);
 
+  if (shadow_frame.GetDexPC() == 0) {
+    // Entering the method rather than resuming it after deoptimization.
+    AddJitSample(self, shadow_frame);
+  }
+
   bool transaction_active = Runtime::Current()->IsActiveTransaction();
   if (LIKELY(shadow_frame.GetMethod()->IsPreverified())) {
+    // Run the quickened copy of the code if there is one. Deoptimized frames resume in the original
+    // code, which has the same layout.
+    QuickenedCodeTable* quickened_code = Runtime::Current()->GetQuickenedCodeTable();
+    if (quickened_code != nullptr && shadow_frame.GetDexPC() == 0 &&
+        !shadow_frame.GetMethod()->GetDeclaringClass()->IsProxyClass()) {
+      code_item = quickened_code->GetCodeItemForEntry(self, shadow_frame.GetMethod(), code_item);
+    }
+    InterpreterImplKind kind = Runtime::Current()->GetInterpreterImplKind();
+    if (kind == kMterpImplKind) {
+      // The assembly interpreter reports no instrumentation events and cannot record transactions.
+      // It hands over to the default implementation where it stops.
+      if (!transaction_active && !Runtime::Current()->GetInstrumentation()->IsActive()) {
+        if (ExecuteMterp(self, code_item, shadow_frame, &result_register)) {
+          return result_register;
+        }
+      }
+      kind = kDefaultInterpreterImplKind;
+    }
     // Enter the "without access check" interpreter.
-    if (kInterpreterImplKind == kSwitchImpl) {
+    if (kind == kSwitchImpl) {
       if (transaction_active) {
         return ExecuteSwitchImpl<false, true>(self, mh, code_item, shadow_frame, result_register);
       } else {
         return ExecuteSwitchImpl<false, false>(self, mh, code_item, shadow_frame, result_register);
       }
     } else {
-      DCHECK_EQ(kInterpreterImplKind, kComputedGotoImplKind);
+      DCHECK_EQ(kind, kComputedGotoImplKind);
       if (transaction_active) {
         return ExecuteGotoImpl<false, true>(self, mh, code_item, shadow_frame, result_register);
       } else {
@@ -377,14 +405,18 @@ static inline JValue Execute(Thread* self, MethodHelper& mh, const DexFile::Code
     }
   } else {
     // Enter the "with access check" interpreter.
-    if (kInterpreterImplKind == kSwitchImpl) {
+    InterpreterImplKind kind = Runtime::Current()->GetInterpreterImplKind();
+    if (kind == kMterpImplKind) {
+      kind = kDefaultInterpreterImplKind;
+    }
+    if (kind == kSwitchImpl) {
       if (transaction_active) {
         return ExecuteSwitchImpl<true, true>(self, mh, code_item, shadow_frame, result_register);
       } else {
         return ExecuteSwitchImpl<true, false>(self, mh, code_item, shadow_frame, result_register);
       }
     } else {
-      DCHECK_EQ(kInterpreterImplKind, kComputedGotoImplKind);
+      DCHECK_EQ(kind, kComputedGotoImplKind);
       if (transaction_active) {
         return ExecuteGotoImpl<true, true>(self, mh, code_item, shadow_frame, result_register);
       } else {
@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_INTERPRETER_INTERPRETER_H_
 #define ART_RUNTIME_INTERPRETER_INTERPRETER_H_
 
+#include <ostream>
+
 #include "base/mutex.h"
 #include "dex_file.h"
 
@@ -33,6 +35,23 @@ class Thread;
 
 namespace interpreter {
 
+enum InterpreterImplKind {
+  kSwitchImpl,            // Switch-based interpreter implementation.
+  kComputedGotoImplKind,  // Computed-goto-based interpreter implementation.
+  kMterpImplKind          // Assembly interpreter, falling back to the default implementation.
+};
+std::ostream& operator<<(std::ostream& os, const InterpreterImplKind& rhs);
+
+#if !defined(__clang__)
+static constexpr InterpreterImplKind kDefaultInterpreterImplKind = kComputedGotoImplKind;
+#else
+// Clang 3.4 fails to build the goto interpreter implementation.
+static constexpr InterpreterImplKind kDefaultInterpreterImplKind = kSwitchImpl;
+#endif
+
+// Whether kind can run on this build, see -Xinterpreter-impl.
+bool IsInterpreterImplAvailable(InterpreterImplKind kind);
+
 // Called by ArtMethod::Invoke, shadow frames arguments are taken from the args array.
 extern void EnterInterpreterFromInvoke(Thread* self, mirror::ArtMethod* method,
                                        mirror::Object* receiver, uint32_t* args, JValue* result)
@@ -30,6 +30,8 @@
 #include "entrypoints/entrypoint_utils-inl.h"
 #include "gc/accounting/card_table-inl.h"
 #include "handle_scope-inl.h"
+#include "inline_cache.h"
+#include "jit/jit.h"
 #include "method_helper-inl.h"
 #include "nth_caller_visitor.h"
 #include "mirror/art_field-inl.h"
@@ -109,6 +111,21 @@ static inline bool DoInvoke(Thread* self, ShadowFrame& shadow_frame, const Instr
   const uint32_t vregC = (is_range) ? inst->VRegC_3rc() : inst->VRegC_35c();
   Object* receiver = (type == kStatic) ? nullptr : shadow_frame.GetVRegReference(vregC);
   mirror::ArtMethod* sf_method = shadow_frame.GetMethod();
+  // Interface invokes remember where they dispatched to for each receiver class. A hit skips
+  // resolution and the interface table lookup, all of which depend only on the call site and the
+  // receiver's class and already succeeded for it.
+  InlineCache* inline_cache = nullptr;
+  if (type == kInterface && LIKELY(receiver != nullptr)) {
+    inline_cache = Runtime::Current()->GetInlineCacheTable()->GetInlineCache(
+        sf_method, shadow_frame.GetDexPC());
+    if (LIKELY(inline_cache != nullptr)) {
+      ArtMethod* const target = inline_cache->Lookup(receiver->GetClass());
+      if (LIKELY(target != nullptr)) {
+        return DoCall<is_range, do_access_check>(target, self, shadow_frame, inst, inst_data,
+                                                 result);
+      }
+    }
+  }
   ArtMethod* const method = FindMethodFromCode<type, do_access_check>(
       method_idx, &receiver, &sf_method, self);
   // The shadow frame should already be pushed, so we don't need to update it.
@@ -121,6 +138,9 @@ static inline bool DoInvoke(Thread* self, ShadowFrame& shadow_frame, const Instr
     result->SetJ(0);
     return false;
   } else {
+    if (inline_cache != nullptr && !inline_cache->IsMegamorphic()) {
+      inline_cache->Update(receiver->GetClass(), method);
+    }
     return DoCall<is_range, do_access_check>(method, self, shadow_frame, inst, inst_data, result);
   }
 }
@@ -375,6 +395,29 @@ static inline bool IsBackwardBranch(int32_t branch_offset) {
   return branch_offset <= 0;
 }
 
+// Count a hotness sample of the method being interpreted, taken on method entry and on backward
+// branches, so that the JIT compiles methods that are called often or loop for long.
+static inline void AddJitSample(Thread* self, ShadowFrame& shadow_frame)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  jit::Jit* const jit = Runtime::Current()->GetJit();
+  if (UNLIKELY(jit != nullptr)) {
+    jit->AddSamples(self, shadow_frame.GetMethod(), 1);
+  }
+}
+
+// Count a hotness sample for a backward branch to target_dex_pc. Returns true if the JIT moved
+// the method into compiled code at the branch target and it ran to completion there, with its
+// return value in result or an exception pending.
+static inline bool AddJitBackwardBranchSample(Thread* self, ShadowFrame& shadow_frame,
+                                              uint32_t target_dex_pc, JValue* result)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  jit::Jit* const jit = Runtime::Current()->GetJit();
+  if (UNLIKELY(jit != nullptr)) {
+    return jit->AddBackwardBranchSample(self, &shadow_frame, target_dex_pc, result);
+  }
+  return false;
+}
+
 // Explicitly instantiate all DoInvoke functions.
 #define EXPLICIT_DO_INVOKE_TEMPLATE_DECL(_type, _is_range, _do_check)                      \
   template SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)                                     \
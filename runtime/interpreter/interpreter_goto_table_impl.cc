@@ -51,6 +51,17 @@ namespace interpreter {
     }                                                                       \
   } while (false)
 
+// Count a taken backward branch for the JIT. If the JIT finished the method in compiled code,
+// entered at the branch target, the interpreter is done with it.
+#define HANDLE_BACKWARD_BRANCH(_offset)                                                         \
+  do {                                                                                          \
+    JValue osr_result;                                                                          \
+    uint32_t target_dex_pc = static_cast<uint32_t>(static_cast<int32_t>(dex_pc) + (_offset));   \
+    if (UNLIKELY(AddJitBackwardBranchSample(self, shadow_frame, target_dex_pc, &osr_result))) { \
+      return osr_result;                                                                        \
+    }                                                                                           \
+  } while (false)
+
 #define UPDATE_HANDLER_TABLE() \
   currentHandlersTable = handlersTable[Runtime::Current()->GetInstrumentation()->GetInterpreterHandlerTable()]
 
@@ -631,6 +642,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(GOTO) {
     int8_t offset = inst->VRegA_10t(inst_data);
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -643,6 +655,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(GOTO_16) {
     int16_t offset = inst->VRegA_20t();
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -655,6 +668,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(GOTO_32) {
     int32_t offset = inst->VRegA_30t();
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -667,6 +681,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(PACKED_SWITCH) {
     int32_t offset = DoPackedSwitch(inst, shadow_frame, inst_data);
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -679,6 +694,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(SPARSE_SWITCH) {
     int32_t offset = DoSparseSwitch(inst, shadow_frame, inst_data);
     if (IsBackwardBranch(offset)) {
+      HANDLE_BACKWARD_BRANCH(offset);
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -772,6 +788,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) == shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -788,6 +805,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) != shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -804,6 +822,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) < shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -820,6 +839,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) >= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -836,6 +856,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) > shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -852,6 +873,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) <= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -868,6 +890,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) == 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -884,6 +907,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) != 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -900,6 +924,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) < 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -916,6 +941,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) >= 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -932,6 +958,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) > 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -948,6 +975,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) <= 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        HANDLE_BACKWARD_BRANCH(offset);
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -545,6 +545,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int8_t offset = inst->VRegA_10t(inst_data);
         if (IsBackwardBranch(offset)) {
+          AddJitSample(self, shadow_frame);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -556,6 +557,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int16_t offset = inst->VRegA_20t();
         if (IsBackwardBranch(offset)) {
+          AddJitSample(self, shadow_frame);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -567,6 +569,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int32_t offset = inst->VRegA_30t();
         if (IsBackwardBranch(offset)) {
+          AddJitSample(self, shadow_frame);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -578,6 +581,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int32_t offset = DoPackedSwitch(inst, shadow_frame, inst_data);
         if (IsBackwardBranch(offset)) {
+          AddJitSample(self, shadow_frame);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -589,6 +593,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int32_t offset = DoSparseSwitch(inst, shadow_frame, inst_data);
         if (IsBackwardBranch(offset)) {
+          AddJitSample(self, shadow_frame);
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -682,6 +687,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) == shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -697,6 +703,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) != shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -712,6 +719,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) < shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -727,6 +735,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) >= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -742,6 +751,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) > shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -757,6 +767,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) <= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -772,6 +783,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) == 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -787,6 +799,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) != 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -802,6 +815,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) < 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -817,6 +831,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) >= 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -832,6 +847,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) > 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -847,6 +863,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) <= 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            AddJitSample(self, shadow_frame);
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
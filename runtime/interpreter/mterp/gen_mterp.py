@@ -0,0 +1,208 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2014 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#
+# Generates the assembly interpreter of an architecture from its config file and templates.
+#
+# Usage: gen_mterp.py <arch>   (reads config_<arch>, writes out/mterp_<arch>.S)
+#
+# Config file commands:
+#   handler-size <bytes>     Size every opcode handler is aligned to. Must be a power of two and
+#                            match kMterpHandlerSize.
+#   import <file>            Copy <file> to the output as is.
+#   fallback <file>          Template of the opcodes that have no handler of their own.
+#   op-start <dir>           Emit the handlers, taking op_<name>.S of each opcode from <dir>.
+#   op <name> <dir>          Take the handler of opcode <name> from <dir> instead.
+#   op-end                   Done with the handlers.
+#
+# Handler templates are substituted with string.Template, "$$" being a literal '$'. Besides the
+# variables below, a template can use:
+#   %default { "name":"value", ... }       Default values of the variables of the template.
+#   %include "<file>" { "name":"value" }   Expand another template with the given variables.
+#   %break                                 Move what follows out of line, after all handlers, for
+#                                          code that would not fit in the handler size.
+# Every template sees $opcode (e.g. op_add_int) and $opnum (e.g. 0x90).
+#
+
+import os
+import re
+import string
+import sys
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+OPCODE_LIST = os.path.join(SCRIPT_DIR, "..", "..", "dex_instruction_list.h")
+NUM_OPCODES = 256
+
+class DataParseError(Exception):
+  pass
+
+def read_opcodes():
+  opcodes = [None] * NUM_OPCODES
+  pattern = re.compile(r"^\s*V\((0x[0-9A-Fa-f]{2}), (\w+),")
+  with open(OPCODE_LIST) as f:
+    for line in f:
+      match = pattern.match(line)
+      if match:
+        opcodes[int(match.group(1), 16)] = "op_" + match.group(2).lower()
+  if None in opcodes:
+    raise DataParseError("missing opcodes in %s" % OPCODE_LIST)
+  return opcodes
+
+def read_template(path):
+  with open(os.path.join(SCRIPT_DIR, path)) as f:
+    return f.read().splitlines()
+
+def parse_dict(text, where):
+  text = text.strip()
+  if not text:
+    return {}
+  try:
+    value = eval(text, {"__builtins__": {}})
+  except SyntaxError:
+    raise DataParseError("%s: bad dictionary %s" % (where, text))
+  if not isinstance(value, dict):
+    raise DataParseError("%s: expected a dictionary, got %s" % (where, text))
+  return value
+
+include_pattern = re.compile(r'^%include\s+"([^"]+)"\s*(.*)$')
+default_pattern = re.compile(r"^%default\s+(.*)$")
+
+def expand(path, variables, main, sister):
+  """Expand template path into the main and sister line lists."""
+  lines = read_template(path)
+  local_vars = {}
+  for line in lines:
+    match = default_pattern.match(line)
+    if match:
+      local_vars.update(parse_dict(match.group(1), path))
+  local_vars.update(variables)
+  target = main
+  for line in lines:
+    if default_pattern.match(line):
+      continue
+    match = include_pattern.match(line)
+    if match:
+      include_vars = dict(local_vars)
+      include_vars.update(parse_dict(match.group(2), path))
+      expand(match.group(1), include_vars, target, sister)
+      continue
+    if line.strip() == "%break":
+      target = sister
+      continue
+    try:
+      target.append(string.Template(line).substitute(local_vars))
+    except (KeyError, ValueError) as e:
+      raise DataParseError("%s: bad substitution in '%s': %s" % (path, line, e))
+
+def generate(arch):
+  opcodes = read_opcodes()
+  config_path = os.path.join(SCRIPT_DIR, "config_" + arch)
+  out = []
+  sisters = []
+  handler_size = None
+  fallback = None
+  op_dir = None
+  op_dirs = {}
+
+  def emit_handlers():
+    if handler_size is None:
+      raise DataParseError("handler-size must come before op-end")
+    out.append("")
+    out.append("    .global SYMBOL(artMterpAsmInstructionStart)")
+    out.append("    .balign %d" % handler_size)
+    out.append("SYMBOL(artMterpAsmInstructionStart):")
+    for opnum, opcode in enumerate(opcodes):
+      directory = op_dirs.get(opcode, op_dir)
+      path = os.path.join(directory, opcode + ".S")
+      variables = {"opcode": opcode, "opnum": "0x%02x" % opnum}
+      if not os.path.exists(os.path.join(SCRIPT_DIR, path)):
+        if fallback is None:
+          raise DataParseError("no handler for %s and no fallback" % opcode)
+        path = fallback
+      out.append("")
+      out.append("/* ------------------------------ */")
+      out.append("    .balign %d" % handler_size)
+      out.append("%s: /* %s */" % (opcode, variables["opnum"]))
+      sister = []
+      expand(path, variables, out, sister)
+      if sister:
+        sisters.append("")
+        sisters.append("/* continuation for %s */" % opcode)
+        sisters.extend(sister)
+    out.append("")
+    out.append("    .global SYMBOL(artMterpAsmInstructionEnd)")
+    out.append("    .balign %d" % handler_size)
+    out.append("SYMBOL(artMterpAsmInstructionEnd):")
+    out.append("")
+    out.append("/*")
+    out.append(" * ===========================================================================")
+    out.append(" *  Sister implementations")
+    out.append(" * ===========================================================================")
+    out.append(" */")
+    out.extend(sisters)
+
+  with open(config_path) as config:
+    for number, line in enumerate(config, 1):
+      line = line.split("#", 1)[0].strip()
+      if not line:
+        continue
+      tokens = line.split()
+      where = "%s:%d" % (config_path, number)
+      command = tokens[0]
+      if command == "handler-size":
+        handler_size = int(tokens[1])
+        if handler_size & (handler_size - 1):
+          raise DataParseError("%s: handler size must be a power of two" % where)
+      elif command == "import":
+        out.extend(read_template(tokens[1]))
+      elif command == "fallback":
+        fallback = tokens[1]
+      elif command == "op-start":
+        op_dir = tokens[1]
+      elif command == "op":
+        if tokens[1] not in opcodes:
+          raise DataParseError("%s: unknown opcode %s" % (where, tokens[1]))
+        op_dirs[tokens[1]] = tokens[2]
+      elif command == "op-end":
+        if op_dir is None:
+          raise DataParseError("%s: op-end without op-start" % where)
+        emit_handlers()
+      else:
+        raise DataParseError("%s: unknown command %s" % (where, command))
+
+  header = [
+      "/*",
+      " * This file was generated automatically by gen_mterp.py for '%s'." % arch,
+      " *",
+      " * --> DO NOT EDIT <--",
+      " */",
+      "",
+  ]
+  out_dir = os.path.join(SCRIPT_DIR, "out")
+  if not os.path.isdir(out_dir):
+    os.makedirs(out_dir)
+  with open(os.path.join(out_dir, "mterp_%s.S" % arch), "w") as f:
+    f.write("\n".join(header + out) + "\n")
+
+if __name__ == "__main__":
+  if len(sys.argv) != 2:
+    print("Usage: %s <arch>" % sys.argv[0])
+    sys.exit(2)
+  try:
+    generate(sys.argv[1])
+  except DataParseError as e:
+    print("gen_mterp.py: %s" % e)
+    sys.exit(1)
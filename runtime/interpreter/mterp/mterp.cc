@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mterp.h"
+
+#include "interpreter/interpreter_common.h"
+#include "stack.h"
+
+namespace art {
+namespace interpreter {
+
+#if defined(__i386__) || defined(__x86_64__)
+// Defined in out/mterp_<arch>.S.
+extern "C" bool ExecuteMterpImpl(Thread* self, const uint16_t* insns, ShadowFrame* shadow_frame,
+                                 JValue* result_register, uint32_t jit_enabled)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+extern "C" void artMterpAsmInstructionStart();
+extern "C" void artMterpAsmInstructionEnd();
+#endif
+
+void CheckMterpAsmConstants() {
+  CHECK(kMterpAvailable);
+#if defined(__i386__) || defined(__x86_64__)
+  uintptr_t handlers_size = reinterpret_cast<uintptr_t>(&artMterpAsmInstructionEnd) -
+      reinterpret_cast<uintptr_t>(&artMterpAsmInstructionStart);
+  // A handler overflowing its size shifts all the following ones.
+  CHECK_EQ(handlers_size, kNumPackedOpcodes * kMterpHandlerSize)
+      << "mterp handlers do not fit in " << kMterpHandlerSize << " bytes, use %break";
+#endif
+  CHECK_EQ(static_cast<size_t>(SHADOWFRAME_NUMBER_OF_VREGS_OFFSET),
+           ShadowFrame::NumberOfVRegsOffset());
+  CHECK_EQ(static_cast<size_t>(SHADOWFRAME_METHOD_OFFSET), ShadowFrame::MethodOffset());
+  CHECK_EQ(static_cast<size_t>(SHADOWFRAME_DEX_PC_OFFSET), ShadowFrame::DexPCOffset());
+  CHECK_EQ(static_cast<size_t>(SHADOWFRAME_VREGS_OFFSET), ShadowFrame::VRegsOffset());
+  CHECK_EQ(INT_ARRAY_DATA_OFFSET, mirror::Array::DataOffset(sizeof(int32_t)).Int32Value());
+  CHECK_EQ(INT_ARRAY_DATA_OFFSET, mirror::Array::DataOffset(sizeof(int8_t)).Int32Value());
+  CHECK_EQ(LONG_ARRAY_DATA_OFFSET, mirror::Array::DataOffset(sizeof(int64_t)).Int32Value());
+}
+
+bool ExecuteMterp(Thread* self, const DexFile::CodeItem* code_item, ShadowFrame& shadow_frame,
+                  JValue* result_register) {
+  DCHECK(kMterpAvailable);
+  DCHECK(shadow_frame.GetMethod()->IsPreverified());
+  DCHECK(!Runtime::Current()->GetInstrumentation()->IsActive());
+  DCHECK(!Runtime::Current()->IsActiveTransaction());
+#if defined(__i386__) || defined(__x86_64__)
+  uint32_t jit_enabled = Runtime::Current()->GetJit() != nullptr ? 1 : 0;
+  return ExecuteMterpImpl(self, code_item->insns_, &shadow_frame, result_register, jit_enabled);
+#else
+  UNUSED(self);
+  UNUSED(code_item);
+  UNUSED(result_register);
+  LOG(FATAL) << "No assembly interpreter for " << kRuntimeISA;
+  return false;
+#endif
+}
+
+// What a helper that ran code that might have enabled instrumentation returns on success.
+static MterpStatus ContinueOrSwitch() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  return UNLIKELY(Runtime::Current()->GetInstrumentation()->IsActive()) ?
+      kMterpSwitchInterpreters : kMterpContinue;
+}
+
+// Run the instruction at dex_pc_ptr like the computed-goto interpreter does for preverified code
+// outside of transactions, for the opcodes whose handler calls this. The dex pc is exported.
+extern "C" int32_t MterpExecuteInstruction(Thread* self, ShadowFrame* shadow_frame,
+                                           const uint16_t* dex_pc_ptr, JValue* result_register)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  const Instruction* inst = Instruction::At(dex_pc_ptr);
+  uint16_t inst_data = inst->Fetch16(0);
+  bool success;
+  switch (inst->Opcode(inst_data)) {
+    case Instruction::MOVE_EXCEPTION: {
+      mirror::Throwable* exception = self->GetException(nullptr);
+      shadow_frame->SetVRegReference(inst->VRegA_11x(inst_data), exception);
+      self->ClearException();
+      return kMterpContinue;
+    }
+    case Instruction::CONST_STRING:
+    case Instruction::CONST_STRING_JUMBO: {
+      StackHandleScope<1> hs(self);
+      MethodHelper mh(hs.NewHandle(shadow_frame->GetMethod()));
+      bool jumbo = inst->Opcode(inst_data) == Instruction::CONST_STRING_JUMBO;
+      mirror::String* s = ResolveString(self, mh, jumbo ? inst->VRegB_31c() : inst->VRegB_21c());
+      if (UNLIKELY(s == nullptr)) {
+        return kMterpException;
+      }
+      uint32_t vreg = jumbo ? inst->VRegA_31c(inst_data) : inst->VRegA_21c(inst_data);
+      shadow_frame->SetVRegReference(vreg, s);
+      return kMterpContinue;
+    }
+    case Instruction::CONST_CLASS: {
+      mirror::Class* c = ResolveVerifyAndClinit(inst->VRegB_21c(), shadow_frame->GetMethod(),
+                                                self, false, false);
+      if (UNLIKELY(c == nullptr)) {
+        return kMterpException;
+      }
+      shadow_frame->SetVRegReference(inst->VRegA_21c(inst_data), c);
+      return kMterpContinue;
+    }
+    case Instruction::MONITOR_ENTER:
+    case Instruction::MONITOR_EXIT: {
+      mirror::Object* obj = shadow_frame->GetVRegReference(inst->VRegA_11x(inst_data));
+      if (UNLIKELY(obj == nullptr)) {
+        ThrowNullPointerExceptionFromInterpreter(*shadow_frame);
+        return kMterpException;
+      }
+      if (inst->Opcode(inst_data) == Instruction::MONITOR_ENTER) {
+        DoMonitorEnter(self, obj);
+      } else {
+        DoMonitorExit(self, obj);
+      }
+      return self->IsExceptionPending() ? kMterpException : kMterpContinue;
+    }
+    case Instruction::CHECK_CAST: {
+      mirror::Class* c = ResolveVerifyAndClinit(inst->VRegB_21c(), shadow_frame->GetMethod(),
+                                                self, false, false);
+      if (UNLIKELY(c == nullptr)) {
+        return kMterpException;
+      }
+      mirror::Object* obj = shadow_frame->GetVRegReference(inst->VRegA_21c(inst_data));
+      if (UNLIKELY(obj != nullptr && !obj->InstanceOf(c))) {
+        ThrowClassCastException(c, obj->GetClass());
+        return kMterpException;
+      }
+      return kMterpContinue;
+    }
+    case Instruction::INSTANCE_OF: {
+      mirror::Class* c = ResolveVerifyAndClinit(inst->VRegC_22c(), shadow_frame->GetMethod(),
+                                                self, false, false);
+      if (UNLIKELY(c == nullptr)) {
+        return kMterpException;
+      }
+      mirror::Object* obj = shadow_frame->GetVRegReference(inst->VRegB_22c(inst_data));
+      shadow_frame->SetVReg(inst->VRegA_22c(inst_data),
+                            (obj != nullptr && obj->InstanceOf(c)) ? 1 : 0);
+      return kMterpContinue;
+    }
+    case Instruction::NEW_INSTANCE: {
+      mirror::Object* obj = AllocObjectFromCode<false, true>(
+          inst->VRegB_21c(), shadow_frame->GetMethod(), self,
+          Runtime::Current()->GetHeap()->GetCurrentAllocator());
+      if (UNLIKELY(obj == nullptr)) {
+        return kMterpException;
+      }
+      obj->GetClass()->AssertInitializedOrInitializingInThread(self);
+      shadow_frame->SetVRegReference(inst->VRegA_21c(inst_data), obj);
+      return kMterpContinue;
+    }
+    case Instruction::NEW_ARRAY: {
+      int32_t length = shadow_frame->GetVReg(inst->VRegB_22c(inst_data));
+      mirror::Object* obj = AllocArrayFromCode<false, true>(
+          inst->VRegC_22c(), shadow_frame->GetMethod(), length, self,
+          Runtime::Current()->GetHeap()->GetCurrentAllocator());
+      if (UNLIKELY(obj == nullptr)) {
+        return kMterpException;
+      }
+      shadow_frame->SetVRegReference(inst->VRegA_22c(inst_data), obj);
+      return kMterpContinue;
+    }
+    case Instruction::FILLED_NEW_ARRAY:
+      success = DoFilledNewArray<false, false, false>(inst, *shadow_frame, self, result_register);
+      break;
+    case Instruction::FILLED_NEW_ARRAY_RANGE:
+      success = DoFilledNewArray<true, false, false>(inst, *shadow_frame, self, result_register);
+      break;
+    case Instruction::FILL_ARRAY_DATA: {
+      mirror::Object* obj = shadow_frame->GetVRegReference(inst->VRegA_31t(inst_data));
+      if (UNLIKELY(obj == nullptr)) {
+        ThrowNullPointerException(nullptr, "null array in FILL_ARRAY_DATA");
+        return kMterpException;
+      }
+      mirror::Array* array = obj->AsArray();
+      DCHECK(array->IsArrayInstance() && !array->IsObjectArray());
+      const uint16_t* payload_addr = dex_pc_ptr + inst->VRegB_31t();
+      const Instruction::ArrayDataPayload* payload =
+          reinterpret_cast<const Instruction::ArrayDataPayload*>(payload_addr);
+      if (UNLIKELY(static_cast<int32_t>(payload->element_count) > array->GetLength())) {
+        self->ThrowNewExceptionF(shadow_frame->GetCurrentLocationForThrow(),
+                                 "Ljava/lang/ArrayIndexOutOfBoundsException;",
+                                 "failed FILL_ARRAY_DATA; length=%d, index=%d",
+                                 array->GetLength(), payload->element_count);
+        return kMterpException;
+      }
+      uint32_t size_in_bytes = payload->element_count * payload->element_width;
+      memcpy(array->GetRawData(payload->element_width, 0), payload->data, size_in_bytes);
+      return kMterpContinue;
+    }
+    case Instruction::THROW: {
+      mirror::Object* exception = shadow_frame->GetVRegReference(inst->VRegA_11x(inst_data));
+      if (UNLIKELY(exception == nullptr)) {
+        ThrowNullPointerException(nullptr, "throw with null exception");
+      } else {
+        self->SetException(shadow_frame->GetCurrentLocationForThrow(), exception->AsThrowable());
+      }
+      return kMterpException;
+    }
+    case Instruction::APUT_OBJECT: {
+      mirror::Object* a = shadow_frame->GetVRegReference(inst->VRegB_23x());
+      if (UNLIKELY(a == nullptr)) {
+        ThrowNullPointerExceptionFromInterpreter(*shadow_frame);
+        return kMterpException;
+      }
+      int32_t index = shadow_frame->GetVReg(inst->VRegC_23x());
+      mirror::Object* val = shadow_frame->GetVRegReference(inst->VRegA_23x(inst_data));
+      mirror::ObjectArray<mirror::Object>* array = a->AsObjectArray<mirror::Object>();
+      if (UNLIKELY(!array->CheckIsValidIndex(index) || !array->CheckAssignable(val))) {
+        return kMterpException;
+      }
+      array->SetWithoutChecks<false>(index, val);
+      return kMterpContinue;
+    }
+
+#define MTERP_FIELD_GET(_opcode, _find_type, _field_type)                                  \
+    case Instruction::_opcode:                                                             \
+      success = DoFieldGet<_find_type, _field_type, false>(self, *shadow_frame, inst,      \
+                                                           inst_data);                     \
+      break;
+#define MTERP_FIELD_PUT(_opcode, _find_type, _field_type)                                  \
+    case Instruction::_opcode:                                                             \
+      success = DoFieldPut<_find_type, _field_type, false, false>(self, *shadow_frame,     \
+                                                                  inst, inst_data);        \
+      break;
+    MTERP_FIELD_GET(IGET, InstancePrimitiveRead, Primitive::kPrimInt)
+    MTERP_FIELD_GET(IGET_WIDE, InstancePrimitiveRead, Primitive::kPrimLong)
+    MTERP_FIELD_GET(IGET_OBJECT, InstanceObjectRead, Primitive::kPrimNot)
+    MTERP_FIELD_GET(IGET_BOOLEAN, InstancePrimitiveRead, Primitive::kPrimBoolean)
+    MTERP_FIELD_GET(IGET_BYTE, InstancePrimitiveRead, Primitive::kPrimByte)
+    MTERP_FIELD_GET(IGET_CHAR, InstancePrimitiveRead, Primitive::kPrimChar)
+    MTERP_FIELD_GET(IGET_SHORT, InstancePrimitiveRead, Primitive::kPrimShort)
+    MTERP_FIELD_GET(SGET, StaticPrimitiveRead, Primitive::kPrimInt)
+    MTERP_FIELD_GET(SGET_WIDE, StaticPrimitiveRead, Primitive::kPrimLong)
+    MTERP_FIELD_GET(SGET_OBJECT, StaticObjectRead, Primitive::kPrimNot)
+    MTERP_FIELD_GET(SGET_BOOLEAN, StaticPrimitiveRead, Primitive::kPrimBoolean)
+    MTERP_FIELD_GET(SGET_BYTE, StaticPrimitiveRead, Primitive::kPrimByte)
+    MTERP_FIELD_GET(SGET_CHAR, StaticPrimitiveRead, Primitive::kPrimChar)
+    MTERP_FIELD_GET(SGET_SHORT, StaticPrimitiveRead, Primitive::kPrimShort)
+    MTERP_FIELD_PUT(IPUT, InstancePrimitiveWrite, Primitive::kPrimInt)
+    MTERP_FIELD_PUT(IPUT_WIDE, InstancePrimitiveWrite, Primitive::kPrimLong)
+    MTERP_FIELD_PUT(IPUT_OBJECT, InstanceObjectWrite, Primitive::kPrimNot)
+    MTERP_FIELD_PUT(IPUT_BOOLEAN, InstancePrimitiveWrite, Primitive::kPrimBoolean)
+    MTERP_FIELD_PUT(IPUT_BYTE, InstancePrimitiveWrite, Primitive::kPrimByte)
+    MTERP_FIELD_PUT(IPUT_CHAR, InstancePrimitiveWrite, Primitive::kPrimChar)
+    MTERP_FIELD_PUT(IPUT_SHORT, InstancePrimitiveWrite, Primitive::kPrimShort)
+    MTERP_FIELD_PUT(SPUT, StaticPrimitiveWrite, Primitive::kPrimInt)
+    MTERP_FIELD_PUT(SPUT_WIDE, StaticPrimitiveWrite, Primitive::kPrimLong)
+    MTERP_FIELD_PUT(SPUT_OBJECT, StaticObjectWrite, Primitive::kPrimNot)
+    MTERP_FIELD_PUT(SPUT_BOOLEAN, StaticPrimitiveWrite, Primitive::kPrimBoolean)
+    MTERP_FIELD_PUT(SPUT_BYTE, StaticPrimitiveWrite, Primitive::kPrimByte)
+    MTERP_FIELD_PUT(SPUT_CHAR, StaticPrimitiveWrite, Primitive::kPrimChar)
+    MTERP_FIELD_PUT(SPUT_SHORT, StaticPrimitiveWrite, Primitive::kPrimShort)
+#undef MTERP_FIELD_GET
+#undef MTERP_FIELD_PUT
+
+    case Instruction::IPUT_OBJECT_QUICK:
+      success = DoIPutQuick<Primitive::kPrimNot, false>(*shadow_frame, inst, inst_data);
+      break;
+
+    // Invokes may run code that enables instrumentation.
+#define MTERP_INVOKE(_opcode, _type, _is_range)                                               \
+    case Instruction::_opcode:                                                                \
+      if (!DoInvoke<_type, _is_range, false>(self, *shadow_frame, inst, inst_data,            \
+                                             result_register)) {                              \
+        return kMterpException;                                                               \
+      }                                                                                       \
+      return ContinueOrSwitch();
+    MTERP_INVOKE(INVOKE_VIRTUAL, kVirtual, false)
+    MTERP_INVOKE(INVOKE_VIRTUAL_RANGE, kVirtual, true)
+    MTERP_INVOKE(INVOKE_SUPER, kSuper, false)
+    MTERP_INVOKE(INVOKE_SUPER_RANGE, kSuper, true)
+    MTERP_INVOKE(INVOKE_DIRECT, kDirect, false)
+    MTERP_INVOKE(INVOKE_DIRECT_RANGE, kDirect, true)
+    MTERP_INVOKE(INVOKE_STATIC, kStatic, false)
+    MTERP_INVOKE(INVOKE_STATIC_RANGE, kStatic, true)
+    MTERP_INVOKE(INVOKE_INTERFACE, kInterface, false)
+    MTERP_INVOKE(INVOKE_INTERFACE_RANGE, kInterface, true)
+#undef MTERP_INVOKE
+    case Instruction::INVOKE_VIRTUAL_QUICK:
+      if (!DoInvokeVirtualQuick<false>(self, *shadow_frame, inst, inst_data, result_register)) {
+        return kMterpException;
+      }
+      return ContinueOrSwitch();
+    case Instruction::INVOKE_VIRTUAL_RANGE_QUICK:
+      if (!DoInvokeVirtualQuick<true>(self, *shadow_frame, inst, inst_data, result_register)) {
+        return kMterpException;
+      }
+      return ContinueOrSwitch();
+
+    default:
+      LOG(FATAL) << "No mterp helper for " << inst->DumpString(nullptr);
+      return kMterpException;
+  }
+  // Class initializers run by field accesses may have enabled instrumentation too.
+  return success ? ContinueOrSwitch() : kMterpException;
+}
+
+// Branch offsets of the switch instructions at dex_pc_ptr.
+extern "C" int32_t MterpDoPackedSwitch(ShadowFrame* shadow_frame, const uint16_t* dex_pc_ptr)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  const Instruction* inst = Instruction::At(dex_pc_ptr);
+  return DoPackedSwitch(inst, *shadow_frame, inst->Fetch16(0));
+}
+
+extern "C" int32_t MterpDoSparseSwitch(ShadowFrame* shadow_frame, const uint16_t* dex_pc_ptr)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  const Instruction* inst = Instruction::At(dex_pc_ptr);
+  return DoSparseSwitch(inst, *shadow_frame, inst->Fetch16(0));
+}
+
+// A backward branch by offset from the exported dex pc is taken while the thread flags are set
+// or the JIT is enabled. Returns kMterpReturned if the method was finished in compiled code.
+extern "C" int32_t MterpBackwardBranch(Thread* self, ShadowFrame* shadow_frame, int32_t offset,
+                                       JValue* result_register)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  uint32_t target_dex_pc = static_cast<uint32_t>(static_cast<int32_t>(shadow_frame->GetDexPC()) +
+                                                 offset);
+  JValue osr_result;
+  if (UNLIKELY(AddJitBackwardBranchSample(self, *shadow_frame, target_dex_pc, &osr_result))) {
+    *result_register = osr_result;
+    return kMterpReturned;
+  }
+  if (UNLIKELY(self->TestAllFlags())) {
+    CheckSuspend(self);
+  }
+  return ContinueOrSwitch();
+}
+
+// A return found the thread flags set.
+extern "C" int32_t MterpSuspendCheck(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  CheckSuspend(self);
+  return ContinueOrSwitch();
+}
+
+// Find the catch handler of the pending exception, thrown at the exported dex pc. Returns
+// kMterpException if the method has none, otherwise continues at the handler, whose dex pc is
+// stored to the shadow frame.
+extern "C" int32_t MterpHandleException(Thread* self, ShadowFrame* shadow_frame)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  DCHECK(self->IsExceptionPending());
+  if (UNLIKELY(self->TestAllFlags())) {
+    CheckSuspend(self);
+  }
+  const instrumentation::Instrumentation* instrumentation =
+      Runtime::Current()->GetInstrumentation();
+  uint32_t found_dex_pc = FindNextInstructionFollowingException(self, *shadow_frame,
+                                                                shadow_frame->GetDexPC(),
+                                                                instrumentation);
+  if (found_dex_pc == DexFile::kDexNoIndex) {
+    return kMterpException;
+  }
+  shadow_frame->SetDexPC(found_dex_pc);
+  return ContinueOrSwitch();
+}
+
+extern "C" void MterpThrowDivideByZero() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  ThrowArithmeticExceptionDivideByZero();
+}
+
+extern "C" void MterpThrowArrayBounds(int32_t index, int32_t length)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  ThrowArrayIndexOutOfBoundsException(index, length);
+}
+
+extern "C" void MterpThrowNullPointer(ShadowFrame* shadow_frame)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  ThrowNullPointerExceptionFromInterpreter(*shadow_frame);
+}
+
+}  // namespace interpreter
+}  // namespace art
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_INTERPRETER_MTERP_MTERP_H_
+#define ART_RUNTIME_INTERPRETER_MTERP_MTERP_H_
+
+#include "asm_support.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "dex_file.h"
+#include "globals.h"
+
+namespace art {
+
+union JValue;
+class ShadowFrame;
+class Thread;
+
+namespace interpreter {
+
+// The assembly interpreter ("mterp") is generated by gen_mterp.py from the templates of each
+// architecture into out/mterp_<arch>.S, regenerate it after changing them. It runs the common
+// opcodes in hand-written handlers and the rarer ones through MterpExecuteInstruction, and leaves
+// the rest of the method to the C++ interpreter whenever it meets an opcode it has no handler for
+// or instrumentation gets enabled.
+//
+// The handlers do not report instrumentation events, run transactions or do access checks, so
+// mterp is only entered for preverified methods while instrumentation is inactive and no
+// transaction is active. Handlers read references straight from the shadow frame, which rules
+// out read barriers.
+#if defined(__i386__) || defined(__x86_64__)
+static constexpr bool kMterpAvailable = !kUseBakerOrBrooksReadBarrier;
+#else
+static constexpr bool kMterpAvailable = false;
+#endif
+
+// Size of the handler of each opcode, the handler of an opcode is at
+// artMterpAsmInstructionStart + opcode * kMterpHandlerSize.
+static constexpr size_t kMterpHandlerSize = 128;
+
+// What the helpers called by the handlers tell them to do next.
+enum MterpStatus {
+  kMterpException = 0,           // An exception is pending at the exported dex pc.
+  kMterpContinue = 1,            // Go on to the next instruction.
+  kMterpSwitchInterpreters = 2,  // Let the C++ interpreter run the next instruction.
+  kMterpReturned = 3,            // The method finished, its result is in the result register.
+};
+COMPILE_ASSERT(kMterpException == MTERP_STATUS_EXCEPTION, mterp_status_exception_mismatch);
+COMPILE_ASSERT(kMterpContinue == MTERP_STATUS_CONTINUE, mterp_status_continue_mismatch);
+COMPILE_ASSERT(kMterpSwitchInterpreters == MTERP_STATUS_SWITCH_INTERPRETERS,
+               mterp_status_switch_interpreters_mismatch);
+COMPILE_ASSERT(kMterpReturned == MTERP_STATUS_RETURNED, mterp_status_returned_mismatch);
+
+// Check the offsets the handlers use and that every handler fits in kMterpHandlerSize. Aborts on
+// a mismatch.
+void CheckMterpAsmConstants();
+
+// Interpret code_item from the dex pc of shadow_frame. Returns true if the method returned, with
+// its result in result_register, or let an exception escape. Returns false if the C++ interpreter
+// has to go on from the dex pc of shadow_frame.
+bool ExecuteMterp(Thread* self, const DexFile::CodeItem* code_item, ShadowFrame& shadow_frame,
+                  JValue* result_register)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+}  // namespace interpreter
+}  // namespace art
+
+#endif  // ART_RUNTIME_INTERPRETER_MTERP_MTERP_H_
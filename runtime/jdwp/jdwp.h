@@ -22,11 +22,13 @@
 #include "jdwp/jdwp_bits.h"
 #include "jdwp/jdwp_constants.h"
 #include "jdwp/jdwp_expand_buf.h"
+#include "safe_map.h"
 
 #include <pthread.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <vector>
 
 struct iovec;
 
@@ -321,6 +323,10 @@ struct JdwpState {
   void UnregisterEvent(JdwpEvent* pEvent)
       EXCLUSIVE_LOCKS_REQUIRED(event_list_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  bool HasEventsOfKind(JdwpEventKind eventKind) const
+      EXCLUSIVE_LOCKS_REQUIRED(event_list_lock_);
+  bool HasLocationEventsFor(int eventFlags) const
+      EXCLUSIVE_LOCKS_REQUIRED(event_list_lock_);
   void SendBufferedRequest(uint32_t type, const std::vector<iovec>& iov);
 
   void StartProcessingRequest() LOCKS_EXCLUDED(process_request_lock_);
@@ -364,6 +370,15 @@ struct JdwpState {
 
   JdwpEvent* event_list_ GUARDED_BY(event_list_lock_);
   size_t event_list_size_ GUARDED_BY(event_list_lock_);  // Number of elements in event_list_.
+  // The events of event_list_ by kind, in registration order, so that matching an event only
+  // looks at the events of its kind. Kinds without events have no entry.
+  SafeMap<JdwpEventKind, std::vector<JdwpEvent*>> events_by_kind_ GUARDED_BY(event_list_lock_);
+  // The breakpoint events with a location modifier, by the method id and dex pc of their first
+  // one, in registration order. A breakpoint hit only looks at the events of its location, unless
+  // there are breakpoint events without a location, which can match any location.
+  SafeMap<std::pair<MethodId, uint64_t>, std::vector<JdwpEvent*>> breakpoints_by_location_
+      GUARDED_BY(event_list_lock_);
+  size_t breakpoints_without_location_ GUARDED_BY(event_list_lock_);
 
   // Used to synchronize suspension of the event thread (to avoid receiving "resume"
   // events before the thread has finished suspending itself).
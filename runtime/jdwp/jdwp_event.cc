@@ -21,6 +21,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/stringprintf.h"
 #include "debugger.h"
@@ -160,6 +162,18 @@ uint32_t GetInstrumentationEventFor(JdwpEventKind eventKind) {
   }
 }
 
+/*
+ * Returns the first location modifier of a breakpoint event, or nullptr if it has none.
+ */
+static const JdwpLocation* GetBreakpointLocation(const JdwpEvent* pEvent) {
+  for (int i = 0; i < pEvent->modCount; i++) {
+    if (pEvent->mods[i].modKind == MK_LOCATION_ONLY) {
+      return &pEvent->mods[i].locationOnly.loc;
+    }
+  }
+  return nullptr;
+}
+
 /*
  * Add an event to the list.  Ordering is not important.
  *
@@ -219,6 +233,24 @@ JdwpError JdwpState::RegisterEvent(JdwpEvent* pEvent) {
     }
     event_list_ = pEvent;
     ++event_list_size_;
+    auto it = events_by_kind_.find(pEvent->eventKind);
+    if (it == events_by_kind_.end()) {
+      it = events_by_kind_.Put(pEvent->eventKind, std::vector<JdwpEvent*>());
+    }
+    it->second.push_back(pEvent);
+    if (pEvent->eventKind == EK_BREAKPOINT) {
+      const JdwpLocation* location = GetBreakpointLocation(pEvent);
+      if (location == nullptr) {
+        ++breakpoints_without_location_;
+      } else {
+        auto key = std::make_pair(location->method_id, location->dex_pc);
+        auto location_it = breakpoints_by_location_.find(key);
+        if (location_it == breakpoints_by_location_.end()) {
+          location_it = breakpoints_by_location_.Put(key, std::vector<JdwpEvent*>());
+        }
+        location_it->second.push_back(pEvent);
+      }
+    }
   }
 
   Dbg::ManageDeoptimization();
@@ -250,6 +282,34 @@ void JdwpState::UnregisterEvent(JdwpEvent* pEvent) {
   }
   pEvent->prev = NULL;
 
+  auto it = events_by_kind_.find(pEvent->eventKind);
+  CHECK(it != events_by_kind_.end());
+  std::vector<JdwpEvent*>& events = it->second;
+  auto event_it = std::find(events.begin(), events.end(), pEvent);
+  CHECK(event_it != events.end());
+  events.erase(event_it);
+  if (events.empty()) {
+    events_by_kind_.erase(it);
+  }
+  if (pEvent->eventKind == EK_BREAKPOINT) {
+    const JdwpLocation* location = GetBreakpointLocation(pEvent);
+    if (location == nullptr) {
+      CHECK_NE(breakpoints_without_location_, 0U);
+      --breakpoints_without_location_;
+    } else {
+      auto location_it =
+          breakpoints_by_location_.find(std::make_pair(location->method_id, location->dex_pc));
+      CHECK(location_it != breakpoints_by_location_.end());
+      std::vector<JdwpEvent*>& location_events = location_it->second;
+      auto location_event_it = std::find(location_events.begin(), location_events.end(), pEvent);
+      CHECK(location_event_it != location_events.end());
+      location_events.erase(location_event_it);
+      if (location_events.empty()) {
+        breakpoints_by_location_.erase(location_it);
+      }
+    }
+  }
+
   {
     /*
      * Unhook us from the interpreter, if necessary.
@@ -340,6 +400,9 @@ void JdwpState::UnregisterAll() {
   }
 
   event_list_ = NULL;
+  CHECK(events_by_kind_.empty());
+  CHECK(breakpoints_by_location_.empty());
+  CHECK_EQ(breakpoints_without_location_, 0U);
 }
 
 /*
@@ -535,17 +598,63 @@ static bool ModsMatch(JdwpEvent* pEvent, const ModBasket& basket)
  */
 void JdwpState::FindMatchingEvents(JdwpEventKind eventKind, const ModBasket& basket,
                                    JdwpEvent** match_list, size_t* pMatchCount) {
+  auto it = events_by_kind_.find(eventKind);
+  if (it == events_by_kind_.end()) {
+    return;
+  }
+
   /* start after the existing entries */
   match_list += *pMatchCount;
 
-  for (JdwpEvent* pEvent = event_list_; pEvent != nullptr; pEvent = pEvent->next) {
-    if (pEvent->eventKind == eventKind && ModsMatch(pEvent, basket)) {
+  const std::vector<JdwpEvent*>* candidates = &it->second;
+  if (eventKind == EK_BREAKPOINT && basket.pLoc != nullptr && breakpoints_without_location_ == 0) {
+    // Only the breakpoint events at the location can match.
+    auto location_it = breakpoints_by_location_.find(
+        std::make_pair(Dbg::GetMethodId(basket.pLoc->method),
+                       static_cast<uint64_t>(basket.pLoc->dex_pc)));
+    if (location_it == breakpoints_by_location_.end()) {
+      return;
+    }
+    candidates = &location_it->second;
+  }
+
+  /* most recently registered first, as they are in event_list_ */
+  const std::vector<JdwpEvent*>& events = *candidates;
+  for (auto event_it = events.rbegin(); event_it != events.rend(); ++event_it) {
+    JdwpEvent* pEvent = *event_it;
+    DCHECK_EQ(pEvent->eventKind, eventKind);
+    if (ModsMatch(pEvent, basket)) {
       *match_list++ = pEvent;
       (*pMatchCount)++;
     }
   }
 }
 
+bool JdwpState::HasEventsOfKind(JdwpEventKind eventKind) const {
+  return events_by_kind_.find(eventKind) != events_by_kind_.end();
+}
+
+/*
+ * Returns whether any event could match a location event with the given
+ * "eventFlags".
+ */
+bool JdwpState::HasLocationEventsFor(int eventFlags) const {
+  if ((eventFlags & Dbg::kBreakpoint) != 0 && HasEventsOfKind(EK_BREAKPOINT)) {
+    return true;
+  }
+  if ((eventFlags & Dbg::kSingleStep) != 0 && HasEventsOfKind(EK_SINGLE_STEP)) {
+    return true;
+  }
+  if ((eventFlags & Dbg::kMethodEntry) != 0 && HasEventsOfKind(EK_METHOD_ENTRY)) {
+    return true;
+  }
+  if ((eventFlags & Dbg::kMethodExit) != 0 &&
+      (HasEventsOfKind(EK_METHOD_EXIT) || HasEventsOfKind(EK_METHOD_EXIT_WITH_RETURN_VALUE))) {
+    return true;
+  }
+  return false;
+}
+
 /*
  * Scan through the list of matches and determine the most severe
  * suspension policy.
@@ -825,6 +934,17 @@ bool JdwpState::PostLocationEvent(const EventLocation* pLoc, mirror::Object* thi
   DCHECK(pLoc->method != nullptr);
   DCHECK_EQ(pLoc->method->IsStatic(), thisPtr == nullptr);
 
+  /*
+   * Most locations reported while a debugger is attached are of no interest
+   * to any event, don't build the basket (and its class name) for them.
+   */
+  {
+    MutexLock mu(Thread::Current(), event_list_lock_);
+    if (!HasLocationEventsFor(eventFlags)) {
+      return false;
+    }
+  }
+
   ModBasket basket;
   basket.pLoc = pLoc;
   basket.locationClass = pLoc->method->GetDeclaringClass();
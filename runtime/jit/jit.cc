@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit.h"
+
+#include <dlfcn.h>
+#include <string.h>
+
+#include "asm_support.h"
+#include "base/stringprintf.h"
+#include "instrumentation.h"
+#include "interpreter/interpreter.h"
+#include "jvalue.h"
+#include "mapping_table.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "stack.h"
+#include "thread-inl.h"
+#include "thread_pool.h"
+#include "utils.h"
+#include "vmap_table.h"
+
+#if defined(__arm__)
+#include "arch/arm/registers_arm.h"
+#elif defined(__i386__)
+#include "arch/x86/registers_x86.h"
+#endif
+
+namespace art {
+namespace jit {
+
+#if defined(__arm__) || defined(__i386__)
+#define ART_JIT_SUPPORTS_OSR 1
+
+// What art_quick_osr_stub loads into registers before it enters compiled code. Registers are
+// indexed by their number, only the callee saves a method can promote Dalvik registers to are
+// read.
+struct OsrEntryState {
+  const void* native_pc;
+  uint32_t frame_size;
+  Thread* self;
+  // The offset in the frame of the spill slot of the register the stub keeps its stack pointer
+  // in, or 0 if the method doesn't spill that register.
+  uint32_t sp_spill_offset;
+  const char* shorty;
+  uint32_t core_registers[16];
+  uint32_t fp_registers[32];
+};
+
+COMPILE_ASSERT(offsetof(OsrEntryState, native_pc) == OSR_ENTRY_NATIVE_PC_OFFSET,
+               osr_entry_native_pc_offset_mismatch);
+COMPILE_ASSERT(offsetof(OsrEntryState, frame_size) == OSR_ENTRY_FRAME_SIZE_OFFSET,
+               osr_entry_frame_size_offset_mismatch);
+COMPILE_ASSERT(offsetof(OsrEntryState, self) == OSR_ENTRY_SELF_OFFSET,
+               osr_entry_self_offset_mismatch);
+COMPILE_ASSERT(offsetof(OsrEntryState, sp_spill_offset) == OSR_ENTRY_SP_SPILL_OFFSET,
+               osr_entry_sp_spill_offset_mismatch);
+COMPILE_ASSERT(offsetof(OsrEntryState, shorty) == OSR_ENTRY_SHORTY_OFFSET,
+               osr_entry_shorty_offset_mismatch);
+COMPILE_ASSERT(offsetof(OsrEntryState, core_registers) == OSR_ENTRY_CORE_REGISTERS_OFFSET,
+               osr_entry_core_registers_offset_mismatch);
+COMPILE_ASSERT(offsetof(OsrEntryState, fp_registers) == OSR_ENTRY_FP_REGISTERS_OFFSET,
+               osr_entry_fp_registers_offset_mismatch);
+
+// Copies the frame image onto the stack below its own frame, loads the registers of state and
+// jumps to state->native_pc. The compiled method returns into the stub, which stores the return
+// value in result.
+extern "C" void art_quick_osr_stub(const uint8_t* frame_image, size_t frame_image_size,
+                                   const OsrEntryState* state, JValue* result);
+
+// The callee save the stub keeps its stack pointer in across the compiled code.
+#if defined(__arm__)
+static constexpr uint32_t kOsrStubSpRegister = arm::R11;
+#else
+static constexpr uint32_t kOsrStubSpRegister = x86::EBP;
+#endif
+#endif  // __arm__ || __i386__
+
+// Compiles a single hot method on the JIT thread. Methods are neither moved nor unloaded, so
+// holding the raw ArtMethod* until the task runs is safe.
+class JitCompileTask FINAL : public Task {
+ public:
+  JitCompileTask(Jit* jit, mirror::ArtMethod* method) : jit_(jit), method_(method) {
+  }
+
+  void Run(Thread* self) OVERRIDE {
+    ScopedObjectAccess soa(self);
+    jit_->CompileMethod(self, method_);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  Jit* const jit_;
+  mirror::ArtMethod* const method_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitCompileTask);
+};
+
+Jit* Jit::Create(size_t code_cache_capacity, size_t compile_threshold, std::string* error_msg) {
+  CHECK_GT(compile_threshold, 0U);
+  CHECK_LE(compile_threshold, kMaxCompileThreshold);
+  JitCodeCache* code_cache = JitCodeCache::Create(code_cache_capacity, error_msg);
+  if (code_cache == nullptr) {
+    return nullptr;
+  }
+  std::unique_ptr<Jit> jit(new Jit(code_cache, compile_threshold));
+  if (!jit->LoadCompiler(error_msg)) {
+    return nullptr;
+  }
+  return jit.release();
+}
+
+Jit::Jit(JitCodeCache* code_cache, size_t compile_threshold)
+    : jit_library_handle_(nullptr), jit_compiler_handle_(nullptr), jit_load_(nullptr),
+      jit_unload_(nullptr), jit_compile_method_(nullptr), code_cache_(code_cache),
+      compile_threshold_(static_cast<uint16_t>(compile_threshold)),
+      hotness_counters_(new Atomic<uint16_t>[kHotnessTableSize]),
+      lock_("JIT queued methods lock") {
+}
+
+Jit::~Jit() {
+  DeleteThreadPool();
+  if (jit_compiler_handle_ != nullptr) {
+    jit_unload_(jit_compiler_handle_);
+  }
+  if (jit_library_handle_ != nullptr) {
+    dlclose(jit_library_handle_);
+  }
+}
+
+bool Jit::LoadCompiler(std::string* error_msg) {
+  const char* compiler_library = kIsDebugBuild ? "libartd-compiler.so" : "libart-compiler.so";
+  jit_library_handle_ = dlopen(compiler_library, RTLD_NOW);
+  if (jit_library_handle_ == nullptr) {
+    *error_msg = StringPrintf("JIT could not load %s: %s", compiler_library, dlerror());
+    return false;
+  }
+  jit_load_ = reinterpret_cast<void* (*)()>(dlsym(jit_library_handle_, "jit_load"));
+  jit_unload_ = reinterpret_cast<void (*)(void*)>(dlsym(jit_library_handle_, "jit_unload"));
+  jit_compile_method_ = reinterpret_cast<bool (*)(void*, mirror::ArtMethod*, Thread*)>(
+      dlsym(jit_library_handle_, "jit_compile_method"));
+  if (jit_load_ == nullptr || jit_unload_ == nullptr || jit_compile_method_ == nullptr) {
+    *error_msg = StringPrintf("JIT could not find the entry points of %s", compiler_library);
+    return false;
+  }
+  jit_compiler_handle_ = jit_load_();
+  if (jit_compiler_handle_ == nullptr) {
+    *error_msg = "JIT could not create the compiler";
+    return false;
+  }
+  return true;
+}
+
+void Jit::CreateThreadPool() {
+  CHECK(thread_pool_.get() == nullptr);
+  Thread* self = Thread::Current();
+  // A single thread keeps compilation from competing with the application for more than a core.
+  thread_pool_.reset(new ThreadPool("Jit thread pool", 1));
+  thread_pool_->StartWorkers(self);
+}
+
+void Jit::DeleteThreadPool() {
+  if (thread_pool_.get() != nullptr) {
+    // Waits for the compilation in progress, tasks still queued are dropped.
+    thread_pool_->StopWorkers(Thread::Current());
+    thread_pool_.reset();
+  }
+}
+
+void Jit::MethodHot(Thread* self, mirror::ArtMethod* method) {
+  if (thread_pool_.get() == nullptr) {
+    return;
+  }
+  if (method->IsNative() || method->IsAbstract() || method->IsProxyMethod() ||
+      method->IsClassInitializer() || !method->IsPreverified()) {
+    // Methods not verified ahead of execution keep running with access checks.
+    return;
+  }
+  if (method->IsStatic() && !method->GetDeclaringClass()->IsInitialized()) {
+    // Keep the resolution trampoline that runs the class initializer, the method is queued once
+    // it gets hot again after initialization.
+    return;
+  }
+  if (Runtime::Current()->GetInstrumentation()->InterpretOnly()) {
+    // Running with -Xint or under a debugger that forces interpretation.
+    return;
+  }
+  {
+    MutexLock mu(self, lock_);
+    if (!queued_methods_.insert(method).second) {
+      return;
+    }
+  }
+  VLOG(jit) << "Queueing hot method " << PrettyMethod(method) << " for compilation";
+  thread_pool_->AddTask(self, new JitCompileTask(this, method));
+}
+
+bool Jit::AddBackwardBranchSample(Thread* self, ShadowFrame* shadow_frame, uint32_t dex_pc,
+                                  JValue* result) {
+  mirror::ArtMethod* method = shadow_frame->GetMethod();
+  if (LIKELY(!CountSamples(method, 1))) {
+    return false;
+  }
+  const void* code = code_cache_->GetCodeFor(self, method);
+  if (code == nullptr) {
+    MethodHot(self, method);
+    return false;
+  }
+  return OnStackReplace(self, shadow_frame, code, dex_pc, result);
+}
+
+bool Jit::OnStackReplace(Thread* self, ShadowFrame* shadow_frame, const void* code,
+                         uint32_t dex_pc, JValue* result) {
+#if defined(ART_JIT_SUPPORTS_OSR)
+  mirror::ArtMethod* method = shadow_frame->GetMethod();
+  if (method->GetEntryPointFromQuickCompiledCode() != code) {
+    // Not installed yet, or hidden behind instrumentation stubs.
+    return false;
+  }
+  // Pairs with the fence in JitCompiler::AddToCodeCache, the gc map was set before the code.
+  QuasiAtomic::ThreadFenceAcquire();
+  if (Runtime::Current()->GetInstrumentation()->IsActive() || method->IsSynchronized()) {
+    // Listeners expect the interpreter's events until the method returns. The monitor of a
+    // synchronized method belongs to the interpreter's caller.
+    return false;
+  }
+  const void* code_pointer = mirror::ArtMethod::EntryPointToCodePointer(code);
+  MappingTable mapping_table(method->GetMappingTable(code_pointer));
+  uintptr_t native_pc = 0;
+  // Only exported pcs are entry points, the pc-to-dex entries are in the middle of blocks.
+  for (auto it = mapping_table.DexToPcBegin(), end = mapping_table.DexToPcEnd(); it != end; ++it) {
+    if (it.DexPc() == dex_pc) {
+      native_pc = reinterpret_cast<uintptr_t>(code) + it.NativePcOffset();
+      break;
+    }
+  }
+  if (native_pc == 0) {
+    return false;
+  }
+  const DexFile::CodeItem* code_item = method->GetCodeItem();
+  QuickMethodFrameInfo frame_info = method->GetQuickFrameInfo(code_pointer);
+  size_t frame_size = frame_info.FrameSizeInBytes();
+  uint32_t core_spills = frame_info.CoreSpillMask();
+  uint32_t fp_spills = frame_info.FpSpillMask();
+  // The image holds the compiled frame, then the null ArtMethod* that ends stack walks and the
+  // ins, which compiled code keeps in its caller's out area.
+  size_t image_size = RoundUp(frame_size + sizeof(StackReference<mirror::ArtMethod>) +
+                              code_item->ins_size_ * sizeof(uint32_t), kStackAlignment);
+  // The image is built on this stack and the stub copies it below, leave room for both.
+  if (UNLIKELY(reinterpret_cast<byte*>(__builtin_frame_address(0)) - 2 * image_size <
+               self->GetStackEnd())) {
+    return false;
+  }
+  uint8_t* frame_image = reinterpret_cast<uint8_t*>(alloca(image_size));
+  memset(frame_image, 0, image_size);
+  reinterpret_cast<StackReference<mirror::ArtMethod>*>(frame_image)->Assign(method);
+  OsrEntryState state;
+  memset(&state, 0, sizeof(state));
+
+  // Deoptimization in reverse. Quick keeps no values in temps across blocks, so at a loop header
+  // each Dalvik register is in its frame slot or in the callee save it is promoted to. A register
+  // promoted to both a core and a float register is written to both, whichever one the code
+  // reads has the right bits.
+  VmapTable vmap_table(method->GetVmapTable(code_pointer));
+  uint32_t vmap_offset;
+  for (uint16_t reg = 0; reg < code_item->registers_size_; ++reg) {
+    uint32_t value = shadow_frame->GetVReg(reg);
+    int offset = StackVisitor::GetVRegOffset(code_item, core_spills, fp_spills, frame_size, reg,
+                                             kRuntimeISA);
+    DCHECK_LE(offset + sizeof(uint32_t), image_size);
+    *reinterpret_cast<uint32_t*>(&frame_image[offset]) = value;
+    if (vmap_table.IsInContext(reg, kIntVReg, &vmap_offset)) {
+      uint32_t core_reg = vmap_table.ComputeRegister(core_spills, vmap_offset, kIntVReg);
+      DCHECK_LT(core_reg, arraysize(state.core_registers));
+      state.core_registers[core_reg] = value;
+    }
+    if (vmap_table.IsInContext(reg, kFloatVReg, &vmap_offset)) {
+      uint32_t fp_reg = vmap_table.ComputeRegister(fp_spills, vmap_offset, kFloatVReg);
+      DCHECK_LT(fp_reg, arraysize(state.fp_registers));
+      state.fp_registers[fp_reg] = value;
+    }
+  }
+  // The method pointer is the special temp following the Dalvik registers and may be promoted.
+  if (vmap_table.IsInContext(code_item->registers_size_, kReferenceVReg, &vmap_offset)) {
+    uint32_t core_reg = vmap_table.ComputeRegister(core_spills, vmap_offset, kReferenceVReg);
+    DCHECK_LT(core_reg, arraysize(state.core_registers));
+    state.core_registers[core_reg] = reinterpret_cast<uintptr_t>(method);
+  }
+  if ((core_spills & (1u << kOsrStubSpRegister)) != 0) {
+    // Core spills are stored from the top of the frame down, highest register first.
+    state.sp_spill_offset = frame_size - POPCOUNT(core_spills >> kOsrStubSpRegister) * kPointerSize;
+  }
+  state.native_pc = reinterpret_cast<const void*>(native_pc);
+  state.frame_size = frame_size;
+  state.self = self;
+  state.shorty = method->GetShorty();
+  VLOG(jit) << "On-stack replacement of " << PrettyMethod(method) << " at dex pc 0x" << std::hex
+            << dex_pc;
+  osr_entries_.FetchAndAddSequentiallyConsistent(1);
+
+  // The compiled frame takes the place of the interpreter's, which is pushed back for the
+  // interpreter's caller to pop.
+  ShadowFrame* top_shadow_frame = self->PopShadowFrame();
+  DCHECK_EQ(top_shadow_frame, shadow_frame);
+  ManagedStack fragment;
+  self->PushManagedStackFragment(&fragment);
+  art_quick_osr_stub(frame_image, image_size, &state, result);
+  if (UNLIKELY(self->GetException(nullptr) == Thread::GetDeoptimizationException())) {
+    // As in ArtMethod::Invoke, the compiled frame was deoptimized and continues in the
+    // interpreter.
+    self->ClearException();
+    ShadowFrame* deoptimized_frame = self->GetAndClearDeoptimizationShadowFrame(result);
+    self->SetTopOfStack(nullptr, 0);
+    self->SetTopOfShadowStack(deoptimized_frame);
+    interpreter::EnterInterpreterFromDeoptimize(self, deoptimized_frame, result);
+  }
+  self->PopManagedStackFragment(fragment);
+  self->PushShadowFrame(shadow_frame);
+  return true;
+#else
+  UNUSED(self);
+  UNUSED(shadow_frame);
+  UNUSED(code);
+  UNUSED(dex_pc);
+  UNUSED(result);
+  return false;
+#endif  // ART_JIT_SUPPORTS_OSR
+}
+
+bool Jit::CompileMethod(Thread* self, mirror::ArtMethod* method) {
+  uint64_t start_ns = NanoTime();
+  bool success = jit_compile_method_(jit_compiler_handle_, method, self);
+  uint64_t duration_ns = NanoTime() - start_ns;
+  compile_time_ns_.FetchAndAddSequentiallyConsistent(duration_ns);
+  if (success) {
+    methods_compiled_.FetchAndAddSequentiallyConsistent(1);
+  } else {
+    methods_failed_.FetchAndAddSequentiallyConsistent(1);
+  }
+  VLOG(jit) << (success ? "Compiled " : "Failed to compile ") << PrettyMethod(method) << " in "
+            << PrettyDuration(duration_ns);
+  return success;
+}
+
+void Jit::DumpInfo(std::ostream& os) {
+  os << "JIT: " << methods_compiled_.LoadRelaxed() << " methods compiled, "
+     << methods_failed_.LoadRelaxed() << " failed, "
+     << PrettyDuration(compile_time_ns_.LoadRelaxed()) << " spent compiling, "
+     << osr_entries_.LoadRelaxed() << " on-stack replacements, "
+     << "compile threshold " << compile_threshold_ << "\n";
+  code_cache_->Dump(os);
+}
+
+}  // namespace jit
+}  // namespace art
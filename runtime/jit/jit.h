@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_H_
+#define ART_RUNTIME_JIT_JIT_H_
+
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "jit/jit_code_cache.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+
+class ShadowFrame;
+class Thread;
+class ThreadPool;
+union JValue;
+
+namespace jit {
+
+// Compiles methods that get hot in the interpreter with the Quick backend of libart-compiler,
+// which is loaded on demand, and installs the code through the code cache. Hotness is sampled by
+// the interpreter on method entry and on backward branches. Compilation happens on a single
+// background thread so the mutators only pay for counting. Loops that keep running in the
+// interpreter after their method was compiled are moved into the code by on-stack replacement.
+class Jit {
+ public:
+  static constexpr size_t kDefaultCompileThreshold = 1000;
+  // Thresholds must fit the 16-bit hotness counters.
+  static constexpr size_t kMaxCompileThreshold = 0xFFFF;
+
+  // Load the compiler and create the code cache, returns nullptr and sets error_msg on failure.
+  static Jit* Create(size_t code_cache_capacity, size_t compile_threshold,
+                     std::string* error_msg);
+  ~Jit();
+
+  // Start the compiler thread. Must be called by an attached thread not holding the mutator lock.
+  void CreateThreadPool() LOCKS_EXCLUDED(Locks::mutator_lock_);
+  void DeleteThreadPool();
+
+  // Add count hotness samples to an interpreted method, queueing it for compilation once its
+  // counter reaches the compile threshold.
+  void AddSamples(Thread* self, mirror::ArtMethod* method, uint16_t count)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (UNLIKELY(CountSamples(method, count))) {
+      MethodHot(self, method);
+    }
+  }
+
+  // Add a hotness sample for a backward branch to dex_pc taken by the interpreted shadow_frame.
+  // Once the counter reaches the threshold and the method already has JIT code, the activation
+  // moves into that code at the loop header. Returns true if it did and the method ran to
+  // completion, with its return value in result or an exception pending.
+  bool AddBackwardBranchSample(Thread* self, ShadowFrame* shadow_frame, uint32_t dex_pc,
+                               JValue* result)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Compile method and install its code, returns false if the method could not be compiled.
+  // Called on the compiler thread.
+  bool CompileMethod(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  JitCodeCache* GetCodeCache() const {
+    return code_cache_.get();
+  }
+
+  size_t GetCompileThreshold() const {
+    return compile_threshold_;
+  }
+
+  void DumpInfo(std::ostream& os);
+
+ private:
+  // Counters are kept in a table indexed by method address rather than in ArtMethod, whose
+  // layout is shared with java.lang.reflect.ArtMethod. Methods sharing a slot share a counter,
+  // which at worst compiles a lukewarm method early.
+  static constexpr size_t kHotnessTableSize = 16 * KB;
+
+  static size_t HotnessIndex(mirror::ArtMethod* method) {
+    return (reinterpret_cast<uintptr_t>(method) / kObjectAlignment) & (kHotnessTableSize - 1);
+  }
+
+  Jit(JitCodeCache* code_cache, size_t compile_threshold);
+
+  // Add count samples to the counter of method. Returns true, restarting the count, when the
+  // counter reaches the compile threshold.
+  bool CountSamples(mirror::ArtMethod* method, uint16_t count) {
+    Atomic<uint16_t>& counter = hotness_counters_[HotnessIndex(method)];
+    uint32_t new_count = static_cast<uint32_t>(counter.LoadRelaxed()) + count;
+    if (LIKELY(new_count < compile_threshold_)) {
+      counter.StoreRelaxed(static_cast<uint16_t>(new_count));
+      return false;
+    }
+    counter.StoreRelaxed(0);
+    return true;
+  }
+
+  bool LoadCompiler(std::string* error_msg);
+
+  // Slow path of AddSamples, queue method for compilation unless it was already queued.
+  void MethodHot(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Transfer the interpreted shadow_frame into a frame of code, the installed JIT code of its
+  // method, and continue there at dex_pc. Returns false if the code has no entry for dex_pc or the
+  // transfer isn't possible, the interpreter then carries on.
+  bool OnStackReplace(Thread* self, ShadowFrame* shadow_frame, const void* code, uint32_t dex_pc,
+                      JValue* result)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Interface to libart-compiler, see compiler/jit/jit_compiler.cc.
+  void* jit_library_handle_;
+  void* jit_compiler_handle_;
+  void* (*jit_load_)();
+  void (*jit_unload_)(void*);
+  bool (*jit_compile_method_)(void*, mirror::ArtMethod*, Thread*);
+
+  std::unique_ptr<JitCodeCache> code_cache_;
+  std::unique_ptr<ThreadPool> thread_pool_;
+  const uint16_t compile_threshold_;
+  std::unique_ptr<Atomic<uint16_t>[]> hotness_counters_;
+
+  // Guards the set of methods queued so far. Methods are never queued twice, whether or not
+  // their compilation succeeds.
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::set<mirror::ArtMethod*> queued_methods_ GUARDED_BY(lock_);
+
+  Atomic<uint32_t> methods_compiled_;
+  Atomic<uint32_t> methods_failed_;
+  Atomic<uint64_t> compile_time_ns_;
+  Atomic<uint32_t> osr_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(Jit);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_H_
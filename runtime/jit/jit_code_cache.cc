@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_cache.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+
+#include "base/stringprintf.h"
+#include "instruction_set.h"
+#include "oat.h"
+#include "thread-inl.h"
+#include "utils.h"
+
+namespace art {
+namespace jit {
+
+static void ProtectCodeCache(uint8_t* begin, uint8_t* end, int prot) {
+  if (begin < end && mprotect(begin, end - begin, prot) != 0) {
+    PLOG(FATAL) << "mprotect(" << reinterpret_cast<void*>(begin) << ", " << (end - begin) << ", "
+                << prot << ") failed";
+  }
+}
+
+JitCodeCache* JitCodeCache::Create(size_t capacity, std::string* error_msg) {
+  CHECK_GT(capacity, 0U);
+  CHECK_LE(capacity, kMaxCapacity);
+  std::string error_str;
+  // Map name specific for android_os_Debug.cpp accounting. The cache is only made writable while
+  // CommitCode copies code in.
+  MemMap* map = MemMap::MapAnonymous("jit-code-cache", nullptr, RoundUp(capacity, kPageSize),
+                                     PROT_READ | PROT_EXEC, false, &error_str);
+  if (map == nullptr) {
+    *error_msg = StringPrintf("Failed to create JIT code cache of %zd bytes: %s", capacity,
+                              error_str.c_str());
+    return nullptr;
+  }
+  return new JitCodeCache(map);
+}
+
+JitCodeCache::JitCodeCache(MemMap* mem_map)
+    : lock_("JIT code cache lock", kJitCodeCacheLock), mem_map_(mem_map), top_(mem_map->Begin()),
+      data_size_(0), failed_commits_(0) {
+}
+
+const void* JitCodeCache::CommitCode(Thread* self, mirror::ArtMethod* method,
+                                     const std::vector<uint8_t>& mapping_table,
+                                     const std::vector<uint8_t>& vmap_table,
+                                     const std::vector<uint8_t>& gc_map,
+                                     size_t frame_size_in_bytes, uint32_t core_spill_mask,
+                                     uint32_t fp_spill_mask, const std::vector<uint8_t>& code,
+                                     size_t code_delta, const uint8_t** gc_map_out) {
+  DCHECK(!code.empty());
+  const size_t alignment = GetInstructionSetAlignment(kRuntimeISA);
+  MutexLock mu(self, lock_);
+  uint8_t* const mapping_table_ptr = top_;
+  uint8_t* const vmap_table_ptr = mapping_table_ptr + mapping_table.size();
+  uint8_t* const gc_map_ptr = vmap_table_ptr + vmap_table.size();
+  uint8_t* const tables_end = gc_map_ptr + gc_map.size();
+  uint8_t* const code_ptr = AlignUp(tables_end + sizeof(OatQuickMethodHeader), alignment);
+  uint8_t* const code_end = code_ptr + code.size();
+  if (code_end > mem_map_->End()) {
+    ++failed_commits_;
+    return nullptr;
+  }
+  // The pages written are not executable meanwhile, except for a first page that also holds the
+  // end of code committed before, which may be running.
+  uint8_t* const write_begin = AlignDown(mapping_table_ptr, kPageSize);
+  uint8_t* const write_end = AlignUp(code_end, kPageSize);
+  uint8_t* const rw_begin = write_begin == mapping_table_ptr ? write_begin
+                                                             : write_begin + kPageSize;
+  ProtectCodeCache(write_begin, std::min(rw_begin, write_end),
+                   PROT_READ | PROT_WRITE | PROT_EXEC);
+  ProtectCodeCache(rw_begin, write_end, PROT_READ | PROT_WRITE);
+  std::copy(mapping_table.begin(), mapping_table.end(), mapping_table_ptr);
+  std::copy(vmap_table.begin(), vmap_table.end(), vmap_table_ptr);
+  std::copy(gc_map.begin(), gc_map.end(), gc_map_ptr);
+  uint32_t mapping_table_offset =
+      mapping_table.empty() ? 0u : static_cast<uint32_t>(code_ptr - mapping_table_ptr);
+  uint32_t vmap_table_offset =
+      vmap_table.empty() ? 0u : static_cast<uint32_t>(code_ptr - vmap_table_ptr);
+  new (code_ptr - sizeof(OatQuickMethodHeader)) OatQuickMethodHeader(
+      mapping_table_offset, vmap_table_offset, frame_size_in_bytes, core_spill_mask,
+      fp_spill_mask, code.size());
+  std::copy(code.begin(), code.end(), code_ptr);
+  // Only uses __builtin___clear_cache if GCC >= 4.3.3
+  __builtin___clear_cache(reinterpret_cast<char*>(code_ptr), reinterpret_cast<char*>(code_end));
+  ProtectCodeCache(write_begin, write_end, PROT_READ | PROT_EXEC);
+  data_size_ += code_ptr - mapping_table_ptr;
+  top_ = code_end;
+  const void* entry_point = code_ptr + code_delta;
+  method_code_map_.Overwrite(method, entry_point);
+  *gc_map_out = gc_map.empty() ? nullptr : gc_map_ptr;
+  return entry_point;
+}
+
+const void* JitCodeCache::GetCodeFor(Thread* self, mirror::ArtMethod* method) {
+  MutexLock mu(self, lock_);
+  auto it = method_code_map_.find(method);
+  return it != method_code_map_.end() ? it->second : nullptr;
+}
+
+size_t JitCodeCache::CodeCacheSize() {
+  MutexLock mu(Thread::Current(), lock_);
+  return top_ - mem_map_->Begin();
+}
+
+size_t JitCodeCache::NumMethods() {
+  MutexLock mu(Thread::Current(), lock_);
+  return method_code_map_.size();
+}
+
+void JitCodeCache::Dump(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t used = top_ - mem_map_->Begin();
+  os << "JIT code cache: " << method_code_map_.size() << " methods, "
+     << PrettySize(used) << "/" << PrettySize(Capacity()) << " used ("
+     << PrettySize(data_size_) << " tables), " << failed_commits_ << " failed commits\n";
+}
+
+}  // namespace jit
+}  // namespace art
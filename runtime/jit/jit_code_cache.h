@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_CODE_CACHE_H_
+#define ART_RUNTIME_JIT_JIT_CODE_CACHE_H_
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "mem_map.h"
+#include "safe_map.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+
+class Thread;
+
+namespace jit {
+
+// Holds the code and tables of methods compiled by the JIT. Each method is laid out the way the
+// oat writer lays out a method: the mapping, vmap and gc map tables, then an OatQuickMethodHeader
+// immediately followed by the code, so that the existing ArtMethod accessors work unchanged on
+// JIT code. The cache is a single executable mapping filled by a bump allocator, code is never
+// freed.
+class JitCodeCache {
+ public:
+  static constexpr size_t kMaxCapacity = 64 * MB;
+  static constexpr size_t kDefaultCapacity = 2 * MB;
+
+  // Create the code cache, returns nullptr and sets error_msg on failure.
+  static JitCodeCache* Create(size_t capacity, std::string* error_msg);
+
+  // Copy a compiled method into the cache and remember it as the code of method. Returns the
+  // entry point, which is the code pointer plus code_delta, or nullptr if the cache is full.
+  // The address of the copied gc map is returned in gc_map_out.
+  const void* CommitCode(Thread* self, mirror::ArtMethod* method,
+                         const std::vector<uint8_t>& mapping_table,
+                         const std::vector<uint8_t>& vmap_table,
+                         const std::vector<uint8_t>& gc_map,
+                         size_t frame_size_in_bytes, uint32_t core_spill_mask,
+                         uint32_t fp_spill_mask, const std::vector<uint8_t>& code,
+                         size_t code_delta, const uint8_t** gc_map_out)
+      LOCKS_EXCLUDED(lock_);
+
+  // Returns the JIT entry point of method, or nullptr if the method was not compiled.
+  const void* GetCodeFor(Thread* self, mirror::ArtMethod* method) LOCKS_EXCLUDED(lock_);
+
+  // Returns true if ptr points into the code cache.
+  bool ContainsCodePtr(const void* ptr) const {
+    return ptr >= mem_map_->Begin() && ptr < mem_map_->End();
+  }
+
+  size_t Capacity() const {
+    return mem_map_->Size();
+  }
+
+  size_t CodeCacheSize() LOCKS_EXCLUDED(lock_);
+  size_t NumMethods() LOCKS_EXCLUDED(lock_);
+
+  void Dump(std::ostream& os) LOCKS_EXCLUDED(lock_);
+
+ private:
+  explicit JitCodeCache(MemMap* mem_map);
+
+  // Guards the allocation pointer and the method to code map.
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::unique_ptr<MemMap> mem_map_;
+  uint8_t* top_ GUARDED_BY(lock_);
+  // Number of bytes used by tables and headers rather than code.
+  size_t data_size_ GUARDED_BY(lock_);
+  // Number of commits that did not fit.
+  size_t failed_commits_ GUARDED_BY(lock_);
+  SafeMap<mirror::ArtMethod*, const void*> method_code_map_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(JitCodeCache);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_CODE_CACHE_H_
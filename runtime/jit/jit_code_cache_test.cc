@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_cache.h"
+
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "oat.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+namespace jit {
+
+class JitCodeCacheTest : public CommonRuntimeTest {};
+
+TEST_F(JitCodeCacheTest, CommitCode) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* object_class = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(object_class != nullptr);
+  mirror::ArtMethod* method = object_class->GetDirectMethod(0);
+
+  std::string error_msg;
+  std::unique_ptr<JitCodeCache> code_cache(JitCodeCache::Create(kPageSize, &error_msg));
+  ASSERT_TRUE(code_cache.get() != nullptr) << error_msg;
+  EXPECT_TRUE(code_cache->GetCodeFor(soa.Self(), method) == nullptr);
+
+  std::vector<uint8_t> mapping_table(3, 0x11);
+  std::vector<uint8_t> vmap_table(5, 0x22);
+  std::vector<uint8_t> gc_map(7, 0x33);
+  std::vector<uint8_t> code(16, 0x44);
+  const uint8_t* gc_map_ptr = nullptr;
+  const void* entry_point = code_cache->CommitCode(soa.Self(), method, mapping_table, vmap_table,
+                                                   gc_map, 64, 0x1, 0x0, code, 0, &gc_map_ptr);
+  ASSERT_TRUE(entry_point != nullptr);
+  EXPECT_EQ(entry_point, code_cache->GetCodeFor(soa.Self(), method));
+  EXPECT_TRUE(code_cache->ContainsCodePtr(entry_point));
+  EXPECT_EQ(1U, code_cache->NumMethods());
+  EXPECT_TRUE(IsAlignedParam(reinterpret_cast<uintptr_t>(entry_point),
+                             GetInstructionSetAlignment(kRuntimeISA)));
+
+  // The tables are found the way ArtMethod finds them, relative to the code.
+  const uint8_t* code_ptr = reinterpret_cast<const uint8_t*>(entry_point);
+  const OatQuickMethodHeader* header = reinterpret_cast<const OatQuickMethodHeader*>(code_ptr) - 1;
+  EXPECT_EQ(code.size(), header->code_size_);
+  EXPECT_EQ(64U, header->frame_info_.FrameSizeInBytes());
+  EXPECT_EQ(0, memcmp(&code[0], code_ptr, code.size()));
+  EXPECT_EQ(0, memcmp(&mapping_table[0], code_ptr - header->mapping_table_offset_,
+                      mapping_table.size()));
+  EXPECT_EQ(0, memcmp(&vmap_table[0], code_ptr - header->vmap_table_offset_, vmap_table.size()));
+  ASSERT_TRUE(gc_map_ptr != nullptr);
+  EXPECT_EQ(0, memcmp(&gc_map[0], gc_map_ptr, gc_map.size()));
+}
+
+TEST_F(JitCodeCacheTest, CommitCodeWhenFull) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* object_class = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(object_class != nullptr);
+  mirror::ArtMethod* method = object_class->GetDirectMethod(0);
+
+  std::string error_msg;
+  std::unique_ptr<JitCodeCache> code_cache(JitCodeCache::Create(kPageSize, &error_msg));
+  ASSERT_TRUE(code_cache.get() != nullptr) << error_msg;
+  std::vector<uint8_t> empty;
+  std::vector<uint8_t> code(kPageSize, 0x44);
+  const uint8_t* gc_map_ptr = nullptr;
+  EXPECT_TRUE(code_cache->CommitCode(soa.Self(), method, empty, empty, empty, 64, 0x1, 0x0, code,
+                                     0, &gc_map_ptr) == nullptr);
+  EXPECT_TRUE(code_cache->GetCodeFor(soa.Self(), method) == nullptr);
+  EXPECT_EQ(0U, code_cache->NumMethods());
+  EXPECT_EQ(0U, code_cache->CodeCacheSize());
+}
+
+}  // namespace jit
+}  // namespace art
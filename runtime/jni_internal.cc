@@ -3433,6 +3433,36 @@ void RegisterNativeMethods(JNIEnv* env, const char* jni_class_name, const JNINat
   JNI::RegisterNativeMethods(env, c.get(), methods, method_count, false);
 }
 
+void RegisterOptionalNativeMethods(JNIEnv* env, const char* jni_class_name,
+                                   const JNINativeMethod* methods, jint method_count) {
+  ScopedLocalRef<jclass> c(env, env->FindClass(jni_class_name));
+  if (c.get() == nullptr) {
+    LOG(FATAL) << "Couldn't find class: " << jni_class_name;
+  }
+  for (jint i = 0; i < method_count; ++i) {
+    const char* sig = methods[i].signature;
+    if (*sig == '!') {
+      ++sig;
+    }
+    bool declared;
+    {
+      ScopedObjectAccess soa(env);
+      mirror::Class* klass = soa.Decode<mirror::Class*>(c.get());
+      mirror::ArtMethod* m = klass->FindDirectMethod(methods[i].name, sig);
+      if (m == nullptr) {
+        m = klass->FindVirtualMethod(methods[i].name, sig);
+      }
+      declared = m != nullptr && m->IsNative();
+    }
+    if (declared) {
+      JNI::RegisterNativeMethods(env, c.get(), &methods[i], 1, false);
+    } else {
+      VLOG(jni) << "Not registering " << jni_class_name << "." << methods[i].name << sig
+                << ", it isn't declared native";
+    }
+  }
+}
+
 }  // namespace art
 
 std::ostream& operator<<(std::ostream& os, const jobjectRefType& rhs) {
@@ -53,6 +53,10 @@ void JniAbortF(const char* jni_function_name, const char* fmt, ...)
     __attribute__((__format__(__printf__, 2, 3)));
 void RegisterNativeMethods(JNIEnv* env, const char* jni_class_name, const JNINativeMethod* methods,
                            jint method_count);
+// Like RegisterNativeMethods, but skips the methods the class doesn't declare as native. For
+// natives whose Java declarations the class library may not have yet.
+void RegisterOptionalNativeMethods(JNIEnv* env, const char* jni_class_name,
+                                   const JNINativeMethod* methods, jint method_count);
 
 int ThrowNewException(JNIEnv* env, jclass exception_class, const char* msg, jobject cause);
 
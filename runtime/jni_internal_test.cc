@@ -533,6 +533,39 @@ TEST_F(JniInternalTest, RegisterAndUnregisterNatives) {
   EXPECT_EQ(env_->UnregisterNatives(jlnsme), JNI_OK);
 }
 
+TEST_F(JniInternalTest, RegisterFastNativesAgain) {
+  jclass jlobject = env_->FindClass("java/lang/Object");
+  jmethodID notify = env_->GetMethodID(jlobject, "notify", "()V");
+  ASSERT_NE(notify, nullptr);
+  void* native_function = reinterpret_cast<void*>(BogusMethod);
+  JNINativeMethod fast_methods[] = { { "notify", "!()V", native_function } };
+  JNINativeMethod methods[] = { { "notify", "()V", native_function } };
+
+  // Unregistering drops the fast flag of a method registered with '!'.
+  EXPECT_EQ(env_->RegisterNatives(jlobject, fast_methods, 1), JNI_OK);
+  {
+    ScopedObjectAccess soa(env_);
+    EXPECT_TRUE(soa.DecodeMethod(notify)->IsFastNative());
+  }
+  EXPECT_EQ(env_->UnregisterNatives(jlobject), JNI_OK);
+  {
+    ScopedObjectAccess soa(env_);
+    EXPECT_FALSE(soa.DecodeMethod(notify)->IsFastNative());
+    EXPECT_FALSE(soa.DecodeMethod(notify)->IsCriticalNative());
+  }
+
+  // So does registering again without '!'.
+  EXPECT_EQ(env_->RegisterNatives(jlobject, fast_methods, 1), JNI_OK);
+  EXPECT_EQ(env_->RegisterNatives(jlobject, methods, 1), JNI_OK);
+  {
+    ScopedObjectAccess soa(env_);
+    EXPECT_FALSE(soa.DecodeMethod(notify)->IsFastNative());
+    EXPECT_FALSE(soa.DecodeMethod(notify)->IsCriticalNative());
+  }
+  EXPECT_FALSE(env_->ExceptionCheck());
+  EXPECT_EQ(env_->UnregisterNatives(jlobject), JNI_OK);
+}
+
 #define EXPECT_PRIMITIVE_ARRAY(new_fn, \
                                get_region_fn, \
                                set_region_fn, \
@@ -0,0 +1,553 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lock_contention_profiler.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+#include "base/unix_file/fd_file.h"
+#include "dex_file-inl.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "os.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "stack.h"
+#include "thread.h"
+#include "thread_list.h"
+#include "utils.h"
+
+namespace art {
+
+// Number of locks and waiter stacks per lock shown in a report.
+static constexpr size_t kMaxReportedLocks = 20;
+static constexpr size_t kMaxReportedStacks = 3;
+
+// A single producer, single consumer ring of samples. The producer is the thread currently owning
+// the buffer, the consumer is whoever holds LockContentionProfiler::lock_.
+class ContentionSampleBuffer {
+ public:
+  static constexpr size_t kCapacity = 256;
+
+  ContentionSampleBuffer()
+      : owner_(nullptr), next_(nullptr), head_(0), tail_(0), dropped_(0), contentions_(0) {
+    pending_.depth = 0;
+  }
+
+  bool TryAcquire(Thread* self) {
+    return owner_.CompareExchangeStrongSequentiallyConsistent(nullptr, self);
+  }
+
+  void Release() {
+    owner_.StoreSequentiallyConsistent(nullptr);
+  }
+
+  // Returns true if the stack of the current contention should be recorded. Only accessed by the
+  // owner.
+  bool ShouldCaptureStack(uint32_t sample_interval) {
+    return (contentions_++ % sample_interval) == 0;
+  }
+
+  // The sample of the contended mutex acquisition in progress, its waiter stack is captured before
+  // the mutex is acquired. Only accessed by the owner.
+  ContentionSample* GetPendingSample() {
+    return &pending_;
+  }
+
+  void Push(const ContentionSample& sample) {
+    size_t head = head_.LoadRelaxed();
+    if (head - tail_.LoadSequentiallyConsistent() == kCapacity) {
+      // Full, the consumer hasn't caught up.
+      dropped_.FetchAndAddSequentiallyConsistent(1);
+      return;
+    }
+    samples_[head % kCapacity] = sample;
+    head_.StoreRelease(head + 1);
+  }
+
+  template <typename Visitor>
+  void Drain(Visitor* visitor) {
+    size_t tail = tail_.LoadRelaxed();
+    const size_t head = head_.LoadSequentiallyConsistent();
+    for (; tail != head; ++tail) {
+      (*visitor)(samples_[tail % kCapacity]);
+    }
+    tail_.StoreSequentiallyConsistent(tail);
+  }
+
+  // Drop the samples not drained yet and the count of dropped samples.
+  void Discard() {
+    tail_.StoreSequentiallyConsistent(head_.LoadSequentiallyConsistent());
+    dropped_.StoreRelaxed(0);
+  }
+
+  uint32_t GetDropped() const {
+    return dropped_.LoadRelaxed();
+  }
+
+  ContentionSampleBuffer* GetNext() const {
+    return next_;
+  }
+
+  void SetNext(ContentionSampleBuffer* next) {
+    next_ = next;
+  }
+
+ private:
+  Atomic<Thread*> owner_;
+  // Next buffer in LockContentionProfiler::buffers_, only written before publication.
+  ContentionSampleBuffer* next_;
+  Atomic<size_t> head_;
+  Atomic<size_t> tail_;
+  Atomic<uint32_t> dropped_;
+  uint32_t contentions_;
+  ContentionSample pending_;
+  ContentionSample samples_[kCapacity];
+
+  DISALLOW_COPY_AND_ASSIGN(ContentionSampleBuffer);
+};
+
+namespace {
+
+typedef std::tuple<const DexFile*, uint32_t, uint32_t> FrameKey;
+typedef std::vector<FrameKey> StackKey;
+
+static FrameKey MakeFrameKey(const ContentionFrame& frame) {
+  return std::make_tuple(frame.dex_file, frame.method_idx, frame.dex_pc);
+}
+
+struct WaitStats {
+  WaitStats() : count(0), total_wait_ns(0), max_wait_ns(0) {}
+
+  void Add(uint64_t wait_ns) {
+    ++count;
+    total_wait_ns += wait_ns;
+    max_wait_ns = std::max(max_wait_ns, wait_ns);
+  }
+
+  uint64_t count;
+  uint64_t total_wait_ns;
+  uint64_t max_wait_ns;
+};
+
+struct LockStats {
+  WaitStats waits;
+  std::map<StackKey, WaitStats> waiter_stacks;
+  std::map<FrameKey, WaitStats> owner_frames;
+};
+
+// Identifies a lock by its runtime mutex or by the class of the contended object.
+typedef std::tuple<const BaseMutex*, const DexFile*, uint16_t> LockKey;
+
+// Aggregated samples, guarded by LockContentionProfiler::lock_.
+static std::map<LockKey, LockStats>* gAggregatedStats = nullptr;
+
+class SampleAggregator {
+ public:
+  explicit SampleAggregator(std::map<LockKey, LockStats>* stats) : stats_(stats) {}
+
+  void operator()(const ContentionSample& sample) {
+    LockKey lock_key(sample.mutex, sample.monitor_dex_file, sample.monitor_type_idx);
+    LockStats& lock_stats = (*stats_)[lock_key];
+    lock_stats.waits.Add(sample.wait_ns);
+    StackKey stack_key;
+    for (size_t i = 0; i < sample.depth; ++i) {
+      stack_key.push_back(MakeFrameKey(sample.frames[i]));
+    }
+    lock_stats.waiter_stacks[stack_key].Add(sample.wait_ns);
+    if (sample.has_owner_frame) {
+      lock_stats.owner_frames[MakeFrameKey(sample.owner_frame)].Add(sample.wait_ns);
+    }
+  }
+
+ private:
+  std::map<LockKey, LockStats>* const stats_;
+};
+
+template <typename Key>
+static bool CompareTotalWait(const std::pair<const Key*, const WaitStats*>& lhs,
+                             const std::pair<const Key*, const WaitStats*>& rhs) {
+  return lhs.second->total_wait_ns > rhs.second->total_wait_ns;
+}
+
+// Returns the entries of the map with the largest total wait, most contended first.
+template <typename Key>
+static std::vector<std::pair<const Key*, const WaitStats*>> TopByWait(
+    const std::map<Key, WaitStats>& stats, size_t max_entries) {
+  std::vector<std::pair<const Key*, const WaitStats*>> entries;
+  for (const auto& entry : stats) {
+    entries.push_back(std::make_pair(&entry.first, &entry.second));
+  }
+  std::sort(entries.begin(), entries.end(), CompareTotalWait<Key>);
+  if (entries.size() > max_entries) {
+    entries.resize(max_entries);
+  }
+  return entries;
+}
+
+static void DumpFrame(std::ostream& os, const FrameKey& frame) {
+  const DexFile* dex_file = std::get<0>(frame);
+  os << PrettyMethod(std::get<1>(frame), *dex_file) << " (dex_pc=" << std::get<2>(frame) << ")";
+}
+
+static void DumpWaitStats(std::ostream& os, const WaitStats& stats) {
+  os << "count=" << stats.count << " total=" << PrettyDuration(stats.total_wait_ns)
+     << " max=" << PrettyDuration(stats.max_wait_ns);
+}
+
+static void DumpLockName(std::ostream& os, const LockKey& key) {
+  const BaseMutex* mutex = std::get<0>(key);
+  const DexFile* dex_file = std::get<1>(key);
+  if (mutex != nullptr) {
+    os << "mutex \"" << mutex->GetName() << "\"";
+  } else if (dex_file != nullptr) {
+    os << "monitor of " << PrettyDescriptor(dex_file->StringByTypeIdx(std::get<2>(key)));
+  } else {
+    os << "monitor of an array or proxy class";
+  }
+}
+
+class ContentionStackVisitor : public StackVisitor {
+ public:
+  ContentionStackVisitor(Thread* thread, ContentionSample* sample)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      : StackVisitor(thread, nullptr), sample_(sample) {}
+
+  bool VisitFrame() OVERRIDE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::ArtMethod* m = GetMethod();
+    if (m->IsRuntimeMethod() || m->IsProxyMethod()) {
+      return true;
+    }
+    ContentionFrame& frame = sample_->frames[sample_->depth++];
+    frame.dex_file = m->GetDexFile();
+    frame.method_idx = m->GetDexMethodIndex();
+    frame.dex_pc = GetDexPc(false);
+    return sample_->depth < ContentionSample::kMaxStackDepth;
+  }
+
+ private:
+  ContentionSample* const sample_;
+};
+
+}  // namespace
+
+Atomic<bool> LockContentionProfiler::enabled_(false);
+Atomic<uint32_t> LockContentionProfiler::sample_interval_(1);
+Atomic<ContentionSampleBuffer*> LockContentionProfiler::buffers_(nullptr);
+Mutex* LockContentionProfiler::lock_ = nullptr;
+std::string* LockContentionProfiler::output_filename_ = nullptr;
+pthread_t LockContentionProfiler::drain_pthread_ = 0U;
+
+void LockContentionProfiler::Start(uint32_t sample_interval, const std::string& output_filename) {
+  CHECK_GT(sample_interval, 0U);
+  if (lock_ == nullptr) {
+    lock_ = new Mutex("lock contention profiler lock");
+  }
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    MutexLock mu2(self, *lock_);
+    if (gAggregatedStats == nullptr) {
+      gAggregatedStats = new std::map<LockKey, LockStats>;
+    }
+    if (!IsEnabled()) {
+      // A new profile, forget the samples of the previous one.
+      gAggregatedStats->clear();
+      for (ContentionSampleBuffer* buffer = buffers_.LoadSequentiallyConsistent();
+           buffer != nullptr; buffer = buffer->GetNext()) {
+        buffer->Discard();
+      }
+    }
+    delete output_filename_;
+    output_filename_ = output_filename.empty() ? nullptr : new std::string(output_filename);
+    sample_interval_.StoreRelaxed(sample_interval);
+    enabled_.StoreSequentiallyConsistent(true);
+    // Threads attaching from now on get their buffer in ThreadAttached.
+    for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+      AssignThreadBufferLocked(thread);
+    }
+  }
+  VLOG(monitor) << "Lock contention profiling started, sample interval " << sample_interval;
+  // Threads can't be attached before the runtime is started, Runtime::Start starts it then.
+  if (Runtime::Current()->IsStarted()) {
+    StartDrainThread();
+  }
+}
+
+void LockContentionProfiler::StartDrainThread() {
+  if (lock_ == nullptr) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), *lock_);
+  if (IsEnabled() && drain_pthread_ == 0U) {
+    CHECK_PTHREAD_CALL(pthread_create, (&drain_pthread_, nullptr, &RunDrainThread, nullptr),
+                       "Lock contention profiler drain thread");
+  }
+}
+
+void* LockContentionProfiler::RunDrainThread(void* /*arg*/) {
+  Runtime* runtime = Runtime::Current();
+  if (!runtime->AttachCurrentThread("Lock contention profiler", true,
+                                    runtime->GetSystemThreadGroup(), !runtime->IsCompiler())) {
+    // The runtime is shutting down, it dumps what is left.
+    return nullptr;
+  }
+  Thread* self = Thread::Current();
+  while (IsEnabled()) {
+    usleep(kDrainIntervalMs * 1000);
+    // Keep the rings from filling up and dropping samples between reports.
+    MutexLock mu(self, *lock_);
+    DrainLocked();
+  }
+  runtime->DetachCurrentThread();
+  return nullptr;
+}
+
+void LockContentionProfiler::Stop() {
+  enabled_.StoreSequentiallyConsistent(false);
+  if (lock_ == nullptr) {
+    return;
+  }
+  pthread_t drain_pthread;
+  {
+    MutexLock mu(Thread::Current(), *lock_);
+    drain_pthread = drain_pthread_;
+    drain_pthread_ = 0U;
+  }
+  if (drain_pthread != 0U) {
+    CHECK_PTHREAD_CALL(pthread_join, (drain_pthread, nullptr),
+                       "Lock contention profiler drain thread shutdown");
+  }
+}
+
+void LockContentionProfiler::Shutdown() {
+  if (lock_ == nullptr) {
+    return;
+  }
+  Stop();
+  Thread* self = Thread::Current();
+  if (self != nullptr) {
+    ScopedObjectAccess soa(self);
+    DumpToFile();
+  }
+  // The per-thread buffers are left alone as exiting daemon threads may still release them.
+}
+
+void LockContentionProfiler::ThreadAttached(Thread* self) {
+  if (!IsEnabled()) {
+    return;
+  }
+  MutexLock mu(self, *lock_);
+  // Start may have seen self in the thread list already.
+  if (IsEnabled()) {
+    AssignThreadBufferLocked(self);
+  }
+}
+
+void LockContentionProfiler::AssignThreadBufferLocked(Thread* thread) {
+  if (thread->GetContentionSampleBuffer() != nullptr) {
+    return;
+  }
+  // Reuse the buffer of an exited thread if possible.
+  ContentionSampleBuffer* buffer;
+  for (buffer = buffers_.LoadSequentiallyConsistent(); buffer != nullptr;
+       buffer = buffer->GetNext()) {
+    if (buffer->TryAcquire(thread)) {
+      thread->SetContentionSampleBuffer(buffer);
+      return;
+    }
+  }
+  buffer = new ContentionSampleBuffer;
+  CHECK(buffer->TryAcquire(thread));
+  ContentionSampleBuffer* head;
+  do {
+    head = buffers_.LoadRelaxed();
+    buffer->SetNext(head);
+  } while (!buffers_.CompareExchangeWeakSequentiallyConsistent(head, buffer));
+  thread->SetContentionSampleBuffer(buffer);
+}
+
+void LockContentionProfiler::ReleaseThreadBuffer(ContentionSampleBuffer* buffer) {
+  if (buffer != nullptr) {
+    buffer->Release();
+  }
+}
+
+void LockContentionProfiler::CaptureStack(Thread* self, ContentionSample* sample) {
+  ContentionStackVisitor visitor(self, sample);
+  visitor.WalkStack(false);
+}
+
+void LockContentionProfiler::RecordMonitorContention(Thread* self, mirror::Class* klass,
+                                                     uint32_t owner_tid,
+                                                     mirror::ArtMethod* owner_method,
+                                                     uint32_t owner_dex_pc, uint64_t wait_ns) {
+  ContentionSampleBuffer* buffer = self->GetContentionSampleBuffer();
+  if (buffer == nullptr) {
+    // Attached while sampling started, the next contention is recorded.
+    return;
+  }
+  ContentionSample sample;
+  sample.mutex = nullptr;
+  if (klass->IsArrayClass() || klass->IsProxyClass()) {
+    sample.monitor_dex_file = nullptr;
+    sample.monitor_type_idx = 0;
+  } else {
+    sample.monitor_dex_file = &klass->GetDexFile();
+    sample.monitor_type_idx = klass->GetDexTypeIndex();
+  }
+  sample.wait_ns = wait_ns;
+  sample.waiter_tid = self->GetThreadId();
+  sample.owner_tid = owner_tid;
+  sample.has_owner_frame = owner_method != nullptr && !owner_method->IsProxyMethod();
+  if (sample.has_owner_frame) {
+    sample.owner_frame.dex_file = owner_method->GetDexFile();
+    sample.owner_frame.method_idx = owner_method->GetDexMethodIndex();
+    sample.owner_frame.dex_pc = owner_dex_pc;
+  }
+  sample.depth = 0;
+  if (buffer->ShouldCaptureStack(sample_interval_.LoadRelaxed())) {
+    CaptureStack(self, &sample);
+  }
+  buffer->Push(sample);
+}
+
+void LockContentionProfiler::BeginMutexContention(Thread* self) {
+  // Not attached, or attached while sampling started, nowhere to record the sample.
+  ContentionSampleBuffer* buffer = (self != nullptr) ? self->GetContentionSampleBuffer() : nullptr;
+  if (buffer == nullptr) {
+    return;
+  }
+  ContentionSample* sample = buffer->GetPendingSample();
+  sample->depth = 0;
+  // The managed stack may only be walked while holding a share of the mutator lock.
+  if (buffer->ShouldCaptureStack(sample_interval_.LoadRelaxed()) &&
+      Locks::mutator_lock_->IsSharedHeld(self)) {
+    CaptureStack(self, sample);
+  }
+}
+
+void LockContentionProfiler::RecordMutexContention(Thread* self, const BaseMutex* mutex,
+                                                   uint64_t owner_tid, uint64_t wait_ns) {
+  ContentionSampleBuffer* buffer = (self != nullptr) ? self->GetContentionSampleBuffer() : nullptr;
+  if (buffer == nullptr) {
+    return;
+  }
+  // The waiter stack was captured by BeginMutexContention, if the buffer was assigned by then.
+  ContentionSample* sample = buffer->GetPendingSample();
+  sample->mutex = mutex;
+  sample->monitor_dex_file = nullptr;
+  sample->monitor_type_idx = 0;
+  sample->wait_ns = wait_ns;
+  sample->waiter_tid = self->GetThreadId();
+  sample->owner_tid = static_cast<uint32_t>(owner_tid);
+  sample->has_owner_frame = false;
+  buffer->Push(*sample);
+  sample->depth = 0;
+}
+
+void LockContentionProfiler::DrainLocked() {
+  SampleAggregator aggregator(gAggregatedStats);
+  for (ContentionSampleBuffer* buffer = buffers_.LoadSequentiallyConsistent(); buffer != nullptr;
+       buffer = buffer->GetNext()) {
+    buffer->Drain(&aggregator);
+  }
+}
+
+void LockContentionProfiler::Dump(std::ostream& os) {
+  if (lock_ == nullptr) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), *lock_);
+  DrainLocked();
+  uint64_t dropped = 0;
+  for (ContentionSampleBuffer* buffer = buffers_.LoadSequentiallyConsistent(); buffer != nullptr;
+       buffer = buffer->GetNext()) {
+    dropped += buffer->GetDropped();
+  }
+  std::map<LockKey, WaitStats> lock_waits;
+  WaitStats total;
+  for (const auto& entry : *gAggregatedStats) {
+    lock_waits[entry.first] = entry.second.waits;
+    total.count += entry.second.waits.count;
+    total.total_wait_ns += entry.second.waits.total_wait_ns;
+  }
+  os << "Lock contention profile: " << total.count << " contended acquisitions, total wait "
+     << PrettyDuration(total.total_wait_ns) << ", " << dropped << " samples dropped\n";
+  size_t rank = 0;
+  for (const auto& lock_entry : TopByWait(lock_waits, kMaxReportedLocks)) {
+    const LockStats& lock_stats = gAggregatedStats->find(*lock_entry.first)->second;
+    os << "  #" << ++rank << " ";
+    DumpLockName(os, *lock_entry.first);
+    os << ": ";
+    DumpWaitStats(os, lock_stats.waits);
+    os << "\n";
+    for (const auto& owner_entry : TopByWait(lock_stats.owner_frames, 1)) {
+      os << "    owner at ";
+      DumpFrame(os, *owner_entry.first);
+      os << " ";
+      DumpWaitStats(os, *owner_entry.second);
+      os << "\n";
+    }
+    for (const auto& stack_entry : TopByWait(lock_stats.waiter_stacks, kMaxReportedStacks)) {
+      os << "    waiters ";
+      DumpWaitStats(os, *stack_entry.second);
+      os << "\n";
+      if (stack_entry.first->empty()) {
+        os << "      (stack not sampled)\n";
+      }
+      for (const FrameKey& frame : *stack_entry.first) {
+        os << "      at ";
+        DumpFrame(os, frame);
+        os << "\n";
+      }
+    }
+  }
+  os << "\n";
+}
+
+void LockContentionProfiler::DumpToFile() {
+  if (lock_ == nullptr) {
+    return;
+  }
+  std::string filename;
+  {
+    MutexLock mu(Thread::Current(), *lock_);
+    if (output_filename_ == nullptr) {
+      return;
+    }
+    filename = *output_filename_;
+  }
+  std::ostringstream os;
+  Dump(os);
+  std::unique_ptr<File> file(OS::CreateEmptyFile(filename.c_str()));
+  if (file.get() == nullptr) {
+    PLOG(ERROR) << "Failed to open lock contention profile " << filename;
+    return;
+  }
+  const std::string report(os.str());
+  if (!file->WriteFully(report.c_str(), report.size())) {
+    PLOG(ERROR) << "Failed to write lock contention profile " << filename;
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_LOCK_CONTENTION_PROFILER_H_
+#define ART_RUNTIME_LOCK_CONTENTION_PROFILER_H_
+
+#include <pthread.h>
+
+#include <ostream>
+#include <string>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+  class Class;
+}  // namespace mirror
+
+class DexFile;
+class Thread;
+
+// A frame of a sampled stack. Methods are recorded by dex file and index rather than by
+// ArtMethod so that samples remain valid when a moving collector relocates the methods.
+struct ContentionFrame {
+  const DexFile* dex_file;
+  uint32_t method_idx;
+  uint32_t dex_pc;
+};
+
+// A single contended lock acquisition.
+struct ContentionSample {
+  static constexpr size_t kMaxStackDepth = 8;
+
+  // The contended runtime mutex, or nullptr for a contended monitor.
+  const BaseMutex* mutex;
+  // The class of the contended object for a contended monitor, nullptr for array and proxy
+  // classes which have no class def.
+  const DexFile* monitor_dex_file;
+  uint16_t monitor_type_idx;
+  uint64_t wait_ns;
+  uint32_t waiter_tid;
+  uint32_t owner_tid;
+  // Where the owner acquired the lock, only known for monitors.
+  ContentionFrame owner_frame;
+  bool has_owner_frame;
+  // The waiter's managed stack, innermost frame first.
+  size_t depth;
+  ContentionFrame frames[kMaxStackDepth];
+};
+
+class ContentionSampleBuffer;
+
+// Samples contended monitor enters and runtime mutex acquisitions into per-thread buffers. The
+// buffers are single producer, single consumer rings, assigned to the threads as sampling starts
+// or as they attach, so recording takes no locks and can happen from inside Mutex::ExclusiveLock.
+// Once the runtime is started, a daemon thread drains the buffers
+// every kDrainIntervalMs into counts aggregated per lock and waiter stack. A report is dumped on
+// SIGQUIT, through VMDebug or to the file given by -Xlockcontentionprofile-file.
+class LockContentionProfiler {
+ public:
+  static constexpr uint32_t kDrainIntervalMs = 100;
+
+  // Start sampling, recording the waiter stack for every sample_interval-th contended acquisition
+  // of each thread. Starting after a stop discards the samples of the previous profile, starting
+  // while sampling only changes the interval.
+  static void Start(uint32_t sample_interval, const std::string& output_filename)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, lock_);
+  // Stop sampling, the samples so far are kept for the next report.
+  static void Stop() LOCKS_EXCLUDED(lock_);
+  static void Shutdown() LOCKS_EXCLUDED(lock_);
+
+  // Start the drain thread if sampling was started before the runtime. Called by Runtime::Start.
+  static void StartDrainThread() LOCKS_EXCLUDED(lock_);
+
+  static bool IsEnabled() {
+    return enabled_.LoadRelaxed();
+  }
+
+  // Record a contended monitor enter, called by the waiter once it is runnable again and before
+  // it takes the monitor.
+  static void RecordMonitorContention(Thread* self, mirror::Class* klass, uint32_t owner_tid,
+                                      mirror::ArtMethod* owner_method, uint32_t owner_dex_pc,
+                                      uint64_t wait_ns)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Called as a thread is attached, assigns its buffer if sampling.
+  static void ThreadAttached(Thread* self) LOCKS_EXCLUDED(lock_);
+
+  // Start recording a contended runtime mutex acquisition, capturing the waiter stack before the
+  // mutex is acquired. Must not acquire any lock.
+  static void BeginMutexContention(Thread* self) NO_THREAD_SAFETY_ANALYSIS;
+
+  // Record the contended runtime mutex acquisition begun by BeginMutexContention once the mutex is
+  // held. Must not acquire any lock.
+  static void RecordMutexContention(Thread* self, const BaseMutex* mutex, uint64_t owner_tid,
+                                    uint64_t wait_ns) NO_THREAD_SAFETY_ANALYSIS;
+
+  // Aggregate the outstanding samples and dump a report ranked by total wait time.
+  static void Dump(std::ostream& os) LOCKS_EXCLUDED(lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Dump the report to the output file, if one was given.
+  static void DumpToFile() LOCKS_EXCLUDED(lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Called as a thread is destroyed, its samples are kept until the next report.
+  static void ReleaseThreadBuffer(ContentionSampleBuffer* buffer);
+
+ private:
+  static void AssignThreadBufferLocked(Thread* thread) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  static void Record(Thread* self, const ContentionSample& sample);
+  static void CaptureStack(Thread* self, ContentionSample* sample)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static void DrainLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  static void* RunDrainThread(void* arg) LOCKS_EXCLUDED(lock_);
+
+  static Atomic<bool> enabled_;
+  static Atomic<uint32_t> sample_interval_;
+  // Lock free list of all per-thread buffers, buffers are reused once their thread exits.
+  static Atomic<ContentionSampleBuffer*> buffers_;
+  // Guards the aggregated samples and the output filename.
+  static Mutex* lock_;
+  static std::string* output_filename_ GUARDED_BY(lock_);
+  static pthread_t drain_pthread_ GUARDED_BY(lock_);
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(LockContentionProfiler);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_LOCK_CONTENTION_PROFILER_H_
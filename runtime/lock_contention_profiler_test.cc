@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lock_contention_profiler.h"
+
+#include <unistd.h>
+
+#include <sstream>
+
+#include "atomic.h"
+#include "common_runtime_test.h"
+#include "handle_scope-inl.h"
+#include "lock_word.h"
+#include "mirror/object-inl.h"
+#include "mirror/string-inl.h"
+#include "scoped_thread_state_change.h"
+#include "thread_pool.h"
+
+namespace art {
+
+class LockContentionProfilerTest : public CommonRuntimeTest {};
+
+// Locks an object the test thread holds, publishing its thread first.
+class ContendMonitorTask : public Task {
+ public:
+  ContendMonitorTask(Handle<mirror::String> object, Atomic<Thread*>* waiter)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      : object_(object), waiter_(waiter) {}
+
+  void Run(Thread* self) {
+    waiter_->StoreSequentiallyConsistent(self);
+    ScopedObjectAccess soa(self);
+    object_->MonitorEnter(self);
+    object_->MonitorExit(self);
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  Handle<mirror::String> object_;
+  Atomic<Thread*>* const waiter_;
+};
+
+TEST_F(LockContentionProfilerTest, MutexContentionRanking) {
+  Thread* self = Thread::Current();
+  Mutex hot("hot test lock");
+  Mutex cold("cold test lock");
+  LockContentionProfiler::Start(1, "");
+  ASSERT_TRUE(LockContentionProfiler::IsEnabled());
+  LockContentionProfiler::RecordMutexContention(self, &cold, 0, MsToNs(1));
+  LockContentionProfiler::RecordMutexContention(self, &hot, 0, MsToNs(5));
+  LockContentionProfiler::RecordMutexContention(self, &hot, 0, MsToNs(5));
+
+  std::ostringstream os;
+  {
+    ScopedObjectAccess soa(self);
+    LockContentionProfiler::Dump(os);
+  }
+  LockContentionProfiler::Stop();
+  EXPECT_FALSE(LockContentionProfiler::IsEnabled());
+
+  const std::string report(os.str());
+  size_t hot_pos = report.find("mutex \"hot test lock\": count=2");
+  size_t cold_pos = report.find("mutex \"cold test lock\": count=1");
+  ASSERT_NE(hot_pos, std::string::npos) << report;
+  ASSERT_NE(cold_pos, std::string::npos) << report;
+  // Locks are ranked by total wait time.
+  EXPECT_LT(hot_pos, cold_pos) << report;
+}
+
+TEST_F(LockContentionProfilerTest, MonitorContention) {
+  Thread* self = Thread::Current();
+  StackHandleScope<1> hs(self);
+  Handle<mirror::String> object;
+  Atomic<Thread*> waiter(nullptr);
+  ThreadPool thread_pool("Lock contention profiler test thread pool", 1);
+  LockContentionProfiler::Start(1, "");
+  {
+    ScopedObjectAccess soa(self);
+    object = hs.NewHandle(mirror::String::AllocFromModifiedUtf8(self, "contended"));
+    object->MonitorEnter(self);
+    thread_pool.AddTask(self, new ContendMonitorTask(object, &waiter));
+  }
+  thread_pool.StartWorkers(self);
+
+  // The waiter revokes our bias, inflating the lock, then blocks on the monitor.
+  while (true) {
+    usleep(1000);
+    ScopedObjectAccess soa(self);
+    Thread* waiter_thread = waiter.LoadSequentiallyConsistent();
+    if (waiter_thread != nullptr && waiter_thread->GetState() == kBlocked &&
+        object->GetLockWord(true).GetState() == LockWord::kFatLocked) {
+      break;
+    }
+  }
+  // Give the waiter time to go from blocked to waiting on the monitor.
+  usleep(10 * 1000);
+  {
+    ScopedObjectAccess soa(self);
+    object->MonitorExit(self);
+  }
+  thread_pool.Wait(self, true, false);
+
+  std::ostringstream os;
+  {
+    ScopedObjectAccess soa(self);
+    LockContentionProfiler::Dump(os);
+  }
+  LockContentionProfiler::Stop();
+  const std::string report(os.str());
+  EXPECT_NE(report.find("monitor of java.lang.String: count=1"), std::string::npos) << report;
+}
+
+}  // namespace art
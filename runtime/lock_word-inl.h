@@ -32,6 +32,16 @@ inline uint32_t LockWord::ThinLockCount() const {
   return (value_ >> kThinLockCountShift) & kThinLockCountMask;
 }
 
+inline uint32_t LockWord::BiasOwner() const {
+  DCHECK_EQ(GetState(), kBiased);
+  return (value_ >> kThinLockOwnerShift) & kThinLockOwnerMask;
+}
+
+inline uint32_t LockWord::BiasLockCount() const {
+  DCHECK_EQ(GetState(), kBiased);
+  return (value_ >> kThinLockCountShift) & kThinLockCountMask;
+}
+
 inline Monitor* LockWord::FatLockMonitor() const {
   DCHECK_EQ(GetState(), kFatLocked);
   MonitorId mon_id = static_cast<MonitorId>(value_ & ~(kStateMask << kStateShift));
@@ -31,12 +31,22 @@ namespace mirror {
 class Monitor;
 
 /* The lock value itself as stored in mirror::Object::monitor_.  The two most significant bits of
- * the state. The three possible states are fat locked, thin/unlocked, and hash code.
+ * the state. The four possible states are fat locked, thin/unlocked, biased and hash code.
  * When the lock word is in the "thin" state and its bits are formatted as follows:
  *
- *  |33|22222222221111|1111110000000000|
- *  |10|98765432109876|5432109876543210|
- *  |00| lock count   |thread id owner |
+ *  |33|2|2222222221111|1111110000000000|
+ *  |10|9|8765432109876|5432109876543210|
+ *  |00|0| lock count  |thread id owner |
+ *
+ * When the lock word is in the "biased" state and its bits are formatted as follows:
+ *
+ *  |33|2|2222222221111|1111110000000000|
+ *  |10|9|8765432109876|5432109876543210|
+ *  |00|1| hold count  |thread id owner |
+ *
+ * Unlike the thin lock count, which is the recursion depth minus one, the biased hold count is
+ * the number of times the owner currently holds the lock. A count of zero means the lock is not
+ * held but remains reserved for the owner, which may acquire and release it with plain stores.
  *
  * When the lock word is in the "fat" state and its bits are formatted as follows:
  *
@@ -57,8 +67,10 @@ class LockWord {
     kStateSize = 2,
     // Number of bits to encode the thin lock owner.
     kThinLockOwnerSize = 16,
+    // Number of bits distinguishing a biased lock from a thin lock.
+    kBiasedSize = 1,
     // Remaining bits are the recursive lock count.
-    kThinLockCountSize = 32 - kThinLockOwnerSize - kStateSize,
+    kThinLockCountSize = 32 - kThinLockOwnerSize - kBiasedSize - kStateSize,
     // Thin lock bits. Owner in lowest bits.
 
     kThinLockOwnerShift = 0,
@@ -68,8 +80,12 @@ class LockWord {
     kThinLockCountMask = (1 << kThinLockCountSize) - 1,
     kThinLockMaxCount = kThinLockCountMask,
 
+    // Biased bit above the count, biased locks share the owner and count fields with thin locks.
+    kBiasedShift = kThinLockCountSize + kThinLockCountShift,
+    kBiasedMask = (1 << kBiasedSize) - 1,
+
     // State in the highest bits.
-    kStateShift = kThinLockCountSize + kThinLockCountShift,
+    kStateShift = kBiasedSize + kBiasedShift,
     kStateMask = (1 << kStateSize) - 1,
     kStateThinOrUnlocked = 0,
     kStateFat = 1,
@@ -88,6 +104,13 @@ class LockWord {
                      (kStateThinOrUnlocked << kStateShift));
   }
 
+  static LockWord FromBiasedLockId(uint32_t thread_id, uint32_t count) {
+    CHECK_LE(thread_id, static_cast<uint32_t>(kThinLockOwnerMask));
+    DCHECK_LE(count, static_cast<uint32_t>(kThinLockMaxCount));
+    return LockWord((thread_id << kThinLockOwnerShift) | (count << kThinLockCountShift) |
+                    (1 << kBiasedShift) | (kStateThinOrUnlocked << kStateShift));
+  }
+
   static LockWord FromForwardingAddress(size_t target) {
     DCHECK(IsAligned < 1 << kStateSize>(target));
     return LockWord((target >> kStateSize) | (kStateForwardingAddress << kStateShift));
@@ -101,6 +124,7 @@ class LockWord {
   enum LockState {
     kUnlocked,    // No lock owners.
     kThinLocked,  // Single uncontended owner.
+    kBiased,      // Reserved for a single thread, which may or may not currently hold it.
     kFatLocked,   // See associated monitor.
     kHashCode,    // Lock word contains an identity hash.
     kForwardingAddress,  // Lock word contains the forwarding address of an object.
@@ -113,7 +137,7 @@ class LockWord {
       uint32_t internal_state = (value_ >> kStateShift) & kStateMask;
       switch (internal_state) {
         case kStateThinOrUnlocked:
-          return kThinLocked;
+          return ((value_ >> kBiasedShift) & kBiasedMask) != 0 ? kBiased : kThinLocked;
         case kStateHash:
           return kHashCode;
         case kStateForwardingAddress:
@@ -131,6 +155,12 @@ class LockWord {
   // Return the number of times a lock value has been locked.
   uint32_t ThinLockCount() const;
 
+  // Return the thread id the lock is biased towards.
+  uint32_t BiasOwner() const;
+
+  // Return the number of times the bias owner currently holds the lock, zero if it is not held.
+  uint32_t BiasLockCount() const;
+
   // Return the Monitor encoded in a fat lock.
   Monitor* FatLockMonitor() const;
 
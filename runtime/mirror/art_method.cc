@@ -374,16 +374,29 @@ void ArtMethod::Invoke(Thread* self, uint32_t* args, uint32_t args_size, JValue*
 void ArtMethod::RegisterNative(Thread* self, const void* native_method, bool is_fast) {
   DCHECK(Thread::Current() == self);
   CHECK(IsNative()) << PrettyMethod(this);
-  CHECK(!IsFastNative()) << PrettyMethod(this);
   CHECK(native_method != NULL) << PrettyMethod(this);
   if (is_fast) {
+    // Methods annotated @FastNative already are fast, critical natives cannot take the JNIEnv* a
+    // fast native gets.
+    CHECK(!IsCriticalNative()) << PrettyMethod(this);
     SetAccessFlags(GetAccessFlags() | kAccFastNative);
+  } else if ((GetAccessFlags() & (kAccFastNative | kAccCriticalNative)) != 0) {
+    // Drop the flag a previous registration with '!' set, only the tier annotated in the dex file
+    // stays. The compiled stub depends on it, see ClassLinker::LoadMethod.
+    uint32_t access_flags = GetAccessFlags() & ~(kAccFastNative | kAccCriticalNative);
+    const DexFile* dex_file = GetDexFile();
+    access_flags |= dex_file->GetNativeMethodAnnotationAccessFlags(
+        *GetDeclaringClass()->GetClassDef(), GetDexMethodIndex(), access_flags);
+    if (kUsePortableCompiler) {
+      access_flags &= ~kAccCriticalNative;
+    }
+    SetAccessFlags(access_flags);
   }
   SetNativeMethod(native_method);
 }
 
 void ArtMethod::UnregisterNative(Thread* self) {
-  CHECK(IsNative() && !IsFastNative()) << PrettyMethod(this);
+  CHECK(IsNative()) << PrettyMethod(this);
   // restore stub to lookup native pointer via dlsym
   RegisterNative(self, GetJniDlsymLookupStub(), false);
 }
@@ -131,6 +131,13 @@ class MANAGED ArtMethod FINAL : public Object {
     return (GetAccessFlags() & mask) == mask;
   }
 
+  // A critical native is called without JNIEnv*, jclass or thread state transition, see
+  // DexFile::GetNativeMethodAnnotationAccessFlags.
+  bool IsCriticalNative() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    uint32_t mask = kAccCriticalNative | kAccNative;
+    return (GetAccessFlags() & mask) == mask;
+  }
+
   bool IsAbstract() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     return (GetAccessFlags() & kAccAbstract) != 0;
   }
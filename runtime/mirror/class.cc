@@ -147,6 +147,15 @@ void Class::SetStatus(Status new_status, Thread* self) {
   }
 }
 
+void Class::SetBiasDisabled() {
+  // Any thread revoking a bias may get here, don't lose a concurrent update of the flags.
+  int32_t flags;
+  do {
+    flags = GetField32(AccessFlagsOffset());
+  } while (!CasFieldWeakSequentiallyConsistent32<false>(
+      AccessFlagsOffset(), flags, static_cast<int32_t>(flags | kAccClassIsBiasDisabled)));
+}
+
 void Class::SetDexCache(DexCache* new_dex_cache) {
   SetFieldObject<false>(OFFSET_OF_OBJECT_MEMBER(Class, dex_cache_), new_dex_cache);
 }
@@ -243,6 +243,17 @@ class MANAGED Class FINAL : public Object {
     SetAccessFlags(flags | kAccClassIsFinalizable);
   }
 
+  // Returns true if instances of the class are thin locked rather than biased, see Monitor.
+  bool IsBiasDisabled() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return (GetAccessFlags() & kAccClassIsBiasDisabled) != 0;
+  }
+
+  void SetBiasDisabled() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static MemberOffset AccessFlagsOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(Class, access_flags_);
+  }
+
   // Returns true if the class is abstract.
   bool IsAbstract() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     return (GetAccessFlags() & kAccAbstract) != 0;
@@ -172,6 +172,17 @@ int32_t Object::IdentityHashCode() const {
         current_this = h_this.Get();
         break;
       }
+      case LockWord::kBiased: {
+        // Revoke the bias, installing the hash code in the lock word if nobody holds the lock or
+        // else in the monitor it is inflated to. May fail spuriously.
+        Thread* self = Thread::Current();
+        StackHandleScope<1> hs(self);
+        Handle<mirror::Object> h_this(hs.NewHandle(current_this));
+        Monitor::RevokeBias(self, h_this, lw, GenerateIdentityHashCode());
+        // A GC may have occurred when we switched to kBlocked.
+        current_this = h_this.Get();
+        break;
+      }
       case LockWord::kFatLocked: {
         // Already inflated, return the has stored in the monitor.
         Monitor* monitor = lw.FatLockMonitor();
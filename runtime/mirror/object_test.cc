@@ -80,6 +80,8 @@ TEST_F(ObjectTest, AsmConstants) {
   EXPECT_EQ(LOCK_WORD_OFFSET, Object::MonitorOffset().Int32Value());
 
   EXPECT_EQ(CLASS_COMPONENT_TYPE_OFFSET, Class::ComponentTypeOffset().Int32Value());
+  EXPECT_EQ(CLASS_ACCESS_FLAGS_OFFSET, Class::AccessFlagsOffset().Int32Value());
+  EXPECT_EQ(static_cast<uint32_t>(ACCESS_FLAGS_CLASS_IS_BIAS_DISABLED), kAccClassIsBiasDisabled);
 
   EXPECT_EQ(ARRAY_LENGTH_OFFSET, Array::LengthOffset().Int32Value());
   EXPECT_EQ(OBJECT_ARRAY_DATA_OFFSET, Array::DataOffset(sizeof(HeapReference<Object>)).Int32Value());
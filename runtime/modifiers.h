@@ -48,12 +48,15 @@ static constexpr uint32_t kAccPreverified =          0x00080000;  // class (runt
 static constexpr uint32_t kAccFastNative =           0x00080000;  // method (dex only)
 static constexpr uint32_t kAccPortableCompiled =     0x00100000;  // method (dex only)
 static constexpr uint32_t kAccMiranda =              0x00200000;  // method (dex only)
+static constexpr uint32_t kAccCriticalNative =       0x00400000;  // method (dex only)
 
 // Special runtime-only flags.
 // Note: if only kAccClassIsReference is set, we have a soft reference.
 
 // class/ancestor overrides finalize()
 static constexpr uint32_t kAccClassIsFinalizable        = 0x80000000;
+// locking an instance of the class takes a thin lock rather than a biased one
+static constexpr uint32_t kAccClassIsBiasDisabled       = 0x40000000;
 // class is a soft/weak/phantom ref
 static constexpr uint32_t kAccClassIsReference          = 0x08000000;
 // class is a weak reference
@@ -23,6 +23,7 @@
 #include "class_linker.h"
 #include "dex_file-inl.h"
 #include "dex_instruction.h"
+#include "lock_contention_profiler.h"
 #include "lock_word-inl.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/class-inl.h"
@@ -51,6 +52,15 @@ static constexpr uint64_t kLongWaitMs = 100;
  * from the "thin" state to the "fat" state and this transition is referred to as inflation. Once
  * a lock has been inflated it remains in the "fat" state indefinitely.
  *
+ * An unlocked object is first locked in the "biased" state, which reserves the lock for the
+ * locking thread (see Kawachiya et al.'s "Lock Reservation: Java Locks Can Mostly Do Without
+ * Atomic Operations", OOPSLA 2002). The bias owner then acquires and releases the lock with plain
+ * stores to the lock word. Any other thread wanting the lock, or an identity hash code, revokes the
+ * bias by suspending the owner and inflating the lock, so a biased lock is never contended.
+ * Revocations by other threads are counted per class. Once a class reaches
+ * MonitorList::kBiasRevocationThreshold of them, it is marked so that its instances are thin
+ * locked from then on.
+ *
  * The lock value itself is stored in mirror::Object::monitor_ and the representation is described
  * in the LockWord value type.
  *
@@ -67,6 +77,9 @@ static constexpr uint64_t kLongWaitMs = 100;
 
 bool (*Monitor::is_sensitive_thread_hook_)() = NULL;
 uint32_t Monitor::lock_profiling_threshold_ = 0;
+Atomic<uint32_t> Monitor::bias_revocations_(0);
+Atomic<uint32_t> Monitor::bias_self_revocations_(0);
+Atomic<uint64_t> Monitor::bias_revocation_time_ns_(0);
 
 bool Monitor::IsSensitiveThread() {
   if (is_sensitive_thread_hook_ != NULL) {
@@ -145,6 +158,16 @@ bool Monitor::Install(Thread* self) {
       lock_count_ = lw.ThinLockCount();
       break;
     }
+    case LockWord::kBiased: {
+      if (lw.BiasLockCount() != 0) {
+        CHECK_EQ(owner_->GetThreadId(), lw.BiasOwner());
+        lock_count_ = lw.BiasLockCount() - 1;
+      } else {
+        // The bias owner doesn't hold the lock, inflate to an unowned monitor.
+        CHECK(owner_ == nullptr);
+      }
+      break;
+    }
     case LockWord::kHashCode: {
       CHECK_EQ(hash_code_.LoadRelaxed(), static_cast<int32_t>(lw.GetHashCode()));
       break;
@@ -166,7 +189,8 @@ bool Monitor::Install(Thread* self) {
   // Publish the updated lock word, which may race with other threads.
   bool success = GetObject()->CasLockWordWeakSequentiallyConsistent(lw, fat);
   // Lock profiling.
-  if (success && owner_ != nullptr && lock_profiling_threshold_ != 0) {
+  if (success && owner_ != nullptr &&
+      (lock_profiling_threshold_ != 0 || LockContentionProfiler::IsEnabled())) {
     // Do not abort on dex pc errors. This can easily happen when we want to dump a stack trace on
     // abort.
     locking_method_ = owner_->GetCurrentMethod(&locking_dex_pc_, false);
@@ -238,7 +262,7 @@ void Monitor::Lock(Thread* self) {
       CHECK_EQ(lock_count_, 0);
       // When debugging, save the current monitor holder for future
       // acquisition failures to use in sampled logging.
-      if (lock_profiling_threshold_ != 0) {
+      if (lock_profiling_threshold_ != 0 || LockContentionProfiler::IsEnabled()) {
         locking_method_ = self->GetCurrentMethod(&locking_dex_pc_);
       }
       return;
@@ -249,6 +273,10 @@ void Monitor::Lock(Thread* self) {
     // Contended.
     const bool log_contention = (lock_profiling_threshold_ != 0);
     uint64_t wait_start_ms = log_contention ? MilliTime() : 0;
+    const bool profile_contention = LockContentionProfiler::IsEnabled();
+    uint64_t wait_start_ns = profile_contention ? NanoTime() : 0;
+    bool waited = false;
+    uint32_t owners_thread_id = owner_->GetThreadId();
     mirror::ArtMethod* owners_method = locking_method_;
     uint32_t owners_dex_pc = locking_dex_pc_;
     // Do this before releasing the lock so that we don't get deflated.
@@ -261,6 +289,7 @@ void Monitor::Lock(Thread* self) {
       MutexLock mu2(self, monitor_lock_);  // Reacquire monitor_lock_ without mutator_lock_ for Wait.
       if (owner_ != NULL) {  // Did the owner_ give the lock up?
         monitor_contenders_.Wait(self);  // Still contended so wait.
+        waited = true;
         // Woken from contention.
         if (log_contention) {
           uint64_t wait_ms = MilliTime() - wait_start_ms;
@@ -286,6 +315,13 @@ void Monitor::Lock(Thread* self) {
       }
     }
     self->SetMonitorEnterObject(nullptr);
+    if (profile_contention && waited) {
+      // Record now that we are runnable again and may walk our stack.
+      LockContentionProfiler::RecordMonitorContention(self, GetObject()->GetClass(),
+                                                      owners_thread_id, owners_method,
+                                                      owners_dex_pc,
+                                                      NanoTime() - wait_start_ns);
+    }
     monitor_lock_.Lock(self);  // Reacquire locks in order.
     --num_waiters_;
   }
@@ -704,6 +740,84 @@ void Monitor::InflateThinLocked(Thread* self, Handle<mirror::Object> obj, LockWo
   }
 }
 
+void Monitor::RevokeBias(Thread* self, Handle<mirror::Object> obj, LockWord lock_word,
+                         uint32_t hash_code) {
+  DCHECK_EQ(lock_word.GetState(), LockWord::kBiased);
+  uint64_t start_time = NanoTime();
+  uint32_t owner_thread_id = lock_word.BiasOwner();
+  LockWord revoked = hash_code != 0 ? LockWord::FromHashCode(hash_code) : LockWord();
+  if (owner_thread_id == self->GetThreadId()) {
+    // Only we write a lock word biased towards us, so there is no need to reach a safepoint.
+    if (lock_word.BiasLockCount() != 0) {
+      Inflate(self, self, obj.Get(), hash_code);
+    } else {
+      // We don't hold the lock, there is nothing to inflate. May fail spuriously.
+      obj->CasLockWordWeakSequentiallyConsistent(lock_word, revoked);
+    }
+    bias_self_revocations_.FetchAndAddSequentiallyConsistent(1);
+  } else {
+    ThreadList* thread_list = Runtime::Current()->GetThreadList();
+    if (lock_word.BiasLockCount() == 0 &&
+        thread_list->ReplaceLockWordOfExitedThread(self, obj.Get(), lock_word, revoked)) {
+      // The bias owner has exited without holding the lock, no need to suspend anybody.
+      VLOG(monitor) << "monitor: revoked bias of exited thread " << owner_thread_id
+          << " for object " << obj.Get();
+    } else {
+      // Bring the owner to a safepoint by suspending it, then inflate. First change to blocked
+      // and give up mutator_lock_.
+      self->SetMonitorEnterObject(obj.Get());
+      bool timed_out;
+      Thread* owner;
+      {
+        ScopedThreadStateChange tsc(self, kBlocked);
+        // Take suspend thread lock to avoid races with threads trying to suspend this one.
+        MutexLock mu(self, *Locks::thread_list_suspend_thread_lock_);
+        owner = thread_list->SuspendThreadByThreadId(owner_thread_id, false, &timed_out);
+      }
+      if (owner != nullptr) {
+        // The owner can't write the lock word while suspended, check the bias didn't change.
+        lock_word = obj->GetLockWord(true);
+        if (lock_word.GetState() == LockWord::kBiased &&
+            lock_word.BiasOwner() == owner_thread_id) {
+          Inflate(self, lock_word.BiasLockCount() != 0 ? owner : nullptr, obj.Get(), hash_code);
+          VLOG(monitor) << "monitor: revoked bias of thread " << owner_thread_id
+              << " for object " << obj.Get();
+        }
+        thread_list->Resume(owner, false);
+      } else if (!timed_out) {
+        // The owner has left the thread list, its thread id isn't released yet. It released its
+        // locks in Thread::Destroy and no longer writes lock words, clear the bias directly rather
+        // than retry until the id is released. May fail spuriously.
+        if (obj->CasLockWordWeakSequentiallyConsistent(lock_word, revoked)) {
+          VLOG(monitor) << "monitor: revoked bias of exiting thread " << owner_thread_id
+              << " for object " << obj.Get();
+        }
+      }
+      self->SetMonitorEnterObject(nullptr);
+    }
+    mirror::Class* klass = obj->GetClass();
+    if (!klass->IsBiasDisabled() &&
+        Runtime::Current()->GetMonitorList()->AddBiasRevocation(self, klass)) {
+      klass->SetBiasDisabled();
+      VLOG(monitor) << "monitor: disabled biased locking for " << PrettyClass(klass);
+    }
+  }
+  bias_revocations_.FetchAndAddSequentiallyConsistent(1);
+  bias_revocation_time_ns_.FetchAndAddSequentiallyConsistent(NanoTime() - start_time);
+}
+
+void Monitor::DumpBiasedLockingStats(std::ostream& os) {
+  uint32_t revocations = bias_revocations_.LoadRelaxed();
+  uint64_t revocation_time_ns = bias_revocation_time_ns_.LoadRelaxed();
+  os << "Biased lock revocations: " << revocations
+     << " (" << bias_self_revocations_.LoadRelaxed() << " by the bias owner)"
+     << " total time: " << PrettyDuration(revocation_time_ns);
+  if (revocations != 0) {
+    os << " mean time: " << PrettyDuration(revocation_time_ns / revocations);
+  }
+  os << "\n";
+}
+
 // Fool annotalysis into thinking that the lock on obj is acquired.
 static mirror::Object* FakeLock(mirror::Object* obj)
     EXCLUSIVE_LOCK_FUNCTION(obj) NO_THREAD_SAFETY_ANALYSIS {
@@ -728,13 +842,31 @@ mirror::Object* Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
     LockWord lock_word = h_obj->GetLockWord(true);
     switch (lock_word.GetState()) {
       case LockWord::kUnlocked: {
-        LockWord thin_locked(LockWord::FromThinLockId(thread_id, 0));
-        if (h_obj->CasLockWordWeakSequentiallyConsistent(lock_word, thin_locked)) {
+        // Reserve the lock for this thread, later acquisitions won't need an atomic operation,
+        // unless instances of the class are shared between threads too often.
+        LockWord locked(h_obj->GetClass()->IsBiasDisabled() ?
+                        LockWord::FromThinLockId(thread_id, 0) :
+                        LockWord::FromBiasedLockId(thread_id, 1));
+        if (h_obj->CasLockWordWeakSequentiallyConsistent(lock_word, locked)) {
           // CasLockWord enforces more than the acquire ordering we need here.
           return h_obj.Get();  // Success!
         }
         continue;  // Go again.
       }
+      case LockWord::kBiased: {
+        if (lock_word.BiasOwner() == thread_id) {
+          uint32_t new_count = lock_word.BiasLockCount() + 1;
+          if (LIKELY(new_count <= LockWord::kThinLockMaxCount)) {
+            // Other threads only modify the lock word once they have suspended us, a plain store
+            // suffices.
+            h_obj->SetLockWord(LockWord::FromBiasedLockId(thread_id, new_count), false);
+            return h_obj.Get();  // Success!
+          }
+        }
+        // Another thread holds the bias or we'd overflow the hold count, revoke and inflate.
+        RevokeBias(self, h_obj, lock_word, 0);
+        continue;  // Start from the beginning.
+      }
       case LockWord::kThinLocked: {
         uint32_t owner_thread_id = lock_word.ThinLockOwner();
         if (owner_thread_id == thread_id) {
@@ -816,6 +948,25 @@ bool Monitor::MonitorExit(Thread* self, mirror::Object* obj) {
         return true;  // Success!
       }
     }
+    case LockWord::kBiased: {
+      uint32_t thread_id = self->GetThreadId();
+      uint32_t owner_thread_id = lock_word.BiasOwner();
+      if (lock_word.BiasLockCount() == 0) {
+        // Reserved but not held by anybody.
+        FailedUnlock(h_obj.Get(), self, nullptr, nullptr);
+        return false;  // Failure.
+      } else if (owner_thread_id != thread_id) {
+        Thread* owner =
+            Runtime::Current()->GetThreadList()->FindThreadByThreadId(owner_thread_id);
+        FailedUnlock(h_obj.Get(), self, owner, nullptr);
+        return false;  // Failure.
+      } else {
+        // We hold the lock, decrease the hold count keeping the bias.
+        LockWord biased(LockWord::FromBiasedLockId(thread_id, lock_word.BiasLockCount() - 1));
+        h_obj->SetLockWord(biased, false);
+        return true;  // Success!
+      }
+    }
     case LockWord::kFatLocked: {
       Monitor* mon = lock_word.FatLockMonitor();
       return mon->Unlock(self);
@@ -856,6 +1007,21 @@ void Monitor::Wait(Thread* self, mirror::Object *obj, int64_t ms, int32_t ns,
         }
         break;
       }
+      case LockWord::kBiased: {
+        if (lock_word.BiasOwner() != self->GetThreadId() || lock_word.BiasLockCount() == 0) {
+          ThrowIllegalMonitorStateExceptionF("object not locked by thread before wait()");
+          return;  // Failure.
+        } else {
+          // We hold the lock, revoke our own bias to enqueue ourself on the Monitor. May fail
+          // spuriously so re-load.
+          StackHandleScope<1> hs(self);
+          Handle<mirror::Object> h_obj(hs.NewHandle(obj));
+          RevokeBias(self, h_obj, lock_word, 0);
+          obj = h_obj.Get();
+          lock_word = obj->GetLockWord(true);
+        }
+        break;
+      }
       case LockWord::kFatLocked:  // Unreachable given the loop condition above. Fall-through.
       default: {
         LOG(FATAL) << "Invalid monitor state " << lock_word.GetState();
@@ -888,6 +1054,15 @@ void Monitor::DoNotify(Thread* self, mirror::Object* obj, bool notify_all) {
         return;  // Success.
       }
     }
+    case LockWord::kBiased: {
+      if (lock_word.BiasOwner() != self->GetThreadId() || lock_word.BiasLockCount() == 0) {
+        ThrowIllegalMonitorStateExceptionF("object not locked by thread before notify()");
+        return;  // Failure.
+      } else {
+        // We hold the lock but there's no Monitor and therefore no waiters.
+        return;  // Success.
+      }
+    }
     case LockWord::kFatLocked: {
       Monitor* mon = lock_word.FatLockMonitor();
       if (notify_all) {
@@ -914,6 +1089,8 @@ uint32_t Monitor::GetLockOwnerThreadId(mirror::Object* obj) {
       return ThreadList::kInvalidThreadId;
     case LockWord::kThinLocked:
       return lock_word.ThinLockOwner();
+    case LockWord::kBiased:
+      return lock_word.BiasLockCount() != 0 ? lock_word.BiasOwner() : ThreadList::kInvalidThreadId;
     case LockWord::kFatLocked: {
       Monitor* mon = lock_word.FatLockMonitor();
       return mon->GetOwnerThreadId();
@@ -951,7 +1128,8 @@ void Monitor::DescribeWait(std::ostream& os, const Thread* thread) {
     if (pretty_object == nullptr) {
       os << wait_message << "an unknown object";
     } else {
-      if ((pretty_object->GetLockWord(true).GetState() == LockWord::kThinLocked) &&
+      LockWord::LockState lock_state = pretty_object->GetLockWord(true).GetState();
+      if ((lock_state == LockWord::kThinLocked || lock_state == LockWord::kBiased) &&
           Locks::mutator_lock_->IsExclusiveHeld(Thread::Current())) {
         // Getting the identity hashcode here would result in lock inflation and suspension of the
         // current thread, which isn't safe if this is the only runnable thread.
@@ -1059,6 +1237,9 @@ bool Monitor::IsValidLockWord(LockWord lock_word) {
     case LockWord::kThinLocked:
       // Basic sanity check of owner.
       return lock_word.ThinLockOwner() != ThreadList::kInvalidThreadId;
+    case LockWord::kBiased:
+      // Basic sanity check of bias owner.
+      return lock_word.BiasOwner() != ThreadList::kInvalidThreadId;
     case LockWord::kFatLocked: {
       // Check the  monitor appears in the monitor list.
       Monitor* mon = lock_word.FatLockMonitor();
@@ -1165,6 +1346,32 @@ void MonitorList::SweepMonitorList(IsMarkedCallback* callback, void* arg) {
   }
 }
 
+bool MonitorList::AddBiasRevocation(Thread* self, mirror::Class* klass) {
+  MutexLock mu(self, monitor_list_lock_);
+  auto it = bias_revocations_.find(klass);
+  if (it == bias_revocations_.end()) {
+    it = bias_revocations_.Put(klass, 0);
+  }
+  if (++it->second < kBiasRevocationThreshold) {
+    return false;
+  }
+  // The class is marked by the caller, there is nothing left to count.
+  bias_revocations_.erase(it);
+  return true;
+}
+
+void MonitorList::SweepBiasRevocations(IsMarkedCallback* callback, void* arg) {
+  MutexLock mu(Thread::Current(), monitor_list_lock_);
+  SafeMap<mirror::Class*, uint32_t> swept;
+  for (const auto& entry : bias_revocations_) {
+    mirror::Object* new_klass = callback(entry.first, arg);
+    if (new_klass != nullptr) {
+      swept.Put(down_cast<mirror::Class*>(new_klass), entry.second);
+    }
+  }
+  bias_revocations_.swap(swept);
+}
+
 struct MonitorDeflateArgs {
   MonitorDeflateArgs() : self(Thread::Current()), deflate_count(0) {}
   Thread* const self;
@@ -1205,6 +1412,13 @@ MonitorInfo::MonitorInfo(mirror::Object* obj) : owner_(NULL), entry_count_(0) {
       entry_count_ = 1 + lock_word.ThinLockCount();
       // Thin locks have no waiters.
       break;
+    case LockWord::kBiased:
+      if (lock_word.BiasLockCount() != 0) {
+        owner_ = Runtime::Current()->GetThreadList()->FindThreadByThreadId(lock_word.BiasOwner());
+        entry_count_ = lock_word.BiasLockCount();
+      }
+      // Biased locks have no waiters.
+      break;
     case LockWord::kFatLocked: {
       Monitor* mon = lock_word.FatLockMonitor();
       owner_ = mon->owner_;
@@ -30,6 +30,7 @@
 #include "gc_root.h"
 #include "object_callbacks.h"
 #include "read_barrier_option.h"
+#include "safe_map.h"
 #include "thread_state.h"
 
 namespace art {
@@ -42,6 +43,7 @@ typedef uint32_t MonitorId;
 
 namespace mirror {
   class ArtMethod;
+  class Class;
   class Object;
 }  // namespace mirror
 
@@ -124,6 +126,17 @@ class Monitor {
   static void InflateThinLocked(Thread* self, Handle<mirror::Object> obj, LockWord lock_word,
                                 uint32_t hash_code) NO_THREAD_SAFETY_ANALYSIS;
 
+  // Revoke the bias of a biased lock on obj, inflating it so that it never becomes biased again
+  // while the monitor lives. The bias owner, if it isn't the calling thread, is brought to a
+  // safepoint by suspending it through the thread list. A lock not held by the calling thread or
+  // an exited owner is not inflated, its lock word is replaced by hash_code or an unlocked word.
+  // May fail for spurious reasons, always re-check.
+  static void RevokeBias(Thread* self, Handle<mirror::Object> obj, LockWord lock_word,
+                         uint32_t hash_code) NO_THREAD_SAFETY_ANALYSIS;
+
+  // Dump how often and for how long biased locks have been revoked.
+  static void DumpBiasedLockingStats(std::ostream& os);
+
   static bool Deflate(Thread* self, mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -192,6 +205,11 @@ class Monitor {
   static bool (*is_sensitive_thread_hook_)();
   static uint32_t lock_profiling_threshold_;
 
+  // Biased locking statistics, see DumpBiasedLockingStats.
+  static Atomic<uint32_t> bias_revocations_;
+  static Atomic<uint32_t> bias_self_revocations_;
+  static Atomic<uint64_t> bias_revocation_time_ns_;
+
   Mutex monitor_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
 
   ConditionVariable monitor_contenders_ GUARDED_BY(monitor_lock_);
@@ -239,6 +257,10 @@ class Monitor {
 
 class MonitorList {
  public:
+  // Number of biases on instances of a class that other threads revoke before instances of the
+  // class are no longer biased.
+  static constexpr uint32_t kBiasRevocationThreshold = 40;
+
   MonitorList();
   ~MonitorList();
 
@@ -252,6 +274,13 @@ class MonitorList {
   size_t DeflateMonitors() LOCKS_EXCLUDED(monitor_list_lock_)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Count a bias on an instance of klass revoked by another thread than the bias owner. Returns
+  // true once the class reaches the threshold past which its instances shouldn't be biased.
+  bool AddBiasRevocation(Thread* self, mirror::Class* klass) LOCKS_EXCLUDED(monitor_list_lock_);
+  // Update the classes of the revocation counts after they moved or were unloaded.
+  void SweepBiasRevocations(IsMarkedCallback* callback, void* arg)
+      LOCKS_EXCLUDED(monitor_list_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   typedef std::list<Monitor*, TrackingAllocator<Monitor*, kAllocatorTagMonitorList>> Monitors;
 
  private:
@@ -263,6 +292,7 @@ class MonitorList {
   Mutex monitor_list_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   ConditionVariable monitor_add_condition_ GUARDED_BY(monitor_list_lock_);
   Monitors list_ GUARDED_BY(monitor_list_lock_);
+  SafeMap<mirror::Class*, uint32_t> bias_revocations_ GUARDED_BY(monitor_list_lock_);
 
   friend class Monitor;
   DISALLOW_COPY_AND_ASSIGN(MonitorList);
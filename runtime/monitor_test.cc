@@ -23,6 +23,7 @@
 #include "common_runtime_test.h"
 #include "handle_scope-inl.h"
 #include "mirror/class-inl.h"
+#include "mirror/object_array-inl.h"
 #include "mirror/string-inl.h"  // Strings are easiest to allocate
 #include "scoped_thread_state_change.h"
 #include "thread_pool.h"
@@ -116,13 +117,13 @@ class CreateTask : public Task {
 
       monitor_test_->thread_ = self;        // Pass the Thread.
       monitor_test_->object_.Get()->MonitorEnter(self);     // Lock the object. This should transition
-      LockWord lock_after = monitor_test_->object_.Get()->GetLockWord(false);     // it to thinLocked.
+      LockWord lock_after = monitor_test_->object_.Get()->GetLockWord(false);     // it to biased.
       LockWord::LockState new_state = lock_after.GetState();
 
       // Cannot use ASSERT only, as analysis thinks we'll keep holding the mutex.
-      if (LockWord::LockState::kThinLocked != new_state) {
-        monitor_test_->object_.Get()->MonitorExit(self);         // To appease analysis.
-        ASSERT_EQ(LockWord::LockState::kThinLocked, new_state);  // To fail the test.
+      if (LockWord::LockState::kBiased != new_state) {
+        monitor_test_->object_.Get()->MonitorExit(self);     // To appease analysis.
+        ASSERT_EQ(LockWord::LockState::kBiased, new_state);  // To fail the test.
         return;
       }
 
@@ -378,4 +379,51 @@ TEST_F(MonitorTest, CheckExceptionsWait3) {
                   "Monitor test thread pool 3");
 }
 
+TEST_F(MonitorTest, BiasDisabledPastRevocationThreshold) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<3> hs(self);
+  Handle<mirror::Class> klass(hs.NewHandle(
+      class_linker_->FindSystemClass(self, "[Ljava/lang/Object;")));
+  ASSERT_FALSE(klass->IsBiasDisabled());
+  MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+  for (uint32_t i = 1; i < MonitorList::kBiasRevocationThreshold; ++i) {
+    EXPECT_FALSE(monitor_list->AddBiasRevocation(self, klass.Get()));
+  }
+  EXPECT_TRUE(monitor_list->AddBiasRevocation(self, klass.Get()));
+
+  // Other classes are still biased.
+  Handle<mirror::String> string(hs.NewHandle(mirror::String::AllocFromModifiedUtf8(self, "s")));
+  string->MonitorEnter(self);
+  EXPECT_EQ(LockWord::kBiased, string->GetLockWord(false).GetState());
+  string->MonitorExit(self);
+
+  klass->SetBiasDisabled();
+  EXPECT_TRUE(klass->IsBiasDisabled());
+  Handle<mirror::ObjectArray<mirror::Object>> array(hs.NewHandle(
+      mirror::ObjectArray<mirror::Object>::Alloc(self, klass.Get(), 1)));
+  ASSERT_TRUE(array.Get() != nullptr);
+  array->MonitorEnter(self);
+  EXPECT_EQ(LockWord::kThinLocked, array->GetLockWord(false).GetState());
+  array->MonitorExit(self);
+  EXPECT_EQ(LockWord::kUnlocked, array->GetLockWord(false).GetState());
+}
+
+TEST_F(MonitorTest, HashCodeOfUnlockedBiasedObject) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<1> hs(self);
+  Handle<mirror::String> string(hs.NewHandle(mirror::String::AllocFromModifiedUtf8(self, "s")));
+  string->MonitorEnter(self);
+  string->MonitorExit(self);
+  ASSERT_EQ(LockWord::kBiased, string->GetLockWord(false).GetState());
+
+  // Our own bias on a lock nobody holds is revoked in place, without inflating.
+  int32_t hash_code = string->IdentityHashCode();
+  LockWord lock_word = string->GetLockWord(false);
+  ASSERT_EQ(LockWord::kHashCode, lock_word.GetState());
+  EXPECT_EQ(hash_code, lock_word.GetHashCode());
+  EXPECT_EQ(hash_code, string->IdentityHashCode());
+}
+
 }  // namespace art
@@ -17,8 +17,13 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <sstream>
+#include <vector>
+
+#include "base/stringprintf.h"
 #include "class_linker.h"
 #include "common_throws.h"
+#include "cpu_sampling_profiler.h"
 #include "debugger.h"
 #include "gc/space/bump_pointer_space.h"
 #include "gc/space/dlmalloc_space.h"
@@ -27,7 +32,10 @@
 #include "gc/space/zygote_space.h"
 #include "hprof/hprof.h"
 #include "jni_internal.h"
+#include "lock_contention_profiler.h"
+#include "mirror/array-inl.h"
 #include "mirror/class.h"
+#include "mirror/object_array-inl.h"
 #include "ScopedLocalRef.h"
 #include "ScopedUtfChars.h"
 #include "scoped_fast_native_object_access.h"
@@ -43,6 +51,10 @@ static jobjectArray VMDebug_getVmFeatureList(JNIEnv* env, jclass) {
     "method-sample-profiling",
     "hprof-heap-dump",
     "hprof-heap-dump-streaming",
+    "class-histogram",
+    "gc-telemetry",
+    "lock-contention-profiling",
+    "cpu-sampling-profiling",
   };
   jobjectArray result = env->NewObjectArray(arraysize(features),
                                             WellKnownClasses::java_lang_String,
@@ -75,9 +87,16 @@ static void VMDebug_resetAllocCount(JNIEnv*, jclass, jint kinds) {
   Runtime::Current()->ResetStats(kinds);
 }
 
+// Traces to a file may be streamed, DDMS always gets a buffered trace.
+static TraceOutputMode GetTraceOutputMode(jint flags) {
+  return (flags & Trace::kTraceStreamingOutput) != 0 ? kTraceOutputModeStreaming
+                                                     : kTraceOutputModeBuffered;
+}
+
 static void VMDebug_startMethodTracingDdmsImpl(JNIEnv*, jclass, jint bufferSize, jint flags,
                                                jboolean samplingEnabled, jint intervalUs) {
-  Trace::Start("[DDMS]", -1, bufferSize, flags, true, samplingEnabled, intervalUs);
+  Trace::Start("[DDMS]", -1, bufferSize, flags, true, samplingEnabled, intervalUs,
+               kTraceOutputModeBuffered);
 }
 
 static void VMDebug_startMethodTracingFd(JNIEnv* env, jclass, jstring javaTraceFilename,
@@ -101,7 +120,8 @@ static void VMDebug_startMethodTracingFd(JNIEnv* env, jclass, jstring javaTraceF
   if (traceFilename.c_str() == NULL) {
     return;
   }
-  Trace::Start(traceFilename.c_str(), fd, bufferSize, flags, false, samplingEnabled, intervalUs);
+  Trace::Start(traceFilename.c_str(), fd, bufferSize, flags, false, samplingEnabled, intervalUs,
+               GetTraceOutputMode(flags));
 }
 
 static void VMDebug_startMethodTracingFilename(JNIEnv* env, jclass, jstring javaTraceFilename,
@@ -111,7 +131,8 @@ static void VMDebug_startMethodTracingFilename(JNIEnv* env, jclass, jstring java
   if (traceFilename.c_str() == NULL) {
     return;
   }
-  Trace::Start(traceFilename.c_str(), -1, bufferSize, flags, false, samplingEnabled, intervalUs);
+  Trace::Start(traceFilename.c_str(), -1, bufferSize, flags, false, samplingEnabled, intervalUs,
+               GetTraceOutputMode(flags));
 }
 
 static jint VMDebug_getMethodTracingMode(JNIEnv*, jclass) {
@@ -262,6 +283,144 @@ static jlong VMDebug_countInstancesOfClass(JNIEnv* env, jclass, jclass javaClass
   return count;
 }
 
+// Counts the instances of all of the classes in a single walk of the heap, rather than one walk
+// per class. Null classes have no instances.
+static jlongArray VMDebug_countInstancesOfClasses(JNIEnv* env, jclass, jobjectArray javaClasses,
+                                                  jboolean countAssignable) {
+  ScopedObjectAccess soa(env);
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  // We only want reachable instances, so do a GC.
+  heap->CollectGarbage(false);
+  mirror::ObjectArray<mirror::Class>* decoded_classes =
+      soa.Decode<mirror::ObjectArray<mirror::Class>*>(javaClasses);
+  if (decoded_classes == nullptr) {
+    ThrowNullPointerException(nullptr, "classes == null");
+    return nullptr;
+  }
+  std::vector<mirror::Class*> classes;
+  std::vector<size_t> indices;
+  for (int32_t i = 0; i < decoded_classes->GetLength(); ++i) {
+    mirror::Class* c = decoded_classes->Get(i);
+    if (c != nullptr) {
+      classes.push_back(c);
+      indices.push_back(i);
+    }
+  }
+  std::vector<uint64_t> counts(classes.size(), 0);
+  heap->CountInstances(classes, countAssignable, counts.data());
+  // The allocation may move the classes.
+  int32_t length = decoded_classes->GetLength();
+  mirror::LongArray* long_counts = mirror::LongArray::Alloc(soa.Self(), length);
+  if (long_counts == nullptr) {
+    DCHECK(soa.Self()->IsExceptionPending());
+    return nullptr;
+  }
+  for (size_t i = 0; i < counts.size(); ++i) {
+    long_counts->Set(indices[i], counts[i]);
+  }
+  return soa.AddLocalReference<jlongArray>(long_counts);
+}
+
+static void VMDebug_dumpClassHistogram(JNIEnv* env, jclass, jint maxClasses) {
+  ScopedObjectAccess soa(env);
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  // Only count reachable instances.
+  heap->CollectGarbage(false);
+  LOG(INFO) << "--- class histogram dump ---";
+  std::ostringstream os;
+  heap->DumpClassHistogram(os, maxClasses < 0 ? 0 : maxClasses);
+  LOG(INFO) << os.str();
+  LOG(INFO) << "---";
+}
+
+// Returns the records of the collections after the one with the given id that are still kept,
+// one line per collection. Pass the last id seen to only get the new collections.
+static jstring VMDebug_getGcTelemetry(JNIEnv* env, jclass, jlong afterId) {
+  std::vector<gc::GcTelemetryRecord> records;
+  Runtime::Current()->GetHeap()->GetGcTelemetry()->GetRecords(afterId < 0 ? 0 : afterId,
+                                                              &records);
+  std::ostringstream os;
+  for (const gc::GcTelemetryRecord& record : records) {
+    gc::GcTelemetry::DumpRecord(os, record);
+  }
+  return env->NewStringUTF(os.str().c_str());
+}
+
+static void VMDebug_startGcTelemetryStreaming(JNIEnv* env, jclass, jobject javaFd) {
+  int originalFd = jniGetFDFromFileDescriptor(env, javaFd);
+  if (originalFd < 0) {
+    ScopedObjectAccess soa(env);
+    ThrowRuntimeException("Invalid file descriptor");
+    return;
+  }
+
+  int fd = dup(originalFd);
+  if (fd < 0) {
+    ScopedObjectAccess soa(env);
+    ThrowLocation throw_location = soa.Self()->GetCurrentLocationForThrow();
+    soa.Self()->ThrowNewExceptionF(throw_location, "Ljava/lang/RuntimeException;",
+                                   "dup(%d) failed: %s", originalFd, strerror(errno));
+    return;
+  }
+  Runtime::Current()->GetHeap()->GetGcTelemetry()->StartStreaming(fd);
+}
+
+static void VMDebug_stopGcTelemetryStreaming(JNIEnv*, jclass) {
+  Runtime::Current()->GetHeap()->GetGcTelemetry()->StopStreaming();
+}
+
+static void VMDebug_startLockContentionProfiling(JNIEnv* env, jclass, jint sampleInterval) {
+  if (sampleInterval <= 0) {
+    ScopedObjectAccess soa(env);
+    std::string msg(StringPrintf("Invalid sample interval %d", sampleInterval));
+    ThrowIllegalArgumentException(nullptr, msg.c_str());
+    return;
+  }
+  LockContentionProfiler::Start(sampleInterval, "");
+}
+
+static void VMDebug_stopLockContentionProfiling(JNIEnv*, jclass) {
+  LockContentionProfiler::Stop();
+}
+
+// Returns the report of the contention sampled so far, ranked by total wait time.
+static jstring VMDebug_getLockContentionProfile(JNIEnv* env, jclass) {
+  std::ostringstream os;
+  {
+    ScopedObjectAccess soa(env);
+    LockContentionProfiler::Dump(os);
+  }
+  return env->NewStringUTF(os.str().c_str());
+}
+
+static void VMDebug_startCpuSampling(JNIEnv* env, jclass, jint intervalUs) {
+  if (!CpuSamplingProfiler::kIsSupported) {
+    ThrowUnsupportedOperationException(env);
+    return;
+  }
+  if (intervalUs <= 0) {
+    ScopedObjectAccess soa(env);
+    std::string msg(StringPrintf("Invalid sampling interval %d", intervalUs));
+    ThrowIllegalArgumentException(nullptr, msg.c_str());
+    return;
+  }
+  CpuSamplingProfiler::Start(intervalUs, "");
+}
+
+static void VMDebug_stopCpuSampling(JNIEnv*, jclass) {
+  CpuSamplingProfiler::Stop();
+}
+
+// Returns the stacks sampled so far in the collapsed format of flame graph tools.
+static jstring VMDebug_getCpuSamplingProfile(JNIEnv* env, jclass) {
+  std::ostringstream os;
+  {
+    ScopedObjectAccess soa(env);
+    CpuSamplingProfiler::DumpCollapsedStacks(os);
+  }
+  return env->NewStringUTF(os.str().c_str());
+}
+
 // We export the VM internal per-heap-space size/alloc/free metrics
 // for the zygote space, alloc space (application heap), and the large
 // object space for dumpsys meminfo. The other memory region data such
@@ -355,8 +514,25 @@ static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(VMDebug, threadCpuTimeNanos, "!()J"),
 };
 
+// Natives of methods the class library may not declare yet, registered only where it does.
+static JNINativeMethod gOptionalMethods[] = {
+  NATIVE_METHOD(VMDebug, countInstancesOfClasses, "([Ljava/lang/Class;Z)[J"),
+  NATIVE_METHOD(VMDebug, dumpClassHistogram, "(I)V"),
+  NATIVE_METHOD(VMDebug, getCpuSamplingProfile, "()Ljava/lang/String;"),
+  NATIVE_METHOD(VMDebug, getGcTelemetry, "(J)Ljava/lang/String;"),
+  NATIVE_METHOD(VMDebug, getLockContentionProfile, "()Ljava/lang/String;"),
+  NATIVE_METHOD(VMDebug, startCpuSampling, "(I)V"),
+  NATIVE_METHOD(VMDebug, startGcTelemetryStreaming, "(Ljava/io/FileDescriptor;)V"),
+  NATIVE_METHOD(VMDebug, startLockContentionProfiling, "(I)V"),
+  NATIVE_METHOD(VMDebug, stopCpuSampling, "()V"),
+  NATIVE_METHOD(VMDebug, stopGcTelemetryStreaming, "()V"),
+  NATIVE_METHOD(VMDebug, stopLockContentionProfiling, "()V"),
+};
+
 void register_dalvik_system_VMDebug(JNIEnv* env) {
   REGISTER_NATIVE_METHODS("dalvik/system/VMDebug");
+  RegisterOptionalNativeMethods(env, "dalvik/system/VMDebug", gOptionalMethods,
+                                arraysize(gOptionalMethods));
 }
 
 }  // namespace art
@@ -23,7 +23,7 @@
 namespace art {
 
 const uint8_t OatHeader::kOatMagic[] = { 'o', 'a', 't', '\n' };
-const uint8_t OatHeader::kOatVersion[] = { '0', '3', '9', '\0' };
+const uint8_t OatHeader::kOatVersion[] = { '0', '4', '2', '\0' };
 
 static size_t ComputeOatHeaderSize(const SafeMap<std::string, std::string>* variable_data) {
   size_t estimate = 0U;
@@ -466,6 +466,11 @@ bool OatHeader::GetStoreKeyValuePairByIndex(size_t index, const char** key,
   return false;
 }
 
+bool OatHeader::HasMethodTraceHooks() const {
+  const char* value = GetStoreValueByKey(kMethodTraceHooksKey);
+  return value != nullptr && strcmp(value, "true") == 0;
+}
+
 size_t OatHeader::GetHeaderSize() const {
   return sizeof(OatHeader) + key_value_store_size_;
 }
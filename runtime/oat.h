@@ -35,6 +35,7 @@ class PACKED(4) OatHeader {
   static constexpr const char* kImageLocationKey = "image-location";
   static constexpr const char* kDex2OatCmdLineKey = "dex2oat-cmdline";
   static constexpr const char* kDex2OatHostKey = "dex2oat-host";
+  static constexpr const char* kMethodTraceHooksKey = "method-trace-hooks";
 
   static OatHeader* Create(InstructionSet instruction_set,
                            const InstructionSetFeatures& instruction_set_features,
@@ -101,6 +102,8 @@ class PACKED(4) OatHeader {
   const uint8_t* GetKeyValueStore() const;
   const char* GetStoreValueByKey(const char* key) const;
   bool GetStoreKeyValuePairByIndex(size_t index, const char** key, const char** value) const;
+  // Was the code compiled with method entry and exit hooks for method tracing?
+  bool HasMethodTraceHooks() const;
 
   size_t GetHeaderSize() const;
 
@@ -139,7 +139,7 @@ OatFile* OatFile::OpenElfFile(File* file,
 
 OatFile::OatFile(const std::string& location, bool is_executable)
     : location_(location), begin_(NULL), end_(NULL), is_executable_(is_executable),
-      dlopen_handle_(NULL),
+      has_method_trace_hooks_(false), dlopen_handle_(NULL),
       secondary_lookup_lock_("OatFile secondary lookup lock", kOatFileSecondaryLookupLock) {
   CHECK(!location_.empty());
 }
@@ -242,6 +242,7 @@ bool OatFile::Setup(std::string* error_msg) {
                               End());
     return false;
   }
+  has_method_trace_hooks_ = GetOatHeader().HasMethodTraceHooks();
 
   uint32_t dex_file_count = GetOatHeader().GetDexFileCount();
   oat_dex_files_storage_.reserve(dex_file_count);
@@ -84,6 +84,12 @@ class OatFile {
 
   const OatHeader& GetOatHeader() const;
 
+  // Was the code compiled with method entry and exit hooks for method tracing? Read from the
+  // header once the oat file is set up.
+  bool HasMethodTraceHooks() const {
+    return has_method_trace_hooks_;
+  }
+
   class OatDexFile;
 
   class OatMethod {
@@ -327,6 +333,8 @@ class OatFile {
   // Was this oat_file loaded executable?
   const bool is_executable_;
 
+  bool has_method_trace_hooks_;
+
   // Backing memory map for oat file during when opened by ElfWriter during initial compilation.
   std::unique_ptr<MemMap> mem_map_;
 
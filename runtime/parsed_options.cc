@@ -21,8 +21,10 @@
 #endif
 
 #include "base/stringpiece.h"
+#include "cpu_sampling_profiler.h"
 #include "debugger.h"
 #include "gc/heap.h"
+#include "jit/jit.h"
 #include "monitor.h"
 #include "runtime.h"
 #include "trace.h"
@@ -244,9 +246,19 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
   long_pause_log_threshold_ = gc::Heap::kDefaultLongPauseLogThreshold;
   long_gc_log_threshold_ = gc::Heap::kDefaultLongGCLogThreshold;
   dump_gc_performance_on_shutdown_ = false;
+  perf_counters_ = false;
+  dump_class_histogram_on_sigquit_ = false;
   ignore_max_footprint_ = false;
 
   lock_profiling_threshold_ = 0;
+  lock_contention_profile_ = false;
+  lock_contention_profile_interval_ = 1;
+  cpu_sample_profile_ = false;
+  cpu_sample_profile_interval_us_ = 10000;
+  interpreter_impl_kind_ = interpreter::kDefaultInterpreterImplKind;
+  use_jit_ = false;
+  jit_compile_threshold_ = jit::Jit::kDefaultCompileThreshold;
+  jit_code_cache_capacity_ = jit::JitCodeCache::kDefaultCapacity;
   hook_is_sensitive_thread_ = NULL;
 
   hook_vfprintf_ = vfprintf;
@@ -258,6 +270,7 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
 //  gLogVerbosity.gc = true;  // TODO: don't check this in!
 //  gLogVerbosity.heap = true;  // TODO: don't check this in!
 //  gLogVerbosity.jdwp = true;  // TODO: don't check this in!
+//  gLogVerbosity.jit = true;  // TODO: don't check this in!
 //  gLogVerbosity.jni = true;  // TODO: don't check this in!
 //  gLogVerbosity.monitor = true;  // TODO: don't check this in!
 //  gLogVerbosity.profiler = true;  // TODO: don't check this in!
@@ -270,6 +283,7 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
   method_trace_ = false;
   method_trace_file_ = "/data/method-trace-file.bin";
   method_trace_file_size_ = 10 * MB;
+  method_trace_stream_ = false;
 
   profile_clock_source_ = kDefaultTraceClockSource;
 
@@ -405,6 +419,10 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
       long_gc_log_threshold_ = MsToNs(value);
     } else if (option == "-XX:DumpGCPerformanceOnShutdown") {
       dump_gc_performance_on_shutdown_ = true;
+    } else if (option == "-XX:PerfCounters") {
+      perf_counters_ = true;
+    } else if (option == "-XX:DumpClassHistogramOnSigQuit") {
+      dump_class_histogram_on_sigquit_ = true;
     } else if (option == "-XX:IgnoreMaxFootprint") {
       ignore_max_footprint_ = true;
     } else if (option == "-XX:LowMemoryMode") {
@@ -450,6 +468,43 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
       image_dex2oat_enabled_ = true;
     } else if (option == "-Xint") {
       interpreter_only_ = true;
+    } else if (StartsWith(option, "-Xinterpreter-impl:")) {
+      std::string impl;
+      if (!ParseStringAfterChar(option, ':', &impl)) {
+        return false;
+      }
+      if (impl == "switch") {
+        interpreter_impl_kind_ = interpreter::kSwitchImpl;
+      } else if (impl == "goto") {
+        interpreter_impl_kind_ = interpreter::kComputedGotoImplKind;
+      } else if (impl == "mterp") {
+        interpreter_impl_kind_ = interpreter::kMterpImplKind;
+      } else {
+        Usage("Unknown -Xinterpreter-impl option %s\n", impl.c_str());
+        return false;
+      }
+    } else if (option == "-Xjit") {
+      use_jit_ = true;
+    } else if (StartsWith(option, "-Xjitthreshold:")) {
+      if (!ParseUnsignedInteger(option, ':', &jit_compile_threshold_)) {
+        return false;
+      }
+      if (jit_compile_threshold_ == 0 ||
+          jit_compile_threshold_ > jit::Jit::kMaxCompileThreshold) {
+        Usage("-Xjitthreshold must be between 1 and %zd\n", jit::Jit::kMaxCompileThreshold);
+        return false;
+      }
+    } else if (StartsWith(option, "-Xjitcodecachesize:")) {
+      unsigned int capacity_kb;
+      if (!ParseUnsignedInteger(option, ':', &capacity_kb)) {
+        return false;
+      }
+      if (capacity_kb == 0 || capacity_kb > jit::JitCodeCache::kMaxCapacity / KB) {
+        Usage("-Xjitcodecachesize must be between 1 and %zd\n",
+              jit::JitCodeCache::kMaxCapacity / KB);
+        return false;
+      }
+      jit_code_cache_capacity_ = capacity_kb * KB;
     } else if (StartsWith(option, "-Xgc:")) {
       if (!ParseXGcOption(option)) {
         return false;
@@ -487,6 +542,8 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
           gLogVerbosity.heap = true;
         } else if (verbose_options[i] == "jdwp") {
           gLogVerbosity.jdwp = true;
+        } else if (verbose_options[i] == "jit") {
+          gLogVerbosity.jit = true;
         } else if (verbose_options[i] == "jni") {
           gLogVerbosity.jni = true;
         } else if (verbose_options[i] == "monitor") {
@@ -515,6 +572,38 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
       if (!ParseUnsignedInteger(option, ':', &lock_profiling_threshold_)) {
         return false;
       }
+    } else if (option == "-Xlockcontentionprofile") {
+      lock_contention_profile_ = true;
+    } else if (StartsWith(option, "-Xlockcontentionprofile-interval:")) {
+      if (!ParseUnsignedInteger(option, ':', &lock_contention_profile_interval_)) {
+        return false;
+      }
+      if (lock_contention_profile_interval_ == 0) {
+        Usage("-Xlockcontentionprofile-interval must be at least 1\n");
+        return false;
+      }
+    } else if (StartsWith(option, "-Xlockcontentionprofile-file:")) {
+      if (!ParseStringAfterChar(option, ':', &lock_contention_profile_file_)) {
+        return false;
+      }
+    } else if (option == "-Xcpusampleprofile") {
+      if (!CpuSamplingProfiler::kIsSupported) {
+        Usage("-Xcpusampleprofile is not supported without per-thread CPU time clocks\n");
+        return false;
+      }
+      cpu_sample_profile_ = true;
+    } else if (StartsWith(option, "-Xcpusampleprofile-interval:")) {
+      if (!ParseUnsignedInteger(option, ':', &cpu_sample_profile_interval_us_)) {
+        return false;
+      }
+      if (cpu_sample_profile_interval_us_ == 0) {
+        Usage("-Xcpusampleprofile-interval must be at least 1\n");
+        return false;
+      }
+    } else if (StartsWith(option, "-Xcpusampleprofile-file:")) {
+      if (!ParseStringAfterChar(option, ':', &cpu_sample_profile_file_)) {
+        return false;
+      }
     } else if (StartsWith(option, "-Xstacktracefile:")) {
       if (!ParseStringAfterChar(option, ':', &stack_trace_file_)) {
         return false;
@@ -552,6 +641,8 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
       if (!ParseUnsignedInteger(option, ':', &method_trace_file_size_)) {
         return false;
       }
+    } else if (option == "-Xmethod-trace-stream") {
+      method_trace_stream_ = true;
     } else if (option == "-Xprofile:threadcpuclock") {
       Trace::SetDefaultClockSource(kTraceClockSourceThreadCpu);
     } else if (option == "-Xprofile:wallclock") {
@@ -654,8 +745,6 @@ bool ParsedOptions::Parse(const RuntimeOptions& options, bool ignore_unrecognize
                (option == "-Xincludeselectedop") ||
                StartsWith(option, "-Xjitop:") ||
                (option == "-Xincludeselectedmethod") ||
-               StartsWith(option, "-Xjitthreshold:") ||
-               StartsWith(option, "-Xjitcodecachesize:") ||
                (option == "-Xjitblocking") ||
                StartsWith(option, "-Xjitmethod:") ||
                StartsWith(option, "-Xjitclass:") ||
@@ -760,6 +849,10 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -XmxN (max heap, must be multiple of 1K, >= 2MB)\n");
   UsageMessage(stream, "  -XssN (stack size)\n");
   UsageMessage(stream, "  -Xint\n");
+  UsageMessage(stream, "  -Xinterpreter-impl:{switch,goto,mterp}\n");
+  UsageMessage(stream, "  -Xjit\n");
+  UsageMessage(stream, "  -Xjitthreshold:integervalue\n");
+  UsageMessage(stream, "  -Xjitcodecachesize:decimalvalueofkbytes\n");
   UsageMessage(stream, "\n");
 
   UsageMessage(stream, "The following Dalvik options are supported:\n");
@@ -791,12 +884,21 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -XX:LongPauseLogThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:LongGCLogThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:DumpGCPerformanceOnShutdown\n");
+  UsageMessage(stream, "  -XX:PerfCounters\n");
+  UsageMessage(stream, "  -XX:DumpClassHistogramOnSigQuit\n");
   UsageMessage(stream, "  -XX:IgnoreMaxFootprint\n");
   UsageMessage(stream, "  -XX:UseTLAB\n");
   UsageMessage(stream, "  -XX:BackgroundGC=none\n");
   UsageMessage(stream, "  -Xmethod-trace\n");
   UsageMessage(stream, "  -Xmethod-trace-file:filename");
   UsageMessage(stream, "  -Xmethod-trace-file-size:integervalue\n");
+  UsageMessage(stream, "  -Xmethod-trace-stream\n");
+  UsageMessage(stream, "  -Xlockcontentionprofile\n");
+  UsageMessage(stream, "  -Xlockcontentionprofile-interval:integervalue\n");
+  UsageMessage(stream, "  -Xlockcontentionprofile-file:filename\n");
+  UsageMessage(stream, "  -Xcpusampleprofile\n");
+  UsageMessage(stream, "  -Xcpusampleprofile-interval:integervalue (microseconds)\n");
+  UsageMessage(stream, "  -Xcpusampleprofile-file:filename\n");
   UsageMessage(stream, "  -Xenable-profiler\n");
   UsageMessage(stream, "  -Xprofile-filename:filename\n");
   UsageMessage(stream, "  -Xprofile-period:integervalue\n");
@@ -839,8 +941,6 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xincludeselectedop\n");
   UsageMessage(stream, "  -Xjitop:hexopvalue[-endvalue][,hexopvalue[-endvalue]]*\n");
   UsageMessage(stream, "  -Xincludeselectedmethod\n");
-  UsageMessage(stream, "  -Xjitthreshold:integervalue\n");
-  UsageMessage(stream, "  -Xjitcodecachesize:decimalvalueofkbytes\n");
   UsageMessage(stream, "  -Xjitblocking\n");
   UsageMessage(stream, "  -Xjitmethod:signature[,signature]* (eg Ljava/lang/String\\;replace)\n");
   UsageMessage(stream, "  -Xjitclass:classname[,classname]*\n");
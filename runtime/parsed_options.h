@@ -25,6 +25,7 @@
 #include "globals.h"
 #include "gc/collector_type.h"
 #include "instruction_set.h"
+#include "interpreter/interpreter.h"
 #include "profiler_options.h"
 
 namespace art {
@@ -53,6 +54,10 @@ class ParsedOptions {
   bool image_dex2oat_enabled_;
   std::string patchoat_executable_;
   bool interpreter_only_;
+  interpreter::InterpreterImplKind interpreter_impl_kind_;
+  bool use_jit_;
+  unsigned int jit_compile_threshold_;
+  size_t jit_code_cache_capacity_;
   bool is_explicit_gc_disabled_;
   bool use_tlab_;
   bool verify_pre_gc_heap_;
@@ -64,6 +69,8 @@ class ParsedOptions {
   unsigned int long_pause_log_threshold_;
   unsigned int long_gc_log_threshold_;
   bool dump_gc_performance_on_shutdown_;
+  bool perf_counters_;
+  bool dump_class_histogram_on_sigquit_;
   bool ignore_max_footprint_;
   size_t heap_initial_size_;
   size_t heap_maximum_size_;
@@ -81,10 +88,17 @@ class ParsedOptions {
   unsigned int max_spins_before_thin_lock_inflation_;
   bool low_memory_mode_;
   unsigned int lock_profiling_threshold_;
+  bool lock_contention_profile_;
+  unsigned int lock_contention_profile_interval_;
+  std::string lock_contention_profile_file_;
+  bool cpu_sample_profile_;
+  unsigned int cpu_sample_profile_interval_us_;
+  std::string cpu_sample_profile_file_;
   std::string stack_trace_file_;
   bool method_trace_;
   std::string method_trace_file_;
   unsigned int method_trace_file_size_;
+  bool method_trace_stream_;
   bool (*hook_is_sensitive_thread_)();
   jint (*hook_vfprintf_)(FILE* stream, const char* format, va_list ap);
   void (*hook_exit_)(jint status);
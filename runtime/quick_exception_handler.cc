@@ -16,7 +16,10 @@
 
 #include "quick_exception_handler.h"
 
+#include <vector>
+
 #include "arch/context.h"
+#include "class_linker.h"
 #include "dex_instruction.h"
 #include "entrypoints/entrypoint_utils.h"
 #include "handle_scope-inl.h"
@@ -76,10 +79,33 @@ class CatchBlockStackVisitor FINAL : public StackVisitor {
       return true;
     }
     StackHandleScope<1> hs(self_);
-    return HandleTryItems(hs.NewHandle(method));
+    if (!HandleTryItems(hs.NewHandle(method))) {
+      return false;
+    }
+    if (ReportsOwnExit(method)) {
+      unwound_hooked_methods_.push_back(method);
+    }
+    return true;
+  }
+
+  // Methods whose frames are unwound and have to report it for their method trace hooks,
+  // innermost first.
+  const std::vector<mirror::ArtMethod*>& GetUnwoundHookedMethods() const {
+    return unwound_hooked_methods_;
   }
 
  private:
+  // Does the frame run compiled code that reports its own method exit? Frames that return
+  // through an instrumentation exit stub are reported as that stub is popped. The pc of the frame
+  // tells which code runs, so oat code with hooks is told apart from bridges and JIT code without
+  // looking the method up in its oat file.
+  bool ReportsOwnExit(mirror::ArtMethod* method) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return self_->AreMethodTraceHooksEnabled() && !method->IsNative() &&
+        GetCurrentQuickFrame() != nullptr &&
+        GetReturnPc() != GetQuickInstrumentationExitPc() &&
+        Runtime::Current()->GetClassLinker()->IsMethodTraceHookCode(GetCurrentQuickFramePc());
+  }
+
   bool HandleTryItems(Handle<mirror::ArtMethod> method)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     uint32_t dex_pc = DexFile::kDexNoIndex;
@@ -109,6 +135,7 @@ class CatchBlockStackVisitor FINAL : public StackVisitor {
   Handle<mirror::Throwable>* exception_;
   // The quick exception handler we're visiting for.
   QuickExceptionHandler* const exception_handler_;
+  std::vector<mirror::ArtMethod*> unwound_hooked_methods_;
 
   DISALLOW_COPY_AND_ASSIGN(CatchBlockStackVisitor);
 };
@@ -129,6 +156,10 @@ void QuickExceptionHandler::FindCatch(const ThrowLocation& throw_location,
   // Walk the stack to find catch handler or prepare for deoptimization.
   CatchBlockStackVisitor visitor(self_, context_, &exception_ref, this);
   visitor.WalkStack(true);
+  instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
+  for (mirror::ArtMethod* method : visitor.GetUnwoundHookedMethods()) {
+    instrumentation->MethodUnwindEvent(self_, nullptr, method, 0);
+  }
 
   if (kDebugExceptionDelivery) {
     if (handler_quick_frame_->AsMirrorPtr() == nullptr) {
@@ -151,7 +182,6 @@ void QuickExceptionHandler::FindCatch(const ThrowLocation& throw_location,
   // The debugger may suspend this thread and walk its stack. Let's do this before popping
   // instrumentation frames.
   if (!is_exception_reported) {
-    instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
     instrumentation->ExceptionCaughtEvent(self_, throw_location, handler_method_, handler_dex_pc_,
                                           exception_ref.Get());
       // We're not catching this exception but let's remind we already reported the exception above
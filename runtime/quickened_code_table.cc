@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "quickened_code_table.h"
+
+#include <string.h>
+
+#include "class_linker-inl.h"
+#include "dex_instruction-inl.h"
+#include "mirror/art_field-inl.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache-inl.h"
+#include "runtime.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+
+// Returns the field accessed by the iget or iput inst if it can be accessed by offset, which is
+// what the verifier and FindFieldFromCode would have let through for a preverified method.
+static mirror::ArtField* GetQuickenableField(mirror::ArtMethod* method, const Instruction* inst,
+                                             Primitive::Type field_type)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  mirror::ArtField* field = class_linker->GetResolvedField(inst->VRegC_22c(),
+                                                           method->GetDeclaringClass());
+  if (field == nullptr || field->IsStatic() || field->IsVolatile() ||
+      !IsUint(16, field->GetOffset().Int32Value())) {
+    return nullptr;
+  }
+  bool is_primitive = field_type != Primitive::kPrimNot;
+  if (field->IsPrimitiveType() != is_primitive ||
+      field->FieldSize() != Primitive::FieldSize(field_type)) {
+    return nullptr;
+  }
+  return field;
+}
+
+// Returns the vtable index the invoke-virtual inst dispatches through, or -1 if unknown yet.
+static int32_t GetQuickenableVTableIndex(mirror::ArtMethod* method, const Instruction* inst,
+                                         bool is_range)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  uint32_t method_idx = is_range ? inst->VRegB_3rc() : inst->VRegB_35c();
+  mirror::ArtMethod* resolved_method = class_linker->GetResolvedMethod(method_idx, method,
+                                                                       kVirtual);
+  if (resolved_method == nullptr || resolved_method->IsStatic() || resolved_method->IsDirect() ||
+      (resolved_method->GetDeclaringClass()->IsInterface() && !resolved_method->IsMiranda()) ||
+      !IsUint(16, resolved_method->GetMethodIndex())) {
+    return -1;
+  }
+  return resolved_method->GetMethodIndex();
+}
+
+size_t QuickenedCodeTable::Quicken(mirror::ArtMethod* method, DexFile::CodeItem* code_item,
+                                   size_t* sites_left) {
+  size_t quickened = 0;
+  *sites_left = 0;
+  uint32_t dex_pc = 0;
+  while (dex_pc < code_item->insns_size_in_code_units_) {
+    Instruction* inst = const_cast<Instruction*>(Instruction::At(code_item->insns_ + dex_pc));
+    dex_pc += inst->SizeInCodeUnits();
+    Instruction::Code new_opcode;
+    Primitive::Type field_type = Primitive::kPrimVoid;
+    bool is_range = false;
+    switch (inst->Opcode()) {
+      case Instruction::IGET:
+        new_opcode = Instruction::IGET_QUICK;
+        field_type = Primitive::kPrimInt;
+        break;
+      case Instruction::IGET_WIDE:
+        new_opcode = Instruction::IGET_WIDE_QUICK;
+        field_type = Primitive::kPrimLong;
+        break;
+      case Instruction::IGET_OBJECT:
+        new_opcode = Instruction::IGET_OBJECT_QUICK;
+        field_type = Primitive::kPrimNot;
+        break;
+      case Instruction::IPUT:
+        new_opcode = Instruction::IPUT_QUICK;
+        field_type = Primitive::kPrimInt;
+        break;
+      case Instruction::IPUT_WIDE:
+        new_opcode = Instruction::IPUT_WIDE_QUICK;
+        field_type = Primitive::kPrimLong;
+        break;
+      case Instruction::IPUT_OBJECT:
+        new_opcode = Instruction::IPUT_OBJECT_QUICK;
+        field_type = Primitive::kPrimNot;
+        break;
+      case Instruction::INVOKE_VIRTUAL:
+        new_opcode = Instruction::INVOKE_VIRTUAL_QUICK;
+        break;
+      case Instruction::INVOKE_VIRTUAL_RANGE:
+        new_opcode = Instruction::INVOKE_VIRTUAL_RANGE_QUICK;
+        is_range = true;
+        break;
+      default:
+        continue;
+    }
+    if (field_type != Primitive::kPrimVoid) {
+      mirror::ArtField* field = GetQuickenableField(method, inst, field_type);
+      if (field == nullptr) {
+        ++*sites_left;
+        continue;
+      }
+      inst->SetOpcode(new_opcode);
+      // Replace field index by field offset.
+      inst->SetVRegC_22c(static_cast<uint16_t>(field->GetOffset().Int32Value()));
+    } else {
+      int32_t vtable_idx = GetQuickenableVTableIndex(method, inst, is_range);
+      if (vtable_idx < 0) {
+        ++*sites_left;
+        continue;
+      }
+      inst->SetOpcode(new_opcode);
+      // Replace method index by vtable index.
+      if (is_range) {
+        inst->SetVRegB_3rc(static_cast<uint16_t>(vtable_idx));
+      } else {
+        inst->SetVRegB_35c(static_cast<uint16_t>(vtable_idx));
+      }
+    }
+    ++quickened;
+  }
+  return quickened;
+}
+
+QuickenedCodeTable::QuickenedCodeTable()
+    : lock_("quickened code table lock"),
+      entry_counters_(new Atomic<uint16_t>[kTableSize]()),
+      table_(new Atomic<Entry*>[kTableSize]()),
+      copied_bytes_(0) {
+  COMPILE_ASSERT(IsPowerOfTwo(kTableSize), table_size_must_be_a_power_of_two);
+  COMPILE_ASSERT(!kMovingMethods, quickened_code_expects_methods_not_to_move);
+}
+
+QuickenedCodeTable::~QuickenedCodeTable() {
+}
+
+QuickenedCodeTable::Entry* QuickenedCodeTable::FindEntry(mirror::ArtMethod* method) {
+  const size_t start = TableIndex(method);
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    Entry* entry = table_[(start + i) & (kTableSize - 1)].LoadSequentiallyConsistent();
+    if (entry == nullptr || entry->method == method) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+const DexFile::CodeItem* QuickenedCodeTable::GetCodeItemForEntry(
+    Thread* self, mirror::ArtMethod* method, const DexFile::CodeItem* code_item) {
+  DCHECK(method->IsPreverified());
+  // The counters are incremented with a plain load and store rather than an atomic add, which
+  // would cost a locked instruction on every interpreted call. Increments lost to a race only
+  // delay quickening by an entry or so, the counts just pace it and need not be exact. A stale
+  // next_threshold is harmless too, Requicken checks it again with lock_ held.
+  Entry* entry = FindEntry(method);
+  if (LIKELY(entry != nullptr)) {
+    uint32_t entries = entry->entries.LoadRelaxed() + 1;
+    entry->entries.StoreRelaxed(entries);
+    if (UNLIKELY(entries >= entry->next_threshold.LoadRelaxed())) {
+      Requicken(self, entry, code_item);
+    }
+    return entry->code_item.LoadSequentiallyConsistent();
+  }
+  Atomic<uint16_t>& counter = entry_counters_[TableIndex(method)];
+  uint16_t count = counter.LoadRelaxed() + 1;
+  if (LIKELY(count < kFirstQuickenThreshold)) {
+    counter.StoreRelaxed(count);
+    return code_item;
+  }
+  counter.StoreRelaxed(0);
+  CreateEntry(self, method, code_item);
+  entry = FindEntry(method);
+  return entry != nullptr ? entry->code_item.LoadSequentiallyConsistent() : code_item;
+}
+
+const DexFile::CodeItem* QuickenedCodeTable::GetQuickenedCodeItem(mirror::ArtMethod* method) {
+  Entry* entry = FindEntry(method);
+  return entry != nullptr ? entry->code_item.LoadSequentiallyConsistent() : nullptr;
+}
+
+std::unique_ptr<uint8_t[]> QuickenedCodeTable::QuickenedCopy(mirror::ArtMethod* method,
+                                                             const DexFile::CodeItem* code_item,
+                                                             size_t* quickened,
+                                                             size_t* sites_left) {
+  // Only the header and the instructions are copied. The interpreter finds try items and debug
+  // info through the method, which keeps the original code item.
+  const size_t size = CopySize(code_item);
+  if (copied_bytes_ + size > kMaxCopiedBytes) {
+    *quickened = 0;
+    *sites_left = 0;
+    return nullptr;
+  }
+  std::unique_ptr<uint8_t[]> copy(new uint8_t[size]);
+  memcpy(copy.get(), code_item, size);
+  DexFile::CodeItem* copied_code_item = reinterpret_cast<DexFile::CodeItem*>(copy.get());
+  copied_code_item->tries_size_ = 0;
+  copied_code_item->debug_info_off_ = 0;
+  *quickened = Quicken(method, copied_code_item, sites_left);
+  return copy;
+}
+
+const DexFile::CodeItem* QuickenedCodeTable::KeepCopy(std::unique_ptr<uint8_t[]> copy) {
+  const DexFile::CodeItem* copied_code_item =
+      reinterpret_cast<const DexFile::CodeItem*>(copy.get());
+  copied_bytes_ += CopySize(copied_code_item);
+  copies_.push_back(std::move(copy));
+  return copied_code_item;
+}
+
+void QuickenedCodeTable::CreateEntry(Thread* self, mirror::ArtMethod* method,
+                                     const DexFile::CodeItem* code_item) {
+  MutexLock mu(self, lock_);
+  const size_t start = TableIndex(method);
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    Atomic<Entry*>& slot = table_[(start + i) & (kTableSize - 1)];
+    Entry* entry = slot.LoadRelaxed();
+    if (entry != nullptr) {
+      if (entry->method == method) {
+        // Another thread created it meanwhile.
+        return;
+      }
+      continue;
+    }
+    std::unique_ptr<Entry> new_entry(new Entry());
+    new_entry->method = method;
+    size_t quickened;
+    size_t sites_left;
+    std::unique_ptr<uint8_t[]> copy(QuickenedCopy(method, code_item, &quickened, &sites_left));
+    // Methods without a copy keep an entry running their original code, so that they aren't
+    // considered again. Once kMaxCopiedBytes is reached they are never requickened either.
+    new_entry->code_item.StoreRelaxed(quickened != 0 ? KeepCopy(std::move(copy)) : code_item);
+    new_entry->entries.StoreRelaxed(kFirstQuickenThreshold);
+    new_entry->next_threshold.StoreRelaxed(
+        sites_left != 0 ? kFirstQuickenThreshold * kQuickenThresholdGrowth : kNoThreshold);
+    new_entry->generations = 1;
+    new_entry->quickened = quickened;
+    new_entry->sites_left = sites_left;
+    slot.StoreSequentiallyConsistent(new_entry.get());
+    entries_.push_back(std::move(new_entry));
+    return;
+  }
+}
+
+void QuickenedCodeTable::Requicken(Thread* self, Entry* entry,
+                                   const DexFile::CodeItem* code_item) {
+  MutexLock mu(self, lock_);
+  if (entry->entries.LoadRelaxed() < entry->next_threshold.LoadRelaxed()) {
+    // Another thread got here first.
+    return;
+  }
+  entry->next_threshold.StoreRelaxed(entry->next_threshold.LoadRelaxed() * kQuickenThresholdGrowth);
+  size_t quickened;
+  size_t sites_left;
+  std::unique_ptr<uint8_t[]> copy(QuickenedCopy(entry->method, code_item, &quickened,
+                                                &sites_left));
+  if (copy.get() == nullptr) {
+    // Out of room for copies, keep running the current one.
+    entry->next_threshold.StoreRelaxed(kNoThreshold);
+    return;
+  }
+  if (quickened <= entry->quickened) {
+    // Nothing new got resolved, wait for the next threshold.
+    return;
+  }
+  ++entry->generations;
+  entry->quickened = quickened;
+  entry->sites_left = sites_left;
+  if (sites_left == 0 || entry->generations == kMaxGenerations) {
+    entry->next_threshold.StoreRelaxed(kNoThreshold);
+  }
+  entry->code_item.StoreSequentiallyConsistent(KeepCopy(std::move(copy)));
+}
+
+size_t QuickenedCodeTable::NumberOfMethods() {
+  MutexLock mu(Thread::Current(), lock_);
+  return entries_.size();
+}
+
+size_t QuickenedCodeTable::NumberOfQuickenedInstructions() {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t quickened = 0;
+  for (const std::unique_ptr<Entry>& entry : entries_) {
+    quickened += entry->quickened;
+  }
+  return quickened;
+}
+
+size_t QuickenedCodeTable::NumberOfCopiedBytes() {
+  MutexLock mu(Thread::Current(), lock_);
+  return copied_bytes_;
+}
+
+}  // namespace art
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_QUICKENED_CODE_TABLE_H_
+#define ART_RUNTIME_QUICKENED_CODE_TABLE_H_
+
+#include <memory>
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "dex_file.h"
+#include "globals.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+
+class Thread;
+
+// Private copies of the code of interpreted methods in which instance field accesses and virtual
+// invokes whose targets are already resolved are rewritten to their -quick forms, the way the
+// DEX-to-DEX compiler rewrites code ahead of time. The copy replaces the code item only for the
+// interpreter; the dex file stays pristine for the verifier, the compilers and the debugger.
+//
+// A copy is never written once other threads can run it, since another thread could read a new
+// operand with an old opcode. Instead, a method is quickened when it is entered for the
+// kFirstQuickenThreshold-th time, after its first activations resolved most of what it uses. If
+// sites were left because they had not been resolved yet, it is quickened again into a new copy
+// at later thresholds, at most kMaxGenerations times. Replaced copies may still be running and are
+// only freed with the table, so the copies of all methods together are bounded by kMaxCopiedBytes.
+class QuickenedCodeTable {
+ public:
+  static constexpr uint32_t kFirstQuickenThreshold = 2;
+  // Each requickening waits this many times more entries than the previous one.
+  static constexpr uint32_t kQuickenThresholdGrowth = 8;
+  static constexpr size_t kMaxGenerations = 3;
+  // Once the copies take this much, methods are left to run their original code.
+  static constexpr size_t kMaxCopiedBytes = 4 * MB;
+
+  QuickenedCodeTable();
+  ~QuickenedCodeTable();
+
+  // Count an interpreter entry into method, which must be preverified, and return the code the
+  // interpreter should run for it: the latest quickened copy, or code_item if there is none.
+  const DexFile::CodeItem* GetCodeItemForEntry(Thread* self, mirror::ArtMethod* method,
+                                               const DexFile::CodeItem* code_item)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Returns the code the interpreter runs for method once the method has been considered for
+  // quickening, or nullptr before.
+  const DexFile::CodeItem* GetQuickenedCodeItem(mirror::ArtMethod* method);
+
+  size_t NumberOfMethods() LOCKS_EXCLUDED(lock_);
+  size_t NumberOfQuickenedInstructions() LOCKS_EXCLUDED(lock_);
+  size_t NumberOfCopiedBytes() LOCKS_EXCLUDED(lock_);
+
+  // Rewrite in place the instructions of code_item whose field or method is resolved in the dex
+  // cache of method. Returns the number of instructions rewritten, and in sites_left the number
+  // that could be rewritten once resolved.
+  static size_t Quicken(mirror::ArtMethod* method, DexFile::CodeItem* code_item,
+                        size_t* sites_left)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  struct Entry {
+    mirror::ArtMethod* method;
+    Atomic<const DexFile::CodeItem*> code_item;
+    // Incremented without a read-modify-write, see GetCodeItemForEntry.
+    Atomic<uint32_t> entries;
+    // Written with lock_ held, read without it by GetCodeItemForEntry.
+    Atomic<uint32_t> next_threshold;
+    // The following are guarded by lock_.
+    size_t generations;
+    size_t quickened;
+    size_t sites_left;
+  };
+
+  static constexpr size_t kTableSize = 8 * KB;
+  static constexpr size_t kMaxProbes = 16;
+  // Threshold of methods that are done with quickening.
+  static constexpr uint32_t kNoThreshold = 0xFFFFFFFF;
+
+  static size_t TableIndex(mirror::ArtMethod* method) {
+    return (reinterpret_cast<uintptr_t>(method) / kObjectAlignment) & (kTableSize - 1);
+  }
+
+  // Returns the entry of method, or nullptr if it has none.
+  Entry* FindEntry(mirror::ArtMethod* method);
+
+  // Create the entry of method with a first quickened copy of code_item. Does nothing if the
+  // table is full.
+  void CreateEntry(Thread* self, mirror::ArtMethod* method, const DexFile::CodeItem* code_item)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Replace the copy of entry by a new one if more of its sites can be quickened by now.
+  void Requicken(Thread* self, Entry* entry, const DexFile::CodeItem* code_item)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Bytes of the header and the instructions of code_item, which is what gets copied.
+  static size_t CopySize(const DexFile::CodeItem* code_item) {
+    return OFFSETOF_MEMBER(DexFile::CodeItem, insns_) +
+        code_item->insns_size_in_code_units_ * sizeof(uint16_t);
+  }
+
+  // Copy code_item and quicken the copy. Returns nullptr if keeping the copy would go over
+  // kMaxCopiedBytes.
+  std::unique_ptr<uint8_t[]> QuickenedCopy(mirror::ArtMethod* method,
+                                           const DexFile::CodeItem* code_item,
+                                           size_t* quickened, size_t* sites_left)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Keep a copy until the table is deleted and return its code item.
+  const DexFile::CodeItem* KeepCopy(std::unique_ptr<uint8_t[]> copy)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // Entries counted by hashed method address until a method gets an entry of its own. Methods
+  // sharing a counter are at worst quickened a little early.
+  std::unique_ptr<Atomic<uint16_t>[]> entry_counters_;
+  // Slots are only ever filled, under lock_, with entries owned by entries_.
+  std::unique_ptr<Atomic<Entry*>[]> table_;
+  std::vector<std::unique_ptr<Entry>> entries_ GUARDED_BY(lock_);
+  std::vector<std::unique_ptr<uint8_t[]>> copies_ GUARDED_BY(lock_);
+  size_t copied_bytes_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(QuickenedCodeTable);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_QUICKENED_CODE_TABLE_H_
@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "quickened_code_table.h"
+
+#include <string.h>
+#include <vector>
+
+#include "class_linker-inl.h"
+#include "common_runtime_test.h"
+#include "dex_instruction-inl.h"
+#include "instrumentation.h"
+#include "interpreter/interpreter.h"
+#include "mirror/art_field-inl.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache-inl.h"
+#include "mirror/string-inl.h"
+#include "mirror/throwable.h"
+#include "scoped_thread_state_change.h"
+#include "thread_list.h"
+
+namespace art {
+
+// The runtime isn't started, so the methods of QuickenedCode run in the interpreter and go
+// through the quickened code table of the runtime.
+class QuickenedCodeTableTest : public CommonRuntimeTest {
+ protected:
+  void LoadQuickenedCode(Thread* self, Handle<mirror::Class>* klass,
+                         Handle<mirror::Object>* object)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    jobject jclass_loader = LoadDex("QuickenedCode");
+    ScopedObjectAccessUnchecked soa(self);
+    StackHandleScope<1> hs(self);
+    Handle<mirror::ClassLoader> class_loader(
+        hs.NewHandle(soa.Decode<mirror::ClassLoader*>(jclass_loader)));
+    klass->Assign(class_linker_->FindClass(self, "LQuickenedCode;", class_loader));
+    ASSERT_TRUE(klass->Get() != nullptr);
+    ASSERT_TRUE(class_linker_->EnsureInitialized(*klass, true, true));
+    object->Assign((*klass)->AllocObject(self));
+    ASSERT_TRUE(object->Get() != nullptr);
+  }
+
+  // Run a static method taking the object and an int.
+  JValue Invoke(Thread* self, mirror::ArtMethod* method, mirror::Object* object, int32_t arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    uint32_t args[2];
+    args[0] = StackReference<mirror::Object>::FromMirrorPtr(object).AsVRegValue();
+    args[1] = static_cast<uint32_t>(arg);
+    JValue result;
+    interpreter::EnterInterpreterFromInvoke(self, method, nullptr, args, &result);
+    return result;
+  }
+
+  static size_t CountOpcode(const DexFile::CodeItem* code_item, Instruction::Code opcode) {
+    size_t count = 0;
+    for (uint32_t dex_pc = 0; dex_pc < code_item->insns_size_in_code_units_; ) {
+      const Instruction* inst = Instruction::At(code_item->insns_ + dex_pc);
+      if (inst->Opcode() == opcode) {
+        ++count;
+      }
+      dex_pc += inst->SizeInCodeUnits();
+    }
+    return count;
+  }
+};
+
+TEST_F(QuickenedCodeTableTest, FieldsAndInvokes) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::Class> klass(hs.NewHandle<mirror::Class>(nullptr));
+  Handle<mirror::Object> object(hs.NewHandle<mirror::Object>(nullptr));
+  ASSERT_NO_FATAL_FAILURE(LoadQuickenedCode(soa.Self(), &klass, &object));
+  mirror::ArtMethod* method = klass->FindDirectMethod("fieldsAndInvokes", "(LQuickenedCode;I)J");
+  ASSERT_TRUE(method != nullptr);
+  QuickenedCodeTable* table = Runtime::Current()->GetQuickenedCodeTable();
+  ASSERT_TRUE(table != nullptr);
+  EXPECT_TRUE(table->GetQuickenedCodeItem(method) == nullptr);
+
+  for (int32_t value = 1; value <= 4; ++value) {
+    // longField + value() + sum(1, 2, 3, 4, 5), the same before and after quickening.
+    EXPECT_EQ(7 * value + 15, Invoke(soa.Self(), method, object.Get(), value).GetJ());
+    EXPECT_FALSE(soa.Self()->IsExceptionPending());
+  }
+
+  const DexFile::CodeItem* copy = table->GetQuickenedCodeItem(method);
+  ASSERT_TRUE(copy != nullptr);
+  ASSERT_NE(method->GetCodeItem(), copy);
+  EXPECT_EQ(1U, CountOpcode(copy, Instruction::IPUT_QUICK));
+  EXPECT_EQ(1U, CountOpcode(copy, Instruction::IPUT_WIDE_QUICK));
+  EXPECT_EQ(1U, CountOpcode(copy, Instruction::IPUT_OBJECT_QUICK));
+  EXPECT_EQ(1U, CountOpcode(copy, Instruction::IGET_WIDE_QUICK));
+  EXPECT_EQ(1U, CountOpcode(copy, Instruction::IGET_OBJECT_QUICK));
+  EXPECT_EQ(1U, CountOpcode(copy, Instruction::INVOKE_VIRTUAL_QUICK));
+  EXPECT_EQ(1U, CountOpcode(copy, Instruction::INVOKE_VIRTUAL_RANGE_QUICK));
+  EXPECT_EQ(0U, CountOpcode(copy, Instruction::INVOKE_VIRTUAL));
+  EXPECT_EQ(0U, CountOpcode(copy, Instruction::INVOKE_VIRTUAL_RANGE));
+  // The dex file is left alone.
+  EXPECT_EQ(1U, CountOpcode(method->GetCodeItem(), Instruction::IPUT));
+  EXPECT_EQ(0U, CountOpcode(method->GetCodeItem(), Instruction::IPUT_QUICK));
+  EXPECT_GT(table->NumberOfCopiedBytes(), 0U);
+  EXPECT_LE(table->NumberOfCopiedBytes(), QuickenedCodeTable::kMaxCopiedBytes);
+}
+
+// Records the field events posted by the interpreter.
+class FieldEventListener : public instrumentation::InstrumentationListener {
+ public:
+  struct Event {
+    mirror::ArtMethod* method;
+    uint32_t dex_pc;
+    mirror::ArtField* field;
+  };
+
+  void MethodEntered(Thread* thread, mirror::Object* this_object, mirror::ArtMethod* method,
+                     uint32_t dex_pc)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) OVERRIDE {
+  }
+
+  void MethodExited(Thread* thread, mirror::Object* this_object, mirror::ArtMethod* method,
+                    uint32_t dex_pc, const JValue& return_value)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) OVERRIDE {
+  }
+
+  void MethodUnwind(Thread* thread, mirror::Object* this_object, mirror::ArtMethod* method,
+                    uint32_t dex_pc)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) OVERRIDE {
+  }
+
+  void DexPcMoved(Thread* thread, mirror::Object* this_object, mirror::ArtMethod* method,
+                  uint32_t new_dex_pc)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) OVERRIDE {
+  }
+
+  void FieldRead(Thread* thread, mirror::Object* this_object, mirror::ArtMethod* method,
+                 uint32_t dex_pc, mirror::ArtField* field)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) OVERRIDE {
+    reads_.push_back({method, dex_pc, field});
+  }
+
+  void FieldWritten(Thread* thread, mirror::Object* this_object, mirror::ArtMethod* method,
+                    uint32_t dex_pc, mirror::ArtField* field, const JValue& field_value)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) OVERRIDE {
+    writes_.push_back({method, dex_pc, field});
+  }
+
+  void ExceptionCaught(Thread* thread, const ThrowLocation& throw_location,
+                       mirror::ArtMethod* catch_method, uint32_t catch_dex_pc,
+                       mirror::Throwable* exception_object)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) OVERRIDE {
+  }
+
+  std::vector<Event> reads_;
+  std::vector<Event> writes_;
+};
+
+TEST_F(QuickenedCodeTableTest, FieldWatchesInCopy) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<2> hs(self);
+  Handle<mirror::Class> klass(hs.NewHandle<mirror::Class>(nullptr));
+  Handle<mirror::Object> object(hs.NewHandle<mirror::Object>(nullptr));
+  ASSERT_NO_FATAL_FAILURE(LoadQuickenedCode(self, &klass, &object));
+  mirror::ArtMethod* method = klass->FindDirectMethod("fieldsAndInvokes", "(LQuickenedCode;I)J");
+  ASSERT_TRUE(method != nullptr);
+  for (int32_t value = 1; value <= 4; ++value) {
+    Invoke(self, method, object.Get(), value);
+  }
+  const DexFile::CodeItem* copy =
+      Runtime::Current()->GetQuickenedCodeTable()->GetQuickenedCodeItem(method);
+  ASSERT_TRUE(copy != nullptr);
+  ASSERT_NE(method->GetCodeItem(), copy);
+
+  FieldEventListener listener;
+  const uint32_t kFieldEvents = instrumentation::Instrumentation::kFieldRead |
+                                instrumentation::Instrumentation::kFieldWritten;
+  instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
+  {
+    ScopedThreadStateChange stsc(self, kSuspended);
+    Runtime::Current()->GetThreadList()->SuspendAll();
+    instrumentation->AddListener(&listener, kFieldEvents);
+    Runtime::Current()->GetThreadList()->ResumeAll();
+  }
+  EXPECT_EQ(7 * 5 + 15, Invoke(self, method, object.Get(), 5).GetJ());
+  {
+    ScopedThreadStateChange stsc(self, kSuspended);
+    Runtime::Current()->GetThreadList()->SuspendAll();
+    instrumentation->RemoveListener(&listener, kFieldEvents);
+    Runtime::Current()->GetThreadList()->ResumeAll();
+  }
+  ASSERT_EQ(copy, Runtime::Current()->GetQuickenedCodeTable()->GetQuickenedCodeItem(method));
+
+  // The quickened instructions of the copy only have the field offset, the events still name the
+  // field.
+  mirror::ArtField* int_field = klass->FindDeclaredInstanceField("intField", "I");
+  mirror::ArtField* long_field = klass->FindDeclaredInstanceField("longField", "J");
+  mirror::ArtField* object_field = klass->FindDeclaredInstanceField("objectField",
+                                                                    "Ljava/lang/Object;");
+  ASSERT_EQ(3U, listener.writes_.size());
+  const mirror::ArtField* kWrittenFields[] = { int_field, long_field, object_field };
+  const Instruction::Code kWriteOpcodes[] = {
+      Instruction::IPUT_QUICK, Instruction::IPUT_WIDE_QUICK, Instruction::IPUT_OBJECT_QUICK };
+  for (size_t i = 0; i < listener.writes_.size(); ++i) {
+    const FieldEventListener::Event& event = listener.writes_[i];
+    EXPECT_EQ(method, event.method);
+    EXPECT_EQ(kWrittenFields[i], event.field);
+    EXPECT_EQ(kWriteOpcodes[i], Instruction::At(copy->insns_ + event.dex_pc)->Opcode());
+  }
+  // value() and sum() read intField and longField in their own frames.
+  std::vector<FieldEventListener::Event> reads;
+  for (const FieldEventListener::Event& event : listener.reads_) {
+    if (event.method == method) {
+      reads.push_back(event);
+    }
+  }
+  ASSERT_EQ(2U, reads.size());
+  EXPECT_EQ(object_field, reads[0].field);
+  EXPECT_EQ(Instruction::IGET_OBJECT_QUICK,
+            Instruction::At(copy->insns_ + reads[0].dex_pc)->Opcode());
+  EXPECT_EQ(long_field, reads[1].field);
+  EXPECT_EQ(Instruction::IGET_WIDE_QUICK,
+            Instruction::At(copy->insns_ + reads[1].dex_pc)->Opcode());
+}
+
+TEST_F(QuickenedCodeTableTest, RequickenAfterResolution) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<3> hs(soa.Self());
+  Handle<mirror::Class> klass(hs.NewHandle<mirror::Class>(nullptr));
+  Handle<mirror::Object> object(hs.NewHandle<mirror::Object>(nullptr));
+  ASSERT_NO_FATAL_FAILURE(LoadQuickenedCode(soa.Self(), &klass, &object));
+  mirror::ArtMethod* method = klass->FindDirectMethod("lateResolution", "(LQuickenedCode;Z)I");
+  ASSERT_TRUE(method != nullptr);
+  klass->FindDeclaredInstanceField("intField", "I")->SetInt<false>(object.Get(), 3);
+  klass->FindDeclaredInstanceField("lateField", "I")->SetInt<false>(object.Get(), 5);
+
+  // Verification resolved everything the method uses. Forget lateField and lateValue so that
+  // they are only resolved once the method takes the late branch.
+  Handle<mirror::DexCache> dex_cache(hs.NewHandle(klass->GetDexCache()));
+  const DexFile& dex_file = *dex_cache->GetDexFile();
+  const DexFile::CodeItem* code_item = method->GetCodeItem();
+  for (uint32_t dex_pc = 0; dex_pc < code_item->insns_size_in_code_units_; ) {
+    const Instruction* inst = Instruction::At(code_item->insns_ + dex_pc);
+    if (inst->Opcode() == Instruction::IGET &&
+        strcmp(dex_file.GetFieldName(dex_file.GetFieldId(inst->VRegC_22c())), "lateField") == 0) {
+      dex_cache->SetResolvedField(inst->VRegC_22c(), nullptr);
+    } else if (inst->Opcode() == Instruction::INVOKE_VIRTUAL) {
+      // Unresolved methods are the resolution trampoline in the dex cache.
+      dex_cache->SetResolvedMethod(inst->VRegB_35c(), Runtime::Current()->GetResolutionMethod());
+    }
+    dex_pc += inst->SizeInCodeUnits();
+  }
+
+  QuickenedCodeTable* table = Runtime::Current()->GetQuickenedCodeTable();
+  for (size_t i = 0; i < QuickenedCodeTable::kFirstQuickenThreshold; ++i) {
+    EXPECT_EQ(3, Invoke(soa.Self(), method, object.Get(), 0).GetI());
+  }
+  const DexFile::CodeItem* first_copy = table->GetQuickenedCodeItem(method);
+  ASSERT_TRUE(first_copy != nullptr);
+  ASSERT_NE(code_item, first_copy);
+  EXPECT_EQ(1U, CountOpcode(first_copy, Instruction::IGET_QUICK));
+  EXPECT_EQ(1U, CountOpcode(first_copy, Instruction::IGET));
+  EXPECT_EQ(1U, CountOpcode(first_copy, Instruction::INVOKE_VIRTUAL));
+
+  // The late branch resolves the rest through the first copy, the next threshold quickens it.
+  const uint32_t kRequickenThreshold =
+      QuickenedCodeTable::kFirstQuickenThreshold * QuickenedCodeTable::kQuickenThresholdGrowth;
+  for (size_t i = QuickenedCodeTable::kFirstQuickenThreshold; i < kRequickenThreshold; ++i) {
+    EXPECT_EQ(3 + 5 + 5, Invoke(soa.Self(), method, object.Get(), 1).GetI());
+    EXPECT_FALSE(soa.Self()->IsExceptionPending());
+  }
+  const DexFile::CodeItem* second_copy = table->GetQuickenedCodeItem(method);
+  ASSERT_TRUE(second_copy != nullptr);
+  EXPECT_NE(first_copy, second_copy);
+  EXPECT_EQ(2U, CountOpcode(second_copy, Instruction::IGET_QUICK));
+  EXPECT_EQ(0U, CountOpcode(second_copy, Instruction::IGET));
+  EXPECT_EQ(1U, CountOpcode(second_copy, Instruction::INVOKE_VIRTUAL_QUICK));
+  EXPECT_EQ(0U, CountOpcode(second_copy, Instruction::INVOKE_VIRTUAL));
+  EXPECT_EQ(3 + 5 + 5, Invoke(soa.Self(), method, object.Get(), 1).GetI());
+  EXPECT_EQ(3, Invoke(soa.Self(), method, object.Get(), 0).GetI());
+}
+
+TEST_F(QuickenedCodeTableTest, ExceptionsInCopy) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::Class> klass(hs.NewHandle<mirror::Class>(nullptr));
+  Handle<mirror::Object> object(hs.NewHandle<mirror::Object>(nullptr));
+  ASSERT_NO_FATAL_FAILURE(LoadQuickenedCode(soa.Self(), &klass, &object));
+  mirror::ArtMethod* catch_method = klass->FindDirectMethod("catchNullPointer",
+                                                            "(LQuickenedCode;)I");
+  mirror::ArtMethod* throw_method = klass->FindDirectMethod("throwNullPointer",
+                                                            "(LQuickenedCode;)I");
+  ASSERT_TRUE(catch_method != nullptr);
+  ASSERT_TRUE(throw_method != nullptr);
+  mirror::ArtField* next = klass->FindDeclaredInstanceField("next", "LQuickenedCode;");
+  klass->FindDeclaredInstanceField("intField", "I")->SetInt<false>(object.Get(), 7);
+
+  // The copy has no try items, the handler is found in the original code at the same dex pc.
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(-1, Invoke(soa.Self(), catch_method, object.Get(), 0).GetI());
+    EXPECT_FALSE(soa.Self()->IsExceptionPending());
+  }
+  QuickenedCodeTable* table = Runtime::Current()->GetQuickenedCodeTable();
+  const DexFile::CodeItem* copy = table->GetQuickenedCodeItem(catch_method);
+  ASSERT_TRUE(copy != nullptr);
+  EXPECT_EQ(1U, CountOpcode(copy, Instruction::IGET_OBJECT_QUICK));
+  EXPECT_EQ(1U, CountOpcode(copy, Instruction::IGET_QUICK));
+  EXPECT_EQ(0U, copy->tries_size_);
+  next->SetObject<false>(object.Get(), object.Get());
+  EXPECT_EQ(7, Invoke(soa.Self(), catch_method, object.Get(), 0).GetI());
+  next->SetObject<false>(object.Get(), nullptr);
+
+  // Uncaught, the exception leaves the method and names the field of the original instruction.
+  for (size_t i = 0; i < 4; ++i) {
+    Invoke(soa.Self(), throw_method, object.Get(), 0);
+    ASSERT_TRUE(soa.Self()->IsExceptionPending());
+    mirror::Throwable* exception = soa.Self()->GetException(nullptr);
+    EXPECT_EQ("java.lang.NullPointerException", PrettyTypeOf(exception));
+    std::string message(exception->GetDetailMessage()->ToModifiedUtf8());
+    EXPECT_NE(std::string::npos, message.find("QuickenedCode.intField")) << message;
+    soa.Self()->ClearException();
+  }
+  ASSERT_TRUE(table->GetQuickenedCodeItem(throw_method) != nullptr);
+  EXPECT_EQ(1U, CountOpcode(table->GetQuickenedCodeItem(throw_method), Instruction::IGET_QUICK));
+}
+
+}  // namespace art
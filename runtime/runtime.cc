@@ -26,6 +26,7 @@
 #include <sys/syscall.h>
 #include <valgrind.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
@@ -44,7 +45,9 @@
 #include "arch/x86_64/quick_method_frame_info_x86_64.h"
 #include "arch/x86_64/registers_x86_64.h"
 #include "atomic.h"
+#include "base/perf_counters.h"
 #include "class_linker.h"
+#include "cpu_sampling_profiler.h"
 #include "debugger.h"
 #include "elf_file.h"
 #include "fault_handler.h"
@@ -53,9 +56,13 @@
 #include "gc/space/image_space.h"
 #include "gc/space/space.h"
 #include "image.h"
+#include "inline_cache.h"
 #include "instrumentation.h"
 #include "intern_table.h"
+#include "interpreter/mterp/mterp.h"
+#include "jit/jit.h"
 #include "jni_internal.h"
+#include "lock_contention_profiler.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/array.h"
@@ -69,6 +76,7 @@
 #include "oat_file.h"
 #include "os.h"
 #include "quick/quick_method_frame_info.h"
+#include "quickened_code_table.h"
 #include "reflection.h"
 #include "ScopedLocalRef.h"
 #include "scoped_thread_state_change.h"
@@ -78,6 +86,7 @@
 #include "handle_scope-inl.h"
 #include "thread.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "trace.h"
 #include "transaction.h"
 #include "profiler.h"
@@ -93,6 +102,8 @@
 namespace art {
 
 static constexpr bool kEnableJavaStackTraceHandler = false;
+// How many classes of the class histogram -XX:DumpClassHistogramOnSigQuit dumps.
+static constexpr size_t kSigQuitClassHistogramSize = 50;
 const char* Runtime::kDefaultInstructionSetFeatures =
     STRINGIFY(ART_DEFAULT_INSTRUCTION_SET_FEATURES);
 Runtime* Runtime::instance_ = NULL;
@@ -119,6 +130,7 @@ Runtime::Runtime()
       fault_message_lock_("Fault message lock"),
       fault_message_(""),
       method_verifier_lock_("Method verifiers lock"),
+      dex_file_verify_thread_pool_lock_("Dex file verifier thread pool lock"),
       threads_being_born_(0),
       shutdown_cond_(new ConditionVariable("Runtime shutdown", *Locks::runtime_shutdown_lock_)),
       shutting_down_(false),
@@ -134,11 +146,16 @@ Runtime::Runtime()
       method_trace_(false),
       method_trace_file_size_(0),
       instrumentation_(),
+      use_jit_(false),
+      jit_compile_threshold_(0),
+      jit_code_cache_capacity_(0),
+      interpreter_impl_kind_(interpreter::kDefaultInterpreterImplKind),
       use_compile_time_class_path_(false),
       main_thread_group_(nullptr),
       system_thread_group_(nullptr),
       system_class_loader_(nullptr),
       dump_gc_performance_on_shutdown_(false),
+      dump_class_histogram_on_sigquit_(false),
       preinitialization_transaction_(nullptr),
       null_pointer_handler_(nullptr),
       suspend_handler_(nullptr),
@@ -177,10 +194,21 @@ Runtime::~Runtime() {
   fault_manager.Shutdown();
 
   Trace::Shutdown();
+  LockContentionProfiler::Shutdown();
+  CpuSamplingProfiler::Shutdown();
+
+  // Stop the JIT thread before the runtime it compiles against goes away.
+  jit_.reset();
 
   // Make sure to let the GC complete if it is running.
   heap_->WaitForGcToComplete(gc::kGcCauseBackground, self);
   heap_->DeleteThreadPool();
+  std::unique_ptr<ThreadPool> dex_file_verify_thread_pool;
+  {
+    MutexLock mu(self, dex_file_verify_thread_pool_lock_);
+    dex_file_verify_thread_pool.swap(dex_file_verify_thread_pool_);
+  }
+  dex_file_verify_thread_pool.reset();
 
   // Make sure our internal threads are dead before we start tearing down things they're using.
   Dbg::StopJdwp();
@@ -323,6 +351,7 @@ void Runtime::CallExitHook(jint status) {
 void Runtime::SweepSystemWeaks(IsMarkedCallback* visitor, void* arg) {
   GetInternTable()->SweepInternTableWeaks(visitor, arg);
   GetMonitorList()->SweepMonitorList(visitor, arg);
+  GetMonitorList()->SweepBiasRevocations(visitor, arg);
   GetJavaVM()->SweepJniWeakGlobals(visitor, arg);
 }
 
@@ -444,6 +473,10 @@ bool Runtime::Start() {
 
   StartDaemonThreads();
 
+  // Profilers started by the options need the runtime started for their threads.
+  LockContentionProfiler::StartDrainThread();
+  CpuSamplingProfiler::StartDrainThread();
+
   {
     ScopedObjectAccess soa(self);
     self->GetJniEnv()->locals.AssertEmpty();
@@ -531,6 +564,10 @@ void Runtime::DidForkFromZygote(JNIEnv* env, NativeBridgeAction action, const ch
   // Create the thread pool.
   heap_->CreateThreadPool();
 
+  if (use_jit_ && jit_.get() == nullptr) {
+    CreateJit();
+  }
+
   StartSignalCatcher();
 
   // Start the JDWP thread. If the command-line debugger flags specified "suspend=y",
@@ -538,6 +575,23 @@ void Runtime::DidForkFromZygote(JNIEnv* env, NativeBridgeAction action, const ch
   Dbg::StartJdwp();
 }
 
+void Runtime::CreateJit() {
+  CHECK(!IsCompiler());
+#if defined(ART_USE_PORTABLE_COMPILER)
+  LOG(WARNING) << "The JIT is not supported with the portable compiler";
+#else
+  std::string error_msg;
+  jit_.reset(jit::Jit::Create(jit_code_cache_capacity_, jit_compile_threshold_, &error_msg));
+  if (jit_.get() == nullptr) {
+    LOG(WARNING) << "Failed to create JIT: " << error_msg;
+    return;
+  }
+  jit_->CreateThreadPool();
+  VLOG(jit) << "JIT created with compile threshold " << jit_compile_threshold_
+            << " and code cache capacity " << PrettySize(jit_code_cache_capacity_);
+#endif
+}
+
 void Runtime::StartSignalCatcher() {
   if (!is_zygote_) {
     signal_catcher_ = new SignalCatcher(stack_trace_file_);
@@ -697,6 +751,11 @@ bool Runtime::Init(const RuntimeOptions& raw_options, bool ignore_unrecognized)
   monitor_pool_ = MonitorPool::Create();
   thread_list_ = new ThreadList;
   intern_table_ = new InternTable;
+  inline_cache_table_.reset(new InlineCacheTable);
+  // The compiler quickens ahead of time, into the dex file itself.
+  if (!IsCompiler()) {
+    quickened_code_table_.reset(new QuickenedCodeTable);
+  }
 
   verify_ = options->verify_;
   continue_without_dex_ = options->continue_without_dex_;
@@ -705,6 +764,22 @@ bool Runtime::Init(const RuntimeOptions& raw_options, bool ignore_unrecognized)
     GetInstrumentation()->ForceInterpretOnly();
   }
 
+  // Never JIT in dex2oat or when only interpreting.
+  use_jit_ = options->use_jit_ && !IsCompiler() && !options->interpreter_only_;
+  jit_compile_threshold_ = options->jit_compile_threshold_;
+  jit_code_cache_capacity_ = options->jit_code_cache_capacity_;
+
+  interpreter_impl_kind_ = options->interpreter_impl_kind_;
+  if (!interpreter::IsInterpreterImplAvailable(interpreter_impl_kind_)) {
+    LOG(WARNING) << "Interpreter implementation " << interpreter_impl_kind_
+                 << " is not available in this build, using "
+                 << interpreter::kDefaultInterpreterImplKind;
+    interpreter_impl_kind_ = interpreter::kDefaultInterpreterImplKind;
+  }
+  if (interpreter_impl_kind_ == interpreter::kMterpImplKind) {
+    interpreter::CheckMterpAsmConstants();
+  }
+
   heap_ = new gc::Heap(options->heap_initial_size_,
                        options->heap_growth_limit_,
                        options->heap_min_free_,
@@ -734,6 +809,10 @@ bool Runtime::Init(const RuntimeOptions& raw_options, bool ignore_unrecognized)
                        options->min_interval_homogeneous_space_compaction_by_oom_);
 
   dump_gc_performance_on_shutdown_ = options->dump_gc_performance_on_shutdown_;
+  dump_class_histogram_on_sigquit_ = options->dump_class_histogram_on_sigquit_;
+  if (options->perf_counters_) {
+    PerfCounters::SetEnabled(true);
+  }
 
   BlockSignals();
   InitPlatformSignalHandlers();
@@ -742,11 +821,16 @@ bool Runtime::Init(const RuntimeOptions& raw_options, bool ignore_unrecognized)
   switch (kRuntimeISA) {
     case kArm:
     case kThumb2:
-    case kX86:
     case kArm64:
+      implicit_null_checks_ = true;
+      implicit_so_checks_ = true;
+      break;
+    case kX86:
     case kX86_64:
+      // Suspend checks are a load from the suspend trigger, see SuspensionHandler.
       implicit_null_checks_ = true;
       implicit_so_checks_ = true;
+      implicit_suspend_checks_ = true;
       break;
     default:
       // Keep the defaults.
@@ -836,10 +920,22 @@ bool Runtime::Init(const RuntimeOptions& raw_options, bool ignore_unrecognized)
   // TODO: move this to just be an Trace::Start argument
   Trace::SetDefaultClockSource(options->profile_clock_source_);
 
+  if (options->lock_contention_profile_) {
+    LockContentionProfiler::Start(options->lock_contention_profile_interval_,
+                                  options->lock_contention_profile_file_);
+  }
+
+  if (options->cpu_sample_profile_) {
+    CpuSamplingProfiler::Start(options->cpu_sample_profile_interval_us_,
+                               options->cpu_sample_profile_file_);
+  }
+
   if (options->method_trace_) {
     ScopedThreadStateChange tsc(self, kWaitingForMethodTracingStart);
     Trace::Start(options->method_trace_file_.c_str(), -1, options->method_trace_file_size_, 0,
-                 false, false, 0);
+                 false, false, 0,
+                 options->method_trace_stream_ ? kTraceOutputModeStreaming
+                                               : kTraceOutputModeBuffered);
   }
 
   // Pre-allocate an OutOfMemoryError for the double-OOME case.
@@ -993,7 +1089,20 @@ void Runtime::DumpForSigQuit(std::ostream& os) {
   GetInternTable()->DumpForSigQuit(os);
   GetJavaVM()->DumpForSigQuit(os);
   GetHeap()->DumpForSigQuit(os);
+  if (dump_class_histogram_on_sigquit_) {
+    GetHeap()->DumpClassHistogram(os, kSigQuitClassHistogramSize);
+  }
   TrackedAllocators::Dump(os);
+  Monitor::DumpBiasedLockingStats(os);
+  if (jit_.get() != nullptr) {
+    jit_->DumpInfo(os);
+  }
+  if (LockContentionProfiler::IsEnabled()) {
+    LockContentionProfiler::Dump(os);
+  }
+  if (CpuSamplingProfiler::IsEnabled()) {
+    CpuSamplingProfiler::Dump(os);
+  }
   os << "\n";
 
   thread_list_->DumpForSigQuit(os);
@@ -1176,6 +1285,7 @@ void Runtime::VisitNonThreadRoots(RootCallback* callback, void* arg) {
     preinitialization_transaction_->VisitRoots(callback, arg);
   }
   instrumentation_.VisitRoots(callback, arg);
+  inline_cache_table_->VisitRoots(callback, arg);
 }
 
 void Runtime::VisitNonConcurrentRoots(RootCallback* callback, void* arg) {
@@ -1345,6 +1455,34 @@ void Runtime::RemoveMethodVerifier(verifier::MethodVerifier* verifier) {
   method_verifiers_.erase(it);
 }
 
+// Upper bound of threads verifying the dex files of multidex archives. The threads opening the
+// archives only wait for them.
+static constexpr size_t kMaxDexFileVerifyThreads = 4;
+
+ThreadPool* Runtime::GetDexFileVerifyThreadPool(Thread* self) {
+  {
+    MutexLock mu(self, dex_file_verify_thread_pool_lock_);
+    if (dex_file_verify_thread_pool_.get() != nullptr) {
+      return dex_file_verify_thread_pool_.get();
+    }
+  }
+  const size_t num_threads = std::min(kMaxDexFileVerifyThreads,
+                                      static_cast<size_t>(sysconf(_SC_NPROCESSORS_CONF)));
+  if (num_threads <= 1) {
+    return nullptr;
+  }
+  // Creating the pool waits for its workers to attach, so it is not done under the lock. The pool
+  // of a thread losing the race is deleted once the lock is released.
+  std::unique_ptr<ThreadPool> thread_pool(
+      new ThreadPool("Dex file verifier thread pool", num_threads));
+  thread_pool->StartWorkers(self);
+  MutexLock mu(self, dex_file_verify_thread_pool_lock_);
+  if (dex_file_verify_thread_pool_.get() == nullptr) {
+    dex_file_verify_thread_pool_.swap(thread_pool);
+  }
+  return dex_file_verify_thread_pool_.get();
+}
+
 void Runtime::StartProfiler(const char* profile_output_filename) {
   profile_output_filename_ = profile_output_filename;
   profiler_started_ =
@@ -31,6 +31,7 @@
 #include "gc_root.h"
 #include "instrumentation.h"
 #include "instruction_set.h"
+#include "interpreter/interpreter.h"
 #include "jobject_comparator.h"
 #include "object_callbacks.h"
 #include "offsets.h"
@@ -44,6 +45,9 @@ namespace art {
 namespace gc {
   class Heap;
 }  // namespace gc
+namespace jit {
+  class Jit;
+}  // namespace jit
 namespace mirror {
   class ArtMethod;
   class ClassLoader;
@@ -59,15 +63,18 @@ class MethodVerifier;
 }
 class ClassLinker;
 class DexFile;
+class InlineCacheTable;
 class InternTable;
 class JavaVMExt;
 class MonitorList;
 class MonitorPool;
 class NullPointerHandler;
+class QuickenedCodeTable;
 class SignalCatcher;
 class StackOverflowHandler;
 class SuspensionHandler;
 class ThreadList;
+class ThreadPool;
 class Trace;
 class Transaction;
 
@@ -399,6 +406,9 @@ class Runtime {
   bool InitZygote();
   void DidForkFromZygote(JNIEnv* env, NativeBridgeAction action, const char* isa);
 
+  // Create the JIT and its compiler thread, called once the process is no longer the zygote.
+  void CreateJit();
+
   const instrumentation::Instrumentation* GetInstrumentation() const {
     return &instrumentation_;
   }
@@ -407,6 +417,34 @@ class Runtime {
     return &instrumentation_;
   }
 
+  // Returns the JIT, or nullptr if it is disabled or not created yet.
+  jit::Jit* GetJit() {
+    return jit_.get();
+  }
+
+  bool UseJit() const {
+    return use_jit_;
+  }
+
+  // Returns the started thread pool verifying the dex files of multidex archives, creating it on
+  // first use, or nullptr if the machine has a single processor.
+  ThreadPool* GetDexFileVerifyThreadPool(Thread* self)
+      LOCKS_EXCLUDED(dex_file_verify_thread_pool_lock_);
+
+  interpreter::InterpreterImplKind GetInterpreterImplKind() const {
+    return interpreter_impl_kind_;
+  }
+
+  // Returns the receiver type caches of the interpreter's interface invokes.
+  InlineCacheTable* GetInlineCacheTable() {
+    return inline_cache_table_.get();
+  }
+
+  // Returns the interpreter's quickened copies of method code, or nullptr in the compiler.
+  QuickenedCodeTable* GetQuickenedCodeTable() {
+    return quickened_code_table_.get();
+  }
+
   bool UseCompileTimeClassPath() const {
     return use_compile_time_class_path_;
   }
@@ -571,6 +609,11 @@ class Runtime {
   Mutex method_verifier_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   std::set<verifier::MethodVerifier*> method_verifiers_;
 
+  // Verifies the dex files of multidex archives, kept for the archives opened later.
+  Mutex dex_file_verify_thread_pool_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::unique_ptr<ThreadPool> dex_file_verify_thread_pool_
+      GUARDED_BY(dex_file_verify_thread_pool_lock_);
+
   // A non-zero value indicates that a thread has been created but not yet initialized. Guarded by
   // the shutdown lock so that threads aren't born while we're shutting down.
   size_t threads_being_born_ GUARDED_BY(Locks::runtime_shutdown_lock_);
@@ -610,6 +653,18 @@ class Runtime {
   size_t method_trace_file_size_;
   instrumentation::Instrumentation instrumentation_;
 
+  // JIT options and the JIT itself, created after forking from the zygote if -Xjit was given.
+  bool use_jit_;
+  size_t jit_compile_threshold_;
+  size_t jit_code_cache_capacity_;
+  std::unique_ptr<jit::Jit> jit_;
+
+  // Interpreter implementation run for interpreted methods, see -Xinterpreter-impl.
+  interpreter::InterpreterImplKind interpreter_impl_kind_;
+
+  std::unique_ptr<InlineCacheTable> inline_cache_table_;
+  std::unique_ptr<QuickenedCodeTable> quickened_code_table_;
+
   typedef AllocationTrackingSafeMap<jobject, std::vector<const DexFile*>,
                                     kAllocatorTagCompileTimeClassPath, JobjectComparator>
       CompileTimeClassPaths;
@@ -625,6 +680,9 @@ class Runtime {
   // If true, then we dump the GC cumulative timings on shutdown.
   bool dump_gc_performance_on_shutdown_;
 
+  // If true, then we dump the classes with the most live bytes on SIGQUIT.
+  bool dump_class_histogram_on_sigquit_;
+
   // Transaction used for pre-initializing classes at compilation time.
   Transaction* preinitialization_transaction_;
   NullPointerHandler* null_pointer_handler_;
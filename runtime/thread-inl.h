@@ -104,6 +104,9 @@ inline void Thread::TransitionFromRunnableToSuspended(ThreadState new_state) {
       break;
     }
   }
+  if (UNLIKELY((new_state_and_flags.as_struct.flags & kSuspendRequest) != 0)) {
+    RecordTimeToSafepoint(false);
+  }
   // Release share on mutator_lock_.
   Locks::mutator_lock_->SharedUnlock(this);
 }
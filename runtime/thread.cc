@@ -34,6 +34,7 @@
 #include "base/mutex.h"
 #include "class_linker-inl.h"
 #include "class_linker.h"
+#include "cpu_sampling_profiler.h"
 #include "debugger.h"
 #include "dex_file-inl.h"
 #include "entrypoints/entrypoint_utils.h"
@@ -47,6 +48,7 @@
 #include "handle_scope.h"
 #include "indirect_reference_table-inl.h"
 #include "jni_internal.h"
+#include "lock_contention_profiler.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/class_loader.h"
@@ -367,6 +369,8 @@ void Thread::Init(ThreadList* thread_list, JavaVMExt* java_vm) {
 
   tlsPtr_.jni_env = new JNIEnvExt(this, java_vm);
   thread_list->Register(this);
+  LockContentionProfiler::ThreadAttached(this);
+  CpuSamplingProfiler::ThreadAttached(this);
 }
 
 Thread* Thread::Attach(const char* thread_name, bool as_daemon, jobject thread_group,
@@ -649,7 +653,13 @@ void Thread::ModifySuspendCount(Thread* self, int delta, bool for_debugger) {
 
   if (tls32_.suspend_count == 0) {
     AtomicClearFlag(kSuspendRequest);
+    suspend_request_time_ns_ = 0;
   } else {
+    if (tls32_.suspend_count == delta) {
+      // A thread that isn't Runnable never acknowledges the request and the time is dropped when
+      // it gets resumed.
+      suspend_request_time_ns_ = NanoTime();
+    }
     AtomicSetFlag(kSuspendRequest);
     TriggerSuspend();
   }
@@ -670,6 +680,7 @@ void Thread::RunCheckpointFunction() {
     }
     AtomicClearFlag(kCheckpointRequest);
   }
+  RecordTimeToSafepoint(true);
 
   // Outside the lock, run all the checkpoint functions that
   // we collected.
@@ -685,6 +696,32 @@ void Thread::RunCheckpointFunction() {
   CHECK(found_checkpoint);
 }
 
+void Thread::RecordTimeToSafepoint(bool for_checkpoint) NO_THREAD_SAFETY_ANALYSIS {
+  // Long enough to not be the scheduler, worth pointing at the code that doesn't suspend check.
+  static constexpr uint64_t kLongTimeToSafepointNs = MsToNs(50);
+  uint64_t time_ns;
+  {
+    MutexLock mu(this, *Locks::thread_suspend_count_lock_);
+    uint64_t* request_time_ns =
+        for_checkpoint ? &checkpoint_request_time_ns_ : &suspend_request_time_ns_;
+    if (*request_time_ns == 0) {
+      return;  // Already recorded.
+    }
+    time_ns = NanoTime() - *request_time_ns;
+    *request_time_ns = 0;
+    max_time_to_safepoint_ns_ = std::max(max_time_to_safepoint_ns_, time_ns);
+    Runtime::Current()->GetThreadList()->AddTimeToSafepoint(for_checkpoint, time_ns);
+  }
+  if (UNLIKELY(time_ns > kLongTimeToSafepointNs)) {
+    uint32_t dex_pc = 0;
+    mirror::ArtMethod* method = GetCurrentMethod(&dex_pc, false);
+    LOG(WARNING) << "Thread \"" << *tlsPtr_.name << "\" took " << PrettyDuration(time_ns)
+                 << " to reach a " << (for_checkpoint ? "checkpoint" : "suspension")
+                 << ", reached in " << PrettyMethod(method) << " at dex pc 0x" << std::hex
+                 << dex_pc;
+  }
+}
+
 bool Thread::RequestCheckpoint(Closure* function) {
   union StateAndFlags old_state_and_flags;
   old_state_and_flags.as_int = tls32_.state_and_flags.as_int;
@@ -720,6 +757,9 @@ bool Thread::RequestCheckpoint(Closure* function) {
     tlsPtr_.checkpoint_functions[available_checkpoint] = nullptr;
   } else {
     CHECK_EQ(ReadFlag(kCheckpointRequest), true);
+    if (checkpoint_request_time_ns_ == 0) {
+      checkpoint_request_time_ns_ = NanoTime();
+    }
     TriggerSuspend();
   }
   return success;
@@ -793,6 +833,7 @@ void Thread::DumpState(std::ostream& os, const Thread* thread, pid_t tid) {
     os << "  | group=\"" << group_name << "\""
        << " sCount=" << thread->tls32_.suspend_count
        << " dsCount=" << thread->tls32_.debug_suspend_count
+       << " maxTtsp=" << PrettyDuration(thread->max_time_to_safepoint_ns_)
        << " obj=" << reinterpret_cast<void*>(thread->tlsPtr_.opeer)
        << " self=" << reinterpret_cast<const void*>(thread) << "\n";
   }
@@ -926,7 +967,8 @@ struct StackDumpVisitor : public StackVisitor {
     if (o == nullptr) {
       os << "an unknown object";
     } else {
-      if ((o->GetLockWord(false).GetState() == LockWord::kThinLocked) &&
+      LockWord::LockState lock_state = o->GetLockWord(false).GetState();
+      if ((lock_state == LockWord::kThinLocked || lock_state == LockWord::kBiased) &&
           Locks::mutator_lock_->IsExclusiveHeld(Thread::Current())) {
         // Getting the identity hashcode here would result in lock inflation and suspension of the
         // current thread, which isn't safe if this is the only runnable thread.
@@ -1066,7 +1108,9 @@ void Thread::Shutdown() {
   }
 }
 
-Thread::Thread(bool daemon) : tls32_(daemon), wait_monitor_(nullptr), interrupted_(false) {
+Thread::Thread(bool daemon)
+    : tls32_(daemon), wait_monitor_(nullptr), interrupted_(false), checkpoint_request_time_ns_(0),
+      suspend_request_time_ns_(0), max_time_to_safepoint_ns_(0) {
   wait_mutex_ = new Mutex("a thread wait mutex");
   wait_cond_ = new ConditionVariable("a thread wait condition variable", *wait_mutex_);
   tlsPtr_.debug_invoke_req = new DebugInvokeReq;
@@ -1209,6 +1253,8 @@ Thread::~Thread() {
   free(tlsPtr_.nested_signal_state);
 
   Runtime::Current()->GetHeap()->RevokeThreadLocalBuffers(this);
+  LockContentionProfiler::ReleaseThreadBuffer(tlsPtr_.contention_sample_buffer);
+  CpuSamplingProfiler::ReleaseThreadBuffer(tlsPtr_.cpu_sample_buffer);
 
   TearDownAlternateSignalStack();
 }
@@ -1793,6 +1839,7 @@ void Thread::DumpThreadOffset(std::ostream& os, uint32_t offset) {
   DO_THREAD_OFFSET(TopShadowFrameOffset<ptr_size>(), "top_shadow_frame")
   DO_THREAD_OFFSET(TopHandleScopeOffset<ptr_size>(), "top_handle_scope")
   DO_THREAD_OFFSET(ThreadSuspendTriggerOffset<ptr_size>(), "suspend_trigger")
+  DO_THREAD_OFFSET(MethodTraceHooksOffset<ptr_size>(), "method_trace_hooks")
 #undef DO_THREAD_OFFSET
 
 #define INTERPRETER_ENTRY_POINT_INFO(x) \
@@ -1918,6 +1965,8 @@ void Thread::DumpThreadOffset(std::ostream& os, uint32_t offset) {
   QUICK_ENTRY_POINT_INFO(pInvokeSuperTrampolineWithAccessCheck)
   QUICK_ENTRY_POINT_INFO(pInvokeVirtualTrampolineWithAccessCheck)
   QUICK_ENTRY_POINT_INFO(pTestSuspend)
+  QUICK_ENTRY_POINT_INFO(pMethodEntryHook)
+  QUICK_ENTRY_POINT_INFO(pMethodExitHook)
   QUICK_ENTRY_POINT_INFO(pDeliverException)
   QUICK_ENTRY_POINT_INFO(pThrowArrayBounds)
   QUICK_ENTRY_POINT_INFO(pThrowDivZero)
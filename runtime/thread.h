@@ -67,6 +67,8 @@ class BaseMutex;
 class ClassLinker;
 class Closure;
 class Context;
+class ContentionSampleBuffer;
+class CpuSampleBuffer;
 struct DebugInvokeReq;
 class DexFile;
 class JavaVMExt;
@@ -78,6 +80,7 @@ class ShadowFrame;
 struct SingleStepControl;
 class Thread;
 class ThreadList;
+struct TraceThreadBuffer;
 
 // Thread priorities. These must match the Thread.MIN_PRIORITY,
 // Thread.NORM_PRIORITY, and Thread.MAX_PRIORITY constants.
@@ -90,7 +93,9 @@ enum ThreadPriority {
 enum ThreadFlag {
   kSuspendRequest   = 1,  // If set implies that suspend_count_ > 0 and the Thread should enter the
                           // safepoint handler.
-  kCheckpointRequest = 2  // Request that the thread do some checkpoint work and then continue.
+  kCheckpointRequest = 2,  // Request that the thread do some checkpoint work and then continue.
+  kCpuSampleRequest = 4   // Request that the thread records a sample of its stack for the
+                          // CpuSamplingProfiler.
 };
 
 static constexpr size_t kNumRosAllocThreadLocalSizeBrackets = 34;
@@ -281,6 +286,10 @@ class Thread {
     return tls32_.tid;
   }
 
+  pthread_t GetPthreadSelf() const {
+    return tlsPtr_.pthread_self;
+  }
+
   // Returns the java.lang.Thread's name, or NULL if this Thread* doesn't have a peer.
   mirror::String* GetThreadName(const ScopedObjectAccessAlreadyRunnable& ts) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -573,6 +582,12 @@ class Thread {
         OFFSETOF_MEMBER(tls_ptr_sized_values, suspend_trigger));
   }
 
+  template<size_t pointer_size>
+  static ThreadOffset<pointer_size> MethodTraceHooksOffset() {
+    return ThreadOffsetFromTlsPtr<pointer_size>(
+        OFFSETOF_MEMBER(tls_ptr_sized_values, method_trace_hooks));
+  }
+
   // Size of stack less any space reserved for stack overflow
   size_t GetStackSize() const {
     return tlsPtr_.stack_size - (tlsPtr_.stack_end - tlsPtr_.stack_begin);
@@ -762,6 +777,12 @@ class Thread {
 
   void RunCheckpointFunction();
 
+  // Records how long this thread took to reach a safepoint after a checkpoint or a suspension was
+  // requested, see ThreadList::AddTimeToSafepoint. Called Runnable, or for suspensions still
+  // holding the mutator lock just after leaving Runnable.
+  void RecordTimeToSafepoint(bool for_checkpoint)
+      LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_);
+
   bool ReadFlag(ThreadFlag flag) const {
     return (tls32_.state_and_flags.as_struct.flags & flag) != 0;
   }
@@ -853,6 +874,38 @@ class Thread {
     return tlsPtr_.nested_signal_state;
   }
 
+  ContentionSampleBuffer* GetContentionSampleBuffer() const {
+    return tlsPtr_.contention_sample_buffer;
+  }
+
+  void SetContentionSampleBuffer(ContentionSampleBuffer* buffer) {
+    tlsPtr_.contention_sample_buffer = buffer;
+  }
+
+  CpuSampleBuffer* GetCpuSampleBuffer() const {
+    return tlsPtr_.cpu_sample_buffer;
+  }
+
+  void SetCpuSampleBuffer(CpuSampleBuffer* buffer) {
+    tlsPtr_.cpu_sample_buffer = buffer;
+  }
+
+  TraceThreadBuffer* GetTraceBuffer() const {
+    return tlsPtr_.trace_buffer;
+  }
+
+  void SetTraceBuffer(TraceThreadBuffer* buffer) {
+    tlsPtr_.trace_buffer = buffer;
+  }
+
+  bool AreMethodTraceHooksEnabled() const {
+    return tlsPtr_.method_trace_hooks != 0;
+  }
+
+  void SetMethodTraceHooksEnabled(bool enabled) {
+    tlsPtr_.method_trace_hooks = enabled ? 1 : 0;
+  }
+
  private:
   explicit Thread(bool daemon);
   ~Thread() LOCKS_EXCLUDED(Locks::mutator_lock_,
@@ -1029,7 +1082,9 @@ class Thread {
       deoptimization_shadow_frame(nullptr), shadow_frame_under_construction(nullptr), name(nullptr),
       pthread_self(0), last_no_thread_suspension_cause(nullptr), thread_local_start(nullptr),
       thread_local_pos(nullptr), thread_local_end(nullptr), thread_local_objects(0),
-      thread_local_alloc_stack_top(nullptr), thread_local_alloc_stack_end(nullptr) {
+      thread_local_alloc_stack_top(nullptr), thread_local_alloc_stack_end(nullptr),
+      contention_sample_buffer(nullptr), cpu_sample_buffer(nullptr), trace_buffer(nullptr),
+      method_trace_hooks(0) {
     }
 
     // The biased card table, see CardTable for details.
@@ -1144,6 +1199,19 @@ class Thread {
 
     // Recorded thread state for nested signals.
     jmp_buf* nested_signal_state;
+
+    // Lock contention samples of this thread, owned by the LockContentionProfiler.
+    ContentionSampleBuffer* contention_sample_buffer;
+
+    // CPU profiling samples of this thread, owned by the CpuSamplingProfiler.
+    CpuSampleBuffer* cpu_sample_buffer;
+
+    // Chunk and defined methods of this thread in a streaming method trace, owned by the Trace.
+    TraceThreadBuffer* trace_buffer;
+
+    // Non-zero while compiled code with method trace hooks should report method entry and exit.
+    // Compiled code tests the low 32 bits.
+    size_t method_trace_hooks;
   } tlsPtr_;
 
   // Guards the 'interrupted_' and 'wait_monitor_' members.
@@ -1157,6 +1225,14 @@ class Thread {
   // Thread "interrupted" status; stays raised until queried or thrown.
   bool interrupted_ GUARDED_BY(wait_mutex_);
 
+  // When the oldest pending checkpoint and the current suspension were requested, 0 if none is
+  // pending or the thread already reached a safepoint for it.
+  uint64_t checkpoint_request_time_ns_ GUARDED_BY(Locks::thread_suspend_count_lock_);
+  uint64_t suspend_request_time_ns_ GUARDED_BY(Locks::thread_suspend_count_lock_);
+
+  // The longest this thread took to reach a safepoint, shown in its SIGQUIT dump.
+  uint64_t max_time_to_safepoint_ns_ GUARDED_BY(Locks::thread_suspend_count_lock_);
+
   friend class Dbg;  // For SetStateUnsafe.
   friend class gc::collector::SemiSpace;  // For getting stack traces.
   friend class Runtime;  // For CreatePeer.
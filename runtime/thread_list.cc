@@ -25,15 +25,19 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "base/histogram-inl.h"
 #include "base/mutex.h"
 #include "base/mutex-inl.h"
 #include "base/timing_logger.h"
 #include "debugger.h"
+#include "instrumentation.h"
 #include "jni_internal.h"
 #include "lock_word.h"
+#include "mirror/object-inl.h"
 #include "monitor.h"
 #include "scoped_thread_state_change.h"
 #include "thread.h"
+#include "thread_pool.h"
 #include "trace.h"
 #include "utils.h"
 #include "well_known_classes.h"
@@ -42,9 +46,20 @@ namespace art {
 
 static constexpr uint64_t kLongThreadSuspendThreshold = MsToNs(5);
 
+// Time to safepoint histogram bucket width and count, in microseconds.
+static constexpr size_t kTimeToSafepointBucketSize = 10;
+static constexpr size_t kTimeToSafepointBucketCount = 100;
+
+// Fewer suspended threads than this get their checkpoints run by the caller alone.
+static constexpr size_t kMinParallelCheckpointThreads = 4;
+
 ThreadList::ThreadList()
     : suspend_all_count_(0), debug_suspend_all_count_(0),
-      thread_exit_cond_("thread exit condition variable", *Locks::thread_list_lock_) {
+      thread_exit_cond_("thread exit condition variable", *Locks::thread_list_lock_),
+      checkpoint_time_to_safepoint_("Checkpoint time to safepoint", kTimeToSafepointBucketSize,
+                                    kTimeToSafepointBucketCount),
+      suspend_time_to_safepoint_("Suspend time to safepoint", kTimeToSafepointBucketSize,
+                                 kTimeToSafepointBucketCount) {
   CHECK(Monitor::IsValidLockWord(LockWord::FromThinLockId(kMaxThreadId, 1)));
 }
 
@@ -95,11 +110,29 @@ void ThreadList::DumpNativeStacks(std::ostream& os) {
 }
 
 void ThreadList::DumpForSigQuit(std::ostream& os) {
+  Thread* self = Thread::Current();
   {
-    MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+    MutexLock mu(self, *Locks::thread_list_lock_);
     DumpLocked(os);
   }
   DumpUnattachedThreads(os);
+  {
+    MutexLock mu(self, *Locks::thread_suspend_count_lock_);
+    for (Histogram<uint64_t>* histogram : {&checkpoint_time_to_safepoint_,
+                                           &suspend_time_to_safepoint_}) {
+      if (histogram->SampleSize() != 0) {
+        Histogram<uint64_t>::CumulativeData cumulative_data;
+        histogram->CreateHistogram(&cumulative_data);
+        histogram->PrintConfidenceIntervals(os, 0.99, cumulative_data);
+      }
+    }
+  }
+}
+
+void ThreadList::AddTimeToSafepoint(bool for_checkpoint, uint64_t time_ns) {
+  Histogram<uint64_t>* histogram =
+      for_checkpoint ? &checkpoint_time_to_safepoint_ : &suspend_time_to_safepoint_;
+  histogram->AddValue(time_ns / 1000);
 }
 
 static void DumpUnattachedThread(std::ostream& os, pid_t tid) NO_THREAD_SAFETY_ANALYSIS {
@@ -193,7 +226,43 @@ static void ThreadSuspendSleep(Thread* self, useconds_t* delay_us, useconds_t* t
   }
 }
 
-size_t ThreadList::RunCheckpoint(Closure* checkpoint_function) {
+// Runs a checkpoint on behalf of a suspended thread on a thread pool worker.
+class RunCheckpointTask : public Task {
+ public:
+  RunCheckpointTask(Closure* checkpoint_function, Thread* thread)
+      : checkpoint_function_(checkpoint_function), thread_(thread) {
+  }
+
+  virtual void Run(Thread* self) {
+    checkpoint_function_->Run(thread_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  Closure* const checkpoint_function_;
+  Thread* const thread_;
+};
+
+static void WaitForThreadSuspend(Thread* self, Thread* thread) {
+  if (!thread->IsSuspended()) {
+    // Wait until the thread is suspended.
+    useconds_t total_delay_us = 0;
+    do {
+      useconds_t delay_us = 100;
+      ThreadSuspendSleep(self, &delay_us, &total_delay_us);
+    } while (!thread->IsSuspended());
+    // Shouldn't need to wait for longer than 1000 microseconds.
+    constexpr useconds_t kLongWaitThresholdUS = 1000;
+    if (UNLIKELY(total_delay_us > kLongWaitThresholdUS)) {
+      LOG(WARNING) << "Waited " << total_delay_us << " us for thread suspend!";
+    }
+  }
+}
+
+size_t ThreadList::RunCheckpoint(Closure* checkpoint_function, ThreadPool* thread_pool) {
   Thread* self = Thread::Current();
   Locks::mutator_lock_->AssertNotExclusiveHeld(self);
   Locks::thread_list_lock_->AssertNotHeld(self);
@@ -236,26 +305,29 @@ size_t ThreadList::RunCheckpoint(Closure* checkpoint_function) {
   checkpoint_function->Run(self);
 
   // Run the checkpoint on the suspended threads.
-  for (const auto& thread : suspended_count_modified_threads) {
-    if (!thread->IsSuspended()) {
-      // Wait until the thread is suspended.
-      useconds_t total_delay_us = 0;
-      do {
-        useconds_t delay_us = 100;
-        ThreadSuspendSleep(self, &delay_us, &total_delay_us);
-      } while (!thread->IsSuspended());
-      // Shouldn't need to wait for longer than 1000 microseconds.
-      constexpr useconds_t kLongWaitThresholdUS = 1000;
-      if (UNLIKELY(total_delay_us > kLongWaitThresholdUS)) {
-        LOG(WARNING) << "Waited " << total_delay_us << " us for thread suspend!";
-      }
+  if (thread_pool != nullptr &&
+      suspended_count_modified_threads.size() >= kMinParallelCheckpointThreads) {
+    thread_pool->StartWorkers(self);
+    for (const auto& thread : suspended_count_modified_threads) {
+      WaitForThreadSuspend(self, thread);
+      thread_pool->AddTask(self, new RunCheckpointTask(checkpoint_function, thread));
     }
-    // We know for sure that the thread is suspended at this point.
-    checkpoint_function->Run(thread);
-    {
-      MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
+    thread_pool->Wait(self, true, true);
+    thread_pool->StopWorkers(self);
+    MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
+    for (const auto& thread : suspended_count_modified_threads) {
       thread->ModifySuspendCount(self, -1, false);
     }
+  } else {
+    for (const auto& thread : suspended_count_modified_threads) {
+      WaitForThreadSuspend(self, thread);
+      // We know for sure that the thread is suspended at this point.
+      checkpoint_function->Run(thread);
+      {
+        MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
+        thread->ModifySuspendCount(self, -1, false);
+      }
+    }
   }
 
   {
@@ -826,6 +898,10 @@ void ThreadList::Register(Thread* self) {
   }
   CHECK(!Contains(self));
   list_.push_back(self);
+  // Instrumentation sets the method trace hooks of the threads in the list while holding the
+  // thread list lock, a thread registering concurrently gets the flag from here.
+  self->SetMethodTraceHooksEnabled(
+      Runtime::Current()->GetInstrumentation()->AreMethodTraceHooksEnabled());
 }
 
 void ThreadList::Unregister(Thread* self) {
@@ -889,6 +965,45 @@ void ThreadList::VisitRoots(RootCallback* callback, void* arg) const {
   }
 }
 
+// Visits the roots of a single suspended thread on a thread pool worker.
+class VisitThreadRootsTask : public Task {
+ public:
+  VisitThreadRootsTask(Thread* thread, RootCallback* callback, void* arg)
+      : thread_(thread), callback_(callback), arg_(arg) {
+  }
+
+  // The caller of VisitRootsParallel holds the mutator lock on our behalf.
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    thread_->VisitRoots(callback_, arg_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  Thread* const thread_;
+  RootCallback* const callback_;
+  void* const arg_;
+};
+
+void ThreadList::VisitRootsParallel(RootCallback* callback, void* arg, ThreadPool* thread_pool,
+                                    size_t thread_count) const {
+  if (thread_pool == nullptr || thread_count <= 1) {
+    VisitRoots(callback, arg);
+    return;
+  }
+  Thread* self = Thread::Current();
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  for (const auto& thread : list_) {
+    thread_pool->AddTask(self, new VisitThreadRootsTask(thread, callback, arg));
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+}
+
 class VerifyRootWrapperArg {
  public:
   VerifyRootWrapperArg(VerifyRootCallback* callback, void* arg) : callback_(callback), arg_(arg) {
@@ -923,6 +1038,17 @@ uint32_t ThreadList::AllocThreadId(Thread* self) {
   return 0;
 }
 
+bool ThreadList::ReplaceLockWordOfExitedThread(Thread* self, mirror::Object* obj,
+                                               LockWord biased_lock_word,
+                                               LockWord new_lock_word) {
+  DCHECK_EQ(biased_lock_word.GetState(), LockWord::kBiased);
+  MutexLock mu(self, *Locks::allocated_thread_ids_lock_);
+  if (allocated_ids_[biased_lock_word.BiasOwner() - 1]) {  // Zero is reserved to mean "invalid".
+    return false;
+  }
+  return obj->CasLockWordWeakSequentiallyConsistent(biased_lock_word, new_lock_word);
+}
+
 void ThreadList::ReleaseThreadId(Thread* self, uint32_t id) {
   MutexLock mu(self, *Locks::allocated_thread_ids_lock_);
   --id;  // Zero is reserved to mean "invalid".
@@ -17,16 +17,22 @@
 #ifndef ART_RUNTIME_THREAD_LIST_H_
 #define ART_RUNTIME_THREAD_LIST_H_
 
+#include "base/histogram.h"
 #include "base/mutex.h"
 #include "jni.h"
+#include "lock_word.h"
 #include "object_callbacks.h"
 
 #include <bitset>
 #include <list>
 
 namespace art {
+namespace mirror {
+  class Object;
+}  // namespace mirror
 class Closure;
 class Thread;
+class ThreadPool;
 class TimingLogger;
 
 class ThreadList {
@@ -86,9 +92,20 @@ class ThreadList {
   // Find an already suspended thread (or self) by its id.
   Thread* FindThreadByThreadId(uint32_t thin_lock_id);
 
+  // Replace the lock word of obj, biased towards a thread id that isn't allocated to any thread,
+  // with new_lock_word. The thread id can't be reallocated while we do so, so no new thread can
+  // mistake itself for the bias owner. Returns false if the thread id is in use or the lock word
+  // changed.
+  bool ReplaceLockWordOfExitedThread(Thread* self, mirror::Object* obj, LockWord biased_lock_word,
+                                     LockWord new_lock_word)
+      LOCKS_EXCLUDED(Locks::allocated_thread_ids_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Run a checkpoint on threads, running threads are not suspended but run the checkpoint inside
-  // of the suspend check. Returns how many checkpoints we should expect to run.
-  size_t RunCheckpoint(Closure* checkpoint_function)
+  // of the suspend check. Returns how many checkpoints we should expect to run. Given a
+  // thread_pool, the checkpoints of suspended threads are run by its started workers and the
+  // caller in parallel, otherwise by the caller one after the other.
+  size_t RunCheckpoint(Closure* checkpoint_function, ThreadPool* thread_pool = nullptr)
       LOCKS_EXCLUDED(Locks::thread_list_lock_,
                      Locks::thread_suspend_count_lock_);
 
@@ -121,6 +138,18 @@ class ThreadList {
   void VisitRoots(RootCallback* callback, void* arg) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Like VisitRoots with all threads suspended, but the roots of different threads are visited by
+  // up to thread_count - 1 workers of thread_pool and the caller in parallel. The callback has to
+  // be thread safe.
+  void VisitRootsParallel(RootCallback* callback, void* arg, ThreadPool* thread_pool,
+                          size_t thread_count) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Adds how long a Runnable thread took to reach a safepoint after a checkpoint or suspension
+  // was requested to the histograms shown in the SIGQUIT dump.
+  void AddTimeToSafepoint(bool for_checkpoint, uint64_t time_ns)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_suspend_count_lock_);
+
   void VerifyRoots(VerifyRootCallback* callback, void* arg) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -165,6 +194,11 @@ class ThreadList {
   // Signaled when threads terminate. Used to determine when all non-daemons have terminated.
   ConditionVariable thread_exit_cond_ GUARDED_BY(Locks::thread_list_lock_);
 
+  // Time to safepoint of Runnable threads, in microseconds.
+  Histogram<uint64_t> checkpoint_time_to_safepoint_
+      GUARDED_BY(Locks::thread_suspend_count_lock_);
+  Histogram<uint64_t> suspend_time_to_safepoint_ GUARDED_BY(Locks::thread_suspend_count_lock_);
+
   friend class Thread;
 
   DISALLOW_COPY_AND_ASSIGN(ThreadList);
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thread_list.h"
+
+#include <unistd.h>
+
+#include <list>
+#include <map>
+#include <set>
+
+#include "barrier.h"
+#include "base/mutex.h"
+#include "closure.h"
+#include "common_runtime_test.h"
+#include "thread-inl.h"
+#include "thread_pool.h"
+
+namespace art {
+
+class ThreadListTest : public CommonRuntimeTest {};
+
+// Records the threads it ran for and the threads it ran on.
+class CheckpointRecorder : public Closure {
+ public:
+  CheckpointRecorder() : lock_("checkpoint recorder lock"), barrier_(0) {}
+
+  void Run(Thread* thread) OVERRIDE {
+    Thread* self = Thread::Current();
+    // A thread runs its own checkpoint at a suspend check, others run it while it is suspended.
+    if (thread != self) {
+      EXPECT_TRUE(thread->IsSuspended());
+      // Take long enough for the checkpoints of suspended threads to be spread over the workers.
+      usleep(1000);
+    }
+    {
+      MutexLock mu(self, lock_);
+      ++runs_[thread];
+      runners_.insert(self);
+    }
+    barrier_.Pass(self);
+  }
+
+  // Wait for count checkpoints to have run.
+  void Wait(Thread* self, size_t count) {
+    barrier_.Increment(self, count);
+  }
+
+  std::map<Thread*, size_t> GetRuns() {
+    MutexLock mu(Thread::Current(), lock_);
+    return runs_;
+  }
+
+  size_t NumRunners() {
+    MutexLock mu(Thread::Current(), lock_);
+    return runners_.size();
+  }
+
+ private:
+  Mutex lock_;
+  std::map<Thread*, size_t> runs_ GUARDED_BY(lock_);
+  std::set<Thread*> runners_ GUARDED_BY(lock_);
+  Barrier barrier_;
+};
+
+TEST_F(ThreadListTest, ParallelCheckpoint) {
+  static const size_t kSuspendedThreads = 16;
+  static const size_t kCheckpointThreads = 4;
+  Thread* self = Thread::Current();
+  ThreadList* thread_list = Runtime::Current()->GetThreadList();
+  // The workers of a pool wait for tasks in native code, so they are suspended.
+  ThreadPool suspended_threads("Suspended thread pool", kSuspendedThreads);
+  ThreadPool checkpoint_pool("Checkpoint thread pool", kCheckpointThreads);
+  std::list<Thread*> threads;
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    threads = thread_list->GetList();
+  }
+  ASSERT_GE(threads.size(), kSuspendedThreads + kCheckpointThreads + 1);
+
+  CheckpointRecorder recorder;
+  const size_t count = thread_list->RunCheckpoint(&recorder, &checkpoint_pool);
+  EXPECT_EQ(threads.size(), count);
+  recorder.Wait(self, count);
+
+  // Every thread had its checkpoint run exactly once.
+  std::map<Thread*, size_t> runs = recorder.GetRuns();
+  EXPECT_EQ(threads.size(), runs.size());
+  for (Thread* thread : threads) {
+    EXPECT_EQ(1U, runs[thread]) << *thread;
+  }
+  // The caller ran checkpoints and so did workers of the pool.
+  EXPECT_GT(recorder.NumRunners(), 1U);
+
+  // The pool is stopped again and can be used for a checkpoint without being restarted.
+  CheckpointRecorder second_recorder;
+  const size_t second_count = thread_list->RunCheckpoint(&second_recorder, &checkpoint_pool);
+  EXPECT_EQ(count, second_count);
+  second_recorder.Wait(self, second_count);
+  EXPECT_EQ(threads.size(), second_recorder.GetRuns().size());
+}
+
+}  // namespace art
@@ -17,6 +17,9 @@
 #include "trace.h"
 
 #include <sys/uio.h>
+#include <unistd.h>
+
+#include <unordered_set>
 
 #include "base/stl_util.h"
 #include "base/unix_file/fd_file.h"
@@ -74,6 +77,34 @@ namespace art {
 // 32 bits of microseconds is 70 minutes.
 //
 // All values are stored in little-endian order.
+//
+// Streaming file format:
+//     header, with 0xF0 set in the version
+//     record or definition 0
+//     record or definition 1
+//     ...
+//     summary
+//
+// Records are as above. Definitions and the summary use a thread ID of 0:
+//     u2  0
+//     u1  kOpNewMethod
+//     u2  length
+//     ... method line, as in the methods section of the buffered format
+//
+//     u2  0
+//     u1  kOpNewThread
+//     u2  thread ID
+//     u2  length
+//     ... thread name
+//
+//     u2  0
+//     u1  kOpTraceSummary
+//     u4  length
+//     ... version and threads sections, as in the buffered format
+//
+// A method is defined before the first record that uses it in each thread, so it may be defined
+// once per thread. Records of each thread are in order, records of different threads are
+// interleaved in chunks.
 
 enum TraceAction {
     kTraceMethodEnter = 0x00,       // method entry
@@ -113,6 +144,35 @@ static const uint16_t kTraceVersionSingleClock    = 2;
 static const uint16_t kTraceVersionDualClock      = 3;
 static const uint16_t kTraceRecordSizeSingleClock = 10;  // using v2
 static const uint16_t kTraceRecordSizeDualClock   = 14;  // using v3 with two timestamps
+static const uint16_t kTraceVersionStreamingFlag  = 0xF0;
+
+static const uint8_t kOpNewMethod    = 1U;
+static const uint8_t kOpNewThread    = 2U;
+static const uint8_t kOpTraceSummary = 3U;
+
+// Size of the chunks threads record into when streaming.
+static const size_t kTraceChunkSize = 16 * KB;
+
+struct TraceChunk {
+  size_t size;
+  uint8_t data[kTraceChunkSize];
+};
+
+// The streaming state of a thread, only accessed by the thread itself except when it is handed
+// to the writer as the thread exits or tracing stops.
+struct TraceThreadBuffer {
+  explicit TraceThreadBuffer(TraceChunk* initial_chunk)
+      : chunk(initial_chunk), num_records(0) {}
+
+  // Chunk being filled, NULL once handed to the writer for the last time.
+  TraceChunk* chunk;
+
+  // Number of method records, for the summary.
+  size_t num_records;
+
+  // Methods defined by this thread, looked up on every event.
+  std::unordered_set<mirror::ArtMethod*> defined_methods;
+};
 
 TraceClockSource Trace::default_clock_source_ = kDefaultTraceClockSource;
 
@@ -325,7 +385,8 @@ void* Trace::RunSamplingThread(void* arg) {
 }
 
 void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int flags,
-                  bool direct_to_ddms, bool sampling_enabled, int interval_us) {
+                  bool direct_to_ddms, bool sampling_enabled, int interval_us,
+                  TraceOutputMode output_mode) {
   Thread* self = Thread::Current();
   {
     MutexLock mu(self, *Locks::trace_lock_);
@@ -343,6 +404,13 @@ void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int
     return;
   }
 
+  // Streaming writes to a file, and the sampling thread records events on behalf of other
+  // threads, which the per-thread chunks do not allow.
+  if (output_mode == kTraceOutputModeStreaming && (direct_to_ddms || sampling_enabled)) {
+    LOG(WARNING) << "Streaming is only supported for method tracing to a file, buffering instead";
+    output_mode = kTraceOutputModeBuffered;
+  }
+
   // Open trace file if not going directly to ddms.
   std::unique_ptr<File> trace_file;
   if (!direct_to_ddms) {
@@ -373,8 +441,14 @@ void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int
     if (the_trace_ != NULL) {
       LOG(ERROR) << "Trace already in progress, ignoring this request";
     } else {
-      enable_stats = (flags && kTraceCountAllocs) != 0;
-      the_trace_ = new Trace(trace_file.release(), buffer_size, flags, sampling_enabled);
+      enable_stats = (flags & kTraceCountAllocs) != 0;
+      the_trace_ = new Trace(trace_file.release(), buffer_size, flags, sampling_enabled,
+                             output_mode);
+      if (output_mode == kTraceOutputModeStreaming) {
+        CHECK_PTHREAD_CALL(pthread_create, (&the_trace_->writer_pthread_, NULL,
+                                            &RunStreamingWriterThread, the_trace_),
+                                            "Method trace writer thread");
+      }
       if (sampling_enabled) {
         CHECK_PTHREAD_CALL(pthread_create, (&sampling_pthread_, NULL, &RunSamplingThread,
                                             reinterpret_cast<void*>(interval_us)),
@@ -413,9 +487,14 @@ void Trace::Stop() {
       sampling_pthread = sampling_pthread_;
     }
   }
+  bool streaming = the_trace != NULL && the_trace->output_mode_ == kTraceOutputModeStreaming;
   if (the_trace != NULL) {
     stop_alloc_counting = (the_trace->flags_ & kTraceCountAllocs) != 0;
-    the_trace->FinishTracing();
+    if (streaming) {
+      the_trace->StopStreaming(Thread::Current());
+    } else {
+      the_trace->FinishTracing();
+    }
 
     if (the_trace->sampling_enabled_) {
       MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
@@ -427,10 +506,35 @@ void Trace::Stop() {
                                                     instrumentation::Instrumentation::kMethodExited |
                                                     instrumentation::Instrumentation::kMethodUnwind);
     }
-    delete the_trace;
+    if (!streaming) {
+      delete the_trace;
+    }
   }
   runtime->GetThreadList()->ResumeAll();
 
+  // The writer thread attaches and detaches, so it is waited for with threads running. No thread
+  // records into the trace any longer, but threads that waited for a chunk may not have noticed.
+  if (streaming) {
+    CHECK_PTHREAD_CALL(pthread_join, (the_trace->writer_pthread_, NULL), "trace writer shutdown");
+    the_trace->FinishStreaming();
+    while (true) {
+      runtime->GetThreadList()->SuspendAll();
+      bool waiting;
+      {
+        MutexLock mu(Thread::Current(), the_trace->streaming_lock_);
+        waiting = the_trace->num_waiting_threads_ != 0;
+      }
+      if (!waiting) {
+        delete the_trace;
+      }
+      runtime->GetThreadList()->ResumeAll();
+      if (!waiting) {
+        break;
+      }
+      usleep(1000);
+    }
+  }
+
   if (stop_alloc_counting) {
     // Can be racy since SetStatsEnabled is not guarded by any locks.
     Runtime::Current()->SetStatsEnabled(false);
@@ -459,19 +563,33 @@ TracingMode Trace::GetMethodTracingMode() {
   }
 }
 
-Trace::Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled)
-    : trace_file_(trace_file), buf_(new uint8_t[buffer_size]()), flags_(flags),
-      sampling_enabled_(sampling_enabled), clock_source_(default_clock_source_),
+Trace::Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled,
+             TraceOutputMode output_mode)
+    : trace_file_(trace_file),
+      // A streaming trace only keeps its header here, the records go into per-thread chunks.
+      buf_(new uint8_t[output_mode == kTraceOutputModeStreaming ? kTraceHeaderLength
+                                                                 : buffer_size]()),
+      flags_(flags), sampling_enabled_(sampling_enabled), clock_source_(default_clock_source_),
       buffer_size_(buffer_size), start_time_(MicroTime()),
-      clock_overhead_ns_(GetClockOverheadNanoSeconds()), cur_offset_(0), overflow_(false) {
+      clock_overhead_ns_(GetClockOverheadNanoSeconds()), cur_offset_(0), overflow_(false),
+      output_mode_(output_mode),
+      streaming_lock_("trace streaming lock"),
+      chunk_full_cond_("trace chunk full condition", streaming_lock_),
+      chunk_free_cond_("trace chunk free condition", streaming_lock_),
+      num_chunks_(0), num_pending_chunks_(0),
+      max_chunks_(std::max<size_t>(buffer_size / kTraceChunkSize, 2)), num_waiting_threads_(0),
+      writer_stopping_(false), write_failed_(false), writer_pthread_(0U) {
   // Set up the beginning of the trace.
   uint16_t trace_version = GetTraceVersion(clock_source_);
+  if (output_mode == kTraceOutputModeStreaming) {
+    trace_version |= kTraceVersionStreamingFlag;
+  }
   memset(buf_.get(), 0, kTraceHeaderLength);
   Append4LE(buf_.get(), kTraceMagicValue);
   Append2LE(buf_.get() + 4, trace_version);
   Append2LE(buf_.get() + 6, kTraceHeaderLength);
   Append8LE(buf_.get() + 8, start_time_);
-  if (trace_version >= kTraceVersionDualClock) {
+  if (GetTraceVersion(clock_source_) >= kTraceVersionDualClock) {
     uint16_t record_size = GetRecordSize(clock_source_);
     Append2LE(buf_.get() + 16, record_size);
   }
@@ -480,6 +598,12 @@ Trace::Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled
   cur_offset_.StoreRelaxed(kTraceHeaderLength);
 }
 
+Trace::~Trace() {
+  STLDeleteElements(&thread_buffers_);
+  STLDeleteElements(&free_chunks_);
+  DCHECK(full_chunks_.empty());
+}
+
 static void DumpBuf(uint8_t* buf, size_t buf_size, TraceClockSource clock_source)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   uint8_t* ptr = buf + kTraceHeaderLength;
@@ -495,40 +619,14 @@ static void DumpBuf(uint8_t* buf, size_t buf_size, TraceClockSource clock_source
 }
 
 void Trace::FinishTracing() {
-  // Compute elapsed time.
-  uint64_t elapsed = MicroTime() - start_time_;
-
   size_t final_offset = cur_offset_.LoadRelaxed();
 
   std::set<mirror::ArtMethod*> visited_methods;
   GetVisitedMethods(final_offset, &visited_methods);
 
   std::ostringstream os;
-
-  os << StringPrintf("%cversion\n", kTraceTokenChar);
-  os << StringPrintf("%d\n", GetTraceVersion(clock_source_));
-  os << StringPrintf("data-file-overflow=%s\n", overflow_ ? "true" : "false");
-  if (UseThreadCpuClock()) {
-    if (UseWallClock()) {
-      os << StringPrintf("clock=dual\n");
-    } else {
-      os << StringPrintf("clock=thread-cpu\n");
-    }
-  } else {
-    os << StringPrintf("clock=wall\n");
-  }
-  os << StringPrintf("elapsed-time-usec=%" PRIu64 "\n", elapsed);
   size_t num_records = (final_offset - kTraceHeaderLength) / GetRecordSize(clock_source_);
-  os << StringPrintf("num-method-calls=%zd\n", num_records);
-  os << StringPrintf("clock-call-overhead-nsec=%d\n", clock_overhead_ns_);
-  os << StringPrintf("vm=art\n");
-  if ((flags_ & kTraceCountAllocs) != 0) {
-    os << StringPrintf("alloc-count=%d\n", Runtime::Current()->GetStat(KIND_ALLOCATED_OBJECTS));
-    os << StringPrintf("alloc-size=%d\n", Runtime::Current()->GetStat(KIND_ALLOCATED_BYTES));
-    os << StringPrintf("gc-count=%d\n", Runtime::Current()->GetStat(KIND_GC_INVOCATIONS));
-  }
-  os << StringPrintf("%cthreads\n", kTraceTokenChar);
-  DumpThreadList(os);
+  DumpSummary(os, num_records, overflow_);
   os << StringPrintf("%cmethods\n", kTraceTokenChar);
   DumpMethodList(os, visited_methods);
   os << StringPrintf("%cend\n", kTraceTokenChar);
@@ -556,6 +654,35 @@ void Trace::FinishTracing() {
   }
 }
 
+void Trace::DumpSummary(std::ostream& os, size_t num_records, bool overflow) {
+  // Compute elapsed time.
+  uint64_t elapsed = MicroTime() - start_time_;
+
+  os << StringPrintf("%cversion\n", kTraceTokenChar);
+  os << StringPrintf("%d\n", GetTraceVersion(clock_source_));
+  os << StringPrintf("data-file-overflow=%s\n", overflow ? "true" : "false");
+  if (UseThreadCpuClock()) {
+    if (UseWallClock()) {
+      os << StringPrintf("clock=dual\n");
+    } else {
+      os << StringPrintf("clock=thread-cpu\n");
+    }
+  } else {
+    os << StringPrintf("clock=wall\n");
+  }
+  os << StringPrintf("elapsed-time-usec=%" PRIu64 "\n", elapsed);
+  os << StringPrintf("num-method-calls=%zd\n", num_records);
+  os << StringPrintf("clock-call-overhead-nsec=%d\n", clock_overhead_ns_);
+  os << StringPrintf("vm=art\n");
+  if ((flags_ & kTraceCountAllocs) != 0) {
+    os << StringPrintf("alloc-count=%d\n", Runtime::Current()->GetStat(KIND_ALLOCATED_OBJECTS));
+    os << StringPrintf("alloc-size=%d\n", Runtime::Current()->GetStat(KIND_ALLOCATED_BYTES));
+    os << StringPrintf("gc-count=%d\n", Runtime::Current()->GetStat(KIND_GC_INVOCATIONS));
+  }
+  os << StringPrintf("%cthreads\n", kTraceTokenChar);
+  DumpThreadList(os);
+}
+
 void Trace::DexPcMoved(Thread* thread, mirror::Object* this_object,
                        mirror::ArtMethod* method, uint32_t new_dex_pc) {
   // We're not recorded to listen to this kind of event, so complain.
@@ -632,18 +759,6 @@ void Trace::ReadClocks(Thread* thread, uint32_t* thread_clock_diff, uint32_t* wa
 void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
                                 instrumentation::Instrumentation::InstrumentationEvent event,
                                 uint32_t thread_clock_diff, uint32_t wall_clock_diff) {
-  // Advance cur_offset_ atomically.
-  int32_t new_offset;
-  int32_t old_offset;
-  do {
-    old_offset = cur_offset_.LoadRelaxed();
-    new_offset = old_offset + GetRecordSize(clock_source_);
-    if (new_offset > buffer_size_) {
-      overflow_ = true;
-      return;
-    }
-  } while (!cur_offset_.CompareExchangeWeakSequentiallyConsistent(old_offset, new_offset));
-
   TraceAction action = kTraceMethodEnter;
   switch (event) {
     case instrumentation::Instrumentation::kMethodEntered:
@@ -661,8 +776,38 @@ void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
 
   uint32_t method_value = EncodeTraceMethodAndAction(method, action);
 
+  uint8_t* ptr;
+  if (output_mode_ == kTraceOutputModeStreaming) {
+    // Events are only recorded by the thread itself when streaming.
+    DCHECK_EQ(thread, Thread::Current());
+    TraceThreadBuffer* buffer = thread->GetTraceBuffer();
+    if (UNLIKELY(buffer == NULL)) {
+      buffer = AddThreadBuffer(thread);
+    }
+    if (UNLIKELY(buffer->defined_methods.find(method) == buffer->defined_methods.end())) {
+      WriteMethodDefinition(thread, buffer, method);
+    }
+    ptr = ReserveStreamingSpace(thread, buffer, GetRecordSize(clock_source_));
+    if (UNLIKELY(ptr == NULL)) {
+      return;
+    }
+    ++buffer->num_records;
+  } else {
+    // Advance cur_offset_ atomically.
+    int32_t new_offset;
+    int32_t old_offset;
+    do {
+      old_offset = cur_offset_.LoadRelaxed();
+      new_offset = old_offset + GetRecordSize(clock_source_);
+      if (new_offset > buffer_size_) {
+        overflow_ = true;
+        return;
+      }
+    } while (!cur_offset_.CompareExchangeWeakSequentiallyConsistent(old_offset, new_offset));
+    ptr = buf_.get() + old_offset;
+  }
+
   // Write data
-  uint8_t* ptr = buf_.get() + old_offset;
   Append2LE(ptr, thread->GetTid());
   Append4LE(ptr + 2, method_value);
   ptr += 6;
@@ -676,6 +821,217 @@ void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
   }
 }
 
+TraceThreadBuffer* Trace::AddThreadBuffer(Thread* self) {
+  TraceThreadBuffer* buffer;
+  {
+    MutexLock mu(self, streaming_lock_);
+    buffer = new TraceThreadBuffer(AllocChunkLocked());
+    thread_buffers_.push_back(buffer);
+  }
+  self->SetTraceBuffer(buffer);
+
+  std::string name;
+  self->GetThreadName(name);
+  size_t length = std::min<size_t>(name.length(), kTraceChunkSize - 7);
+  uint8_t* ptr = ReserveStreamingSpace(self, buffer, 7 + length);
+  if (ptr == NULL) {
+    return buffer;
+  }
+  Append2LE(ptr, 0);
+  ptr[2] = kOpNewThread;
+  Append2LE(ptr + 3, self->GetTid());
+  Append2LE(ptr + 5, length);
+  memcpy(ptr + 7, name.c_str(), length);
+  return buffer;
+}
+
+void Trace::WriteMethodDefinition(Thread* self, TraceThreadBuffer* buffer,
+                                  mirror::ArtMethod* method) {
+  buffer->defined_methods.insert(method);
+  std::ostringstream os;
+  std::set<mirror::ArtMethod*> methods;
+  methods.insert(method);
+  DumpMethodList(os, methods);
+  std::string line(os.str());
+  size_t length = std::min<size_t>(line.length(), kTraceChunkSize - 5);
+  uint8_t* ptr = ReserveStreamingSpace(self, buffer, 5 + length);
+  if (ptr == NULL) {
+    return;
+  }
+  Append2LE(ptr, 0);
+  ptr[2] = kOpNewMethod;
+  Append2LE(ptr + 3, length);
+  memcpy(ptr + 5, line.c_str(), length);
+}
+
+uint8_t* Trace::ReserveStreamingSpace(Thread* self, TraceThreadBuffer* buffer, size_t size) {
+  DCHECK_LE(size, kTraceChunkSize);
+  TraceChunk* chunk = buffer->chunk;
+  if (UNLIKELY(chunk != NULL && chunk->size + size > kTraceChunkSize)) {
+    chunk = HandOffChunk(self, buffer);
+  }
+  if (UNLIKELY(chunk == NULL)) {
+    return NULL;
+  }
+  uint8_t* ptr = chunk->data + chunk->size;
+  chunk->size += size;
+  return ptr;
+}
+
+TraceChunk* Trace::HandOffChunk(Thread* self, TraceThreadBuffer* buffer) {
+  {
+    MutexLock mu(self, streaming_lock_);
+    QueueChunkLocked(buffer->chunk);
+    buffer->chunk = NULL;
+    if (!free_chunks_.empty() || num_chunks_ < max_chunks_ || num_pending_chunks_ == 0) {
+      buffer->chunk = AllocChunkLocked();
+      return buffer->chunk;
+    }
+    ++num_waiting_threads_;
+  }
+  // Rather than dropping records, wait for the writer to return a chunk once the budget is used
+  // up. Waiting only while the writer has chunks in flight guarantees progress however many
+  // threads hold a chunk. The wait is suspended so that it never holds up a suspend all.
+  {
+    ScopedThreadStateChange tsc(self, kNative);
+    MutexLock mu(self, streaming_lock_);
+    while (free_chunks_.empty() && num_chunks_ >= max_chunks_ && num_pending_chunks_ != 0 &&
+           !writer_stopping_) {
+      chunk_free_cond_.Wait(self);
+    }
+  }
+  MutexLock mu(self, streaming_lock_);
+  --num_waiting_threads_;
+  // The trace may have been stopped while suspended, the chunks are then no longer written.
+  if (!writer_stopping_) {
+    buffer->chunk = AllocChunkLocked();
+  }
+  return buffer->chunk;
+}
+
+TraceChunk* Trace::AllocChunkLocked() {
+  TraceChunk* chunk;
+  if (!free_chunks_.empty()) {
+    chunk = free_chunks_.back();
+    free_chunks_.pop_back();
+  } else {
+    chunk = new TraceChunk;
+    ++num_chunks_;
+  }
+  chunk->size = 0;
+  return chunk;
+}
+
+void Trace::QueueChunkLocked(TraceChunk* chunk) {
+  full_chunks_.push_back(chunk);
+  ++num_pending_chunks_;
+  chunk_full_cond_.Signal(Thread::Current());
+}
+
+void* Trace::RunStreamingWriterThread(void* arg) {
+  Runtime* runtime = Runtime::Current();
+  Trace* the_trace = reinterpret_cast<Trace*>(arg);
+  // No peer so that no managed code, and so no traced method, runs on this thread.
+  CHECK(runtime->AttachCurrentThread("Method Trace Writer", true, NULL, false));
+  the_trace->WriteStreamingChunks(Thread::Current());
+  runtime->DetachCurrentThread();
+  return NULL;
+}
+
+void Trace::WriteStreamingChunks(Thread* self) {
+  if (!trace_file_->WriteFully(buf_.get(), kTraceHeaderLength)) {
+    PLOG(ERROR) << "Trace header write failed";
+    write_failed_ = true;
+  }
+  while (true) {
+    TraceChunk* chunk;
+    {
+      MutexLock mu(self, streaming_lock_);
+      while (full_chunks_.empty() && !writer_stopping_) {
+        chunk_full_cond_.Wait(self);
+      }
+      if (full_chunks_.empty()) {
+        break;
+      }
+      chunk = full_chunks_.front();
+      full_chunks_.pop_front();
+    }
+    // Keep draining after a failure so that recording threads do not wait forever.
+    if (!write_failed_ && !trace_file_->WriteFully(chunk->data, chunk->size)) {
+      PLOG(ERROR) << "Trace data write failed";
+      write_failed_ = true;
+    }
+    {
+      MutexLock mu(self, streaming_lock_);
+      free_chunks_.push_back(chunk);
+      --num_pending_chunks_;
+      chunk_free_cond_.Broadcast(self);
+    }
+  }
+}
+
+static void ClearThreadTraceBuffer(Thread* thread, void* arg) {
+  thread->SetTraceBuffer(NULL);
+}
+
+void Trace::StopStreaming(Thread* self) {
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    Runtime::Current()->GetThreadList()->ForEach(ClearThreadTraceBuffer, NULL);
+  }
+  MutexLock mu(self, streaming_lock_);
+  for (TraceThreadBuffer* buffer : thread_buffers_) {
+    if (buffer->chunk != NULL) {
+      QueueChunkLocked(buffer->chunk);
+      buffer->chunk = NULL;
+    }
+  }
+  writer_stopping_ = true;
+  chunk_full_cond_.Signal(self);
+  chunk_free_cond_.Broadcast(self);
+}
+
+void Trace::FinishStreaming() {
+  size_t num_records = 0;
+  {
+    MutexLock mu(Thread::Current(), streaming_lock_);
+    DCHECK(full_chunks_.empty());
+    for (TraceThreadBuffer* buffer : thread_buffers_) {
+      num_records += buffer->num_records;
+    }
+  }
+  std::ostringstream os;
+  DumpSummary(os, num_records, false);
+  os << StringPrintf("%cend\n", kTraceTokenChar);
+  std::string summary(os.str());
+
+  uint8_t summary_header[7];
+  Append2LE(summary_header, 0);
+  summary_header[2] = kOpTraceSummary;
+  Append4LE(summary_header + 3, static_cast<uint32_t>(summary.length()));
+  if (write_failed_ ||
+      !trace_file_->WriteFully(summary_header, sizeof(summary_header)) ||
+      !trace_file_->WriteFully(summary.c_str(), summary.length())) {
+    std::string detail(StringPrintf("Trace data write failed: %s", strerror(errno)));
+    PLOG(ERROR) << detail;
+    ScopedObjectAccess soa(Thread::Current());
+    ThrowRuntimeException("%s", detail.c_str());
+  }
+}
+
+void Trace::FlushThreadBuffer(Thread* thread) {
+  TraceThreadBuffer* buffer = thread->GetTraceBuffer();
+  if (buffer == NULL) {
+    return;
+  }
+  thread->SetTraceBuffer(NULL);
+  MutexLock mu(thread, streaming_lock_);
+  if (buffer->chunk != NULL) {
+    QueueChunkLocked(buffer->chunk);
+    buffer->chunk = NULL;
+  }
+}
+
 void Trace::GetVisitedMethods(size_t buf_size,
                               std::set<mirror::ArtMethod*>* visited_methods) {
   uint8_t* ptr = buf_.get() + kTraceHeaderLength;
@@ -720,6 +1076,9 @@ void Trace::StoreExitingThreadInfo(Thread* thread) {
     std::string name;
     thread->GetThreadName(name);
     the_trace_->exited_threads_.Put(thread->GetTid(), name);
+    if (the_trace_->output_mode_ == kTraceOutputModeStreaming) {
+      the_trace_->FlushThreadBuffer(thread);
+    }
   }
 }
 
@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_TRACE_H_
 #define ART_RUNTIME_TRACE_H_
 
+#include <deque>
 #include <memory>
 #include <ostream>
 #include <set>
@@ -25,6 +26,7 @@
 
 #include "atomic.h"
 #include "base/macros.h"
+#include "base/mutex.h"
 #include "globals.h"
 #include "instrumentation.h"
 #include "os.h"
@@ -38,6 +40,8 @@ namespace mirror {
 }  // namespace mirror
 
 class Thread;
+struct TraceChunk;
+struct TraceThreadBuffer;
 
 enum TracingMode {
   kTracingInactive,
@@ -45,16 +49,32 @@ enum TracingMode {
   kSampleProfilingActive,
 };
 
+enum TraceOutputMode {
+  // Records go into one buffer that is written out when tracing stops, and are dropped once it
+  // is full.
+  kTraceOutputModeBuffered,
+  // Each thread records into chunks of its own that a writer thread streams to the trace file
+  // while tracing, so the trace is only bounded by the file system. Method and thread
+  // definitions are emitted as they are first used.
+  kTraceOutputModeStreaming,
+};
+
 class Trace FINAL : public instrumentation::InstrumentationListener {
  public:
   enum TraceFlag {
     kTraceCountAllocs = 1,
+    // Stream the trace to the file while tracing instead of buffering it.
+    kTraceStreamingOutput = 2,
   };
 
   static void SetDefaultClockSource(TraceClockSource clock_source);
 
+  // When streaming, buffer_size bounds the memory used for chunks waiting to be written rather
+  // than the size of the trace. Streaming requires a trace file and method tracing, other
+  // requests fall back to buffered output.
   static void Start(const char* trace_filename, int trace_fd, int buffer_size, int flags,
-                    bool direct_to_ddms, bool sampling_enabled, int interval_us)
+                    bool direct_to_ddms, bool sampling_enabled, int interval_us,
+                    TraceOutputMode output_mode)
       LOCKS_EXCLUDED(Locks::mutator_lock_,
                      Locks::thread_list_lock_,
                      Locks::thread_suspend_count_lock_,
@@ -108,18 +128,60 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   static void StoreExitingThreadInfo(Thread* thread);
 
  private:
-  explicit Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled);
+  explicit Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled,
+                 TraceOutputMode output_mode);
+  ~Trace();
 
   // The sampling interval in microseconds is passed as an argument.
   static void* RunSamplingThread(void* arg) LOCKS_EXCLUDED(Locks::trace_lock_);
 
+  // The Trace being streamed is passed as an argument.
+  static void* RunStreamingWriterThread(void* arg);
+
   void FinishTracing() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Write the version and thread sections shared by the buffered and streaming formats.
+  void DumpSummary(std::ostream& os, size_t num_records, bool overflow)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
+  // Writer thread loop, writes the header and then full chunks until the trace is stopped.
+  void WriteStreamingChunks(Thread* self) LOCKS_EXCLUDED(streaming_lock_);
+
+  // Hand the partially filled chunks of all threads to the writer and ask it to finish, called
+  // with all threads suspended.
+  void StopStreaming(Thread* self) LOCKS_EXCLUDED(streaming_lock_, Locks::thread_list_lock_);
+
+  // Append the summary once the writer thread has written everything else.
+  void FinishStreaming() LOCKS_EXCLUDED(streaming_lock_, Locks::thread_list_lock_);
+
+  // Hand the chunk of an exiting thread to the writer.
+  void FlushThreadBuffer(Thread* thread) LOCKS_EXCLUDED(streaming_lock_);
+
+  TraceThreadBuffer* AddThreadBuffer(Thread* self)
+      LOCKS_EXCLUDED(streaming_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Reserve size bytes in the chunk of the thread, handing the chunk to the writer when full.
+  // Returns NULL, dropping the record, once the trace is stopping.
+  uint8_t* ReserveStreamingSpace(Thread* self, TraceThreadBuffer* buffer, size_t size)
+      LOCKS_EXCLUDED(streaming_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Queue the full chunk of the buffer for writing and give it an empty one. Waits suspended for
+  // the writer when the chunk budget is exhausted and the writer has chunks in flight that it
+  // will return. Returns NULL if the trace stopped while waiting.
+  TraceChunk* HandOffChunk(Thread* self, TraceThreadBuffer* buffer)
+      LOCKS_EXCLUDED(streaming_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  TraceChunk* AllocChunkLocked() EXCLUSIVE_LOCKS_REQUIRED(streaming_lock_);
+  void QueueChunkLocked(TraceChunk* chunk) EXCLUSIVE_LOCKS_REQUIRED(streaming_lock_);
+
+  void WriteMethodDefinition(Thread* self, TraceThreadBuffer* buffer, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void ReadClocks(Thread* thread, uint32_t* thread_clock_diff, uint32_t* wall_clock_diff);
 
   void LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
                            instrumentation::Instrumentation::InstrumentationEvent event,
-                           uint32_t thread_clock_diff, uint32_t wall_clock_diff);
+                           uint32_t thread_clock_diff, uint32_t wall_clock_diff)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Methods to output traced methods and threads.
   void GetVisitedMethods(size_t end_offset, std::set<mirror::ArtMethod*>* visited_methods);
@@ -171,6 +233,43 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   // Map of thread ids and names that have already exited.
   SafeMap<pid_t, std::string> exited_threads_;
 
+  const TraceOutputMode output_mode_;
+
+  // Streaming state. Each thread fills a chunk of its own without synchronization, the lock is
+  // only taken to exchange a full chunk for an empty one.
+  Mutex streaming_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  ConditionVariable chunk_full_cond_ GUARDED_BY(streaming_lock_);
+  ConditionVariable chunk_free_cond_ GUARDED_BY(streaming_lock_);
+
+  // Chunks waiting for the writer thread, in the order they were handed off.
+  std::deque<TraceChunk*> full_chunks_ GUARDED_BY(streaming_lock_);
+
+  // Chunks written out and ready for reuse.
+  std::vector<TraceChunk*> free_chunks_ GUARDED_BY(streaming_lock_);
+
+  // Chunks allocated, and chunks queued or being written.
+  size_t num_chunks_ GUARDED_BY(streaming_lock_);
+  size_t num_pending_chunks_ GUARDED_BY(streaming_lock_);
+
+  // Chunks that may be allocated before threads wait for the writer.
+  const size_t max_chunks_;
+
+  // Threads in HandOffChunk that released the mutator lock to wait, the trace is only deleted
+  // once they are all done with it.
+  size_t num_waiting_threads_ GUARDED_BY(streaming_lock_);
+
+  // Buffers of all threads that recorded events, including exited ones.
+  std::vector<TraceThreadBuffer*> thread_buffers_ GUARDED_BY(streaming_lock_);
+
+  // Set when the writer thread should exit once the queue is drained.
+  bool writer_stopping_ GUARDED_BY(streaming_lock_);
+
+  // Set by the writer thread when writing to the trace file failed.
+  bool write_failed_;
+
+  // Streaming writer thread, non-zero when streaming.
+  pthread_t writer_pthread_;
+
   DISALLOW_COPY_AND_ASSIGN(Trace);
 };
 
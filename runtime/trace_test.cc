@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "interpreter/interpreter.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "scoped_thread_state_change.h"
+#include "utils.h"
+
+namespace art {
+
+class TraceTest : public CommonRuntimeTest {
+ protected:
+  static uint16_t Read2LE(const std::string& data, size_t offset) {
+    return static_cast<uint8_t>(data[offset]) | (static_cast<uint8_t>(data[offset + 1]) << 8);
+  }
+
+  static uint32_t Read4LE(const std::string& data, size_t offset) {
+    return Read2LE(data, offset) | (static_cast<uint32_t>(Read2LE(data, offset + 2)) << 16);
+  }
+};
+
+// The runtime isn't started, so Math.max runs in the interpreter, which reports its entries and
+// exits to the trace.
+TEST_F(TraceTest, StreamingFormat) {
+  static const int32_t kCalls = 3;
+  ScratchFile trace_file;
+  Trace::Start(trace_file.GetFilename().c_str(), -1, 1 * MB, 0, false, false, 0,
+               kTraceOutputModeStreaming);
+  ASSERT_EQ(kMethodTracingActive, Trace::GetMethodTracingMode());
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    StackHandleScope<1> hs(soa.Self());
+    Handle<mirror::Class> math(
+        hs.NewHandle(class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Math;")));
+    ASSERT_TRUE(math.Get() != nullptr);
+    ASSERT_TRUE(class_linker_->EnsureInitialized(math, true, true));
+    mirror::ArtMethod* max = math->FindDirectMethod("max", "(II)I");
+    ASSERT_TRUE(max != nullptr);
+    for (int32_t i = 0; i < kCalls; ++i) {
+      uint32_t args[2] = { static_cast<uint32_t>(i), 1U };
+      JValue result;
+      interpreter::EnterInterpreterFromInvoke(soa.Self(), max, nullptr, args, &result);
+      EXPECT_EQ(std::max(i, 1), result.GetI());
+    }
+  }
+  Trace::Stop();
+  ASSERT_EQ(kTracingInactive, Trace::GetMethodTracingMode());
+
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(trace_file.GetFilename(), &data));
+  ASSERT_GE(data.size(), 32U);
+  EXPECT_EQ(0x574f4c53U, Read4LE(data, 0));
+  const uint16_t version = Read2LE(data, 4);
+  EXPECT_EQ(0xF0, version & 0xF0);
+  const size_t record_size = (version & 0x0F) == 3 ? Read2LE(data, 16) : 10U;
+
+  const uint16_t tid = static_cast<uint16_t>(GetTid());
+  bool thread_defined = false;
+  uint32_t max_id = 0;
+  size_t num_enters = 0;
+  size_t num_exits = 0;
+  std::string summary;
+  size_t pos = Read2LE(data, 6);
+  while (pos < data.size()) {
+    ASSERT_TRUE(summary.empty()) << "Records after the summary";
+    if (Read2LE(data, pos) != 0) {
+      // A method event, the method id with the action in the low two bits.
+      ASSERT_LE(pos + record_size, data.size());
+      EXPECT_EQ(tid, Read2LE(data, pos));
+      const uint32_t method_value = Read4LE(data, pos + 2);
+      if (max_id != 0 && (method_value & ~3U) == max_id) {
+        num_enters += (method_value & 3U) == 0 ? 1 : 0;
+        num_exits += (method_value & 3U) == 1 ? 1 : 0;
+      }
+      pos += record_size;
+      continue;
+    }
+    switch (data[pos + 2]) {
+      case 1: {  // kOpNewMethod
+        const size_t length = Read2LE(data, pos + 3);
+        const std::string line(data, pos + 5, length);
+        if (line.find("java.lang.Math\tmax\t") != std::string::npos) {
+          EXPECT_EQ(0U, max_id) << "Method defined twice";
+          max_id = static_cast<uint32_t>(strtoull(line.c_str(), nullptr, 16));
+        }
+        pos += 5 + length;
+        break;
+      }
+      case 2: {  // kOpNewThread
+        thread_defined |= Read2LE(data, pos + 3) == tid;
+        pos += 7 + Read2LE(data, pos + 5);
+        break;
+      }
+      case 3: {  // kOpTraceSummary
+        const size_t length = Read4LE(data, pos + 3);
+        summary.assign(data, pos + 7, length);
+        pos += 7 + length;
+        break;
+      }
+      default:
+        FAIL() << "Unexpected op " << static_cast<int>(data[pos + 2]) << " at " << pos;
+    }
+  }
+  EXPECT_EQ(data.size(), pos);
+  EXPECT_TRUE(thread_defined);
+  ASSERT_NE(0U, max_id);
+  // Definitions precede the events using them, so every call was counted.
+  EXPECT_EQ(static_cast<size_t>(kCalls), num_enters);
+  EXPECT_EQ(static_cast<size_t>(kCalls), num_exits);
+  EXPECT_EQ(0U, summary.find("*version\n")) << summary;
+  EXPECT_NE(std::string::npos, summary.find("num-method-calls=")) << summary;
+  EXPECT_NE(std::string::npos, summary.find("*threads\n")) << summary;
+  ASSERT_GE(summary.size(), 5U);
+  EXPECT_EQ("*end\n", summary.substr(summary.size() - 5)) << summary;
+}
+
+}  // namespace art
@@ -19,8 +19,51 @@
 
 #include "utf.h"
 
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "base/macros.h"
+
 namespace art {
 
+// The word at a time scan below finds the first flagged byte from the low end of the word.
+COMPILE_ASSERT(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, ascii_scan_assumes_little_endian);
+
+inline size_t CountLeadingAsciiChars(const uint8_t* utf8, size_t byte_count) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= byte_count; i += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8 + i));
+    // Set the top bit of every zero byte, bytes with the top bit set are not ASCII.
+    int mask = _mm_movemask_epi8(_mm_or_si128(chunk, _mm_cmpeq_epi8(chunk, zero)));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#endif
+  static constexpr uint64_t kLowBits = UINT64_C(0x0101010101010101);
+  static constexpr uint64_t kHighBits = UINT64_C(0x8080808080808080);
+  for (; i + sizeof(uint64_t) <= byte_count; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, utf8 + i, sizeof(word));
+    // The top bit of the lowest byte that is zero or not ASCII is set, higher bytes may be
+    // flagged spuriously by the borrow of the subtraction.
+    uint64_t flags = (((word - kLowBits) & ~word) | word) & kHighBits;
+    if (flags != 0) {
+      return i + __builtin_ctzll(flags) / 8;
+    }
+  }
+  for (; i < byte_count; ++i) {
+    if (utf8[i] == 0 || (utf8[i] & 0x80) != 0) {
+      break;
+    }
+  }
+  return i;
+}
+
 inline uint16_t GetUtf16FromUtf8(const char** utf8_data_in) {
   uint8_t one = *(*utf8_data_in)++;
   if ((one & 0x80) == 0) {
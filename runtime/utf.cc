@@ -16,6 +16,8 @@
 
 #include "utf.h"
 
+#include <string.h>
+
 #include "base/logging.h"
 #include "mirror/array.h"
 #include "mirror/object-inl.h"
@@ -24,29 +26,44 @@
 namespace art {
 
 size_t CountModifiedUtf8Chars(const char* utf8) {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(utf8);
+  const uint8_t* end = in + strlen(utf8);
   size_t len = 0;
-  int ic;
-  while ((ic = *utf8++) != '\0') {
-    len++;
-    if ((ic & 0x80) == 0) {
-      // one-byte encoding
-      continue;
+  while (in < end) {
+    size_t ascii_count = CountLeadingAsciiChars(in, end - in);
+    len += ascii_count;
+    in += ascii_count;
+    if (in >= end) {
+      break;
     }
+    int ic = *in++;
+    len++;
     // two- or three-byte encoding
-    utf8++;
+    in++;
     if ((ic & 0x20) == 0) {
       // two-byte encoding
       continue;
     }
     // three-byte encoding
-    utf8++;
+    in++;
   }
   return len;
 }
 
 void ConvertModifiedUtf8ToUtf16(uint16_t* utf16_data_out, const char* utf8_data_in) {
-  while (*utf8_data_in != '\0') {
-    *utf16_data_out++ = GetUtf16FromUtf8(&utf8_data_in);
+  const char* end = utf8_data_in + strlen(utf8_data_in);
+  while (utf8_data_in < end) {
+    const uint8_t* ascii = reinterpret_cast<const uint8_t*>(utf8_data_in);
+    size_t ascii_count = CountLeadingAsciiChars(ascii, end - utf8_data_in);
+    // Widen the ASCII run, simple enough for the compiler to vectorize.
+    for (size_t i = 0; i < ascii_count; ++i) {
+      utf16_data_out[i] = ascii[i];
+    }
+    utf16_data_out += ascii_count;
+    utf8_data_in += ascii_count;
+    if (utf8_data_in < end) {
+      *utf16_data_out++ = GetUtf16FromUtf8(&utf8_data_in);
+    }
   }
 }
 
@@ -86,11 +103,27 @@ int32_t ComputeUtf16Hash(const uint16_t* chars, size_t char_count) {
 }
 
 int32_t ComputeUtf8Hash(const char* chars) {
-  int32_t hash = 0;
-  while (*chars != '\0') {
-    hash = hash * 31 + GetUtf16FromUtf8(&chars);
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(chars);
+  const uint8_t* end = in + strlen(chars);
+  // Unsigned so that the wrap around of the multiplications is defined.
+  uint32_t hash = 0;
+  while (in < end) {
+    const uint8_t* ascii_end = in + CountLeadingAsciiChars(in, end - in);
+    // Hash four ASCII chars per step, the independent products don't wait on each other.
+    for (; in + 4 <= ascii_end; in += 4) {
+      hash = hash * (31U * 31U * 31U * 31U) + in[0] * (31U * 31U * 31U) + in[1] * (31U * 31U) +
+          in[2] * 31U + in[3];
+    }
+    for (; in < ascii_end; ++in) {
+      hash = hash * 31U + *in;
+    }
+    if (in < end) {
+      const char* utf8 = reinterpret_cast<const char*>(in);
+      hash = hash * 31U + GetUtf16FromUtf8(&utf8);
+      in = reinterpret_cast<const uint8_t*>(utf8);
+    }
   }
-  return hash;
+  return static_cast<int32_t>(hash);
 }
 
 int CompareModifiedUtf8ToUtf16AsCodePointValues(const char* utf8_1, const uint16_t* utf8_2) {
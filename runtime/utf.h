@@ -82,6 +82,13 @@ int32_t ComputeUtf16Hash(const uint16_t* chars, size_t char_count);
 // Compute a hash code of a UTF-8 string.
 int32_t ComputeUtf8Hash(const char* chars);
 
+/*
+ * Returns the number of leading bytes of the given modified UTF-8 data, at most byte_count, that
+ * are non-zero ASCII and so each encode a single UTF-16 character. Vectorized where supported,
+ * this lets the decoding loops skip the common ASCII runs.
+ */
+ALWAYS_INLINE size_t CountLeadingAsciiChars(const uint8_t* utf8, size_t byte_count);
+
 /*
  * Retrieve the next UTF-16 character from a UTF-8 string.
  *
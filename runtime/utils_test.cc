@@ -24,6 +24,7 @@
 #include "mirror/string.h"
 #include "scoped_thread_state_change.h"
 #include "handle_scope-inl.h"
+#include "utf-inl.h"
 
 #include <valgrind.h>
 
@@ -402,4 +403,63 @@ TEST_F(UtilsTest, ExecError) {
   }
 }
 
+TEST_F(UtilsTest, ModifiedUtf8AsciiFastPath) {
+  // Mix ASCII runs longer than a vector with two and three byte encodings, starting at every
+  // alignment so that both the vector and the tail loops see the non-ASCII bytes.
+  std::string utf8;
+  std::vector<uint16_t> expected;
+  for (size_t i = 0; i < 200; ++i) {
+    if (i % 37 == 36) {
+      utf8 += "\xc2\xa9";  // U+00A9.
+      expected.push_back(0xa9);
+    } else if (i % 53 == 52) {
+      utf8 += "\xe2\x82\xac";  // U+20AC.
+      expected.push_back(0x20ac);
+    } else {
+      utf8 += static_cast<char>('a' + i % 26);
+      expected.push_back('a' + i % 26);
+    }
+  }
+  std::vector<char> buffer(utf8.size() + 1 + 16);
+  for (size_t offset = 0; offset < 16; ++offset) {
+    char* data = &buffer[offset];
+    memcpy(data, utf8.c_str(), utf8.size() + 1);
+    ASSERT_EQ(expected.size(), CountModifiedUtf8Chars(data));
+    std::vector<uint16_t> utf16(expected.size());
+    ConvertModifiedUtf8ToUtf16(&utf16[0], data);
+    EXPECT_TRUE(expected == utf16) << offset;
+    EXPECT_EQ(ComputeUtf16Hash(&expected[0], expected.size()), ComputeUtf8Hash(data)) << offset;
+    EXPECT_EQ(36U, CountLeadingAsciiChars(reinterpret_cast<const uint8_t*>(data), utf8.size()));
+    EXPECT_EQ(20U, CountLeadingAsciiChars(reinterpret_cast<const uint8_t*>(data), 20));
+  }
+  // The embedded NUL of modified UTF-8 is never ASCII.
+  EXPECT_EQ(0U, CountLeadingAsciiChars(reinterpret_cast<const uint8_t*>("\0abc"), 4));
+}
+
+TEST_F(UtilsTest, ModifiedUtf8Throughput) {
+  // Not a pass/fail benchmark, reports the throughput of the ASCII heavy common case.
+  std::string utf8;
+  for (size_t i = 0; utf8.size() < 1 * MB; ++i) {
+    utf8 += (i % 97 == 96) ? "\xc2\xa9" : "abcdefghijklmnopqrstuvwxyz";
+  }
+  std::vector<uint16_t> utf16(utf8.size());
+  const size_t kIterations = 20;
+  uint64_t start_ns = NanoTime();
+  size_t char_count = 0;
+  for (size_t i = 0; i < kIterations; ++i) {
+    char_count += CountModifiedUtf8Chars(utf8.c_str());
+  }
+  uint64_t count_ns = NanoTime() - start_ns;
+  start_ns = NanoTime();
+  for (size_t i = 0; i < kIterations; ++i) {
+    ConvertModifiedUtf8ToUtf16(&utf16[0], utf8.c_str());
+  }
+  uint64_t convert_ns = NanoTime() - start_ns;
+  EXPECT_EQ(kIterations * CountModifiedUtf8Chars(utf8.c_str()), char_count);
+  const uint64_t total_bytes = kIterations * utf8.size();
+  LOG(INFO) << "CountModifiedUtf8Chars: " << PrettySize(total_bytes * 1000000000 / (count_ns + 1))
+            << "/s, ConvertModifiedUtf8ToUtf16: "
+            << PrettySize(total_bytes * 1000000000 / (convert_ns + 1)) << "/s";
+}
+
 }  // namespace art
@@ -39,15 +39,28 @@ class ZipEntry {
   bool ExtractToFile(File& file, std::string* error_msg);
   MemMap* ExtractToMemMap(const char* zip_filename, const char* entry_filename,
                           std::string* error_msg);
+  // Map the entry read only straight from the archive if it is stored uncompressed at an offset
+  // aligned to alignment, avoiding a private dirty copy. Otherwise extract it like
+  // ExtractToMemMap.
+  MemMap* MapDirectlyOrExtract(const char* zip_filename, const char* entry_filename,
+                               size_t alignment, std::string* error_msg);
   virtual ~ZipEntry();
 
   uint32_t GetUncompressedLength();
   uint32_t GetCrc32();
 
+  // Is the entry stored without compression?
+  bool IsUncompressed();
+  // Does the entry's data start at an offset in the archive that is a multiple of alignment?
+  bool IsAlignedTo(size_t alignment);
+
  private:
   ZipEntry(ZipArchiveHandle handle,
            ::ZipEntry* zip_entry) : handle_(handle), zip_entry_(zip_entry) {}
 
+  MemMap* MapDirectlyFromFile(const char* zip_filename, const char* entry_filename,
+                              std::string* error_msg);
+
   ZipArchiveHandle handle_;
   ::ZipEntry* const zip_entry_;
 
@@ -21,6 +21,7 @@
 #include <sys/types.h>
 #include <zlib.h>
 #include <memory>
+#include <vector>
 
 #include "base/unix_file/fd_file.h"
 #include "common_runtime_test.h"
@@ -28,7 +29,74 @@
 
 namespace art {
 
-class ZipArchiveTest : public CommonRuntimeTest {};
+class ZipArchiveTest : public CommonRuntimeTest {
+ protected:
+  static void Put16(std::vector<uint8_t>* out, uint16_t value) {
+    out->push_back(value & 0xff);
+    out->push_back(value >> 8);
+  }
+
+  static void Put32(std::vector<uint8_t>* out, uint32_t value) {
+    Put16(out, value & 0xffff);
+    Put16(out, value >> 16);
+  }
+
+  // Writes an archive with a single entry stored uncompressed, padding the local header's extra
+  // field so that the entry's data starts at a multiple of alignment.
+  static void WriteStoredZip(File* file, const char* name, const std::vector<uint8_t>& data,
+                             size_t alignment) {
+    const uint32_t crc = crc32(crc32(0L, Z_NULL, 0), &data[0], data.size());
+    const uint16_t name_length = strlen(name);
+    const size_t kLocalHeaderSize = 30;
+    const uint16_t extra_length =
+        RoundUp(kLocalHeaderSize + name_length, alignment) - (kLocalHeaderSize + name_length);
+    std::vector<uint8_t> out;
+    Put32(&out, 0x04034b50);  // Local file header signature.
+    Put16(&out, 10);  // Version needed to extract.
+    Put16(&out, 0);  // Flags.
+    Put16(&out, kCompressStored);
+    Put16(&out, 0);  // Modification time.
+    Put16(&out, 0);  // Modification date.
+    Put32(&out, crc);
+    Put32(&out, data.size());  // Compressed size.
+    Put32(&out, data.size());  // Uncompressed size.
+    Put16(&out, name_length);
+    Put16(&out, extra_length);
+    out.insert(out.end(), name, name + name_length);
+    out.insert(out.end(), extra_length, 0);
+    ASSERT_TRUE(IsAlignedParam(out.size(), alignment));
+    out.insert(out.end(), data.begin(), data.end());
+    const uint32_t central_directory_offset = out.size();
+    Put32(&out, 0x02014b50);  // Central directory file header signature.
+    Put16(&out, 10);  // Version made by.
+    Put16(&out, 10);  // Version needed to extract.
+    Put16(&out, 0);  // Flags.
+    Put16(&out, kCompressStored);
+    Put16(&out, 0);  // Modification time.
+    Put16(&out, 0);  // Modification date.
+    Put32(&out, crc);
+    Put32(&out, data.size());  // Compressed size.
+    Put32(&out, data.size());  // Uncompressed size.
+    Put16(&out, name_length);
+    Put16(&out, 0);  // Extra field length.
+    Put16(&out, 0);  // Comment length.
+    Put16(&out, 0);  // Disk number start.
+    Put16(&out, 0);  // Internal attributes.
+    Put32(&out, 0);  // External attributes.
+    Put32(&out, 0);  // Offset of the local header.
+    out.insert(out.end(), name, name + name_length);
+    const uint32_t central_directory_size = out.size() - central_directory_offset;
+    Put32(&out, 0x06054b50);  // End of central directory signature.
+    Put16(&out, 0);  // Number of this disk.
+    Put16(&out, 0);  // Disk where the central directory starts.
+    Put16(&out, 1);  // Central directory records on this disk.
+    Put16(&out, 1);  // Total central directory records.
+    Put32(&out, central_directory_size);
+    Put32(&out, central_directory_offset);
+    Put16(&out, 0);  // Comment length.
+    ASSERT_TRUE(file->WriteFully(&out[0], out.size()));
+  }
+};
 
 TEST_F(ZipArchiveTest, FindAndExtract) {
   std::string error_msg;
@@ -63,4 +131,49 @@ TEST_F(ZipArchiveTest, FindAndExtract) {
   EXPECT_EQ(zip_entry->GetCrc32(), computed_crc);
 }
 
+TEST_F(ZipArchiveTest, MapDirectlyOrExtractStored) {
+  std::vector<uint8_t> data;
+  for (size_t i = 0; i < 3 * kPageSize + 5; ++i) {
+    data.push_back(static_cast<uint8_t>(i * 7));
+  }
+  ScratchFile tmp;
+  WriteStoredZip(tmp.GetFile(), "classes.dex", data, kPageSize);
+
+  std::string error_msg;
+  std::unique_ptr<ZipArchive> zip_archive(ZipArchive::Open(tmp.GetFilename().c_str(), &error_msg));
+  ASSERT_TRUE(zip_archive.get() != nullptr) << error_msg;
+  std::unique_ptr<ZipEntry> zip_entry(zip_archive->Find("classes.dex", &error_msg));
+  ASSERT_TRUE(zip_entry.get() != nullptr) << error_msg;
+  EXPECT_TRUE(zip_entry->IsUncompressed());
+  EXPECT_TRUE(zip_entry->IsAlignedTo(kPageSize));
+
+  std::unique_ptr<MemMap> map(zip_entry->MapDirectlyOrExtract(tmp.GetFilename().c_str(),
+                                                              "classes.dex", kPageSize,
+                                                              &error_msg));
+  ASSERT_TRUE(map.get() != nullptr) << error_msg;
+  // The entry is used in place rather than copied.
+  EXPECT_NE(std::string::npos, map->GetName().find("mapped directly")) << map->GetName();
+  EXPECT_EQ(PROT_READ, map->GetProtect());
+  ASSERT_EQ(data.size(), map->Size());
+  EXPECT_EQ(0, memcmp(&data[0], map->Begin(), data.size()));
+}
+
+TEST_F(ZipArchiveTest, MapDirectlyOrExtractCompressed) {
+  std::string error_msg;
+  std::unique_ptr<ZipArchive> zip_archive(ZipArchive::Open(GetLibCoreDexFileName().c_str(),
+                                                           &error_msg));
+  ASSERT_TRUE(zip_archive.get() != nullptr) << error_msg;
+  std::unique_ptr<ZipEntry> zip_entry(zip_archive->Find("classes.dex", &error_msg));
+  ASSERT_TRUE(zip_entry.get() != nullptr) << error_msg;
+  ASSERT_FALSE(zip_entry->IsUncompressed());
+
+  // Compressed entries fall back to extraction.
+  std::unique_ptr<MemMap> map(zip_entry->MapDirectlyOrExtract(GetLibCoreDexFileName().c_str(),
+                                                              "classes.dex", sizeof(uint32_t),
+                                                              &error_msg));
+  ASSERT_TRUE(map.get() != nullptr) << error_msg;
+  EXPECT_NE(std::string::npos, map->GetName().find("extracted in memory")) << map->GetName();
+  EXPECT_EQ(zip_entry->GetUncompressedLength(), map->Size());
+}
+
 }  // namespace art
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.lang.reflect.Method;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.HashMap;
+import java.util.Map;
+
+// The methods are compiled with method trace hooks by the run script, so while tracing they keep
+// running their compiled code and report entry, exit and unwind themselves. The events must be
+// the same as the interpreter reports.
+public class Main {
+    private static final String[] TRACED_METHODS = {
+        "caller", "leaf", "catcher", "unwound", "thrower"
+    };
+
+    public static void main(String[] args) throws Exception {
+        String name = System.getProperty("java.vm.name");
+        if (!"Dalvik".equals(name)) {
+            System.out.println("This test is not supported on " + name);
+            return;
+        }
+        File tempFile;
+        try {
+            tempFile = File.createTempFile("test", ".trace");
+        } catch (IOException e) {
+            System.setProperty("java.io.tmpdir", "/sdcard");
+            tempFile = File.createTempFile("test", ".trace");
+        }
+        tempFile.deleteOnExit();
+
+        // Stop method tracing started from the command line.
+        if (VMDebug.getMethodTracingMode() != 0) {
+            VMDebug.stopMethodTracing();
+        }
+        VMDebug.startMethodTracing(tempFile.getPath(), 0, 0, false, 0);
+        caller(1);
+        catcher();
+        VMDebug.stopMethodTracing();
+        printEvents(tempFile);
+    }
+
+    public static int caller(int i) {
+        return leaf(i) * 2;
+    }
+
+    public static int leaf(int i) {
+        return i + 1;
+    }
+
+    public static void catcher() {
+        try {
+            unwound();
+        } catch (IllegalStateException expected) {
+        }
+    }
+
+    public static void unwound() {
+        thrower();
+    }
+
+    public static void thrower() {
+        throw new IllegalStateException();
+    }
+
+    // Print the events of the traced methods from a buffered trace: the text header listing the
+    // methods and ending in "*end", then the binary header and the records.
+    private static void printEvents(File file) throws Exception {
+        RandomAccessFile raf = new RandomAccessFile(file, "r");
+        byte[] data = new byte[(int) raf.length()];
+        raf.readFully(data);
+        raf.close();
+
+        String text = new String(data, "ISO-8859-1");
+        int methodsStart = text.indexOf("*methods\n");
+        int end = text.indexOf("*end\n");
+        if (methodsStart < 0 || end < methodsStart) {
+            System.out.println("Malformed trace");
+            return;
+        }
+        Map<Long, String> methods = new HashMap<Long, String>();
+        for (String line : text.substring(methodsStart, end).split("\n")) {
+            String[] fields = line.split("\t");
+            if (fields.length < 3 || !fields[1].equals("Main")) {
+                continue;
+            }
+            for (String traced : TRACED_METHODS) {
+                if (fields[2].equals(traced)) {
+                    methods.put(Long.decode(fields[0]), traced);
+                }
+            }
+        }
+
+        ByteBuffer buffer = ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN);
+        int header = end + "*end\n".length();
+        int version = buffer.getShort(header + 4);
+        int recordSize = version == 3 ? buffer.getShort(header + 16) : 10;
+        for (int pos = header + buffer.getShort(header + 6); pos + recordSize <= data.length;
+                pos += recordSize) {
+            long value = buffer.getInt(pos + 2) & 0xffffffffL;
+            String method = methods.get(value & ~3L);
+            if (method == null) {
+                continue;
+            }
+            switch ((int) (value & 3)) {
+                case 0: System.out.println("enter " + method); break;
+                case 1: System.out.println("exit " + method); break;
+                case 2: System.out.println("unwind " + method); break;
+                default: System.out.println("unknown event " + method); break;
+            }
+        }
+    }
+
+    private static class VMDebug {
+        private static final Method startMethodTracingMethod;
+        private static final Method stopMethodTracingMethod;
+        private static final Method getMethodTracingModeMethod;
+        static {
+            try {
+                Class c = Class.forName("dalvik.system.VMDebug");
+                startMethodTracingMethod = c.getDeclaredMethod("startMethodTracing", String.class,
+                        Integer.TYPE, Integer.TYPE, Boolean.TYPE, Integer.TYPE);
+                stopMethodTracingMethod = c.getDeclaredMethod("stopMethodTracing");
+                getMethodTracingModeMethod = c.getDeclaredMethod("getMethodTracingMode");
+            } catch (Exception e) {
+                throw new RuntimeException(e);
+            }
+        }
+
+        public static void startMethodTracing(String filename, int bufferSize, int flags,
+                boolean samplingEnabled, int intervalUs) throws Exception {
+            startMethodTracingMethod.invoke(null, filename, bufferSize, flags, samplingEnabled,
+                    intervalUs);
+        }
+        public static void stopMethodTracing() throws Exception {
+            stopMethodTracingMethod.invoke(null);
+        }
+        public static int getMethodTracingMode() throws Exception {
+            return (int) getMethodTracingModeMethod.invoke(null);
+        }
+    }
+}
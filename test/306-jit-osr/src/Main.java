@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The loops run long enough for the JIT to compile their methods, which then continue in the
+// compiled code from the loop header. The registers live across the loop have to arrive there
+// with the values the interpreter left in them.
+public class Main {
+    static class Node {
+        final int value;
+        final Node next;
+
+        Node(int value, Node next) {
+            this.value = value;
+            this.next = next;
+        }
+    }
+
+    static class Counter {
+        long total;
+
+        // The receiver is a live reference in the ins.
+        void run(int iterations) {
+            for (int i = 0; i < iterations; ++i) {
+                total += i;
+            }
+        }
+    }
+
+    public static void main(String[] args) {
+        Node list = null;
+        for (int i = 0; i < 10; ++i) {
+            list = new Node(i, list);
+        }
+        System.out.println(loop(list, "loop", 1000000));
+
+        Counter counter = new Counter();
+        counter.run(500000);
+        System.out.println("counter " + counter.total);
+    }
+
+    // Int, long and reference registers are all live across the loop header.
+    static String loop(Node list, String label, int iterations) {
+        int count = 0;
+        long sum = 0x100000000L;
+        Node node = list;
+        for (int i = 0; i < iterations; ++i) {
+            sum += node.value * (long) i;
+            count += node.value;
+            node = (node.next != null) ? node.next : list;
+        }
+        return label + " " + count + " " + sum + " " + node.value + " " + (node == list);
+    }
+}
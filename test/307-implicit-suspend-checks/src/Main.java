@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+    private static final int SAMPLES = 100;
+
+    public static void main(String[] args) throws Exception {
+        Spinner backEdges = new Spinner(false);
+        Spinner returns = new Spinner(true);
+        backEdges.start();
+        returns.start();
+        backEdges.waitUntilSpinning();
+        returns.waitUntilSpinning();
+
+        // Taking the stack trace of a thread suspends it. A spinner that doesn't take its suspend
+        // checks never suspends and the test times out. Suspended at a check, its top frame is
+        // the method that ran it.
+        boolean suspended = true;
+        for (int i = 0; i < SAMPLES; i++) {
+            suspended &= backEdges.checkTopFrame("spinLoop");
+            suspended &= returns.checkTopFrame("spinReturn", "spinCalls");
+        }
+        if (suspended) {
+            System.out.println("Suspended spinning threads");
+        }
+
+        // Collections suspend all threads, the spinners must keep running in between.
+        for (int i = 0; i < 5; i++) {
+            long backEdgeCount = backEdges.count;
+            long returnCount = returns.count;
+            Runtime.getRuntime().gc();
+            Thread.sleep(10);
+            if (backEdges.count == backEdgeCount || returns.count == returnCount) {
+                System.out.println("Spinner made no progress");
+            }
+        }
+        System.out.println("Collected with spinning threads");
+
+        backEdges.stopNow();
+        returns.stopNow();
+        backEdges.join();
+        returns.join();
+        System.out.println("Done");
+    }
+}
+
+class Spinner extends Thread {
+    private final boolean withReturns;
+    private volatile boolean keepGoing = true;
+    private volatile boolean spinning = false;
+    volatile long count;
+
+    Spinner(boolean withReturns) {
+        this.withReturns = withReturns;
+    }
+
+    public void run() {
+        spinning = true;
+        if (withReturns) {
+            spinCalls();
+        } else {
+            spinLoop();
+        }
+    }
+
+    // The suspend check is on the back edge.
+    private void spinLoop() {
+        long i = 0;
+        while (keepGoing) {
+            i++;
+            count = i;
+        }
+    }
+
+    // The suspend checks are on the back edge and on the return of the callee.
+    private void spinCalls() {
+        long i = 0;
+        while (keepGoing) {
+            i = spinReturn(i);
+            count = i;
+        }
+    }
+
+    private static long spinReturn(long i) {
+        return i + 1;
+    }
+
+    void waitUntilSpinning() throws InterruptedException {
+        while (!spinning || count == 0) {
+            Thread.sleep(1);
+        }
+    }
+
+    boolean checkTopFrame(String... expected) {
+        StackTraceElement[] trace = getStackTrace();
+        if (trace.length == 0) {
+            System.out.println(getName() + " has no stack");
+            return false;
+        }
+        for (String method : expected) {
+            if (trace[0].getMethodName().equals(method)) {
+                return true;
+            }
+        }
+        System.out.println(getName() + " suspended in " + trace[0]);
+        return false;
+    }
+
+    void stopNow() {
+        keepGoing = false;
+    }
+}
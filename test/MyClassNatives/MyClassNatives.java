@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+import dalvik.annotation.optimization.CriticalNative;
+import dalvik.annotation.optimization.FastNative;
+
 class MyClassNatives {
     native void throwException();
     native void foo();
@@ -98,4 +101,36 @@ class MyClassNatives {
     static native boolean returnTrue();
     static native boolean returnFalse();
     static native int returnInt();
+
+    static native int normalAdd(int x, int y);
+    @FastNative
+    static native int fastAdd(int x, int y);
+    @CriticalNative
+    static native int criticalAdd(int x, int y);
+    @CriticalNative
+    static native double criticalMix(int i, long l, float f, double d);
+
+    static int normalAddLoop(int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum = normalAdd(sum, 1);
+        }
+        return sum;
+    }
+
+    static int fastAddLoop(int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum = fastAdd(sum, 1);
+        }
+        return sum;
+    }
+
+    static int criticalAddLoop(int n) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum = criticalAdd(sum, 1);
+        }
+        return sum;
+    }
 }
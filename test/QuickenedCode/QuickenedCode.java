@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class QuickenedCode {
+    int intField;
+    long longField;
+    Object objectField;
+    QuickenedCode next;
+    int lateField;
+
+    int value() {
+        return intField;
+    }
+
+    long sum(int a, int b, int c, int d, int e) {
+        return longField + a + b + c + d + e;
+    }
+
+    int lateValue() {
+        return lateField;
+    }
+
+    // An iget, iput and invoke-virtual of each kind.
+    static long fieldsAndInvokes(QuickenedCode q, int value) {
+        q.intField = value;
+        q.longField = value * 3L;
+        q.objectField = q;
+        QuickenedCode other = (QuickenedCode) q.objectField;
+        return other.longField + other.value() + other.sum(1, 2, 3, 4, 5);
+    }
+
+    // lateField and lateValue are only used when late is true.
+    static int lateResolution(QuickenedCode q, boolean late) {
+        int result = q.intField;
+        if (late) {
+            result += q.lateField + q.lateValue();
+        }
+        return result;
+    }
+
+    static int catchNullPointer(QuickenedCode q) {
+        try {
+            return q.next.intField;
+        } catch (NullPointerException e) {
+            return -1;
+        }
+    }
+
+    static int throwNullPointer(QuickenedCode q) {
+        return q.next.intField;
+    }
+}